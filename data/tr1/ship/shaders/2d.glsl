@@ -32,6 +32,14 @@ uniform bool alphaEnabled;
 uniform bool tintEnabled;
 uniform vec3 tintColor;
 uniform int effect;
+uniform sampler2D texY;
+uniform sampler2D texU;
+uniform sampler2D texV;
+uniform bool yuvEnabled;
+// luma offset, luma scale, chroma scale
+uniform vec3 yuvRange;
+// R from V, G from U, G from V, B from U
+uniform vec4 yuvCoeffs;
 
 #ifdef OGL33C
     #define OUTCOLOR outColor
@@ -60,7 +68,20 @@ void main(void) {
         }
     }
 
-    if (paletteEnabled) {
+    if (yuvEnabled) {
+        if (uv.x < 0.0 || uv.x > 1.0 || uv.y < 0.0 || uv.y > 1.0) {
+            OUTCOLOR = vec4(0.0, 0.0, 0.0, 1.0);
+            return;
+        }
+        float y = (TEXTURE2D(texY, uv).r - yuvRange.x) * yuvRange.y;
+        float u = (TEXTURE2D(texU, uv).r - 128.0 / 255.0) * yuvRange.z;
+        float v = (TEXTURE2D(texV, uv).r - 128.0 / 255.0) * yuvRange.z;
+        OUTCOLOR = vec4(
+            clamp(y + yuvCoeffs.x * v, 0.0, 1.0),
+            clamp(y - yuvCoeffs.y * u - yuvCoeffs.z * v, 0.0, 1.0),
+            clamp(y + yuvCoeffs.w * u, 0.0, 1.0),
+            1.0);
+    } else if (paletteEnabled) {
         float paletteIndex = TEXTURE2D(texMain, uv).r;
         OUTCOLOR = TEXTURE1D(texPalette, paletteIndex);
     } else {
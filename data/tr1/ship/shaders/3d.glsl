@@ -4,6 +4,7 @@
 layout(location = 0) in vec3 inPosition;
 layout(location = 1) in vec3 inTexCoords;
 layout(location = 2) in vec4 inColor;
+layout(location = 3) in float inTexLayer;
 
 uniform mat4 matProjection;
 uniform mat4 matModelView;
@@ -11,21 +12,25 @@ uniform mat4 matModelView;
 #ifdef OGL33C
     out vec4 vertColor;
     out vec3 vertTexCoords;
+    out float vertTexLayer;
 #else
     varying vec4 vertColor;
     varying vec3 vertTexCoords;
+    varying float vertTexLayer;
 #endif
 
 void main(void) {
     gl_Position = matProjection * matModelView * vec4(inPosition, 1);
     vertColor = inColor / 255.0;
     vertTexCoords = inTexCoords;
+    vertTexLayer = inTexLayer;
 }
 
 #else
 // Fragment shader
 
-uniform sampler2D tex0;
+uniform sampler2DArray texPages;
+uniform sampler2D texEnvMap;
 uniform bool texturingEnabled;
 uniform bool smoothingEnabled;
 uniform bool alphaPointDiscard;
@@ -36,39 +41,49 @@ uniform float brightnessMultiplier;
     #define OUTCOLOR outColor
     #define TEXTURESIZE textureSize
     #define TEXTURE texture
+    #define TEXTUREARRAY texture
     #define TEXELFETCH texelFetch
 
     in vec4 vertColor;
     in vec3 vertTexCoords;
+    in float vertTexLayer;
     out vec4 OUTCOLOR;
 #else
     #define OUTCOLOR gl_FragColor
-    #define TEXTURESIZE textureSize2D
-    #define TEXELFETCH texelFetch2D
+    #define TEXTURESIZE textureSize2DArray
+    #define TEXELFETCH texelFetch2DArray
     #define TEXTURE texture2D
+    #define TEXTUREARRAY texture2DArray
 
     varying vec4 vertColor;
     varying vec3 vertTexCoords;
+    varying float vertTexLayer;
 #endif
 
 void main(void) {
     OUTCOLOR = vertColor;
 
     if (texturingEnabled) {
+        // negative layers refer to the environment map
+        float layer = floor(vertTexLayer + 0.5);
+        vec2 uv = vertTexCoords.xy / vertTexCoords.z;
+
 #if defined(GL_EXT_gpu_shader4) || defined(OGL33C)
-        if (alphaPointDiscard && smoothingEnabled) {
+        if (alphaPointDiscard && smoothingEnabled && layer >= 0.0) {
             // do not use smoothing for chroma key
-            ivec2 size = TEXTURESIZE(tex0, 0);
-            int tx = int((vertTexCoords.x / vertTexCoords.z) * size.x) % size.x;
-            int ty = int((vertTexCoords.y / vertTexCoords.z) * size.y) % size.y;
-            vec4 texel = TEXELFETCH(tex0, ivec2(tx, ty), 0);
+            ivec2 size = TEXTURESIZE(texPages, 0).xy;
+            int tx = int(uv.x * size.x) % size.x;
+            int ty = int(uv.y * size.y) % size.y;
+            vec4 texel = TEXELFETCH(texPages, ivec3(tx, ty, int(layer)), 0);
             if (texel.a == 0.0) {
                 discard;
             }
         }
 #endif
 
-        vec4 texColor = TEXTURE(tex0, vertTexCoords.xy / vertTexCoords.z);
+        vec4 texColor = layer < 0.0
+            ? TEXTURE(texEnvMap, uv)
+            : TEXTUREARRAY(texPages, vec3(uv, layer));
         if (alphaThreshold >= 0.0 && texColor.a <= alphaThreshold) {
             discard;
         }
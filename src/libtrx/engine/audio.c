@@ -1,5 +1,6 @@
 #include "audio_internal.h"
 
+#include "engine/recorder.h"
 #include "log.h"
 #include "memory.h"
 
@@ -9,42 +10,142 @@
 #include <stdint.h>
 #include <string.h>
 
+#define MIN_BUFFER_SAMPLES (AUDIO_SAMPLES / 2)
+// Seconds between two buffer size checks in the adaptive mode.
+#define ADAPT_INTERVAL 2.0
+// Seconds without any high load before the buffer is made smaller again.
+#define ADAPT_SHRINK_DELAY 30.0
+// Callbacks in this load bucket or above (75% of the buffer period or more)
+// are a sign that the buffer is too small.
+#define ADAPT_HIGH_LOAD_BUCKET 4
+// Share of the callbacks in a check interval that must be under high load or
+// underrun for the interval to count as overloaded.
+#define ADAPT_HIGH_LOAD_SHARE 0.05
+// Overloaded check intervals in a row before the buffer is made bigger, so
+// that a single hitch does not grow it.
+#define ADAPT_GROW_CHECKS 3
+
 SDL_AudioDeviceID g_AudioDeviceID = 0;
 static int32_t m_RefCount = 0;
+static int32_t m_BufferSamples = AUDIO_SAMPLES;
 static size_t m_MixBufferCapacity = 0;
 static float *m_MixBuffer = NULL;
 static Uint8 m_Silence = 0;
 
+// Upper bounds of the callback load histogram buckets, as a fraction of the
+// buffer period; the last bucket holds everything above.
+static const double m_LoadBucketLimits[AUDIO_LOAD_BUCKETS - 1] = {
+    0.1, 0.25, 0.5, 0.75, 1.0,
+};
+
+// Only touched by the mixer callback, or while the device is closed.
+static struct {
+    AUDIO_STATS stats;
+    double total_callback_time;
+    double total_stream_time;
+    Uint64 last_start;
+} m_Mixer = {};
+
+// The mixer publishes its stats here after every callback. This is a
+// seqlock: the sequence is odd while the stats are being copied, so the game
+// thread can detect torn reads and retry without ever blocking the mixer.
+static struct {
+    SDL_atomic_t sequence;
+    AUDIO_STATS stats;
+} m_Published = {};
+
+static struct {
+    bool enabled;
+    Uint64 last_check;
+    Uint64 last_high_load;
+    int32_t high_load_checks;
+    AUDIO_STATS last_stats;
+} m_Adaptive = {};
+
+static void M_UpdateStats(
+    Uint64 start, Uint64 streams_end, Uint64 end, int32_t active_samples,
+    int32_t active_streams);
+static void M_PublishStats(void);
 static void M_MixerCallback(void *userdata, Uint8 *stream_data, int32_t len);
+static bool M_OpenDevice(int32_t samples);
+static void M_CloseDevice(void);
+static void M_ResizeBuffer(int32_t samples);
+
+static void M_UpdateStats(
+    const Uint64 start, const Uint64 streams_end, const Uint64 end,
+    const int32_t active_samples, const int32_t active_streams)
+{
+    const double ticks_per_ms = SDL_GetPerformanceFrequency() / 1000.0;
+    const double callback_time = (end - start) / ticks_per_ms;
+    const double stream_time = (streams_end - start) / ticks_per_ms;
+
+    AUDIO_STATS *const stats = &m_Mixer.stats;
+    const double period = stats->buffer_period;
+    // A callback that runs too long or starts too late leaves the device
+    // without data.
+    if (callback_time > period
+        || (m_Mixer.last_start != 0
+            && (start - m_Mixer.last_start) / ticks_per_ms > period * 2.0)) {
+        stats->underruns++;
+    }
+    m_Mixer.last_start = start;
+
+    stats->callbacks++;
+    stats->active_samples = active_samples;
+    stats->active_streams = active_streams;
+    stats->last_callback_time = callback_time;
+    if (callback_time > stats->max_callback_time) {
+        stats->max_callback_time = callback_time;
+    }
+    m_Mixer.total_callback_time += callback_time;
+    m_Mixer.total_stream_time += stream_time;
+    stats->avg_callback_time = m_Mixer.total_callback_time / stats->callbacks;
+    stats->avg_stream_time = m_Mixer.total_stream_time / stats->callbacks;
+    stats->avg_load = stats->avg_callback_time / period;
+    stats->max_load = stats->max_callback_time / period;
+
+    const double load = callback_time / period;
+    int32_t bucket = 0;
+    while (bucket < AUDIO_LOAD_BUCKETS - 1
+           && load >= m_LoadBucketLimits[bucket]) {
+        bucket++;
+    }
+    stats->load_histogram[bucket]++;
+
+    M_PublishStats();
+}
+
+static void M_PublishStats(void)
+{
+    SDL_AtomicAdd(&m_Published.sequence, 1);
+    SDL_MemoryBarrierRelease();
+    m_Published.stats = m_Mixer.stats;
+    SDL_MemoryBarrierRelease();
+    SDL_AtomicAdd(&m_Published.sequence, 1);
+}
 
 static void M_MixerCallback(void *userdata, Uint8 *stream_data, int32_t len)
 {
+    const Uint64 start = SDL_GetPerformanceCounter();
     memset(m_MixBuffer, m_Silence, len);
-    Audio_Stream_Mix(m_MixBuffer, len);
-    Audio_Sample_Mix(m_MixBuffer, len);
+    const int32_t active_streams = Audio_Stream_Mix(m_MixBuffer, len);
+    const Uint64 streams_end = SDL_GetPerformanceCounter();
+    const int32_t active_samples = Audio_Sample_Mix(m_MixBuffer, len);
+    Recorder_PushAudio(m_MixBuffer, len / sizeof(float));
     memcpy(stream_data, m_MixBuffer, len);
+    M_UpdateStats(
+        start, streams_end, SDL_GetPerformanceCounter(), active_samples,
+        active_streams);
 }
 
-bool Audio_Init(void)
+static bool M_OpenDevice(const int32_t samples)
 {
-    m_RefCount++;
-    if (g_AudioDeviceID) {
-        // already initialized
-        return true;
-    }
-
-    int32_t result = SDL_Init(SDL_INIT_AUDIO);
-    if (result < 0) {
-        LOG_ERROR("Error while calling SDL_Init: 0x%lx", result);
-        return false;
-    }
-
     SDL_AudioSpec desired;
     SDL_memset(&desired, 0, sizeof(desired));
     desired.freq = AUDIO_WORKING_RATE;
     desired.format = AUDIO_WORKING_FORMAT;
     desired.channels = AUDIO_WORKING_CHANNELS;
-    desired.samples = AUDIO_SAMPLES;
+    desired.samples = samples;
     desired.callback = M_MixerCallback;
     desired.userdata = NULL;
 
@@ -59,10 +160,65 @@ bool Audio_Init(void)
     m_Silence = desired.silence;
     m_MixBufferCapacity = desired.samples * desired.channels
         * SDL_AUDIO_BITSIZE(desired.format) / 8;
+    m_MixBuffer = Memory_Realloc(m_MixBuffer, m_MixBufferCapacity);
 
-    m_MixBuffer = Memory_Alloc(m_MixBufferCapacity);
+    // The stats describe the current device only, so that the adaptive mode
+    // does not judge the new buffer size by the old one's history.
+    m_BufferSamples = samples;
+    memset(&m_Mixer, 0, sizeof(m_Mixer));
+    m_Mixer.stats.buffer_samples = samples;
+    m_Mixer.stats.buffer_period = samples * 1000.0 / AUDIO_WORKING_RATE;
+    M_PublishStats();
+    m_Adaptive.last_stats = m_Mixer.stats;
+    m_Adaptive.high_load_checks = 0;
 
     SDL_PauseAudioDevice(g_AudioDeviceID, 0);
+    return true;
+}
+
+static void M_CloseDevice(void)
+{
+    if (g_AudioDeviceID) {
+        SDL_PauseAudioDevice(g_AudioDeviceID, 1);
+        SDL_CloseAudioDevice(g_AudioDeviceID);
+        g_AudioDeviceID = 0;
+    }
+}
+
+static void M_ResizeBuffer(const int32_t samples)
+{
+    // Playing sounds live outside of the device, so they carry on from
+    // where they were once it is open again.
+    const int32_t old_samples = m_BufferSamples;
+    M_CloseDevice();
+    if (M_OpenDevice(samples)) {
+        LOG_INFO("Audio buffer resized to %d samples", m_BufferSamples);
+        return;
+    }
+    if (!M_OpenDevice(old_samples)) {
+        // Stop resizing so that the device is not reopened every check.
+        LOG_ERROR("Failed to reopen the audio device, audio is disabled");
+        m_Adaptive.enabled = false;
+    }
+}
+
+bool Audio_Init(void)
+{
+    m_RefCount++;
+    if (g_AudioDeviceID) {
+        // already initialized
+        return true;
+    }
+
+    int32_t result = SDL_Init(SDL_INIT_AUDIO);
+    if (result < 0) {
+        LOG_ERROR("Error while calling SDL_Init: 0x%lx", result);
+        return false;
+    }
+
+    if (!M_OpenDevice(AUDIO_SAMPLES)) {
+        return false;
+    }
 
     Audio_Sample_Init();
     Audio_Stream_Init();
@@ -77,16 +233,12 @@ bool Audio_Shutdown(void)
         return false;
     }
 
-    if (g_AudioDeviceID) {
-        SDL_PauseAudioDevice(g_AudioDeviceID, 1);
-        SDL_CloseAudioDevice(g_AudioDeviceID);
-        g_AudioDeviceID = 0;
-    }
-
+    M_CloseDevice();
     Memory_FreePointer(&m_MixBuffer);
 
     Audio_Sample_Shutdown();
     Audio_Stream_Shutdown();
+    Audio_PCMCache_Shutdown();
     return true;
 }
 
@@ -126,3 +278,80 @@ int32_t Audio_GetSDLAudioFormat(const enum AVSampleFormat sample_fmt)
     }
     // clang-format on
 }
+
+void Audio_Update(void)
+{
+    if (!m_Adaptive.enabled || !g_AudioDeviceID) {
+        return;
+    }
+
+    const Uint64 now = SDL_GetPerformanceCounter();
+    const Uint64 freq = SDL_GetPerformanceFrequency();
+    if (now - m_Adaptive.last_check < ADAPT_INTERVAL * freq) {
+        return;
+    }
+    m_Adaptive.last_check = now;
+
+    const AUDIO_STATS stats = Audio_GetStats();
+    const AUDIO_STATS *const last_stats = &m_Adaptive.last_stats;
+    const int32_t callbacks = stats.callbacks - last_stats->callbacks;
+    int32_t high_load_callbacks = stats.underruns - last_stats->underruns;
+    for (int32_t i = ADAPT_HIGH_LOAD_BUCKET; i < AUDIO_LOAD_BUCKETS; i++) {
+        high_load_callbacks +=
+            stats.load_histogram[i] - last_stats->load_histogram[i];
+    }
+    m_Adaptive.last_stats = stats;
+
+    const bool is_high_load = callbacks > 0
+        && high_load_callbacks >= callbacks * ADAPT_HIGH_LOAD_SHARE;
+    if (is_high_load) {
+        m_Adaptive.last_high_load = now;
+        m_Adaptive.high_load_checks++;
+        if (m_Adaptive.high_load_checks >= ADAPT_GROW_CHECKS
+            && m_BufferSamples < AUDIO_MAX_BUFFER_SAMPLES) {
+            M_ResizeBuffer(m_BufferSamples * 2);
+        }
+    } else if (
+        now - m_Adaptive.last_high_load > ADAPT_SHRINK_DELAY * freq
+        && m_BufferSamples > MIN_BUFFER_SAMPLES) {
+        // wait for another quiet period before shrinking again
+        m_Adaptive.last_high_load = now;
+        M_ResizeBuffer(m_BufferSamples / 2);
+    } else {
+        m_Adaptive.high_load_checks = 0;
+    }
+}
+
+void Audio_SetAdaptiveBuffer(const bool enable)
+{
+    if (enable == m_Adaptive.enabled) {
+        return;
+    }
+    m_Adaptive.enabled = enable;
+    m_Adaptive.last_check = SDL_GetPerformanceCounter();
+    m_Adaptive.last_high_load = m_Adaptive.last_check;
+    m_Adaptive.last_stats = Audio_GetStats();
+    m_Adaptive.high_load_checks = 0;
+    if (!enable && g_AudioDeviceID && m_BufferSamples != AUDIO_SAMPLES) {
+        M_ResizeBuffer(AUDIO_SAMPLES);
+    }
+}
+
+bool Audio_IsAdaptiveBuffer(void)
+{
+    return m_Adaptive.enabled;
+}
+
+AUDIO_STATS Audio_GetStats(void)
+{
+    AUDIO_STATS stats;
+    int32_t sequence;
+    do {
+        sequence = SDL_AtomicGet(&m_Published.sequence);
+        SDL_MemoryBarrierAcquire();
+        stats = m_Published.stats;
+        SDL_MemoryBarrierAcquire();
+    } while ((sequence & 1) != 0
+             || sequence != SDL_AtomicGet(&m_Published.sequence));
+    return stats;
+}
@@ -8,6 +8,8 @@
 #define AUDIO_WORKING_RATE 44100
 #define AUDIO_WORKING_FORMAT AUDIO_F32
 #define AUDIO_SAMPLES 500
+// The device buffer can grow up to this size in the adaptive mode.
+#define AUDIO_MAX_BUFFER_SAMPLES (AUDIO_SAMPLES * 8)
 #define AUDIO_WORKING_CHANNELS 2
 
 extern SDL_AudioDeviceID g_AudioDeviceID;
@@ -16,10 +18,55 @@ int32_t Audio_GetAVChannelLayout(int32_t sample_fmt);
 int32_t Audio_GetAVAudioFormat(int32_t sample_fmt);
 int32_t Audio_GetSDLAudioFormat(enum AVSampleFormat sample_fmt);
 
+typedef struct {
+    float *data;
+    size_t size;
+    int32_t channels;
+    int32_t num_samples;
+} AUDIO_PCM;
+
+// Keeps converted sample data across level loads, keyed by a hash of the
+// original sample file. Buffers are reference counted; ones that are no
+// longer used are kept until the cache runs over its memory budget.
+uint64_t Audio_PCMCache_Hash(const char *data, size_t size);
+bool Audio_PCMCache_Acquire(uint64_t key, AUDIO_PCM *out_pcm);
+// Takes ownership of the buffer and acquires it. Returns the cached buffer,
+// which differs from the given one if the key was inserted in the meantime.
+AUDIO_PCM Audio_PCMCache_Insert(uint64_t key, AUDIO_PCM pcm);
+void Audio_PCMCache_Release(uint64_t key);
+// Writes buffers that are not in the disk cache yet, if it is enabled.
+void Audio_PCMCache_Flush(void);
+void Audio_PCMCache_Shutdown(void);
+
+typedef struct {
+    double timestamp;
+    int64_t pos;
+} AUDIO_SEEK_POINT;
+
+// Maps timestamps of a stream file to packet positions, so that streams can
+// seek by bytes instead of relying on the demuxer, which is slow and
+// inaccurate for long files such as the single file CD audio. The index of a
+// file is built by reading through all of its packets on the stream prefetch
+// thread, and is kept in the disk cache.
+void Audio_SeekIndex_Init(void);
+void Audio_SeekIndex_Shutdown(void);
+// Reads or builds the index of the file unless it already exists. This can
+// take a long time, so it must only be called from the prefetch thread;
+// leaves the read position of the format context undefined.
+void Audio_SeekIndex_Build(
+    const char *path, AVFormatContext *format_ctx, int32_t stream_index);
+bool Audio_SeekIndex_IsBuilt(const char *path);
+// Finds the last indexed packet that starts a bit before the timestamp, to
+// give the decoder some data to prime itself with. Returns false if the file
+// is not indexed. Can be called from any thread, and never reads the file.
+bool Audio_SeekIndex_Find(
+    const char *path, double timestamp, AUDIO_SEEK_POINT *out_point);
+
 void Audio_Sample_Init(void);
 void Audio_Sample_Shutdown(void);
-void Audio_Sample_Mix(float *dst_buffer, size_t len);
+// Both return the number of sounds that were mixed.
+int32_t Audio_Sample_Mix(float *dst_buffer, size_t len);
 
 void Audio_Stream_Init(void);
 void Audio_Stream_Shutdown(void);
-void Audio_Stream_Mix(float *dst_buffer, size_t len);
+int32_t Audio_Stream_Mix(float *dst_buffer, size_t len);
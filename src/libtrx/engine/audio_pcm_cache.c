@@ -0,0 +1,260 @@
+#include "audio_internal.h"
+
+#include "debug.h"
+#include "filesystem.h"
+#include "hash_map.h"
+#include "log.h"
+#include "memory.h"
+
+#include <inttypes.h>
+#include <stdio.h>
+
+// Released buffers stay around until the cache outgrows this.
+#define BUDGET (64 * 1024 * 1024)
+#define DISK_DIR "cache"
+#define DISK_MAGIC 0x50585254 // 'TRXP'
+#define DISK_VERSION 1
+
+typedef struct {
+    uint64_t key;
+    AUDIO_PCM pcm;
+    int32_t ref_count;
+    uint32_t last_used;
+    bool is_on_disk;
+} M_ENTRY;
+
+static HASH_MAP *m_Entries = NULL;
+static size_t m_TotalSize = 0;
+static uint32_t m_UseCounter = 0;
+static bool m_UseDisk = false;
+static struct {
+    int32_t hits;
+    int32_t disk_hits;
+    int32_t misses;
+    int32_t evictions;
+} m_Stats = {};
+
+static char *M_GetDiskPath(uint64_t key);
+static bool M_ReadFromDisk(uint64_t key, AUDIO_PCM *out_pcm);
+static void M_WriteToDisk(M_ENTRY *entry);
+static M_ENTRY *M_Insert(uint64_t key, AUDIO_PCM pcm, bool is_on_disk);
+static void M_Evict(void);
+
+static char *M_GetDiskPath(const uint64_t key)
+{
+    const char *const fmt = "%s/%016" PRIx64 ".pcm";
+    const size_t size = snprintf(NULL, 0, fmt, DISK_DIR, key) + 1;
+    char *const path = Memory_Alloc(size);
+    snprintf(path, size, fmt, DISK_DIR, key);
+    return path;
+}
+
+static bool M_ReadFromDisk(const uint64_t key, AUDIO_PCM *const out_pcm)
+{
+    if (!m_UseDisk) {
+        return false;
+    }
+
+    char *path = M_GetDiskPath(key);
+    MYFILE *const fp = File_Open(path, FILE_OPEN_READ);
+    Memory_FreePointer(&path);
+    if (fp == NULL) {
+        return false;
+    }
+
+    bool result = false;
+    const size_t header_size = sizeof(uint32_t) * 5;
+    if (File_Size(fp) < header_size || File_ReadU32(fp) != DISK_MAGIC
+        || File_ReadU32(fp) != DISK_VERSION
+        || File_ReadU32(fp) != AUDIO_WORKING_RATE) {
+        goto finish;
+    }
+
+    const int32_t channels = File_ReadS32(fp);
+    const int32_t num_samples = File_ReadS32(fp);
+    const size_t size = File_Size(fp) - header_size;
+    if (channels <= 0 || num_samples < 0
+        || size != num_samples * sizeof(float)) {
+        goto finish;
+    }
+
+    out_pcm->data = Memory_Alloc(size);
+    out_pcm->size = size;
+    out_pcm->channels = channels;
+    out_pcm->num_samples = num_samples;
+    File_ReadData(fp, out_pcm->data, size);
+    result = true;
+
+finish:
+    File_Close(fp);
+    return result;
+}
+
+static void M_WriteToDisk(M_ENTRY *const entry)
+{
+    if (!m_UseDisk || entry->is_on_disk) {
+        return;
+    }
+
+    char *path = M_GetDiskPath(entry->key);
+    MYFILE *const fp = File_Open(path, FILE_OPEN_WRITE);
+    if (fp == NULL) {
+        LOG_ERROR("Cannot write sample cache file %s", path);
+    } else {
+        File_WriteU32(fp, DISK_MAGIC);
+        File_WriteU32(fp, DISK_VERSION);
+        File_WriteU32(fp, AUDIO_WORKING_RATE);
+        File_WriteS32(fp, entry->pcm.channels);
+        File_WriteS32(fp, entry->pcm.num_samples);
+        File_WriteData(fp, entry->pcm.data, entry->pcm.size);
+        File_Close(fp);
+    }
+    Memory_FreePointer(&path);
+    // do not retry failed writes for every flush
+    entry->is_on_disk = true;
+}
+
+static M_ENTRY *M_Insert(
+    const uint64_t key, const AUDIO_PCM pcm, const bool is_on_disk)
+{
+    if (m_Entries == NULL) {
+        m_Entries = HashMap_Create(HMK_INT, sizeof(M_ENTRY));
+    }
+    const M_ENTRY entry = {
+        .key = key,
+        .pcm = pcm,
+        .ref_count = 0,
+        .last_used = ++m_UseCounter,
+        .is_on_disk = is_on_disk,
+    };
+    m_TotalSize += pcm.size;
+    return HashMap_InsertInt(m_Entries, key, &entry);
+}
+
+static void M_Evict(void)
+{
+    while (m_TotalSize > BUDGET) {
+        M_ENTRY *victim = NULL;
+        int32_t iter = 0;
+        M_ENTRY *entry;
+        while ((entry = HashMap_Iterate(m_Entries, &iter)) != NULL) {
+            if (entry->ref_count == 0
+                && (victim == NULL || entry->last_used < victim->last_used)) {
+                victim = entry;
+            }
+        }
+        if (victim == NULL) {
+            // everything left is used by the current level
+            break;
+        }
+
+        M_WriteToDisk(victim);
+        m_TotalSize -= victim->pcm.size;
+        Memory_Free(victim->pcm.data);
+        m_Stats.evictions++;
+        HashMap_RemoveInt(m_Entries, victim->key);
+    }
+}
+
+uint64_t Audio_PCMCache_Hash(const char *const data, const size_t size)
+{
+    // FNV-1a, seeded with the size
+    uint64_t hash = 14695981039346656037ULL ^ size;
+    for (size_t i = 0; i < size; i++) {
+        hash ^= (uint8_t)data[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+bool Audio_PCMCache_Acquire(const uint64_t key, AUDIO_PCM *const out_pcm)
+{
+    M_ENTRY *entry =
+        m_Entries != NULL ? HashMap_FindInt(m_Entries, key) : NULL;
+    if (entry != NULL) {
+        m_Stats.hits++;
+    } else {
+        AUDIO_PCM pcm;
+        if (!M_ReadFromDisk(key, &pcm)) {
+            m_Stats.misses++;
+            return false;
+        }
+        m_Stats.disk_hits++;
+        entry = M_Insert(key, pcm, true);
+    }
+
+    entry->ref_count++;
+    entry->last_used = ++m_UseCounter;
+    *out_pcm = entry->pcm;
+    M_Evict();
+    return true;
+}
+
+AUDIO_PCM Audio_PCMCache_Insert(const uint64_t key, const AUDIO_PCM pcm)
+{
+    M_ENTRY *entry =
+        m_Entries != NULL ? HashMap_FindInt(m_Entries, key) : NULL;
+    if (entry != NULL) {
+        // another sample with the same contents was converted first
+        Memory_Free(pcm.data);
+    } else {
+        entry = M_Insert(key, pcm, false);
+    }
+    // This runs right before a sound starts playing, so leave the eviction
+    // and its disk writes to the next acquire or release.
+    entry->ref_count++;
+    return entry->pcm;
+}
+
+void Audio_PCMCache_Release(const uint64_t key)
+{
+    M_ENTRY *const entry =
+        m_Entries != NULL ? HashMap_FindInt(m_Entries, key) : NULL;
+    if (entry == NULL) {
+        return;
+    }
+    ASSERT(entry->ref_count > 0);
+    entry->ref_count--;
+    M_Evict();
+}
+
+void Audio_PCMCache_Flush(void)
+{
+    if (m_Entries == NULL || !m_UseDisk) {
+        return;
+    }
+    int32_t iter = 0;
+    M_ENTRY *entry;
+    while ((entry = HashMap_Iterate(m_Entries, &iter)) != NULL) {
+        M_WriteToDisk(entry);
+    }
+}
+
+void Audio_PCMCache_Shutdown(void)
+{
+    if (m_Entries == NULL) {
+        return;
+    }
+
+    Audio_PCMCache_Flush();
+    LOG_INFO(
+        "Sample cache: %d hits, %d disk hits, %d misses, %d evictions",
+        m_Stats.hits, m_Stats.disk_hits, m_Stats.misses, m_Stats.evictions);
+
+    int32_t iter = 0;
+    M_ENTRY *entry;
+    while ((entry = HashMap_Iterate(m_Entries, &iter)) != NULL) {
+        Memory_Free(entry->pcm.data);
+    }
+    HashMap_Free(m_Entries);
+    m_Entries = NULL;
+    m_TotalSize = 0;
+}
+
+void Audio_Sample_SetDiskCache(const bool enable)
+{
+    if (enable && !m_UseDisk) {
+        File_CreateDirectory(DISK_DIR);
+    }
+    m_UseDisk = enable;
+}
@@ -3,8 +3,11 @@
 #include "debug.h"
 #include "log.h"
 #include "memory.h"
+#include "utils.h"
 
+#include <SDL2/SDL_atomic.h>
 #include <SDL2/SDL_audio.h>
+#include <SDL2/SDL_timer.h>
 #include <errno.h>
 #include <libavcodec/avcodec.h>
 #include <libavcodec/codec.h>
@@ -24,10 +27,24 @@
 #include <string.h>
 #include <time.h>
 
+#ifndef M_PI
+    #define M_PI 3.14159265358979323846
+#endif
+
+// Must be a power of two.
+#define COMMAND_QUEUE_SIZE 4096
+// Low-pass filter cutoffs, in Hz.
+#define FILTER_DISTANT_CUTOFF 4000.0f
+#define FILTER_UNDERWATER_CUTOFF 1000.0f
+
 typedef struct {
     char *original_data;
     size_t original_size;
+    // content hash of the original data, used to share converted samples
+    // across level loads
+    uint64_t key;
 
+    // owned by the PCM cache
     float *sample_data;
     int32_t channels;
     int32_t num_samples;
@@ -48,8 +65,47 @@ typedef struct {
     float current_sample;
 
     AUDIO_SAMPLE *sample;
+    uint32_t generation;
+
+    // one-pole low-pass filter
+    float filter_coeff;
+    float filter_state;
 } AUDIO_SAMPLE_SOUND;
 
+// The game thread's view of a sound. The game does not touch the sounds
+// directly; it sends commands to the mixer instead, so that neither thread
+// waits for the other.
+typedef struct {
+    bool is_used;
+    bool is_playing;
+    // Tells apart the sounds that played in the same slot, so that a late
+    // notice about a finished sound does not end the next one.
+    uint32_t generation;
+} AUDIO_SAMPLE_VOICE;
+
+typedef enum {
+    AUDIO_COMMAND_PLAY,
+    AUDIO_COMMAND_CLOSE,
+    AUDIO_COMMAND_PAUSE,
+    AUDIO_COMMAND_UNPAUSE,
+    AUDIO_COMMAND_SET_VOLUME,
+    AUDIO_COMMAND_SET_PAN,
+    AUDIO_COMMAND_SET_PITCH,
+    AUDIO_COMMAND_SET_FILTER,
+} AUDIO_COMMAND_TYPE;
+
+typedef struct {
+    AUDIO_COMMAND_TYPE type;
+    int32_t sound_id;
+    uint32_t generation;
+    AUDIO_SAMPLE *sample;
+    int32_t volume;
+    int32_t pan;
+    float pitch;
+    float filter_coeff;
+    bool is_looped;
+} AUDIO_COMMAND;
+
 typedef struct {
     const char *data;
     const char *ptr;
@@ -60,12 +116,35 @@ typedef struct {
 static int32_t m_LoadedSamplesCount = 0;
 static AUDIO_SAMPLE m_LoadedSamples[AUDIO_MAX_SAMPLES] = {};
 static AUDIO_SAMPLE_SOUND m_Samples[AUDIO_MAX_ACTIVE_SAMPLES] = {};
+static AUDIO_SAMPLE_VOICE m_Voices[AUDIO_MAX_ACTIVE_SAMPLES] = {};
+static uint32_t m_Generation = 0;
+// Set by the mixer to the generation of sounds that finished on their own.
+static SDL_atomic_t m_FinishedGenerations[AUDIO_MAX_ACTIVE_SAMPLES] = {};
+
+// Single producer, single consumer ring buffer: only the game thread pushes
+// and moves the head, and only the mixer pops and moves the tail.
+static struct {
+    AUDIO_COMMAND commands[COMMAND_QUEUE_SIZE];
+    SDL_atomic_t head;
+    SDL_atomic_t tail;
+} m_Queue = {};
 
 static double M_DecibelToMultiplier(double db_gain);
 static bool M_RecalculateChannelVolumes(int32_t sound_id);
+static float M_GetFilterCoeff(float cutoff);
+static void M_MixSound(
+    AUDIO_SAMPLE_SOUND *sound, float *dst_buffer, int32_t samples_requested);
+static bool M_IsValidSound(int32_t sound_id);
+static bool M_IsVoiceUsed(int32_t sound_id);
+static void M_PushCommand(AUDIO_COMMAND command);
+static bool M_PopCommand(AUDIO_COMMAND *out_command);
+static void M_ApplyCommand(const AUDIO_COMMAND *command);
+static void M_ProcessCommands(void);
+static void M_SyncCommands(void);
 static int32_t M_ReadAVBuffer(void *opaque, uint8_t *dst, int32_t dst_size);
 static int64_t M_SeekAVBuffer(void *opaque, int64_t offset, int32_t whence);
 static bool M_Convert(const int32_t sample_id);
+static void M_ReleaseSample(AUDIO_SAMPLE *sample);
 
 static double M_DecibelToMultiplier(double db_gain)
 {
@@ -88,6 +167,176 @@ static bool M_RecalculateChannelVolumes(int32_t sound_id)
     return true;
 }
 
+static float M_GetFilterCoeff(const float cutoff)
+{
+    if (cutoff >= AUDIO_WORKING_RATE / 2.0f) {
+        // let the sound through unchanged
+        return 1.0f;
+    }
+    return 1.0f - expf(-2.0f * (float)M_PI * cutoff / AUDIO_WORKING_RATE);
+}
+
+static void M_MixSound(
+    AUDIO_SAMPLE_SOUND *const sound, float *const dst_buffer,
+    const int32_t samples_requested)
+{
+    float src_sample_idx = sound->current_sample;
+    const float *src_buffer = sound->sample->sample_data;
+    float *dst_ptr = dst_buffer;
+    // keep the filter state in a register for the duration of the loop
+    float filter_state = sound->filter_state;
+    const float filter_coeff = sound->filter_coeff;
+
+    while ((dst_ptr - dst_buffer) / AUDIO_WORKING_CHANNELS
+           < samples_requested) {
+
+        // because we handle 3d sound ourselves, downmix to mono
+        float src_sample = 0.0f;
+        for (int32_t i = 0; i < sound->sample->channels; i++) {
+            src_sample += src_buffer
+                [(int32_t)src_sample_idx * sound->sample->channels + i];
+        }
+        src_sample /= (float)sound->sample->channels;
+
+        // filtering the mono signal before panning costs a single
+        // multiply-add per frame
+        filter_state += filter_coeff * (src_sample - filter_state);
+
+        *dst_ptr++ += filter_state * sound->volume_l;
+        *dst_ptr++ += filter_state * sound->volume_r;
+        src_sample_idx += sound->pitch;
+
+        if ((int32_t)src_sample_idx >= sound->sample->num_samples) {
+            if (sound->is_looped) {
+                src_sample_idx = 0.0f;
+            } else {
+                break;
+            }
+        }
+    }
+
+    sound->current_sample = src_sample_idx;
+    // flush tiny values, as denormals slow down the math considerably
+    sound->filter_state = fabsf(filter_state) < 1.0e-15f ? 0.0f : filter_state;
+}
+
+static bool M_IsValidSound(const int32_t sound_id)
+{
+    return g_AudioDeviceID && sound_id >= 0
+        && sound_id < AUDIO_MAX_ACTIVE_SAMPLES;
+}
+
+static bool M_IsVoiceUsed(const int32_t sound_id)
+{
+    AUDIO_SAMPLE_VOICE *const voice = &m_Voices[sound_id];
+    if (voice->is_used
+        && (uint32_t)SDL_AtomicGet(&m_FinishedGenerations[sound_id])
+            == voice->generation) {
+        voice->is_used = false;
+        voice->is_playing = false;
+    }
+    return voice->is_used;
+}
+
+static void M_PushCommand(const AUDIO_COMMAND command)
+{
+    const uint32_t head = SDL_AtomicGet(&m_Queue.head);
+    if (head - (uint32_t)SDL_AtomicGet(&m_Queue.tail) >= COMMAND_QUEUE_SIZE) {
+        // The mixer fell behind, or is not running. This should be rare, so
+        // just make room while holding the mixer off.
+        LOG_DEBUG("Audio command queue is full");
+        M_SyncCommands();
+    }
+    m_Queue.commands[head & (COMMAND_QUEUE_SIZE - 1)] = command;
+    // publish the command before moving the head past it
+    SDL_MemoryBarrierRelease();
+    SDL_AtomicSet(&m_Queue.head, head + 1);
+}
+
+static bool M_PopCommand(AUDIO_COMMAND *const out_command)
+{
+    const uint32_t tail = SDL_AtomicGet(&m_Queue.tail);
+    if (tail == (uint32_t)SDL_AtomicGet(&m_Queue.head)) {
+        return false;
+    }
+    SDL_MemoryBarrierAcquire();
+    *out_command = m_Queue.commands[tail & (COMMAND_QUEUE_SIZE - 1)];
+    SDL_AtomicSet(&m_Queue.tail, tail + 1);
+    return true;
+}
+
+static void M_ApplyCommand(const AUDIO_COMMAND *const command)
+{
+    AUDIO_SAMPLE_SOUND *const sound = &m_Samples[command->sound_id];
+    switch (command->type) {
+    case AUDIO_COMMAND_PLAY:
+        sound->is_used = true;
+        sound->is_playing = true;
+        sound->volume = command->volume;
+        sound->pitch = command->pitch;
+        sound->pan = command->pan;
+        sound->is_looped = command->is_looped;
+        sound->current_sample = 0.0f;
+        sound->sample = command->sample;
+        sound->generation = command->generation;
+        sound->filter_coeff = 1.0f;
+        sound->filter_state = 0.0f;
+        break;
+
+    case AUDIO_COMMAND_CLOSE:
+        sound->is_used = false;
+        sound->is_playing = false;
+        return;
+
+    case AUDIO_COMMAND_PAUSE:
+        sound->is_playing = false;
+        return;
+
+    case AUDIO_COMMAND_UNPAUSE:
+        sound->is_playing = sound->is_used;
+        return;
+
+    case AUDIO_COMMAND_SET_VOLUME:
+        sound->volume = command->volume;
+        break;
+
+    case AUDIO_COMMAND_SET_PAN:
+        sound->pan = command->pan;
+        break;
+
+    case AUDIO_COMMAND_SET_PITCH:
+        sound->pitch = command->pitch;
+        break;
+
+    case AUDIO_COMMAND_SET_FILTER:
+        sound->filter_coeff = command->filter_coeff;
+        return;
+    }
+    M_RecalculateChannelVolumes(command->sound_id);
+}
+
+// Only the mixer, or a thread that holds the mixer off, may call this.
+static void M_ProcessCommands(void)
+{
+    AUDIO_COMMAND command;
+    while (M_PopCommand(&command)) {
+        M_ApplyCommand(&command);
+    }
+}
+
+// Applies the pending commands right away, for when the game is about to
+// free data that the mixer may still use.
+static void M_SyncCommands(void)
+{
+    if (g_AudioDeviceID) {
+        SDL_LockAudioDevice(g_AudioDeviceID);
+        M_ProcessCommands();
+        SDL_UnlockAudioDevice(g_AudioDeviceID);
+    } else {
+        M_ProcessCommands();
+    }
+}
+
 static int32_t M_ReadAVBuffer(void *opaque, uint8_t *dst, int32_t dst_size)
 {
     ASSERT(opaque != NULL);
@@ -352,10 +601,19 @@ static bool M_Convert(const int32_t sample_id)
     }
 
     int32_t sample_format_bytes = av_get_bytes_per_sample(swr.dst_format);
-    sample->num_samples =
-        working_buffer_size / sample_format_bytes / swr.dst_channels;
-    sample->channels = swr.src_channels;
-    sample->sample_data = working_buffer;
+    const AUDIO_PCM pcm = Audio_PCMCache_Insert(
+        sample->key,
+        (AUDIO_PCM) {
+            .data = working_buffer,
+            .size = working_buffer_size,
+            .channels = swr.src_channels,
+            .num_samples =
+                working_buffer_size / sample_format_bytes / swr.dst_channels,
+        });
+    working_buffer = NULL;
+    sample->num_samples = pcm.num_samples;
+    sample->channels = pcm.channels;
+    sample->sample_data = pcm.data;
     result = true;
 
     const clock_t time_end = clock();
@@ -412,6 +670,16 @@ cleanup:
     return result;
 }
 
+static void M_ReleaseSample(AUDIO_SAMPLE *const sample)
+{
+    if (sample->sample_data != NULL) {
+        Audio_PCMCache_Release(sample->key);
+        sample->sample_data = NULL;
+    }
+    Memory_FreePointer(&sample->original_data);
+    sample->original_size = 0;
+}
+
 void Audio_Sample_Init(void)
 {
     for (int32_t sound_id = 0; sound_id < AUDIO_MAX_ACTIVE_SAMPLES;
@@ -424,7 +692,14 @@ void Audio_Sample_Init(void)
         sound->pan = 0.0f;
         sound->current_sample = 0.0f;
         sound->sample = NULL;
+        sound->generation = 0;
+        sound->filter_coeff = 1.0f;
+        sound->filter_state = 0.0f;
+        m_Voices[sound_id] = (AUDIO_SAMPLE_VOICE) {};
+        SDL_AtomicSet(&m_FinishedGenerations[sound_id], 0);
     }
+    SDL_AtomicSet(&m_Queue.head, 0);
+    SDL_AtomicSet(&m_Queue.tail, 0);
 }
 
 void Audio_Sample_Shutdown(void)
@@ -455,8 +730,8 @@ bool Audio_Sample_Unload(const int32_t sample_id)
         LOG_ERROR("Sample %d is already unloaded", sample_id);
         return false;
     }
-    Memory_FreePointer(&sample->sample_data);
-    Memory_FreePointer(&sample->original_data);
+    M_SyncCommands();
+    M_ReleaseSample(sample);
     m_LoadedSamplesCount--;
     return true;
 }
@@ -468,12 +743,12 @@ bool Audio_Sample_UnloadAll(void)
         return false;
     }
 
+    M_SyncCommands();
     m_LoadedSamplesCount = 0;
     for (int32_t i = 0; i < AUDIO_MAX_SAMPLES; i++) {
-        AUDIO_SAMPLE *const sample = &m_LoadedSamples[i];
-        Memory_FreePointer(&sample->sample_data);
-        Memory_FreePointer(&sample->original_data);
+        M_ReleaseSample(&m_LoadedSamples[i]);
     }
+    Audio_PCMCache_Flush();
     return true;
 }
 
@@ -493,16 +768,26 @@ bool Audio_Sample_LoadSingle(
     }
 
     AUDIO_SAMPLE *const sample = &m_LoadedSamples[sample_id];
-    if (sample->original_data != NULL) {
+    if (sample->original_data != NULL || sample->sample_data != NULL) {
         LOG_ERROR(
             "Sample %d is already loaded (trying to overwrite with %d bytes)",
             sample_id, size);
         return false;
     }
 
-    sample->original_data = Memory_Alloc(size);
-    sample->original_size = size;
-    memcpy(sample->original_data, data, size);
+    // A sample that was converted before, eg. when restarting a level, can be
+    // used right away and does not need its original data.
+    sample->key = Audio_PCMCache_Hash(data, size);
+    AUDIO_PCM pcm;
+    if (Audio_PCMCache_Acquire(sample->key, &pcm)) {
+        sample->sample_data = pcm.data;
+        sample->channels = pcm.channels;
+        sample->num_samples = pcm.num_samples;
+    } else {
+        sample->original_data = Memory_Alloc(size);
+        sample->original_size = size;
+        memcpy(sample->original_data, data, size);
+    }
     m_LoadedSamplesCount++;
     return true;
 }
@@ -544,61 +829,63 @@ int32_t Audio_Sample_Play(
         return AUDIO_NO_SOUND;
     }
 
-    int32_t result = AUDIO_NO_SOUND;
-
-    SDL_LockAudioDevice(g_AudioDeviceID);
     for (int32_t sound_id = 0; sound_id < AUDIO_MAX_ACTIVE_SAMPLES;
          sound_id++) {
-        AUDIO_SAMPLE_SOUND *sound = &m_Samples[sound_id];
-        if (sound->is_used) {
+        if (M_IsVoiceUsed(sound_id)) {
             continue;
         }
 
         M_Convert(sample_id);
 
-        sound->is_used = true;
-        sound->is_playing = true;
-        sound->volume = volume;
-        sound->pitch = pitch;
-        sound->pan = pan;
-        sound->is_looped = is_looped;
-        sound->current_sample = 0.0f;
-        sound->sample = &m_LoadedSamples[sample_id];
-
-        M_RecalculateChannelVolumes(sound_id);
-
-        result = sound_id;
-        break;
-    }
-    SDL_UnlockAudioDevice(g_AudioDeviceID);
+        m_Generation++;
+        if (m_Generation == 0) {
+            // zero means no sound has finished yet
+            m_Generation++;
+        }
 
-    if (result == AUDIO_NO_SOUND) {
-        LOG_ERROR("All sample buffers are used!");
+        AUDIO_SAMPLE_VOICE *const voice = &m_Voices[sound_id];
+        voice->is_used = true;
+        voice->is_playing = true;
+        voice->generation = m_Generation;
+
+        M_PushCommand((AUDIO_COMMAND) {
+            .type = AUDIO_COMMAND_PLAY,
+            .sound_id = sound_id,
+            .generation = m_Generation,
+            .sample = &m_LoadedSamples[sample_id],
+            .volume = volume,
+            .pitch = pitch,
+            .pan = pan,
+            .is_looped = is_looped,
+        });
+        return sound_id;
     }
 
-    return result;
+    LOG_ERROR("All sample buffers are used!");
+    return AUDIO_NO_SOUND;
 }
 
 bool Audio_Sample_IsPlaying(int32_t sound_id)
 {
-    if (!g_AudioDeviceID || sound_id < 0
-        || sound_id >= AUDIO_MAX_ACTIVE_SAMPLES) {
+    if (!M_IsValidSound(sound_id)) {
         return false;
     }
 
-    return m_Samples[sound_id].is_playing;
+    return M_IsVoiceUsed(sound_id) && m_Voices[sound_id].is_playing;
 }
 
 bool Audio_Sample_Pause(int32_t sound_id)
 {
-    if (!g_AudioDeviceID) {
+    if (!M_IsValidSound(sound_id)) {
         return false;
     }
 
-    if (m_Samples[sound_id].is_playing) {
-        SDL_LockAudioDevice(g_AudioDeviceID);
-        m_Samples[sound_id].is_playing = false;
-        SDL_UnlockAudioDevice(g_AudioDeviceID);
+    if (M_IsVoiceUsed(sound_id) && m_Voices[sound_id].is_playing) {
+        m_Voices[sound_id].is_playing = false;
+        M_PushCommand((AUDIO_COMMAND) {
+            .type = AUDIO_COMMAND_PAUSE,
+            .sound_id = sound_id,
+        });
     }
 
     return true;
@@ -612,9 +899,7 @@ bool Audio_Sample_PauseAll(void)
 
     for (int32_t sound_id = 0; sound_id < AUDIO_MAX_ACTIVE_SAMPLES;
          sound_id++) {
-        if (m_Samples[sound_id].is_used) {
-            Audio_Sample_Pause(sound_id);
-        }
+        Audio_Sample_Pause(sound_id);
     }
 
     return true;
@@ -622,14 +907,16 @@ bool Audio_Sample_PauseAll(void)
 
 bool Audio_Sample_Unpause(int32_t sound_id)
 {
-    if (!g_AudioDeviceID) {
+    if (!M_IsValidSound(sound_id)) {
         return false;
     }
 
-    if (!m_Samples[sound_id].is_playing) {
-        SDL_LockAudioDevice(g_AudioDeviceID);
-        m_Samples[sound_id].is_playing = true;
-        SDL_UnlockAudioDevice(g_AudioDeviceID);
+    if (M_IsVoiceUsed(sound_id) && !m_Voices[sound_id].is_playing) {
+        m_Voices[sound_id].is_playing = true;
+        M_PushCommand((AUDIO_COMMAND) {
+            .type = AUDIO_COMMAND_UNPAUSE,
+            .sound_id = sound_id,
+        });
     }
 
     return true;
@@ -643,9 +930,7 @@ bool Audio_Sample_UnpauseAll(void)
 
     for (int32_t sound_id = 0; sound_id < AUDIO_MAX_ACTIVE_SAMPLES;
          sound_id++) {
-        if (m_Samples[sound_id].is_used) {
-            Audio_Sample_Unpause(sound_id);
-        }
+        Audio_Sample_Unpause(sound_id);
     }
 
     return true;
@@ -653,15 +938,16 @@ bool Audio_Sample_UnpauseAll(void)
 
 bool Audio_Sample_Close(int32_t sound_id)
 {
-    if (!g_AudioDeviceID || sound_id < 0
-        || sound_id >= AUDIO_MAX_ACTIVE_SAMPLES) {
+    if (!M_IsValidSound(sound_id)) {
         return false;
     }
 
-    SDL_LockAudioDevice(g_AudioDeviceID);
-    m_Samples[sound_id].is_used = false;
-    m_Samples[sound_id].is_playing = false;
-    SDL_UnlockAudioDevice(g_AudioDeviceID);
+    m_Voices[sound_id].is_used = false;
+    m_Voices[sound_id].is_playing = false;
+    M_PushCommand((AUDIO_COMMAND) {
+        .type = AUDIO_COMMAND_CLOSE,
+        .sound_id = sound_id,
+    });
 
     return true;
 }
@@ -674,7 +960,7 @@ bool Audio_Sample_CloseAll(void)
 
     for (int32_t sound_id = 0; sound_id < AUDIO_MAX_ACTIVE_SAMPLES;
          sound_id++) {
-        if (m_Samples[sound_id].is_used) {
+        if (M_IsVoiceUsed(sound_id)) {
             Audio_Sample_Close(sound_id);
         }
     }
@@ -684,92 +970,140 @@ bool Audio_Sample_CloseAll(void)
 
 bool Audio_Sample_SetPan(int32_t sound_id, int32_t pan)
 {
-    if (!g_AudioDeviceID || sound_id < 0
-        || sound_id >= AUDIO_MAX_ACTIVE_SAMPLES) {
+    if (!M_IsValidSound(sound_id)) {
         return false;
     }
 
-    SDL_LockAudioDevice(g_AudioDeviceID);
-    m_Samples[sound_id].pan = pan;
-    M_RecalculateChannelVolumes(sound_id);
-    SDL_UnlockAudioDevice(g_AudioDeviceID);
+    M_PushCommand((AUDIO_COMMAND) {
+        .type = AUDIO_COMMAND_SET_PAN,
+        .sound_id = sound_id,
+        .pan = pan,
+    });
 
     return true;
 }
 
 bool Audio_Sample_SetVolume(int32_t sound_id, int32_t volume)
 {
-    if (!g_AudioDeviceID || sound_id < 0
-        || sound_id >= AUDIO_MAX_ACTIVE_SAMPLES) {
+    if (!M_IsValidSound(sound_id)) {
         return false;
     }
 
-    SDL_LockAudioDevice(g_AudioDeviceID);
-    m_Samples[sound_id].volume = volume;
-    M_RecalculateChannelVolumes(sound_id);
-    SDL_UnlockAudioDevice(g_AudioDeviceID);
+    M_PushCommand((AUDIO_COMMAND) {
+        .type = AUDIO_COMMAND_SET_VOLUME,
+        .sound_id = sound_id,
+        .volume = volume,
+    });
 
     return true;
 }
 
 bool Audio_Sample_SetPitch(int32_t sound_id, float pitch)
 {
-    if (!g_AudioDeviceID || sound_id < 0
-        || sound_id >= AUDIO_MAX_ACTIVE_SAMPLES) {
+    if (!M_IsValidSound(sound_id)) {
         return false;
     }
 
-    SDL_LockAudioDevice(g_AudioDeviceID);
-    m_Samples[sound_id].pitch = pitch;
-    M_RecalculateChannelVolumes(sound_id);
-    SDL_UnlockAudioDevice(g_AudioDeviceID);
+    M_PushCommand((AUDIO_COMMAND) {
+        .type = AUDIO_COMMAND_SET_PITCH,
+        .sound_id = sound_id,
+        .pitch = pitch,
+    });
 
     return true;
 }
 
-void Audio_Sample_Mix(float *dst_buffer, size_t len)
+bool Audio_Sample_SetFilter(
+    int32_t sound_id, float distance, bool is_underwater)
 {
-    for (int32_t sound_id = 0; sound_id < AUDIO_MAX_ACTIVE_SAMPLES;
-         sound_id++) {
-        AUDIO_SAMPLE_SOUND *sound = &m_Samples[sound_id];
-        if (!sound->is_playing) {
-            continue;
-        }
+    if (!M_IsValidSound(sound_id)) {
+        return false;
+    }
 
-        int32_t samples_requested =
-            len / sizeof(AUDIO_WORKING_FORMAT) / AUDIO_WORKING_CHANNELS;
-        float src_sample_idx = sound->current_sample;
-        const float *src_buffer = sound->sample->sample_data;
-        float *dst_ptr = dst_buffer;
+    CLAMP(distance, 0.0f, 1.0f);
+    // Lower the cutoff exponentially, which sounds about linear.
+    const float nyquist = AUDIO_WORKING_RATE / 2.0f;
+    float cutoff = nyquist * powf(FILTER_DISTANT_CUTOFF / nyquist, distance);
+    if (is_underwater) {
+        CLAMPG(cutoff, FILTER_UNDERWATER_CUTOFF);
+    }
 
-        while ((dst_ptr - dst_buffer) / AUDIO_WORKING_CHANNELS
-               < samples_requested) {
+    M_PushCommand((AUDIO_COMMAND) {
+        .type = AUDIO_COMMAND_SET_FILTER,
+        .sound_id = sound_id,
+        .filter_coeff = M_GetFilterCoeff(cutoff),
+    });
 
-            // because we handle 3d sound ourselves, downmix to mono
-            float src_sample = 0.0f;
-            for (int32_t i = 0; i < sound->sample->channels; i++) {
-                src_sample += src_buffer
-                    [(int32_t)src_sample_idx * sound->sample->channels + i];
-            }
-            src_sample /= (float)sound->sample->channels;
+    return true;
+}
 
-            *dst_ptr++ += src_sample * sound->volume_l;
-            *dst_ptr++ += src_sample * sound->volume_r;
-            src_sample_idx += sound->pitch;
+double Audio_Sample_MeasureVoiceLoad(void)
+{
+    // Mix a second of a looped filtered noise sample in buffer sized chunks,
+    // the same way the mixer does, into a scratch buffer.
+    const int32_t num_samples = AUDIO_WORKING_RATE;
+    float *const data = Memory_Alloc(num_samples * sizeof(float));
+    uint32_t seed = 1;
+    for (int32_t i = 0; i < num_samples; i++) {
+        seed = seed * 1664525 + 1013904223;
+        data[i] = (int32_t)seed / 2147483648.0f;
+    }
 
-            if ((int32_t)src_sample_idx >= sound->sample->num_samples) {
-                if (sound->is_looped) {
-                    src_sample_idx = 0.0f;
-                } else {
-                    break;
-                }
-            }
+    AUDIO_SAMPLE sample = {
+        .sample_data = data,
+        .channels = 1,
+        .num_samples = num_samples,
+    };
+    AUDIO_SAMPLE_SOUND sound = {
+        .is_used = true,
+        .is_playing = true,
+        .is_looped = true,
+        .volume_l = 0.5f,
+        .volume_r = 0.5f,
+        .pitch = 1.0f,
+        .sample = &sample,
+        .filter_coeff = 0.5f,
+    };
+    float *const buffer =
+        Memory_Alloc(AUDIO_SAMPLES * AUDIO_WORKING_CHANNELS * sizeof(float));
+
+    int32_t mixed = 0;
+    const Uint64 start = SDL_GetPerformanceCounter();
+    while (mixed < num_samples) {
+        M_MixSound(&sound, buffer, AUDIO_SAMPLES);
+        mixed += AUDIO_SAMPLES;
+    }
+    const double time = (double)(SDL_GetPerformanceCounter() - start)
+        / SDL_GetPerformanceFrequency();
+
+    Memory_Free(buffer);
+    Memory_Free(data);
+    return time * AUDIO_WORKING_RATE / mixed;
+}
+
+int32_t Audio_Sample_Mix(float *dst_buffer, size_t len)
+{
+    M_ProcessCommands();
+
+    int32_t active_count = 0;
+    for (int32_t sound_id = 0; sound_id < AUDIO_MAX_ACTIVE_SAMPLES;
+         sound_id++) {
+        AUDIO_SAMPLE_SOUND *sound = &m_Samples[sound_id];
+        if (!sound->is_playing) {
+            continue;
         }
+        active_count++;
 
-        sound->current_sample = src_sample_idx;
+        M_MixSound(
+            sound, dst_buffer,
+            len / sizeof(AUDIO_WORKING_FORMAT) / AUDIO_WORKING_CHANNELS);
         if (sound->current_sample >= sound->sample->num_samples
             && !sound->is_looped) {
-            Audio_Sample_Close(sound_id);
+            sound->is_used = false;
+            sound->is_playing = false;
+            SDL_AtomicSet(
+                &m_FinishedGenerations[sound_id], sound->generation);
         }
     }
+    return active_count;
 }
@@ -0,0 +1,278 @@
+#include "audio_internal.h"
+
+#include "filesystem.h"
+#include "hash_map.h"
+#include "log.h"
+#include "memory.h"
+
+#include <SDL2/SDL.h>
+#include <inttypes.h>
+#include <libavformat/avio.h>
+#include <libavutil/avutil.h>
+#include <libavutil/rational.h>
+#include <stdio.h>
+#include <string.h>
+
+#define DISK_DIR "cache"
+#define DISK_MAGIC 0x53585254 // 'TRXS'
+#define DISK_VERSION 1
+// Seconds between two indexed packets.
+#define INTERVAL 0.5
+// Seconds of data to decode ahead of the requested timestamp; some codecs
+// need the previous frames to decode the first frame correctly.
+#define PREROLL 0.1
+
+typedef struct {
+    int64_t time; // in microseconds
+    int64_t pos;
+} M_POINT;
+
+typedef struct {
+    char *path;
+    int32_t count;
+    M_POINT *points;
+} M_INDEX;
+
+static SDL_mutex *m_Mutex = NULL;
+// Indices by path hash; the path is copied into the index rather than
+// interned, since the indices are built on a worker thread. Files that cannot
+// be indexed map to an empty index, so that they are not read through again.
+static HASH_MAP *m_Indices = NULL;
+
+static char *M_GetDiskPath(const char *path);
+static bool M_ReadFromDisk(const char *path, int64_t size, M_INDEX *index);
+static void M_WriteToDisk(const char *path, int64_t size, const M_INDEX *index);
+static void M_Build(
+    AVFormatContext *format_ctx, int32_t stream_index, M_INDEX *index);
+static M_INDEX *M_Find(const char *path);
+
+static char *M_GetDiskPath(const char *const path)
+{
+    const uint64_t key = Audio_PCMCache_Hash(path, strlen(path));
+    const char *const fmt = "%s/%016" PRIx64 ".idx";
+    const size_t size = snprintf(NULL, 0, fmt, DISK_DIR, key) + 1;
+    char *const disk_path = Memory_Alloc(size);
+    snprintf(disk_path, size, fmt, DISK_DIR, key);
+    return disk_path;
+}
+
+static bool M_ReadFromDisk(
+    const char *const path, const int64_t size, M_INDEX *const index)
+{
+    char *disk_path = M_GetDiskPath(path);
+    MYFILE *const fp = File_Open(disk_path, FILE_OPEN_READ);
+    Memory_FreePointer(&disk_path);
+    if (fp == NULL) {
+        return false;
+    }
+
+    bool result = false;
+    const size_t header_size = sizeof(uint32_t) * 5;
+    if (File_Size(fp) < header_size || File_ReadU32(fp) != DISK_MAGIC
+        || File_ReadU32(fp) != DISK_VERSION) {
+        goto finish;
+    }
+
+    // the source file changed since the index was built
+    const uint32_t size_lo = File_ReadU32(fp);
+    const uint32_t size_hi = File_ReadU32(fp);
+    if (size_lo != (uint32_t)size || size_hi != (uint32_t)(size >> 32)) {
+        goto finish;
+    }
+
+    const int32_t count = File_ReadS32(fp);
+    if (count <= 0
+        || File_Size(fp) != header_size + count * sizeof(M_POINT)) {
+        goto finish;
+    }
+
+    index->count = count;
+    index->points = Memory_Alloc(count * sizeof(M_POINT));
+    File_ReadItems(fp, index->points, count, sizeof(M_POINT));
+    result = true;
+
+finish:
+    File_Close(fp);
+    return result;
+}
+
+static void M_WriteToDisk(
+    const char *const path, const int64_t size, const M_INDEX *const index)
+{
+    File_CreateDirectory(DISK_DIR);
+    char *disk_path = M_GetDiskPath(path);
+    MYFILE *const fp = File_Open(disk_path, FILE_OPEN_WRITE);
+    if (fp == NULL) {
+        LOG_ERROR("Cannot write seek index file %s", disk_path);
+    } else {
+        File_WriteU32(fp, DISK_MAGIC);
+        File_WriteU32(fp, DISK_VERSION);
+        File_WriteU32(fp, (uint32_t)size);
+        File_WriteU32(fp, (uint32_t)(size >> 32));
+        File_WriteS32(fp, index->count);
+        File_WriteItems(fp, index->points, index->count, sizeof(M_POINT));
+        File_Close(fp);
+    }
+    Memory_FreePointer(&disk_path);
+}
+
+static void M_Build(
+    AVFormatContext *const format_ctx, const int32_t stream_index,
+    M_INDEX *const index)
+{
+    const AVRational time_base = format_ctx->streams[stream_index]->time_base;
+    int32_t capacity = 0;
+    int64_t last_time = 0;
+
+    AVPacket *packet = av_packet_alloc();
+    while (packet != NULL && av_read_frame(format_ctx, packet) >= 0) {
+        const int64_t pts =
+            packet->pts != AV_NOPTS_VALUE ? packet->pts : packet->dts;
+        if (packet->stream_index == stream_index && packet->pos >= 0
+            && pts != AV_NOPTS_VALUE) {
+            const int64_t time =
+                av_rescale_q(pts, time_base, (AVRational) { 1, 1000000 });
+            if (index->count == 0
+                || time - last_time >= INTERVAL * 1000000) {
+                if (index->count == capacity) {
+                    capacity = capacity ? capacity * 2 : 256;
+                    index->points = Memory_Realloc(
+                        index->points, capacity * sizeof(M_POINT));
+                }
+                index->points[index->count++] = (M_POINT) {
+                    .time = time,
+                    .pos = packet->pos,
+                };
+                last_time = time;
+            }
+        }
+        av_packet_unref(packet);
+    }
+    av_packet_free(&packet);
+}
+
+// Must be called with the lock held.
+static M_INDEX *M_Find(const char *const path)
+{
+    M_INDEX *const index =
+        HashMap_FindInt(m_Indices, Audio_PCMCache_Hash(path, strlen(path)));
+    if (index == NULL || strcmp(index->path, path) != 0) {
+        return NULL;
+    }
+    return index;
+}
+
+void Audio_SeekIndex_Init(void)
+{
+    if (m_Mutex == NULL) {
+        m_Mutex = SDL_CreateMutex();
+        m_Indices = HashMap_Create(HMK_INT, sizeof(M_INDEX));
+    }
+}
+
+void Audio_SeekIndex_Shutdown(void)
+{
+    if (m_Mutex == NULL) {
+        return;
+    }
+
+    int32_t iter = 0;
+    M_INDEX *index;
+    while ((index = HashMap_Iterate(m_Indices, &iter)) != NULL) {
+        Memory_FreePointer(&index->path);
+        Memory_FreePointer(&index->points);
+    }
+    HashMap_Free(m_Indices);
+    m_Indices = NULL;
+    SDL_DestroyMutex(m_Mutex);
+    m_Mutex = NULL;
+}
+
+void Audio_SeekIndex_Build(
+    const char *const path, AVFormatContext *const format_ctx,
+    const int32_t stream_index)
+{
+    if (m_Mutex == NULL || Audio_SeekIndex_IsBuilt(path)) {
+        return;
+    }
+
+    // The lock is not held while reading the file, so that seeking other
+    // streams is never blocked by it.
+    M_INDEX index = {};
+    const int64_t size = avio_size(format_ctx->pb);
+    if (!M_ReadFromDisk(path, size, &index)) {
+        const Uint64 start = SDL_GetPerformanceCounter();
+        M_Build(format_ctx, stream_index, &index);
+        LOG_INFO(
+            "Indexed %s: %d seek points in %.1f ms", path, index.count,
+            (SDL_GetPerformanceCounter() - start) * 1000.0
+                / SDL_GetPerformanceFrequency());
+        if (index.count > 0) {
+            M_WriteToDisk(path, size, &index);
+        }
+    }
+
+    SDL_LockMutex(m_Mutex);
+    const uint64_t key = Audio_PCMCache_Hash(path, strlen(path));
+    // Paths with the same hash as an indexed file are left unindexed.
+    if (HashMap_FindInt(m_Indices, key) == NULL) {
+        index.path = Memory_DupStr(path);
+        HashMap_InsertInt(m_Indices, key, &index);
+    } else {
+        Memory_FreePointer(&index.points);
+    }
+    SDL_UnlockMutex(m_Mutex);
+}
+
+bool Audio_SeekIndex_IsBuilt(const char *const path)
+{
+    if (m_Mutex == NULL) {
+        return false;
+    }
+
+    SDL_LockMutex(m_Mutex);
+    const bool result = M_Find(path) != NULL;
+    SDL_UnlockMutex(m_Mutex);
+    return result;
+}
+
+bool Audio_SeekIndex_Find(
+    const char *const path, const double timestamp,
+    AUDIO_SEEK_POINT *const out_point)
+{
+    if (m_Mutex == NULL) {
+        return false;
+    }
+
+    SDL_LockMutex(m_Mutex);
+    const M_INDEX *const index = M_Find(path);
+    if (index == NULL) {
+        SDL_UnlockMutex(m_Mutex);
+        return false;
+    }
+
+    const int64_t target = (timestamp - PREROLL) * 1000000;
+
+    // binary search for the last point at or before the target
+    int32_t lo = 0;
+    int32_t hi = index->count - 1;
+    int32_t found = -1;
+    while (lo <= hi) {
+        const int32_t mid = (lo + hi) / 2;
+        if (index->points[mid].time <= target) {
+            found = mid;
+            lo = mid + 1;
+        } else {
+            hi = mid - 1;
+        }
+    }
+    if (found == -1 && index->count > 0) {
+        found = 0;
+    }
+    if (found != -1) {
+        out_point->timestamp = index->points[found].time / 1000000.0;
+        out_point->pos = index->points[found].pos;
+    }
+    SDL_UnlockMutex(m_Mutex);
+    return found != -1;
+}
@@ -4,6 +4,7 @@
 #include "filesystem.h"
 #include "log.h"
 #include "memory.h"
+#include "utils.h"
 
 #include <SDL2/SDL_audio.h>
 #include <SDL2/SDL_error.h>
@@ -25,8 +26,11 @@
 #include <stdio.h>
 #include <string.h>
 
-#define READ_BUFFER_SIZE                                                       \
-    (AUDIO_SAMPLES * AUDIO_WORKING_CHANNELS * sizeof(AUDIO_WORKING_FORMAT))
+// Seconds of music to decode when a stream is opened, so that the mixer
+// does not need to decode anything for the first callbacks.
+#define PREBUFFER_TIME 0.5
+#define MAX_PREFETCHED 4
+#define MAX_INDEX_REQUESTS 4
 
 typedef struct {
     bool is_used;
@@ -39,6 +43,17 @@ typedef struct {
 
     double start_at;
     double stop_at;
+    // Decoded data before this timestamp is dropped, so that seeking is
+    // accurate to the sample; negative value means unset.
+    double skip_until;
+    // After a seek through the seek index, the demuxer may not know the
+    // packet timestamps, so the timestamp is advanced by the decoded samples
+    // instead.
+    bool use_sample_clock;
+
+    char *path;
+    float *decode_buffer;
+    size_t decode_buffer_capacity;
 
     void (*finish_callback)(int32_t sound_id, void *user_data);
     void *finish_callback_user_data;
@@ -67,37 +82,104 @@ typedef struct {
     } sdl;
 } AUDIO_STREAM_SOUND;
 
-extern SDL_AudioDeviceID g_AudioDeviceID;
+typedef enum {
+    PREFETCH_EMPTY,
+    PREFETCH_PENDING,
+    PREFETCH_OPENING,
+    PREFETCH_READY,
+    PREFETCH_FAILED,
+} M_PREFETCH_STATE;
 
-static AUDIO_STREAM_SOUND m_Streams[AUDIO_MAX_ACTIVE_STREAMS] = {};
-static float m_MixBuffer[AUDIO_SAMPLES * AUDIO_WORKING_CHANNELS] = {};
+// A stream that is opened and buffered ahead of time, waiting to be picked
+// up by Audio_Stream_CreateFromFileRange.
+typedef struct {
+    M_PREFETCH_STATE state;
+    char *path;
+    double start_at;
+    double stop_at;
+    AUDIO_STREAM_SOUND stream;
+    // Request order for pending entries, use order for all the others.
+    uint32_t stamp;
+} M_PREFETCH_ENTRY;
 
-static size_t m_DecodeBufferCapacity = 0;
-static float *m_DecodeBuffer = NULL;
+extern SDL_AudioDeviceID g_AudioDeviceID;
 
+static AUDIO_STREAM_SOUND m_Streams[AUDIO_MAX_ACTIVE_STREAMS] = {};
+static float m_MixBuffer[AUDIO_MAX_BUFFER_SAMPLES * AUDIO_WORKING_CHANNELS] =
+    {};
+
+static struct {
+    SDL_mutex *mutex;
+    SDL_cond *cond;
+    SDL_Thread *worker;
+    bool quit;
+    M_PREFETCH_ENTRY entries[MAX_PREFETCHED];
+    uint32_t stamp;
+    // Files to build the seek index for, in request order.
+    char *index_requests[MAX_INDEX_REQUESTS];
+    int32_t index_request_count;
+} m_Prefetch = {};
+
+static void M_SeekTo(AUDIO_STREAM_SOUND *stream, double timestamp);
 static void M_SeekToStart(AUDIO_STREAM_SOUND *stream);
 static bool M_DecodeFrame(AUDIO_STREAM_SOUND *stream);
 static bool M_EnqueueFrame(AUDIO_STREAM_SOUND *stream);
-static bool M_InitialiseFromPath(int32_t sound_id, const char *file_path);
+static bool M_Open(
+    AUDIO_STREAM_SOUND *stream, const char *file_path, double start_at,
+    double stop_at, bool build_index);
+static void M_Free(AUDIO_STREAM_SOUND *stream);
 static void M_Clear(AUDIO_STREAM_SOUND *stream);
 
-static void M_SeekToStart(AUDIO_STREAM_SOUND *stream)
+static bool M_StartWorker(void);
+static void M_ResetPrefetchEntry(M_PREFETCH_ENTRY *entry);
+static M_PREFETCH_ENTRY *M_FindPrefetched(
+    const char *path, double start_at, double stop_at);
+static void M_Prefetch(const char *path, double start_at, double stop_at);
+static bool M_TakePrefetched(
+    const char *path, double start_at, double stop_at,
+    AUDIO_STREAM_SOUND *out_stream);
+static void M_RequestIndex(const char *path);
+static void M_BuildIndex(const char *path);
+static int M_PrefetchThread(void *arg);
+
+static void M_SeekTo(AUDIO_STREAM_SOUND *const stream, const double timestamp)
 {
     ASSERT(stream != NULL);
 
-    stream->timestamp = stream->start_at;
-    if (stream->start_at <= 0.0) {
+    AUDIO_SEEK_POINT point;
+    stream->use_sample_clock = false;
+    if (timestamp > 0.0
+        && Audio_SeekIndex_Find(stream->path, timestamp, &point)
+        && av_seek_frame(
+               stream->av.format_ctx, stream->av.stream->index, point.pos,
+               AVSEEK_FLAG_BYTE)
+            >= 0) {
+        stream->timestamp = point.timestamp;
+        stream->use_sample_clock = true;
+    } else if (timestamp <= 0.0) {
         // reset to start of file
+        stream->timestamp = 0.0;
         avio_seek(stream->av.format_ctx->pb, 0, SEEK_SET);
         avformat_seek_file(
             stream->av.format_ctx, -1, 0, 0, 0, AVSEEK_FLAG_FRAME);
     } else {
-        // seek to specific timestamp
+        // the file is not indexed (yet); let the demuxer seek to the
+        // timestamp
+        stream->timestamp = timestamp;
         const double time_base_sec = av_q2d(stream->av.stream->time_base);
         av_seek_frame(
-            stream->av.format_ctx, 0, stream->start_at / time_base_sec,
+            stream->av.format_ctx, 0, timestamp / time_base_sec,
             AVSEEK_FLAG_ANY);
     }
+
+    avcodec_flush_buffers(stream->av.codec_ctx);
+    stream->skip_until = timestamp;
+}
+
+static void M_SeekToStart(AUDIO_STREAM_SOUND *stream)
+{
+    ASSERT(stream != NULL);
+    M_SeekTo(stream, stream->start_at);
 }
 
 static bool M_DecodeFrame(AUDIO_STREAM_SOUND *stream)
@@ -203,14 +285,14 @@ static bool M_EnqueueFrame(AUDIO_STREAM_SOUND *stream)
                 NULL, stream->swr.dst_channels, resampled_size,
                 stream->swr.dst_format, 1);
 
-            if (out_pos + out_buffer_size > m_DecodeBufferCapacity) {
-                m_DecodeBufferCapacity = out_pos + out_buffer_size;
-                m_DecodeBuffer =
-                    Memory_Realloc(m_DecodeBuffer, m_DecodeBufferCapacity);
+            if (out_pos + out_buffer_size > stream->decode_buffer_capacity) {
+                stream->decode_buffer_capacity = out_pos + out_buffer_size;
+                stream->decode_buffer = Memory_Realloc(
+                    stream->decode_buffer, stream->decode_buffer_capacity);
             }
-            if (m_DecodeBuffer != NULL && out_buffer != NULL) {
+            if (stream->decode_buffer != NULL && out_buffer != NULL) {
                 memcpy(
-                    (uint8_t *)m_DecodeBuffer + out_pos, out_buffer,
+                    (uint8_t *)stream->decode_buffer + out_pos, out_buffer,
                     out_buffer_size);
             }
             out_pos += out_buffer_size;
@@ -219,15 +301,47 @@ static bool M_EnqueueFrame(AUDIO_STREAM_SOUND *stream)
                 swr_convert(stream->swr.ctx, &out_buffer, out_samples, NULL, 0);
         }
 
-        if (SDL_AudioStreamPut(stream->sdl.stream, m_DecodeBuffer, out_pos)) {
+        const size_t sample_size = stream->swr.dst_channels * sizeof(float);
+        const int32_t frame_samples = out_pos / sample_size;
+        const int64_t frame_pts = stream->av.frame->best_effort_timestamp;
+        const double time_base_sec = av_q2d(stream->av.stream->time_base);
+        const double frame_start =
+            stream->use_sample_clock || frame_pts == AV_NOPTS_VALUE
+            ? stream->timestamp
+            : frame_pts * time_base_sec;
+        const double frame_end =
+            frame_start + frame_samples / (double)AUDIO_WORKING_RATE;
+
+        // drop the samples outside of the requested range
+        int32_t first = 0;
+        int32_t last = frame_samples;
+        if (stream->skip_until > frame_start) {
+            first = MIN(
+                frame_samples,
+                (int32_t)((stream->skip_until - frame_start)
+                          * AUDIO_WORKING_RATE));
+        }
+        if (stream->stop_at > 0.0 && stream->stop_at < frame_end) {
+            last = MAX(
+                first,
+                (int32_t)((stream->stop_at - frame_start)
+                          * AUDIO_WORKING_RATE));
+        }
+        if (stream->skip_until >= 0.0 && stream->skip_until <= frame_end) {
+            stream->skip_until = -1.0;
+        }
+        stream->timestamp = frame_end;
+
+        if (last > first
+            && SDL_AudioStreamPut(
+                stream->sdl.stream,
+                (uint8_t *)stream->decode_buffer + first * sample_size,
+                (last - first) * sample_size)) {
             LOG_ERROR("Got an error when decoding frame: %s", SDL_GetError());
             av_frame_unref(stream->av.frame);
             break;
         }
 
-        double time_base_sec = av_q2d(stream->av.stream->time_base);
-        stream->timestamp =
-            stream->av.frame->best_effort_timestamp * time_base_sec;
         av_freep(&out_buffer);
         av_frame_unref(stream->av.frame);
     }
@@ -244,22 +358,19 @@ cleanup:
     return true;
 }
 
-static bool M_InitialiseFromPath(int32_t sound_id, const char *file_path)
+static bool M_Open(
+    AUDIO_STREAM_SOUND *const stream, const char *const file_path,
+    const double start_at, const double stop_at, const bool build_index)
 {
+    ASSERT(stream != NULL);
     ASSERT(file_path != NULL);
 
-    if (!g_AudioDeviceID || sound_id < 0
-        || sound_id >= AUDIO_MAX_ACTIVE_STREAMS) {
-        return false;
-    }
-
     bool ret = false;
-    SDL_LockAudioDevice(g_AudioDeviceID);
-
     int32_t error_code;
     char *full_path = File_GetFullPath(file_path);
 
-    AUDIO_STREAM_SOUND *stream = &m_Streams[sound_id];
+    M_Clear(stream);
+    stream->path = Memory_DupStr(file_path);
 
     error_code =
         avformat_open_input(&stream->av.format_ctx, full_path, NULL, NULL);
@@ -321,14 +432,12 @@ static bool M_InitialiseFromPath(int32_t sound_id, const char *file_path)
         goto cleanup;
     }
 
-    M_DecodeFrame(stream);
-
     int32_t sdl_sample_rate = stream->av.codec_ctx->sample_rate;
     int32_t sdl_channels = stream->av.codec_ctx->channels;
 
     stream->is_read_done = false;
     stream->is_used = true;
-    stream->is_playing = true;
+    stream->is_playing = false;
     stream->is_looped = false;
     stream->volume = 1.0f;
     stream->timestamp = 0.0;
@@ -336,8 +445,8 @@ static bool M_InitialiseFromPath(int32_t sound_id, const char *file_path)
     stream->finish_callback_user_data = NULL;
     stream->duration =
         (double)stream->av.format_ctx->duration / (double)AV_TIME_BASE;
-    stream->start_at = -1.0; // negative value means unset
-    stream->stop_at = -1.0; // negative value means unset
+    stream->start_at = start_at;
+    stream->stop_at = stop_at;
 
     stream->sdl.stream = SDL_NewAudioStream(
         AUDIO_WORKING_FORMAT, sdl_channels, AUDIO_WORKING_RATE,
@@ -347,8 +456,25 @@ static bool M_InitialiseFromPath(int32_t sound_id, const char *file_path)
         goto cleanup;
     }
 
+    if (build_index) {
+        Audio_SeekIndex_Build(
+            file_path, stream->av.format_ctx, stream->av.stream->index);
+    }
+    // building the index moves the read position
+    if (start_at > 0.0 || build_index) {
+        M_SeekTo(stream, start_at);
+    }
+
+    // Do not mark the stream as read to the end here; it may still be set to
+    // loop before it starts playing.
+    const int32_t prebuffer_size = PREBUFFER_TIME * AUDIO_WORKING_RATE
+        * AUDIO_WORKING_CHANNELS * sizeof(float);
+    while (SDL_AudioStreamAvailable(stream->sdl.stream) < prebuffer_size
+           && M_DecodeFrame(stream)) {
+        M_EnqueueFrame(stream);
+    }
+
     ret = true;
-    M_EnqueueFrame(stream);
 
 cleanup:
     if (error_code) {
@@ -358,14 +484,62 @@ cleanup:
     }
 
     if (!ret) {
-        Audio_Stream_Close(sound_id);
+        M_Free(stream);
     }
 
-    SDL_UnlockAudioDevice(g_AudioDeviceID);
     Memory_FreePointer(&full_path);
     return ret;
 }
 
+static void M_Free(AUDIO_STREAM_SOUND *const stream)
+{
+    ASSERT(stream != NULL);
+
+    if (stream->av.codec_ctx) {
+        avcodec_close(stream->av.codec_ctx);
+
+        // XXX: potential libav bug - avcodec_close should free this info
+        if (stream->av.codec_ctx->extradata != NULL) {
+            av_freep(&stream->av.codec_ctx->extradata);
+        }
+
+        av_free(stream->av.codec_ctx);
+        stream->av.codec_ctx = NULL;
+    }
+
+    if (stream->av.format_ctx) {
+        avformat_close_input(&stream->av.format_ctx);
+        stream->av.format_ctx = NULL;
+    }
+
+    if (stream->swr.ctx) {
+        swr_free(&stream->swr.ctx);
+    }
+
+    if (stream->av.frame) {
+        av_frame_free(&stream->av.frame);
+        stream->av.frame = NULL;
+    }
+
+    if (stream->av.packet) {
+        av_packet_free(&stream->av.packet);
+        stream->av.packet = NULL;
+    }
+
+    stream->av.stream = NULL;
+    stream->av.codec = NULL;
+
+    if (stream->sdl.stream) {
+        SDL_FreeAudioStream(stream->sdl.stream);
+    }
+
+    Memory_FreePointer(&stream->path);
+    Memory_FreePointer(&stream->decode_buffer);
+    stream->decode_buffer_capacity = 0;
+
+    M_Clear(stream);
+}
+
 static void M_Clear(AUDIO_STREAM_SOUND *stream)
 {
     ASSERT(stream != NULL);
@@ -377,33 +551,253 @@ static void M_Clear(AUDIO_STREAM_SOUND *stream)
     stream->volume = 0.0f;
     stream->duration = 0.0;
     stream->timestamp = 0.0;
+    stream->start_at = -1.0; // negative value means unset
+    stream->stop_at = -1.0; // negative value means unset
+    stream->skip_until = -1.0;
+    stream->use_sample_clock = false;
     stream->sdl.stream = NULL;
     stream->finish_callback = NULL;
     stream->finish_callback_user_data = NULL;
 }
 
+// Must be called with the lock held.
+static bool M_StartWorker(void)
+{
+    if (m_Prefetch.worker == NULL) {
+        m_Prefetch.worker =
+            SDL_CreateThread(M_PrefetchThread, "audio_stream", NULL);
+        if (m_Prefetch.worker == NULL) {
+            LOG_ERROR("SDL_CreateThread(): %s", SDL_GetError());
+        }
+    }
+    return m_Prefetch.worker != NULL;
+}
+
+static void M_ResetPrefetchEntry(M_PREFETCH_ENTRY *const entry)
+{
+    ASSERT(entry->state != PREFETCH_OPENING);
+    if (entry->state == PREFETCH_READY) {
+        M_Free(&entry->stream);
+    }
+    Memory_FreePointer(&entry->path);
+    entry->state = PREFETCH_EMPTY;
+}
+
+// Must be called with the lock held.
+static M_PREFETCH_ENTRY *M_FindPrefetched(
+    const char *const path, const double start_at, const double stop_at)
+{
+    for (int32_t i = 0; i < MAX_PREFETCHED; i++) {
+        M_PREFETCH_ENTRY *const entry = &m_Prefetch.entries[i];
+        if (entry->state != PREFETCH_EMPTY && entry->start_at == start_at
+            && entry->stop_at == stop_at && strcmp(entry->path, path) == 0) {
+            return entry;
+        }
+    }
+    return NULL;
+}
+
+static void M_Prefetch(
+    const char *const path, const double start_at, const double stop_at)
+{
+    if (m_Prefetch.mutex == NULL) {
+        return;
+    }
+
+    SDL_LockMutex(m_Prefetch.mutex);
+    if (!M_StartWorker()
+        || M_FindPrefetched(path, start_at, stop_at) != NULL) {
+        goto finish;
+    }
+
+    // replace the least recently used stream that is not being opened
+    M_PREFETCH_ENTRY *victim = NULL;
+    for (int32_t i = 0; i < MAX_PREFETCHED; i++) {
+        M_PREFETCH_ENTRY *const entry = &m_Prefetch.entries[i];
+        if (entry->state == PREFETCH_EMPTY) {
+            victim = entry;
+            break;
+        }
+        if (entry->state != PREFETCH_OPENING
+            && (victim == NULL || entry->stamp < victim->stamp)) {
+            victim = entry;
+        }
+    }
+    if (victim == NULL) {
+        goto finish;
+    }
+
+    M_ResetPrefetchEntry(victim);
+    victim->state = PREFETCH_PENDING;
+    victim->path = Memory_DupStr(path);
+    victim->start_at = start_at;
+    victim->stop_at = stop_at;
+    victim->stamp = ++m_Prefetch.stamp;
+    SDL_CondBroadcast(m_Prefetch.cond);
+
+finish:
+    SDL_UnlockMutex(m_Prefetch.mutex);
+}
+
+static bool M_TakePrefetched(
+    const char *const path, const double start_at, const double stop_at,
+    AUDIO_STREAM_SOUND *const out_stream)
+{
+    if (m_Prefetch.mutex == NULL) {
+        return false;
+    }
+
+    SDL_LockMutex(m_Prefetch.mutex);
+    M_PREFETCH_ENTRY *const entry = M_FindPrefetched(path, start_at, stop_at);
+    bool result = false;
+    if (entry != NULL) {
+        while (entry->state == PREFETCH_OPENING) {
+            SDL_CondWait(m_Prefetch.cond, m_Prefetch.mutex);
+        }
+        if (entry->state == PREFETCH_READY) {
+            *out_stream = entry->stream;
+            // the stream now belongs to the caller
+            entry->state = PREFETCH_EMPTY;
+            result = true;
+        }
+        M_ResetPrefetchEntry(entry);
+    }
+    SDL_UnlockMutex(m_Prefetch.mutex);
+    return result;
+}
+
+static void M_RequestIndex(const char *const path)
+{
+    if (m_Prefetch.mutex == NULL || Audio_SeekIndex_IsBuilt(path)) {
+        return;
+    }
+
+    SDL_LockMutex(m_Prefetch.mutex);
+    if (!M_StartWorker()
+        || m_Prefetch.index_request_count >= MAX_INDEX_REQUESTS) {
+        goto finish;
+    }
+    for (int32_t i = 0; i < m_Prefetch.index_request_count; i++) {
+        if (strcmp(m_Prefetch.index_requests[i], path) == 0) {
+            goto finish;
+        }
+    }
+    m_Prefetch.index_requests[m_Prefetch.index_request_count++] =
+        Memory_DupStr(path);
+    SDL_CondBroadcast(m_Prefetch.cond);
+
+finish:
+    SDL_UnlockMutex(m_Prefetch.mutex);
+}
+
+static void M_BuildIndex(const char *const path)
+{
+    char *full_path = File_GetFullPath(path);
+    AVFormatContext *format_ctx = NULL;
+    if (avformat_open_input(&format_ctx, full_path, NULL, NULL) == 0
+        && avformat_find_stream_info(format_ctx, NULL) >= 0) {
+        for (uint32_t i = 0; i < format_ctx->nb_streams; i++) {
+            const AVStream *const stream = format_ctx->streams[i];
+            if (stream->codecpar->codec_type == AVMEDIA_TYPE_AUDIO) {
+                Audio_SeekIndex_Build(path, format_ctx, stream->index);
+                break;
+            }
+        }
+    }
+    avformat_close_input(&format_ctx);
+    Memory_FreePointer(&full_path);
+}
+
+static int M_PrefetchThread(void *const arg)
+{
+    SDL_LockMutex(m_Prefetch.mutex);
+    while (!m_Prefetch.quit) {
+        M_PREFETCH_ENTRY *entry = NULL;
+        for (int32_t i = 0; i < MAX_PREFETCHED; i++) {
+            M_PREFETCH_ENTRY *const candidate = &m_Prefetch.entries[i];
+            if (candidate->state == PREFETCH_PENDING
+                && (entry == NULL || candidate->stamp < entry->stamp)) {
+                entry = candidate;
+            }
+        }
+        if (entry == NULL && m_Prefetch.index_request_count > 0) {
+            char *path = m_Prefetch.index_requests[0];
+            m_Prefetch.index_request_count--;
+            memmove(
+                &m_Prefetch.index_requests[0], &m_Prefetch.index_requests[1],
+                m_Prefetch.index_request_count * sizeof(char *));
+            SDL_UnlockMutex(m_Prefetch.mutex);
+            M_BuildIndex(path);
+            Memory_FreePointer(&path);
+            SDL_LockMutex(m_Prefetch.mutex);
+            continue;
+        }
+        if (entry == NULL) {
+            SDL_CondWait(m_Prefetch.cond, m_Prefetch.mutex);
+            continue;
+        }
+
+        // Entries that are being opened are never evicted, so the key stays
+        // valid without the lock.
+        entry->state = PREFETCH_OPENING;
+        SDL_UnlockMutex(m_Prefetch.mutex);
+        const bool result = M_Open(
+            &entry->stream, entry->path, entry->start_at, entry->stop_at,
+            true);
+        SDL_LockMutex(m_Prefetch.mutex);
+        entry->state = result ? PREFETCH_READY : PREFETCH_FAILED;
+        SDL_CondBroadcast(m_Prefetch.cond);
+    }
+    SDL_UnlockMutex(m_Prefetch.mutex);
+    return 0;
+}
+
 void Audio_Stream_Init(void)
 {
     for (int32_t sound_id = 0; sound_id < AUDIO_MAX_ACTIVE_STREAMS;
          sound_id++) {
         M_Clear(&m_Streams[sound_id]);
     }
+
+    Audio_SeekIndex_Init();
+    if (m_Prefetch.mutex == NULL) {
+        m_Prefetch.mutex = SDL_CreateMutex();
+        m_Prefetch.cond = SDL_CreateCond();
+        m_Prefetch.quit = false;
+    }
 }
 
 void Audio_Stream_Shutdown(void)
 {
-    Memory_FreePointer(&m_DecodeBuffer);
-    m_DecodeBufferCapacity = 0;
-    if (!g_AudioDeviceID) {
-        return;
+    if (m_Prefetch.mutex != NULL) {
+        SDL_LockMutex(m_Prefetch.mutex);
+        m_Prefetch.quit = true;
+        SDL_CondBroadcast(m_Prefetch.cond);
+        SDL_UnlockMutex(m_Prefetch.mutex);
+        if (m_Prefetch.worker != NULL) {
+            SDL_WaitThread(m_Prefetch.worker, NULL);
+            m_Prefetch.worker = NULL;
+        }
+        for (int32_t i = 0; i < MAX_PREFETCHED; i++) {
+            M_ResetPrefetchEntry(&m_Prefetch.entries[i]);
+        }
+        for (int32_t i = 0; i < m_Prefetch.index_request_count; i++) {
+            Memory_FreePointer(&m_Prefetch.index_requests[i]);
+        }
+        m_Prefetch.index_request_count = 0;
+        SDL_DestroyCond(m_Prefetch.cond);
+        SDL_DestroyMutex(m_Prefetch.mutex);
+        m_Prefetch.cond = NULL;
+        m_Prefetch.mutex = NULL;
     }
 
     for (int32_t sound_id = 0; sound_id < AUDIO_MAX_ACTIVE_STREAMS;
          sound_id++) {
         if (m_Streams[sound_id].is_used) {
-            Audio_Stream_Close(sound_id);
+            M_Free(&m_Streams[sound_id]);
         }
     }
+    Audio_SeekIndex_Shutdown();
 }
 
 bool Audio_Stream_Pause(int32_t sound_id)
@@ -438,7 +832,23 @@ bool Audio_Stream_Unpause(int32_t sound_id)
     return true;
 }
 
-int32_t Audio_Stream_CreateFromFile(const char *file_path)
+void Audio_Stream_Prefetch(
+    const char *const file_path, const double start_at, const double stop_at)
+{
+    ASSERT(file_path != NULL);
+    if (!g_AudioDeviceID) {
+        return;
+    }
+    M_Prefetch(file_path, start_at, stop_at);
+}
+
+int32_t Audio_Stream_CreateFromFile(const char *const file_path)
+{
+    return Audio_Stream_CreateFromFileRange(file_path, -1.0, -1.0);
+}
+
+int32_t Audio_Stream_CreateFromFileRange(
+    const char *const file_path, const double start_at, const double stop_at)
 {
     if (!g_AudioDeviceID) {
         return AUDIO_NO_SOUND;
@@ -446,21 +856,42 @@ int32_t Audio_Stream_CreateFromFile(const char *file_path)
 
     ASSERT(file_path != NULL);
 
-    for (int32_t sound_id = 0; sound_id < AUDIO_MAX_ACTIVE_STREAMS;
-         sound_id++) {
-        AUDIO_STREAM_SOUND *stream = &m_Streams[sound_id];
-        if (stream->is_used) {
-            continue;
+    // The file is opened without holding the audio lock, so that the mixer
+    // keeps playing the other sounds in the meantime.
+    AUDIO_STREAM_SOUND opened;
+    if (!M_TakePrefetched(file_path, start_at, stop_at, &opened)) {
+        if (!M_Open(&opened, file_path, start_at, stop_at, false)) {
+            return AUDIO_NO_SOUND;
+        }
+        // the next seek may find the index ready
+        if (start_at > 0.0) {
+            M_RequestIndex(file_path);
         }
+    }
 
-        if (!M_InitialiseFromPath(sound_id, file_path)) {
-            return AUDIO_NO_SOUND;
+    int32_t result = AUDIO_NO_SOUND;
+    SDL_LockAudioDevice(g_AudioDeviceID);
+    for (int32_t sound_id = 0; sound_id < AUDIO_MAX_ACTIVE_STREAMS;
+         sound_id++) {
+        AUDIO_STREAM_SOUND *const stream = &m_Streams[sound_id];
+        if (!stream->is_used) {
+            *stream = opened;
+            stream->is_playing = true;
+            result = sound_id;
+            break;
         }
+    }
+    SDL_UnlockAudioDevice(g_AudioDeviceID);
 
-        return sound_id;
+    if (result == AUDIO_NO_SOUND) {
+        M_Free(&opened);
+        return AUDIO_NO_SOUND;
     }
 
-    return AUDIO_NO_SOUND;
+    // Keep the stream ready for the next time it is played, eg. for looped
+    // tracks that are interrupted by other tracks.
+    M_Prefetch(file_path, start_at, stop_at);
+    return result;
 }
 
 bool Audio_Stream_Close(int32_t sound_id)
@@ -474,48 +905,10 @@ bool Audio_Stream_Close(int32_t sound_id)
 
     AUDIO_STREAM_SOUND *stream = &m_Streams[sound_id];
 
-    if (stream->av.codec_ctx) {
-        avcodec_close(stream->av.codec_ctx);
-
-        // XXX: potential libav bug - avcodec_close should free this info
-        if (stream->av.codec_ctx->extradata != NULL) {
-            av_freep(&stream->av.codec_ctx->extradata);
-        }
-
-        av_free(stream->av.codec_ctx);
-        stream->av.codec_ctx = NULL;
-    }
-
-    if (stream->av.format_ctx) {
-        avformat_close_input(&stream->av.format_ctx);
-        stream->av.format_ctx = NULL;
-    }
-
-    if (stream->swr.ctx) {
-        swr_free(&stream->swr.ctx);
-    }
-
-    if (stream->av.frame) {
-        av_frame_free(&stream->av.frame);
-        stream->av.frame = NULL;
-    }
-
-    if (stream->av.packet) {
-        av_packet_free(&stream->av.packet);
-        stream->av.packet = NULL;
-    }
-
-    stream->av.stream = NULL;
-    stream->av.codec = NULL;
-
-    if (stream->sdl.stream) {
-        SDL_FreeAudioStream(stream->sdl.stream);
-    }
-
     void (*finish_callback)(int32_t, void *) = stream->finish_callback;
     void *finish_callback_user_data = stream->finish_callback_user_data;
 
-    M_Clear(stream);
+    M_Free(stream);
 
     SDL_UnlockAudioDevice(g_AudioDeviceID);
 
@@ -575,8 +968,9 @@ bool Audio_Stream_SetFinishCallback(
     return true;
 }
 
-void Audio_Stream_Mix(float *dst_buffer, size_t len)
+int32_t Audio_Stream_Mix(float *dst_buffer, size_t len)
 {
+    int32_t active_count = 0;
     for (int32_t sound_id = 0; sound_id < AUDIO_MAX_ACTIVE_STREAMS;
          sound_id++) {
         AUDIO_STREAM_SOUND *stream = &m_Streams[sound_id];
@@ -593,9 +987,10 @@ void Audio_Stream_Mix(float *dst_buffer, size_t len)
             }
         }
 
-        memset(m_MixBuffer, 0, READ_BUFFER_SIZE);
-        int32_t bytes_gotten = SDL_AudioStreamGet(
-            stream->sdl.stream, m_MixBuffer, READ_BUFFER_SIZE);
+        active_count++;
+        memset(m_MixBuffer, 0, len);
+        int32_t bytes_gotten =
+            SDL_AudioStreamGet(stream->sdl.stream, m_MixBuffer, len);
         if (bytes_gotten < 0) {
             LOG_ERROR("Error reading from sdl.stream: %s", SDL_GetError());
             stream->is_playing = false;
@@ -647,6 +1042,7 @@ void Audio_Stream_Mix(float *dst_buffer, size_t len)
             Audio_Stream_Close(sound_id);
         }
     }
+    return active_count;
 }
 
 double Audio_Stream_GetTimestamp(int32_t sound_id)
@@ -690,13 +1086,14 @@ bool Audio_Stream_SeekTimestamp(int32_t sound_id, double timestamp)
     }
 
     if (m_Streams[sound_id].is_playing) {
+        // The index is never built under the audio lock; until it is ready,
+        // the demuxer seeks instead.
+        M_RequestIndex(m_Streams[sound_id].path);
         SDL_LockAudioDevice(g_AudioDeviceID);
         AUDIO_STREAM_SOUND *stream = &m_Streams[sound_id];
-        const double time_base_sec = av_q2d(stream->av.stream->time_base);
-        av_seek_frame(
-            stream->av.format_ctx, 0, timestamp / time_base_sec,
-            AVSEEK_FLAG_ANY);
-        avcodec_flush_buffers(stream->av.codec_ctx);
+        M_SeekTo(stream, timestamp);
+        SDL_AudioStreamClear(stream->sdl.stream);
+        stream->is_read_done = false;
         SDL_UnlockAudioDevice(g_AudioDeviceID);
         return true;
     }
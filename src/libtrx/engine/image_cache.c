@@ -0,0 +1,371 @@
+#include "engine/image_cache.h"
+
+#include "debug.h"
+#include "log.h"
+#include "memory.h"
+
+#include <SDL2/SDL.h>
+#include <string.h>
+
+#define MAX_ENTRIES 8
+#define MAX_WORKERS 2
+// Decoded images are dropped in LRU order above this many bytes, although the
+// most recently decoded image is always kept.
+#define MAX_SIZE (64 * 1024 * 1024)
+
+typedef enum {
+    STATE_EMPTY,
+    STATE_PENDING,
+    STATE_DECODING,
+    STATE_READY,
+    STATE_FAILED,
+} M_STATE;
+
+typedef struct {
+    M_STATE state;
+    char *path;
+    int32_t width;
+    int32_t height;
+    IMAGE_FIT_MODE fit_mode;
+    IMAGE *image;
+    size_t size;
+    // Prefetched entries are not evicted by other prefetches until the game
+    // asks for them.
+    bool is_used;
+    // Request order for pending entries, use order for all the others.
+    uint32_t stamp;
+} M_ENTRY;
+
+static struct {
+    SDL_mutex *mutex;
+    SDL_cond *cond;
+    SDL_Thread *workers[MAX_WORKERS];
+    int32_t worker_count;
+    bool quit;
+    M_ENTRY entries[MAX_ENTRIES];
+    uint32_t stamp;
+    size_t size;
+    // Workers never drop the image that was returned last.
+    const M_ENTRY *last_used;
+    IMAGE_CACHE_STATS stats;
+} m_Cache = {};
+
+static void M_Init(void);
+static void M_ResetEntry(M_ENTRY *entry);
+static M_ENTRY *M_Find(
+    const char *path, int32_t width, int32_t height, IMAGE_FIT_MODE fit_mode);
+static M_ENTRY *M_Allocate(
+    const char *path, int32_t width, int32_t height, IMAGE_FIT_MODE fit_mode,
+    bool evict_unused);
+static size_t M_GetUnusedSize(void);
+static void M_Trim(const M_ENTRY *keep);
+static M_ENTRY *M_GetNextPending(void);
+static void M_DecodeEntry(M_ENTRY *entry);
+static int M_WorkerThread(void *arg);
+
+static void M_Init(void)
+{
+    if (m_Cache.mutex != NULL) {
+        return;
+    }
+
+    m_Cache.mutex = SDL_CreateMutex();
+    m_Cache.cond = SDL_CreateCond();
+    m_Cache.quit = false;
+    for (int32_t i = 0; i < MAX_WORKERS; i++) {
+        SDL_Thread *const thread =
+            SDL_CreateThread(M_WorkerThread, "image_cache", NULL);
+        if (thread == NULL) {
+            LOG_ERROR("SDL_CreateThread(): %s", SDL_GetError());
+            break;
+        }
+        m_Cache.workers[m_Cache.worker_count++] = thread;
+    }
+}
+
+static void M_ResetEntry(M_ENTRY *const entry)
+{
+    ASSERT(entry->state != STATE_DECODING);
+    Memory_FreePointer(&entry->path);
+    if (entry->image != NULL) {
+        Image_Free(entry->image);
+        entry->image = NULL;
+    }
+    m_Cache.size -= entry->size;
+    entry->size = 0;
+    entry->is_used = false;
+    entry->state = STATE_EMPTY;
+}
+
+static M_ENTRY *M_Find(
+    const char *const path, const int32_t width, const int32_t height,
+    const IMAGE_FIT_MODE fit_mode)
+{
+    for (int32_t i = 0; i < MAX_ENTRIES; i++) {
+        M_ENTRY *const entry = &m_Cache.entries[i];
+        if (entry->state != STATE_EMPTY && entry->width == width
+            && entry->height == height && entry->fit_mode == fit_mode
+            && strcmp(entry->path, path) == 0) {
+            return entry;
+        }
+    }
+    return NULL;
+}
+
+static M_ENTRY *M_Allocate(
+    const char *const path, const int32_t width, const int32_t height,
+    const IMAGE_FIT_MODE fit_mode, const bool evict_unused)
+{
+    M_ENTRY *victim = NULL;
+    for (int32_t i = 0; i < MAX_ENTRIES; i++) {
+        M_ENTRY *const entry = &m_Cache.entries[i];
+        if (entry->state == STATE_EMPTY) {
+            victim = entry;
+            break;
+        }
+        if (entry->state == STATE_DECODING
+            || (!entry->is_used && !evict_unused)) {
+            continue;
+        }
+        if (victim == NULL || entry->stamp < victim->stamp) {
+            victim = entry;
+        }
+    }
+
+    if (victim == NULL) {
+        return NULL;
+    }
+
+    M_ResetEntry(victim);
+    victim->state = STATE_PENDING;
+    victim->path = Memory_DupStr(path);
+    victim->width = width;
+    victim->height = height;
+    victim->fit_mode = fit_mode;
+    victim->stamp = ++m_Cache.stamp;
+    return victim;
+}
+
+static size_t M_GetUnusedSize(void)
+{
+    size_t result = 0;
+    for (int32_t i = 0; i < MAX_ENTRIES; i++) {
+        const M_ENTRY *const entry = &m_Cache.entries[i];
+        if (entry->state == STATE_EMPTY || entry->is_used) {
+            continue;
+        }
+        // Pending images are counted at their requested size.
+        result += entry->image != NULL
+            ? entry->size
+            : (size_t)entry->width * entry->height * sizeof(IMAGE_PIXEL);
+    }
+    return result;
+}
+
+static void M_Trim(const M_ENTRY *const keep)
+{
+    while (m_Cache.size > MAX_SIZE) {
+        // Drop used images first, then prefetched ones that were not shown
+        // yet; these get decoded again when needed.
+        M_ENTRY *victim = NULL;
+        for (int32_t i = 0; i < MAX_ENTRIES; i++) {
+            M_ENTRY *const entry = &m_Cache.entries[i];
+            if (entry == keep || entry == m_Cache.last_used
+                || entry->image == NULL
+                || entry->state != STATE_READY) {
+                continue;
+            }
+            if (victim == NULL || (entry->is_used && !victim->is_used)
+                || (entry->is_used == victim->is_used
+                    && entry->stamp < victim->stamp)) {
+                victim = entry;
+            }
+        }
+        if (victim == NULL) {
+            break;
+        }
+        M_ResetEntry(victim);
+    }
+}
+
+static M_ENTRY *M_GetNextPending(void)
+{
+    M_ENTRY *result = NULL;
+    for (int32_t i = 0; i < MAX_ENTRIES; i++) {
+        M_ENTRY *const entry = &m_Cache.entries[i];
+        if (entry->state == STATE_PENDING
+            && (result == NULL || entry->stamp < result->stamp)) {
+            result = entry;
+        }
+    }
+    return result;
+}
+
+// Must be called with the lock held; the lock is released while decoding.
+static void M_DecodeEntry(M_ENTRY *const entry)
+{
+    // Decoding entries are never evicted, so the key stays valid without
+    // the lock.
+    entry->state = STATE_DECODING;
+    SDL_UnlockMutex(m_Cache.mutex);
+
+    const Uint64 start = SDL_GetPerformanceCounter();
+    IMAGE *const image = entry->width > 0 && entry->height > 0
+        ? Image_CreateFromFileInto(
+              entry->path, entry->width, entry->height, entry->fit_mode)
+        : Image_CreateFromFile(entry->path);
+    const double time = (SDL_GetPerformanceCounter() - start) * 1000.0
+        / SDL_GetPerformanceFrequency();
+
+    SDL_LockMutex(m_Cache.mutex);
+    entry->image = image;
+    if (image != NULL) {
+        entry->size =
+            (size_t)image->width * image->height * sizeof(IMAGE_PIXEL);
+        m_Cache.size += entry->size;
+    }
+    entry->state = image != NULL ? STATE_READY : STATE_FAILED;
+    m_Cache.stats.decodes++;
+    if (image == NULL) {
+        m_Cache.stats.failures++;
+    }
+    m_Cache.stats.total_decode_time += time;
+    if (time > m_Cache.stats.max_decode_time) {
+        m_Cache.stats.max_decode_time = time;
+    }
+    LOG_DEBUG("Decoded %s in %.1f ms", entry->path, time);
+    M_Trim(entry);
+    SDL_CondBroadcast(m_Cache.cond);
+}
+
+static int M_WorkerThread(void *const arg)
+{
+    SDL_LockMutex(m_Cache.mutex);
+    while (!m_Cache.quit) {
+        M_ENTRY *const entry = M_GetNextPending();
+        if (entry == NULL) {
+            SDL_CondWait(m_Cache.cond, m_Cache.mutex);
+        } else {
+            M_DecodeEntry(entry);
+        }
+    }
+    SDL_UnlockMutex(m_Cache.mutex);
+    return 0;
+}
+
+void ImageCache_Shutdown(void)
+{
+    if (m_Cache.mutex == NULL) {
+        return;
+    }
+
+    SDL_LockMutex(m_Cache.mutex);
+    m_Cache.quit = true;
+    SDL_CondBroadcast(m_Cache.cond);
+    SDL_UnlockMutex(m_Cache.mutex);
+    for (int32_t i = 0; i < m_Cache.worker_count; i++) {
+        SDL_WaitThread(m_Cache.workers[i], NULL);
+        m_Cache.workers[i] = NULL;
+    }
+    m_Cache.worker_count = 0;
+
+    for (int32_t i = 0; i < MAX_ENTRIES; i++) {
+        M_ResetEntry(&m_Cache.entries[i]);
+    }
+
+    const IMAGE_CACHE_STATS *const stats = &m_Cache.stats;
+    LOG_INFO(
+        "Image cache: %d hits, %d late hits, %d misses, %d prefetches; "
+        "%d decodes (%d failed), %.1f ms average, %.1f ms max",
+        stats->hits, stats->late_hits, stats->misses, stats->prefetches,
+        stats->decodes, stats->failures,
+        stats->decodes > 0 ? stats->total_decode_time / stats->decodes : 0.0,
+        stats->max_decode_time);
+
+    SDL_DestroyCond(m_Cache.cond);
+    SDL_DestroyMutex(m_Cache.mutex);
+    m_Cache.cond = NULL;
+    m_Cache.mutex = NULL;
+}
+
+bool ImageCache_Prefetch(
+    const char *const path, const int32_t width, const int32_t height,
+    const IMAGE_FIT_MODE fit_mode)
+{
+    ASSERT(path != NULL);
+    M_Init();
+
+    SDL_LockMutex(m_Cache.mutex);
+    bool result = M_Find(path, width, height, fit_mode) != NULL;
+    // If the cache is already full of images that were not used yet, the
+    // request is dropped and the image gets decoded when it is needed.
+    const size_t size = (size_t)width * height * sizeof(IMAGE_PIXEL);
+    if (!result && M_GetUnusedSize() + size <= MAX_SIZE
+        && M_Allocate(path, width, height, fit_mode, false) != NULL) {
+        m_Cache.stats.prefetches++;
+        SDL_CondBroadcast(m_Cache.cond);
+        result = true;
+    }
+    SDL_UnlockMutex(m_Cache.mutex);
+    return result;
+}
+
+bool ImageCache_IsReady(
+    const char *const path, const int32_t width, const int32_t height,
+    const IMAGE_FIT_MODE fit_mode)
+{
+    ASSERT(path != NULL);
+    M_Init();
+
+    SDL_LockMutex(m_Cache.mutex);
+    const M_ENTRY *const entry = M_Find(path, width, height, fit_mode);
+    const bool result = entry != NULL
+        && (entry->state == STATE_READY || entry->state == STATE_FAILED);
+    SDL_UnlockMutex(m_Cache.mutex);
+    return result;
+}
+
+const IMAGE *ImageCache_Get(
+    const char *const path, const int32_t width, const int32_t height,
+    const IMAGE_FIT_MODE fit_mode)
+{
+    ASSERT(path != NULL);
+    M_Init();
+
+    SDL_LockMutex(m_Cache.mutex);
+    M_ENTRY *entry = M_Find(path, width, height, fit_mode);
+    if (entry == NULL) {
+        m_Cache.stats.misses++;
+        entry = M_Allocate(path, width, height, fit_mode, true);
+        ASSERT(entry != NULL);
+        M_DecodeEntry(entry);
+    } else if (entry->state == STATE_PENDING) {
+        // No worker got to it yet; this is quicker than waiting.
+        m_Cache.stats.misses++;
+        M_DecodeEntry(entry);
+    } else if (entry->state == STATE_DECODING) {
+        m_Cache.stats.late_hits++;
+        while (entry->state == STATE_DECODING) {
+            SDL_CondWait(m_Cache.cond, m_Cache.mutex);
+        }
+    } else {
+        m_Cache.stats.hits++;
+    }
+    entry->stamp = ++m_Cache.stamp;
+    entry->is_used = true;
+    m_Cache.last_used = entry;
+    const IMAGE *const image = entry->image;
+    SDL_UnlockMutex(m_Cache.mutex);
+    return image;
+}
+
+IMAGE_CACHE_STATS ImageCache_GetStats(void)
+{
+    if (m_Cache.mutex == NULL) {
+        return m_Cache.stats;
+    }
+    SDL_LockMutex(m_Cache.mutex);
+    const IMAGE_CACHE_STATS stats = m_Cache.stats;
+    SDL_UnlockMutex(m_Cache.mutex);
+    return stats;
+}
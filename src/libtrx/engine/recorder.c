@@ -0,0 +1,625 @@
+#include "engine/recorder.h"
+
+#include "audio_internal.h"
+#include "debug.h"
+#include "filesystem.h"
+#include "log.h"
+#include "memory.h"
+#include "utils.h"
+
+#include <SDL2/SDL.h>
+#include <errno.h>
+#include <libavcodec/avcodec.h>
+#include <libavformat/avformat.h>
+#include <libavutil/channel_layout.h>
+#include <libavutil/error.h>
+#include <libavutil/frame.h>
+#include <libavutil/pixfmt.h>
+#include <libswscale/swscale.h>
+#include <string.h>
+
+#define MAX_QUEUED_FRAMES 8
+#define VIDEO_BIT_RATE 8000000
+#define AUDIO_BIT_RATE 192000
+// About three seconds of audio; the encoder drains it every few
+// milliseconds. Must be a power of two.
+#define AUDIO_RING_SIZE (1 << 18)
+#define ENCODER_POLL_MS 10
+
+typedef struct {
+    IMAGE *image;
+    int32_t timestamp;
+} M_FRAME;
+
+typedef struct {
+    AVCodecContext *codec_ctx;
+    AVStream *stream;
+    AVFrame *frame;
+} M_OUTPUT;
+
+static struct {
+    SDL_atomic_t is_active;
+    SDL_Thread *thread;
+    SDL_mutex *mutex;
+    SDL_cond *cond;
+    bool quit;
+    uint32_t start_ticks;
+
+    M_FRAME frames[MAX_QUEUED_FRAMES];
+    int32_t frame_head;
+    int32_t frame_count;
+
+    RECORDER_STATS stats;
+} m_Recorder = {};
+
+// Single producer, single consumer ring written by the mixer callback and
+// read by the encoder thread, so that the mixer never takes a lock. Both
+// positions only ever grow and are wrapped when indexing.
+static struct {
+    float samples[AUDIO_RING_SIZE];
+    SDL_atomic_t head;
+    SDL_atomic_t tail;
+    SDL_atomic_t dropped;
+} m_Audio = {};
+
+// Owned by the encoder thread.
+static struct {
+    AVFormatContext *format_ctx;
+    bool header_written;
+    M_OUTPUT video;
+    M_OUTPUT audio;
+    AVPacket *packet;
+    struct SwsContext *sws_ctx;
+    int64_t last_video_pts;
+    int64_t audio_pts;
+    float *audio_buffer;
+} m_Encoder = {};
+
+static void M_CloseOutput(M_OUTPUT *output);
+static bool M_OpenOutput(M_OUTPUT *output, const AVCodec *codec);
+static bool M_OpenVideo(int32_t width, int32_t height);
+static bool M_OpenAudio(void);
+static bool M_WriteHeader(int32_t width, int32_t height);
+static bool M_WritePackets(M_OUTPUT *output);
+static bool M_EncodeFrame(M_OUTPUT *output, AVFrame *frame);
+static bool M_EncodeVideo(const M_FRAME *frame);
+static size_t M_ReadAudio(float *samples, size_t count, bool partial);
+static bool M_EncodeAudio(bool flush);
+static void M_Finish(void);
+static int M_EncoderThread(void *arg);
+
+static void M_CloseOutput(M_OUTPUT *const output)
+{
+    if (output->codec_ctx != NULL) {
+        avcodec_free_context(&output->codec_ctx);
+    }
+    if (output->frame != NULL) {
+        av_frame_free(&output->frame);
+    }
+    output->stream = NULL;
+}
+
+static bool M_OpenOutput(M_OUTPUT *const output, const AVCodec *const codec)
+{
+    AVCodecContext *const codec_ctx = output->codec_ctx;
+    if (m_Encoder.format_ctx->oformat->flags & AVFMT_GLOBALHEADER) {
+        codec_ctx->flags |= AV_CODEC_FLAG_GLOBAL_HEADER;
+    }
+
+    int error_code = avcodec_open2(codec_ctx, codec, NULL);
+    if (error_code < 0) {
+        LOG_ERROR(
+            "Cannot open %s encoder: %s", codec->name, av_err2str(error_code));
+        return false;
+    }
+
+    output->stream = avformat_new_stream(m_Encoder.format_ctx, NULL);
+    if (output->stream == NULL) {
+        return false;
+    }
+    output->stream->time_base = codec_ctx->time_base;
+    error_code =
+        avcodec_parameters_from_context(output->stream->codecpar, codec_ctx);
+    if (error_code < 0) {
+        return false;
+    }
+
+    output->frame = av_frame_alloc();
+    return output->frame != NULL;
+}
+
+static bool M_OpenVideo(const int32_t width, const int32_t height)
+{
+    const AVCodec *codec =
+        avcodec_find_encoder(m_Encoder.format_ctx->oformat->video_codec);
+    if (codec == NULL) {
+        codec = avcodec_find_encoder(AV_CODEC_ID_MPEG4);
+    }
+    if (codec == NULL) {
+        LOG_ERROR("No video encoder available");
+        return false;
+    }
+
+    AVCodecContext *const codec_ctx = avcodec_alloc_context3(codec);
+    if (codec_ctx == NULL) {
+        return false;
+    }
+    m_Encoder.video.codec_ctx = codec_ctx;
+
+    // YUV 4:2:0 needs even dimensions
+    codec_ctx->width = width & ~1;
+    codec_ctx->height = height & ~1;
+    codec_ctx->pix_fmt = AV_PIX_FMT_YUV420P;
+    codec_ctx->bit_rate = VIDEO_BIT_RATE;
+    codec_ctx->gop_size = 60;
+    // Frames are timed by when they were presented, so the frame rate may
+    // vary.
+    codec_ctx->time_base = (AVRational) { 1, 1000 };
+
+    codec_ctx->thread_count = 0;
+    if (codec->capabilities & AV_CODEC_CAP_FRAME_THREADS) {
+        codec_ctx->thread_type = FF_THREAD_FRAME;
+    } else if (codec->capabilities & AV_CODEC_CAP_SLICE_THREADS) {
+        codec_ctx->thread_type = FF_THREAD_SLICE;
+    } else {
+        codec_ctx->thread_count = 1;
+    }
+
+    if (!M_OpenOutput(&m_Encoder.video, codec)) {
+        return false;
+    }
+
+    AVFrame *const frame = m_Encoder.video.frame;
+    frame->format = codec_ctx->pix_fmt;
+    frame->width = codec_ctx->width;
+    frame->height = codec_ctx->height;
+    return av_frame_get_buffer(frame, 0) >= 0;
+}
+
+static bool M_OpenAudio(void)
+{
+    const enum AVCodecID codec_id = m_Encoder.format_ctx->oformat->audio_codec;
+    if (codec_id == AV_CODEC_ID_NONE) {
+        return true;
+    }
+
+    const AVCodec *const codec = avcodec_find_encoder(codec_id);
+    if (codec == NULL) {
+        LOG_WARNING("No audio encoder available, recording without sound");
+        return true;
+    }
+
+    enum AVSampleFormat sample_fmt = AV_SAMPLE_FMT_FLTP;
+    if (codec->sample_fmts != NULL) {
+        sample_fmt = codec->sample_fmts[0];
+    }
+    if (sample_fmt != AV_SAMPLE_FMT_FLTP && sample_fmt != AV_SAMPLE_FMT_FLT) {
+        LOG_WARNING(
+            "Unsupported %s sample format, recording without sound",
+            codec->name);
+        return true;
+    }
+
+    AVCodecContext *const codec_ctx = avcodec_alloc_context3(codec);
+    if (codec_ctx == NULL) {
+        return false;
+    }
+    m_Encoder.audio.codec_ctx = codec_ctx;
+
+    codec_ctx->sample_fmt = sample_fmt;
+    codec_ctx->sample_rate = AUDIO_WORKING_RATE;
+    codec_ctx->channel_layout =
+        Audio_GetAVChannelLayout(AUDIO_WORKING_CHANNELS);
+    codec_ctx->channels = AUDIO_WORKING_CHANNELS;
+    codec_ctx->bit_rate = AUDIO_BIT_RATE;
+    codec_ctx->time_base = (AVRational) { 1, AUDIO_WORKING_RATE };
+
+    if (!M_OpenOutput(&m_Encoder.audio, codec)) {
+        return false;
+    }
+
+    AVFrame *const frame = m_Encoder.audio.frame;
+    frame->format = codec_ctx->sample_fmt;
+    frame->channel_layout = codec_ctx->channel_layout;
+    frame->sample_rate = codec_ctx->sample_rate;
+    frame->nb_samples = codec_ctx->frame_size;
+    if (frame->nb_samples == 0
+        || (codec->capabilities & AV_CODEC_CAP_VARIABLE_FRAME_SIZE)) {
+        frame->nb_samples = AUDIO_SAMPLES * 2;
+    }
+    if (av_frame_get_buffer(frame, 0) < 0) {
+        return false;
+    }
+
+    m_Encoder.audio_buffer = Memory_Alloc(
+        sizeof(float) * frame->nb_samples * AUDIO_WORKING_CHANNELS);
+    return true;
+}
+
+static bool M_WriteHeader(const int32_t width, const int32_t height)
+{
+    if (!M_OpenVideo(width, height) || !M_OpenAudio()) {
+        return false;
+    }
+
+    const int error_code = avformat_write_header(m_Encoder.format_ctx, NULL);
+    if (error_code < 0) {
+        LOG_ERROR("Cannot write video header: %s", av_err2str(error_code));
+        return false;
+    }
+    m_Encoder.header_written = true;
+    m_Encoder.last_video_pts = -1;
+    m_Encoder.audio_pts = 0;
+    return true;
+}
+
+static bool M_WritePackets(M_OUTPUT *const output)
+{
+    AVPacket *const packet = m_Encoder.packet;
+    while (true) {
+        int error_code = avcodec_receive_packet(output->codec_ctx, packet);
+        if (error_code == AVERROR(EAGAIN) || error_code == AVERROR_EOF) {
+            return true;
+        }
+        if (error_code < 0) {
+            LOG_ERROR("Error while encoding: %s", av_err2str(error_code));
+            return false;
+        }
+
+        av_packet_rescale_ts(
+            packet, output->codec_ctx->time_base, output->stream->time_base);
+        packet->stream_index = output->stream->index;
+        error_code = av_interleaved_write_frame(m_Encoder.format_ctx, packet);
+        if (error_code < 0) {
+            LOG_ERROR("Error while writing video: %s", av_err2str(error_code));
+            return false;
+        }
+    }
+}
+
+static bool M_EncodeFrame(M_OUTPUT *const output, AVFrame *const frame)
+{
+    const int error_code = avcodec_send_frame(output->codec_ctx, frame);
+    if (error_code < 0) {
+        LOG_ERROR("Error while encoding: %s", av_err2str(error_code));
+        return false;
+    }
+    return M_WritePackets(output);
+}
+
+static bool M_EncodeVideo(const M_FRAME *const frame)
+{
+    const IMAGE *const image = frame->image;
+    if (!m_Encoder.header_written
+        && !M_WriteHeader(image->width, image->height)) {
+        return false;
+    }
+
+    // Frames presented within the same millisecond would share a timestamp.
+    if (frame->timestamp <= m_Encoder.last_video_pts) {
+        return true;
+    }
+
+    AVFrame *const dst = m_Encoder.video.frame;
+    m_Encoder.sws_ctx = sws_getCachedContext(
+        m_Encoder.sws_ctx, image->width, image->height, AV_PIX_FMT_RGB24,
+        dst->width, dst->height, dst->format, SWS_BILINEAR, NULL, NULL, NULL);
+    if (m_Encoder.sws_ctx == NULL) {
+        LOG_ERROR("Failed to get SWS context");
+        return false;
+    }
+
+    if (av_frame_make_writable(dst) < 0) {
+        return false;
+    }
+
+    // The image is stored bottom-up; a negative stride flips it during the
+    // conversion.
+    const int pitch = image->width * sizeof(IMAGE_PIXEL);
+    const uint8_t *const src_planes[1] = {
+        (const uint8_t *)image->data + (image->height - 1) * pitch,
+    };
+    const int src_linesize[1] = { -pitch };
+    sws_scale(
+        m_Encoder.sws_ctx, src_planes, src_linesize, 0, image->height,
+        dst->data, dst->linesize);
+
+    dst->pts = frame->timestamp;
+    m_Encoder.last_video_pts = frame->timestamp;
+    return M_EncodeFrame(&m_Encoder.video, dst);
+}
+
+static size_t M_ReadAudio(
+    float *const samples, const size_t count, const bool partial)
+{
+    const uint32_t tail = SDL_AtomicGet(&m_Audio.tail);
+    const uint32_t available = (uint32_t)SDL_AtomicGet(&m_Audio.head) - tail;
+    const size_t len = MIN(count, available);
+    if (len == 0 || (len < count && !partial)) {
+        return 0;
+    }
+
+    // see the samples written before the head was moved past them
+    SDL_MemoryBarrierAcquire();
+    if (samples != NULL) {
+        for (size_t i = 0; i < len; i++) {
+            samples[i] = m_Audio.samples[(tail + i) & (AUDIO_RING_SIZE - 1)];
+        }
+    }
+    SDL_AtomicSet(&m_Audio.tail, tail + len);
+    return len;
+}
+
+static bool M_EncodeAudio(const bool flush)
+{
+    M_OUTPUT *const output = &m_Encoder.audio;
+    if (output->codec_ctx == NULL) {
+        // drop the sound if there is nothing to encode it with
+        M_ReadAudio(NULL, AUDIO_RING_SIZE, true);
+        return true;
+    }
+
+    AVFrame *const frame = output->frame;
+    const size_t frame_len = frame->nb_samples * AUDIO_WORKING_CHANNELS;
+    while (true) {
+        const size_t len =
+            M_ReadAudio(m_Encoder.audio_buffer, frame_len, flush);
+        if (len == 0) {
+            return true;
+        }
+
+        // pad the last frame with silence
+        memset(
+            &m_Encoder.audio_buffer[len], 0, (frame_len - len) * sizeof(float));
+
+        if (av_frame_make_writable(frame) < 0) {
+            return false;
+        }
+        if (frame->format == AV_SAMPLE_FMT_FLT) {
+            memcpy(
+                frame->data[0], m_Encoder.audio_buffer,
+                frame_len * sizeof(float));
+        } else {
+            for (int32_t i = 0; i < frame->nb_samples; i++) {
+                for (int32_t j = 0; j < AUDIO_WORKING_CHANNELS; j++) {
+                    ((float *)frame->data[j])[i] =
+                        m_Encoder.audio_buffer[i * AUDIO_WORKING_CHANNELS + j];
+                }
+            }
+        }
+
+        frame->pts = m_Encoder.audio_pts;
+        m_Encoder.audio_pts += frame->nb_samples;
+        if (!M_EncodeFrame(output, frame)) {
+            return false;
+        }
+    }
+}
+
+static void M_Finish(void)
+{
+    if (m_Encoder.header_written) {
+        M_EncodeAudio(true);
+        if (m_Encoder.audio.codec_ctx != NULL) {
+            M_EncodeFrame(&m_Encoder.audio, NULL);
+        }
+        M_EncodeFrame(&m_Encoder.video, NULL);
+        av_write_trailer(m_Encoder.format_ctx);
+    }
+
+    M_CloseOutput(&m_Encoder.video);
+    M_CloseOutput(&m_Encoder.audio);
+    if (m_Encoder.sws_ctx != NULL) {
+        sws_freeContext(m_Encoder.sws_ctx);
+        m_Encoder.sws_ctx = NULL;
+    }
+    if (m_Encoder.packet != NULL) {
+        av_packet_free(&m_Encoder.packet);
+    }
+    if (m_Encoder.format_ctx != NULL) {
+        avio_closep(&m_Encoder.format_ctx->pb);
+        avformat_free_context(m_Encoder.format_ctx);
+        m_Encoder.format_ctx = NULL;
+    }
+    Memory_FreePointer(&m_Encoder.audio_buffer);
+    m_Encoder.header_written = false;
+}
+
+static int M_EncoderThread(void *const arg)
+{
+    bool is_ok = true;
+    SDL_LockMutex(m_Recorder.mutex);
+    while (true) {
+        if (m_Recorder.frame_count == 0) {
+            if (m_Recorder.quit) {
+                break;
+            }
+            // wake up regularly to keep the audio ring drained
+            SDL_CondWaitTimeout(
+                m_Recorder.cond, m_Recorder.mutex, ENCODER_POLL_MS);
+        }
+
+        M_FRAME frame = { .image = NULL };
+        if (m_Recorder.frame_count > 0) {
+            frame = m_Recorder.frames[m_Recorder.frame_head];
+            m_Recorder.frame_head =
+                (m_Recorder.frame_head + 1) % MAX_QUEUED_FRAMES;
+            m_Recorder.frame_count--;
+            m_Recorder.stats.queue_depth = m_Recorder.frame_count;
+        }
+        SDL_UnlockMutex(m_Recorder.mutex);
+
+        if (frame.image != NULL) {
+            if (is_ok) {
+                is_ok = M_EncodeVideo(&frame);
+            }
+            Image_Free(frame.image);
+        }
+        // audio is only muxed once the video stream exists
+        if (is_ok && m_Encoder.header_written) {
+            is_ok = M_EncodeAudio(false);
+        }
+
+        SDL_LockMutex(m_Recorder.mutex);
+        if (frame.image != NULL && is_ok) {
+            m_Recorder.stats.frames_encoded++;
+        }
+    }
+    SDL_UnlockMutex(m_Recorder.mutex);
+
+    if (!is_ok) {
+        LOG_ERROR("Recording aborted");
+    }
+    M_Finish();
+    return 0;
+}
+
+bool Recorder_Start(const char *const path)
+{
+    if (Recorder_IsActive()) {
+        return false;
+    }
+
+    int error_code = avformat_alloc_output_context2(
+        &m_Encoder.format_ctx, NULL, NULL, path);
+    if (error_code < 0) {
+        LOG_ERROR(
+            "Cannot determine video format of '%s': %s", path,
+            av_err2str(error_code));
+        return false;
+    }
+
+    error_code = avio_open(&m_Encoder.format_ctx->pb, path, AVIO_FLAG_WRITE);
+    if (error_code < 0) {
+        LOG_ERROR(
+            "Cannot create video file '%s': %s", path, av_err2str(error_code));
+        M_Finish();
+        return false;
+    }
+    File_InvalidateIndex();
+
+    m_Encoder.packet = av_packet_alloc();
+    if (m_Encoder.packet == NULL) {
+        M_Finish();
+        return false;
+    }
+
+    if (m_Recorder.mutex == NULL) {
+        m_Recorder.mutex = SDL_CreateMutex();
+        m_Recorder.cond = SDL_CreateCond();
+    }
+    m_Recorder.quit = false;
+    m_Recorder.frame_head = 0;
+    m_Recorder.frame_count = 0;
+    m_Recorder.stats = (RECORDER_STATS) {};
+    // the mixer only writes while recording, so this is safe to reset here
+    SDL_AtomicSet(&m_Audio.head, 0);
+    SDL_AtomicSet(&m_Audio.tail, 0);
+    SDL_AtomicSet(&m_Audio.dropped, 0);
+
+    m_Recorder.thread =
+        SDL_CreateThread(M_EncoderThread, "video_encoder", NULL);
+    if (m_Recorder.thread == NULL) {
+        LOG_ERROR("SDL_CreateThread(): %s", SDL_GetError());
+        M_Finish();
+        return false;
+    }
+
+    m_Recorder.start_ticks = SDL_GetTicks();
+    SDL_AtomicSet(&m_Recorder.is_active, 1);
+    LOG_INFO("Recording to %s", path);
+    return true;
+}
+
+void Recorder_Stop(void)
+{
+    if (!Recorder_IsActive()) {
+        return;
+    }
+    SDL_AtomicSet(&m_Recorder.is_active, 0);
+
+    SDL_LockMutex(m_Recorder.mutex);
+    m_Recorder.quit = true;
+    SDL_CondSignal(m_Recorder.cond);
+    SDL_UnlockMutex(m_Recorder.mutex);
+    SDL_WaitThread(m_Recorder.thread, NULL);
+    m_Recorder.thread = NULL;
+
+    const RECORDER_STATS stats = Recorder_GetStats();
+    LOG_INFO(
+        "Recording finished: %d frames encoded, %d dropped, queue peak %d, "
+        "%d audio samples dropped",
+        stats.frames_encoded, stats.frames_dropped, stats.max_queue_depth,
+        stats.audio_samples_dropped);
+}
+
+bool Recorder_IsActive(void)
+{
+    return SDL_AtomicGet(&m_Recorder.is_active) != 0;
+}
+
+int32_t Recorder_GetTimestamp(void)
+{
+    return SDL_GetTicks() - m_Recorder.start_ticks;
+}
+
+void Recorder_PushFrame(IMAGE *const image, const int32_t timestamp)
+{
+    ASSERT(image != NULL);
+    if (!Recorder_IsActive()) {
+        Image_Free(image);
+        return;
+    }
+
+    SDL_LockMutex(m_Recorder.mutex);
+    if (m_Recorder.frame_count == MAX_QUEUED_FRAMES) {
+        m_Recorder.stats.frames_dropped++;
+        SDL_UnlockMutex(m_Recorder.mutex);
+        Image_Free(image);
+        return;
+    }
+
+    const int32_t idx =
+        (m_Recorder.frame_head + m_Recorder.frame_count) % MAX_QUEUED_FRAMES;
+    m_Recorder.frames[idx].image = image;
+    m_Recorder.frames[idx].timestamp = timestamp;
+    m_Recorder.frame_count++;
+    m_Recorder.stats.queue_depth = m_Recorder.frame_count;
+    m_Recorder.stats.max_queue_depth =
+        MAX(m_Recorder.stats.max_queue_depth, m_Recorder.frame_count);
+    SDL_CondSignal(m_Recorder.cond);
+    SDL_UnlockMutex(m_Recorder.mutex);
+}
+
+void Recorder_PushAudio(const float *const samples, const size_t count)
+{
+    if (!Recorder_IsActive()) {
+        return;
+    }
+
+    const uint32_t head = SDL_AtomicGet(&m_Audio.head);
+    const uint32_t used = head - (uint32_t)SDL_AtomicGet(&m_Audio.tail);
+    const size_t len = MIN(count, AUDIO_RING_SIZE - used);
+    for (size_t i = 0; i < len; i++) {
+        m_Audio.samples[(head + i) & (AUDIO_RING_SIZE - 1)] = samples[i];
+    }
+    // publish the samples before moving the head past them
+    SDL_MemoryBarrierRelease();
+    SDL_AtomicSet(&m_Audio.head, head + len);
+
+    if (len < count) {
+        SDL_AtomicAdd(&m_Audio.dropped, count - len);
+    }
+}
+
+RECORDER_STATS Recorder_GetStats(void)
+{
+    if (m_Recorder.mutex == NULL) {
+        return (RECORDER_STATS) {};
+    }
+    SDL_LockMutex(m_Recorder.mutex);
+    RECORDER_STATS stats = m_Recorder.stats;
+    SDL_UnlockMutex(m_Recorder.mutex);
+    stats.audio_samples_dropped = SDL_AtomicGet(&m_Audio.dropped);
+    return stats;
+}
@@ -119,6 +119,20 @@ typedef struct {
     int *queue_serial;
 } M_CLOCK;
 
+typedef struct {
+    int width;
+    int height;
+    enum AVPixelFormat pixel_format;
+    int32_t stride;
+} M_SURFACE_PARAMS;
+
+typedef struct {
+    int x;
+    int y;
+    int width;
+    int height;
+} M_RECT;
+
 typedef struct {
     AVFrame *frame;
     int serial;
@@ -129,6 +143,12 @@ typedef struct {
     int height;
     int format;
     AVRational sar;
+
+    // video frames only: the frame converted for the surface, if the video
+    // thread could do it ahead of time
+    void *surface;
+    M_SURFACE_PARAMS surface_params;
+    bool is_staged;
 } M_FRAME;
 
 typedef struct {
@@ -142,6 +162,8 @@ typedef struct {
     SDL_mutex *mutex;
     SDL_cond *cond;
     M_PACKET_QUEUE *pktq;
+    // time the producer spent waiting for a free slot
+    int64_t wait_time;
 } M_FRAME_QUEUE;
 
 typedef enum {
@@ -229,6 +251,8 @@ typedef struct {
     double max_frame_duration; // maximum duration of a frame - above this, we
                                // consider the jump a timestamp discontinuity
     struct SwsContext *img_convert_ctx;
+    struct SwsContext *stage_convert_ctx;
+    VIDEO_STATS stats;
     bool eof;
 
     char *filename;
@@ -264,6 +288,9 @@ typedef struct {
 
     void (*surface_upload_func)(void *surface, void *user_data);
     void *surface_upload_func_user_data;
+
+    VIDEO_YUV_UPLOAD_FUNC yuv_upload_func;
+    void *yuv_upload_func_user_data;
 } M_STATE;
 
 static int64_t m_AudioCallbackTime;
@@ -599,8 +626,12 @@ static M_FRAME *M_FrameQueuePeekLast(M_FRAME_QUEUE *f)
 static M_FRAME *M_FrameQueuePeekWritable(M_FRAME_QUEUE *f)
 {
     SDL_LockMutex(f->mutex);
-    while (f->size >= f->max_size && !f->pktq->abort_request) {
-        SDL_CondWait(f->cond, f->mutex);
+    if (f->size >= f->max_size && !f->pktq->abort_request) {
+        const int64_t wait_start = av_gettime_relative();
+        while (f->size >= f->max_size && !f->pktq->abort_request) {
+            SDL_CondWait(f->cond, f->mutex);
+        }
+        f->wait_time += av_gettime_relative() - wait_start;
     }
     SDL_UnlockMutex(f->mutex);
 
@@ -691,75 +722,215 @@ static void M_ReallocPrimarySurface(
     }
 }
 
-static void M_RecalcSurfaceTargetRect(
-    M_STATE *is, int32_t frame_width, int32_t frame_height)
+static M_SURFACE_PARAMS M_GetSurfaceParams(M_STATE *is)
+{
+    return (M_SURFACE_PARAMS) {
+        .width = is->surface_width,
+        .height = is->surface_height,
+        .pixel_format = is->primary_surface_pixel_format,
+        .stride = is->primary_surface_stride,
+    };
+}
+
+static bool M_SurfaceParamsEqual(
+    const M_SURFACE_PARAMS *a, const M_SURFACE_PARAMS *b)
+{
+    return a->width == b->width && a->height == b->height
+        && a->pixel_format == b->pixel_format && a->stride == b->stride;
+}
+
+static M_RECT M_GetTargetRect(
+    const M_SURFACE_PARAMS *params, int32_t frame_width, int32_t frame_height)
 {
     const float source_ratio = frame_width / (float)frame_height;
-    const float target_ratio = is->surface_width / (float)is->surface_height;
+    const float target_ratio = params->width / (float)params->height;
 
-    is->target_surface_width = source_ratio < target_ratio
-        ? is->surface_height * source_ratio
-        : is->surface_width;
-    is->target_surface_height = source_ratio < target_ratio
-        ? is->surface_height
-        : is->surface_width / source_ratio;
-    is->target_surface_x = (is->surface_width - is->target_surface_width) / 2;
-    is->target_surface_y = (is->surface_height - is->target_surface_height) / 2;
+    M_RECT rect;
+    rect.width = source_ratio < target_ratio ? params->height * source_ratio
+                                             : params->width;
+    rect.height = source_ratio < target_ratio ? params->height
+                                              : params->width / source_ratio;
+    rect.x = (params->width - rect.width) / 2;
+    rect.y = (params->height - rect.height) / 2;
+    return rect;
 }
 
-static int M_UploadTexture(M_STATE *is, AVFrame *frame)
+static void M_RecalcSurfaceTargetRect(
+    M_STATE *is, int32_t frame_width, int32_t frame_height)
 {
-    int ret = 0;
+    const M_SURFACE_PARAMS params = M_GetSurfaceParams(is);
+    const M_RECT rect = M_GetTargetRect(&params, frame_width, frame_height);
+    is->target_surface_x = rect.x;
+    is->target_surface_y = rect.y;
+    is->target_surface_width = rect.width;
+    is->target_surface_height = rect.height;
+}
+
+static bool M_IsYUVFrame(M_STATE *is, const AVFrame *frame)
+{
+    return is->yuv_upload_func != NULL
+        && (frame->format == AV_PIX_FMT_YUV420P
+            || frame->format == AV_PIX_FMT_YUVJ420P);
+}
+
+static bool M_UploadYUV(M_STATE *is, const AVFrame *frame)
+{
+    if (!M_IsYUVFrame(is, frame)) {
+        return false;
+    }
+
+    VIDEO_YUV_FRAME yuv = {
+        .width = frame->width,
+        .height = frame->height,
+        .is_full_range = frame->format == AV_PIX_FMT_YUVJ420P
+            || frame->color_range == AVCOL_RANGE_JPEG,
+        // untagged HD videos are most likely BT.709
+        .is_bt709 = frame->colorspace == AVCOL_SPC_BT709
+            || (frame->colorspace == AVCOL_SPC_UNSPECIFIED
+                && frame->height >= 720),
+    };
+    for (int i = 0; i < 3; i++) {
+        yuv.planes[i] = frame->data[i];
+        yuv.pitches[i] = frame->linesize[i];
+    }
+
+    const float u0 = -is->target_surface_x / (float)is->target_surface_width;
+    const float u1 = (is->surface_width - is->target_surface_x)
+        / (float)is->target_surface_width;
+    const float v0 = -is->target_surface_y / (float)is->target_surface_height;
+    const float v1 = (is->surface_height - is->target_surface_y)
+        / (float)is->target_surface_height;
+    yuv.uv[0].u = u0;
+    yuv.uv[0].v = v0;
+    yuv.uv[1].u = u1;
+    yuv.uv[1].v = v0;
+    yuv.uv[2].u = u1;
+    yuv.uv[2].v = v1;
+    yuv.uv[3].u = u0;
+    yuv.uv[3].v = v1;
+
+    is->render_begin_func(is->primary_surface, is->render_begin_func_user_data);
+    is->yuv_upload_func(&yuv, is->yuv_upload_func_user_data);
+    is->render_end_func(is->primary_surface, is->render_end_func_user_data);
+    return true;
+}
+
+static int M_ConvertFrame(
+    M_STATE *is, struct SwsContext **convert_ctx, const AVFrame *frame,
+    void *surface, const M_SURFACE_PARAMS *params)
+{
+    const M_RECT rect = M_GetTargetRect(params, frame->width, frame->height);
+    *convert_ctx = sws_getCachedContext(
+        *convert_ctx, frame->width, frame->height, frame->format, rect.width,
+        rect.height, params->pixel_format, SWS_BILINEAR, NULL, NULL, NULL);
+    if (*convert_ctx == NULL) {
+        LOG_ERROR("Cannot initialize the conversion context");
+        return -1;
+    }
 
-    is->img_convert_ctx = sws_getCachedContext(
-        is->img_convert_ctx, frame->width, frame->height, frame->format,
-        is->target_surface_width, is->target_surface_height,
-        is->primary_surface_pixel_format, SWS_BILINEAR, NULL, NULL, NULL);
+    void *pixels =
+        is->surface_lock_func(surface, is->surface_lock_func_user_data);
+    if (pixels == NULL) {
+        return -1;
+    }
 
-    if (is->img_convert_ctx) {
-        is->render_begin_func(
-            is->primary_surface, is->render_begin_func_user_data);
+    uint8_t *surf_planes[4] = { pixels, NULL, NULL, NULL };
+    int surf_linesize[4] = {};
+    if (params->stride > 0) {
+        surf_linesize[0] = params->stride;
+    } else {
+        surf_linesize[0] =
+            av_image_get_linesize(params->pixel_format, params->width, 0);
+    }
 
-        void *pixels = is->surface_lock_func(
-            is->primary_surface, is->surface_lock_func_user_data);
+    surf_planes[0] += rect.y * surf_linesize[0];
+    surf_planes[0] += av_image_get_linesize(params->pixel_format, rect.x, 0);
 
-        if (pixels != NULL) {
-            uint8_t *surf_planes[4] = { pixels, NULL, NULL, NULL };
-            int surf_linesize[4] = {};
-            if (is->primary_surface_stride > 0) {
-                surf_linesize[0] = is->primary_surface_stride;
-            } else {
-                surf_linesize[0] = av_image_get_linesize(
-                    is->primary_surface_pixel_format, is->surface_width, 0);
-            }
+    sws_scale(
+        *convert_ctx, (const uint8_t *const *)frame->data, frame->linesize, 0,
+        frame->height, surf_planes, surf_linesize);
 
-            surf_planes[0] += is->target_surface_y * surf_linesize[0];
-            surf_planes[0] += av_image_get_linesize(
-                is->primary_surface_pixel_format, is->target_surface_x, 0);
+    is->surface_unlock_func(surface, is->surface_unlock_func_user_data);
+    return 0;
+}
+
+// Runs on the video thread: converts the frame into the staging surface of
+// its queue slot, so that presenting it later is just an upload.
+static void M_StageFrame(M_STATE *is, M_FRAME *vp)
+{
+    SDL_LockMutex(is->pictq.mutex);
+    const bool can_stage =
+        is->surface_allocator_func != NULL && !M_IsYUVFrame(is, vp->frame);
+    const M_SURFACE_PARAMS params = M_GetSurfaceParams(is);
+    SDL_UnlockMutex(is->pictq.mutex);
 
-            sws_scale(
-                is->img_convert_ctx, (const uint8_t *const *)frame->data,
-                frame->linesize, 0, frame->height, surf_planes, surf_linesize);
+    vp->is_staged = false;
+    if (!can_stage || params.width <= 0 || params.height <= 0) {
+        return;
+    }
 
-            is->surface_unlock_func(
-                is->primary_surface, is->surface_unlock_func_user_data);
-            is->surface_upload_func(
-                is->primary_surface, is->surface_upload_func_user_data);
+    if (vp->surface == NULL
+        || !M_SurfaceParamsEqual(&vp->surface_params, &params)) {
+        if (vp->surface != NULL) {
+            is->surface_deallocator_func(
+                vp->surface, is->surface_deallocator_func_user_data);
         }
+        vp->surface = is->surface_allocator_func(
+            params.width, params.height,
+            is->surface_allocator_func_user_data);
+        vp->surface_params = params;
+        // the black bars are never drawn over, so clear them only once
+        is->surface_clear_func(vp->surface, is->surface_clear_func_user_data);
+    }
 
-        is->render_end_func(is->primary_surface, is->render_end_func_user_data);
-    } else {
-        LOG_ERROR("Cannot initialize the conversion context");
-        ret = -1;
+    const int ret = M_ConvertFrame(
+        is, &is->stage_convert_ctx, vp->frame, vp->surface, &params);
+    vp->is_staged = ret == 0;
+    if (vp->is_staged) {
+        SDL_LockMutex(is->pictq.mutex);
+        is->stats.frames_staged++;
+        SDL_UnlockMutex(is->pictq.mutex);
+    }
+}
+
+static int M_UploadTexture(M_STATE *is, AVFrame *frame)
+{
+    if (M_UploadYUV(is, frame)) {
+        return 0;
     }
 
+    is->render_begin_func(is->primary_surface, is->render_begin_func_user_data);
+    const M_SURFACE_PARAMS params = M_GetSurfaceParams(is);
+    const int ret = M_ConvertFrame(
+        is, &is->img_convert_ctx, frame, is->primary_surface, &params);
+    if (ret == 0) {
+        is->surface_upload_func(
+            is->primary_surface, is->surface_upload_func_user_data);
+    }
+    is->render_end_func(is->primary_surface, is->render_end_func_user_data);
     return ret;
 }
 
 static void M_VideoImageDisplay(M_STATE *is)
 {
     M_FRAME *vp = M_FrameQueuePeekLast(&is->pictq);
+    is->stats.frames_shown++;
+
+    // A staged frame is already converted; it only needs uploading, unless
+    // the surface changed since it was decoded.
+    const M_SURFACE_PARAMS params = M_GetSurfaceParams(is);
+    if (vp->is_staged && M_SurfaceParamsEqual(&vp->surface_params, &params)
+        && !M_IsYUVFrame(is, vp->frame)) {
+        is->render_begin_func(vp->surface, is->render_begin_func_user_data);
+        is->surface_upload_func(
+            vp->surface, is->surface_upload_func_user_data);
+        is->render_end_func(vp->surface, is->render_end_func_user_data);
+        return;
+    }
 
+    if (!M_IsYUVFrame(is, vp->frame)) {
+        is->stats.frames_converted_late++;
+    }
     M_RecalcSurfaceTargetRect(is, vp->frame->width, vp->frame->height);
     M_UploadTexture(is, vp->frame);
 }
@@ -824,10 +995,18 @@ static void M_StreamClose(M_STATE *is)
     M_PacketQueueDestroy(&is->videoq);
     M_PacketQueueDestroy(&is->audioq);
 
+    for (int i = 0; i < is->pictq.max_size; i++) {
+        M_FRAME *const vp = &is->pictq.queue[i];
+        if (vp->surface != NULL) {
+            is->surface_deallocator_func(
+                vp->surface, is->surface_deallocator_func_user_data);
+        }
+    }
     M_FrameQueueShutdown(&is->pictq);
     M_FrameQueueShutdown(&is->sampq);
     SDL_DestroyCond(is->continue_read_thread);
     sws_freeContext(is->img_convert_ctx);
+    sws_freeContext(is->stage_convert_ctx);
     av_free(is->filename);
     if (is->primary_surface) {
         is->surface_deallocator_func(
@@ -1061,6 +1240,7 @@ static int M_QueuePicture(
     vp->serial = serial;
 
     av_frame_move_ref(vp->frame, src_frame);
+    M_StageFrame(is, vp);
     M_FrameQueuePush(&is->pictq);
     return 0;
 }
@@ -1528,6 +1708,17 @@ static int M_StreamComponentOpen(M_STATE *is, int stream_index)
     avctx->codec_id = codec->id;
     avctx->lowres = 0;
 
+    if (avctx->codec_type == AVMEDIA_TYPE_VIDEO) {
+        avctx->thread_count = 0;
+        if (codec->capabilities & AV_CODEC_CAP_FRAME_THREADS) {
+            avctx->thread_type = FF_THREAD_FRAME;
+        } else if (codec->capabilities & AV_CODEC_CAP_SLICE_THREADS) {
+            avctx->thread_type = FF_THREAD_SLICE;
+        } else {
+            avctx->thread_count = 1;
+        }
+    }
+
     if ((ret = avcodec_open2(avctx, codec, NULL)) < 0) {
         goto fail;
     }
@@ -1925,6 +2116,13 @@ void Video_Close(VIDEO *const video)
 {
     M_STATE *const is = video->priv;
     if (is) {
+        const VIDEO_STATS stats = Video_GetStats(video);
+        LOG_DEBUG(
+            "Shown %d frames, dropped %d early and %d late, staged %d, "
+            "converted %d late, decoder waited %.2f s",
+            stats.frames_shown, stats.frames_dropped_early,
+            stats.frames_dropped_late, stats.frames_staged,
+            stats.frames_converted_late, stats.queue_wait_time);
         M_StreamClose(is);
     }
 
@@ -1939,34 +2137,43 @@ void Video_SetSurfaceSize(
     const int32_t surface_height)
 {
     M_STATE *const is = video->priv;
+    SDL_LockMutex(is->pictq.mutex);
     if (is->surface_width == surface_width
         && is->surface_height == surface_height) {
+        SDL_UnlockMutex(is->pictq.mutex);
         return;
     }
 
     M_ReallocPrimarySurface(is, surface_width, surface_height, false);
+    SDL_UnlockMutex(is->pictq.mutex);
 }
 
 void Video_SetSurfacePixelFormat(VIDEO *video, enum AVPixelFormat pixel_format)
 {
     M_STATE *const is = video->priv;
+    SDL_LockMutex(is->pictq.mutex);
     if (is->primary_surface_pixel_format == pixel_format) {
+        SDL_UnlockMutex(is->pictq.mutex);
         return;
     }
 
     is->primary_surface_pixel_format = pixel_format;
     M_ReallocPrimarySurface(is, is->surface_width, is->surface_height, false);
+    SDL_UnlockMutex(is->pictq.mutex);
 }
 
 void Video_SetSurfaceStride(VIDEO *video, const int32_t stride)
 {
     M_STATE *const is = video->priv;
+    SDL_LockMutex(is->pictq.mutex);
     if (is->primary_surface_stride == stride) {
+        SDL_UnlockMutex(is->pictq.mutex);
         return;
     }
 
     is->primary_surface_stride = stride;
     M_ReallocPrimarySurface(is, is->surface_width, is->surface_height, false);
+    SDL_UnlockMutex(is->pictq.mutex);
 }
 
 void Video_SetSurfaceAllocatorFunc(
@@ -2040,3 +2247,25 @@ void Video_SetRenderEndFunc(
     is->render_end_func = func;
     is->render_end_func_user_data = user_data;
 }
+
+void Video_SetYUVUploadFunc(
+    VIDEO *const video, const VIDEO_YUV_UPLOAD_FUNC func, void *const user_data)
+{
+    M_STATE *const is = video->priv;
+    SDL_LockMutex(is->pictq.mutex);
+    is->yuv_upload_func = func;
+    is->yuv_upload_func_user_data = user_data;
+    SDL_UnlockMutex(is->pictq.mutex);
+}
+
+VIDEO_STATS Video_GetStats(VIDEO *const video)
+{
+    M_STATE *const is = video->priv;
+    SDL_LockMutex(is->pictq.mutex);
+    VIDEO_STATS stats = is->stats;
+    stats.queue_wait_time = is->pictq.wait_time / 1000000.0;
+    SDL_UnlockMutex(is->pictq.mutex);
+    stats.frames_dropped_early = is->frame_drops_early;
+    stats.frames_dropped_late = is->frame_drops_late;
+    return stats;
+}
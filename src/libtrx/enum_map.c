@@ -1,56 +1,56 @@
 #include "enum_map.h"
 
-#include "memory.h"
+#include "hash_map.h"
 
-#include <stdio.h>
-#include <uthash.h>
+#include <stdint.h>
 
+// Every enum type gets its own pair of maps, so lookups do not need to build
+// a composite key first.
 typedef struct {
-    char *key;
-    int32_t value;
-    UT_hash_handle hh;
-} M_ENTRY;
+    // string -> int32_t value
+    HASH_MAP *values;
+    // value -> interned string
+    HASH_MAP *names;
+} M_ENUM;
 
-typedef struct {
-    char *key;
-    char *str_value;
-    UT_hash_handle hh;
-} M_INVERSE_ENTRY;
-
-static M_ENTRY *m_Map = NULL;
-static M_INVERSE_ENTRY *m_InverseMap = NULL;
+static HASH_MAP *m_Enums = NULL;
 
-static void M_Define(
-    const char *enum_name, int32_t enum_value, const char *str_value);
+static M_ENUM *M_GetEnum(const char *enum_name, bool create);
+static void M_Define(M_ENUM *e, int32_t enum_value, const char *str_value);
 static void M_DefineInverse(
-    const char *enum_name, int32_t enum_value, const char *str_value);
+    M_ENUM *e, int32_t enum_value, const char *str_value);
 
-static void M_Define(
-    const char *const enum_name, const int32_t enum_value,
-    const char *const str_value)
+static M_ENUM *M_GetEnum(const char *const enum_name, const bool create)
 {
-    const size_t key_len = strlen(enum_name) + strlen(str_value) + 2;
-    char *const key = Memory_Alloc(key_len);
-    snprintf(key, key_len, "%s|%s", enum_name, str_value);
+    if (m_Enums == NULL) {
+        if (!create) {
+            return NULL;
+        }
+        m_Enums = HashMap_Create(HMK_STRING, sizeof(M_ENUM));
+    }
 
-    M_ENTRY *const entry = Memory_Alloc(sizeof(M_ENTRY));
-    entry->key = key;
-    entry->value = enum_value;
-    HASH_ADD_KEYPTR(hh, m_Map, entry->key, strlen(entry->key), entry);
+    M_ENUM *e = HashMap_FindStr(m_Enums, enum_name);
+    if (e == NULL && create) {
+        const M_ENUM new_enum = {
+            .values = HashMap_Create(HMK_STRING, sizeof(int32_t)),
+            .names = HashMap_Create(HMK_INT, sizeof(const char *)),
+        };
+        e = HashMap_InsertStr(m_Enums, enum_name, &new_enum);
+    }
+    return e;
 }
 
-static void M_DefineInverse(
-    const char *const enum_name, const int32_t enum_value,
-    const char *const str_value)
+static void M_Define(
+    M_ENUM *const e, const int32_t enum_value, const char *const str_value)
 {
-    const size_t key_len =
-        snprintf(NULL, 0, "%s|%d", enum_name, enum_value) + 1;
-    char *const key = Memory_Alloc(key_len);
-    snprintf(key, key_len, "%s|%d", enum_name, enum_value);
+    HashMap_InsertStr(e->values, str_value, &enum_value);
+}
 
-    M_INVERSE_ENTRY *entry;
-    HASH_FIND_STR(m_InverseMap, key, entry);
-    if (entry != NULL) {
+static void M_DefineInverse(
+    M_ENUM *const e, const int32_t enum_value, const char *const str_value)
+{
+    const uint64_t key = (uint32_t)enum_value;
+    if (HashMap_FindInt(e->names, key) != NULL) {
         // The inverse lookup is already defined - do not override it.
         // (This means that the first call to ENUM_MAP_DEFINE for a given enum
         // value also determines what serializing it back to string will pick
@@ -58,65 +58,55 @@ static void M_DefineInverse(
         return;
     }
 
-    entry = Memory_Alloc(sizeof(M_INVERSE_ENTRY));
-    entry->key = key;
-    entry->str_value = Memory_DupStr(str_value);
-    HASH_ADD_KEYPTR(hh, m_InverseMap, entry->key, strlen(entry->key), entry);
+    const char *const name = HashMap_Intern(str_value);
+    HashMap_InsertInt(e->names, key, &name);
 }
 
 void EnumMap_Define(
     const char *const enum_name, const int32_t enum_value,
     const char *const str_value)
 {
-    M_Define(enum_name, enum_value, str_value);
-    M_DefineInverse(enum_name, enum_value, str_value);
+    M_ENUM *const e = M_GetEnum(enum_name, true);
+    M_Define(e, enum_value, str_value);
+    M_DefineInverse(e, enum_value, str_value);
 }
 
 int32_t EnumMap_Get(
     const char *const enum_name, const char *const str_value,
     int32_t default_value)
 {
-    size_t key_len = strlen(enum_name) + strlen(str_value) + 2;
-    char key[key_len];
-    snprintf(key, key_len, "%s|%s", enum_name, str_value);
-
-    M_ENTRY *entry;
-    HASH_FIND_STR(m_Map, key, entry);
-    return entry != NULL ? entry->value : default_value;
+    const M_ENUM *const e = M_GetEnum(enum_name, false);
+    if (e == NULL) {
+        return default_value;
+    }
+    const int32_t *const value = HashMap_FindStr(e->values, str_value);
+    return value != NULL ? *value : default_value;
 }
 
 const char *EnumMap_ToString(
     const char *const enum_name, const int32_t enum_value)
 {
-    size_t key_len = snprintf(NULL, 0, "%s|%d", enum_name, enum_value) + 1;
-    char key[key_len];
-    snprintf(key, key_len, "%s|%d", enum_name, enum_value);
-
-    M_INVERSE_ENTRY *entry;
-    HASH_FIND_STR(m_InverseMap, key, entry);
-    return entry != NULL ? entry->str_value : NULL;
+    const M_ENUM *const e = M_GetEnum(enum_name, false);
+    if (e == NULL) {
+        return NULL;
+    }
+    const char *const *const name =
+        HashMap_FindInt(e->names, (uint32_t)enum_value);
+    return name != NULL ? *name : NULL;
 }
 
 void EnumMap_Shutdown(void)
 {
-    {
-        M_ENTRY *current, *tmp;
-        HASH_ITER(hh, m_Map, current, tmp)
-        {
-            HASH_DEL(m_Map, current);
-            Memory_Free(current->key);
-            Memory_Free(current);
-        }
+    if (m_Enums == NULL) {
+        return;
     }
 
-    {
-        M_INVERSE_ENTRY *current, *tmp;
-        HASH_ITER(hh, m_InverseMap, current, tmp)
-        {
-            HASH_DEL(m_InverseMap, current);
-            Memory_Free(current->str_value);
-            Memory_Free(current->key);
-            Memory_Free(current);
-        }
+    int32_t iter = 0;
+    M_ENUM *e;
+    while ((e = HashMap_Iterate(m_Enums, &iter)) != NULL) {
+        HashMap_Free(e->values);
+        HashMap_Free(e->names);
     }
+    HashMap_Free(m_Enums);
+    m_Enums = NULL;
 }
@@ -1,5 +1,6 @@
 #include "event_manager.h"
 
+#include "hash_map.h"
 #include "memory.h"
 #include "vector.h"
 
@@ -15,14 +16,18 @@ typedef struct {
 } M_LISTENER;
 
 typedef struct EVENT_MANAGER {
-    VECTOR *listeners;
+    // event name -> VECTOR of M_LISTENER, in subscription order
+    HASH_MAP *listeners;
+    // listener id -> interned event name
+    HASH_MAP *listener_events;
     int32_t listener_id;
 } EVENT_MANAGER;
 
 EVENT_MANAGER *EventManager_Create(void)
 {
     EVENT_MANAGER *manager = Memory_Alloc(sizeof(EVENT_MANAGER));
-    manager->listeners = Vector_Create(sizeof(M_LISTENER));
+    manager->listeners = HashMap_Create(HMK_STRING, sizeof(VECTOR *));
+    manager->listener_events = HashMap_Create(HMK_INT, sizeof(const char *));
     manager->listener_id = 0;
     return manager;
 }
@@ -32,7 +37,13 @@ void EventManager_Free(EVENT_MANAGER *const manager)
     if (manager == NULL) {
         return;
     }
-    Vector_Free(manager->listeners);
+    int32_t iter = 0;
+    VECTOR **listeners;
+    while ((listeners = HashMap_Iterate(manager->listeners, &iter)) != NULL) {
+        Vector_Free(*listeners);
+    }
+    HashMap_Free(manager->listeners);
+    HashMap_Free(manager->listener_events);
     Memory_Free(manager);
 }
 
@@ -43,22 +54,44 @@ int32_t EventManager_Subscribe(
 {
     M_LISTENER entry = {
         .listener_id = manager->listener_id++,
-        .event_name = event_name,
+        .event_name = HashMap_Intern(event_name),
         .sender = sender,
         .listener = listener,
         .user_data = user_data,
     };
-    Vector_Add(manager->listeners, &entry);
+
+    VECTOR **listeners = HashMap_FindStr(manager->listeners, event_name);
+    if (listeners == NULL) {
+        VECTOR *const new_listeners = Vector_Create(sizeof(M_LISTENER));
+        listeners =
+            HashMap_InsertStr(manager->listeners, event_name, &new_listeners);
+    }
+    Vector_Add(*listeners, &entry);
+    HashMap_InsertInt(
+        manager->listener_events, entry.listener_id, &entry.event_name);
     return entry.listener_id;
 }
 
 void EventManager_Unsubscribe(
     EVENT_MANAGER *const manager, const int32_t listener_id)
 {
-    for (int32_t i = 0; i < manager->listeners->count; i++) {
-        M_LISTENER entry = *(M_LISTENER *)Vector_Get(manager->listeners, i);
+    const char *const *const event_name =
+        HashMap_FindInt(manager->listener_events, listener_id);
+    if (event_name == NULL) {
+        return;
+    }
+
+    VECTOR *const *const listeners =
+        HashMap_FindStr(manager->listeners, *event_name);
+    HashMap_RemoveInt(manager->listener_events, listener_id);
+    if (listeners == NULL) {
+        return;
+    }
+
+    for (int32_t i = 0; i < (*listeners)->count; i++) {
+        M_LISTENER entry = *(M_LISTENER *)Vector_Get(*listeners, i);
         if (entry.listener_id == listener_id) {
-            Vector_RemoveAt(manager->listeners, i);
+            Vector_RemoveAt(*listeners, i);
             return;
         }
     }
@@ -66,10 +99,16 @@ void EventManager_Unsubscribe(
 
 void EventManager_Fire(EVENT_MANAGER *const manager, const EVENT *const event)
 {
-    for (int32_t i = 0; i < manager->listeners->count; i++) {
-        M_LISTENER entry = *(M_LISTENER *)Vector_Get(manager->listeners, i);
-        if (strcmp(entry.event_name, event->name) == 0
-            && entry.sender == event->sender) {
+    VECTOR *const *const listeners =
+        HashMap_FindStr(manager->listeners, event->name);
+    if (listeners == NULL) {
+        return;
+    }
+
+    VECTOR *const vector = *listeners;
+    for (int32_t i = 0; i < vector->count; i++) {
+        M_LISTENER entry = *(M_LISTENER *)Vector_Get(vector, i);
+        if (entry.sender == event->sender) {
             entry.listener(event, entry.user_data);
         }
     }
@@ -6,9 +6,12 @@
 #include "strings.h"
 #include "utils.h"
 
+#include <SDL2/SDL_atomic.h>
 #include <SDL2/SDL_filesystem.h>
+#include <SDL2/SDL_mutex.h>
 #include <dirent.h>
 #include <stdbool.h>
+#include <uthash.h>
 
 #if defined(_WIN32)
     #include <direct.h>
@@ -23,10 +26,38 @@ struct MYFILE {
     const char *path;
 };
 
+// Directory listings used to resolve paths case-insensitively, keyed by the
+// upper-cased entry name. Listings are read on first use and dropped
+// whenever the game writes to the disk. Screenshots and recordings are
+// written from worker threads, so the index is guarded by a mutex.
+typedef struct {
+    char *key;
+    char *name;
+    UT_hash_handle hh;
+} M_INDEX_ENTRY;
+
+typedef struct {
+    char *path;
+    bool exists;
+    M_INDEX_ENTRY *entries;
+    UT_hash_handle hh;
+} M_INDEX_DIR;
+
 const char *m_GameDir = NULL;
+static M_INDEX_DIR *m_Index = NULL;
+static SDL_mutex *m_IndexMutex = NULL;
+static SDL_SpinLock m_IndexMutexInit = 0;
+static struct {
+    int32_t lookups;
+    int32_t scans;
+} m_IndexStats = {};
 
 static void M_PathAppendSeparator(char *path);
 static void M_PathAppendPart(char *path, const char *part);
+static void M_LockIndex(void);
+static void M_UnlockIndex(void);
+static M_INDEX_DIR *M_IndexDirectory(const char *path);
+static const char *M_IndexLookup(M_INDEX_DIR *dir, const char *name);
 static char *M_CasePath(char const *path);
 static bool M_ExistsRaw(const char *path);
 
@@ -43,6 +74,93 @@ static void M_PathAppendPart(char *path, const char *part)
     strcat(path, part);
 }
 
+static void M_LockIndex(void)
+{
+    SDL_AtomicLock(&m_IndexMutexInit);
+    if (m_IndexMutex == NULL) {
+        m_IndexMutex = SDL_CreateMutex();
+    }
+    SDL_AtomicUnlock(&m_IndexMutexInit);
+    SDL_LockMutex(m_IndexMutex);
+}
+
+static void M_UnlockIndex(void)
+{
+    SDL_UnlockMutex(m_IndexMutex);
+}
+
+static M_INDEX_DIR *M_IndexDirectory(const char *const path)
+{
+    M_INDEX_DIR *dir;
+    HASH_FIND_STR(m_Index, path, dir);
+    if (dir != NULL) {
+        return dir;
+    }
+
+    dir = Memory_Alloc(sizeof(M_INDEX_DIR));
+    dir->path = Memory_DupStr(path);
+    dir->entries = NULL;
+
+    DIR *const path_dir = opendir(path);
+    dir->exists = path_dir != NULL;
+    m_IndexStats.scans++;
+    if (path_dir != NULL) {
+        struct dirent *cur_file;
+        while ((cur_file = readdir(path_dir)) != NULL) {
+            char *key = String_ToUpper(cur_file->d_name);
+            M_INDEX_ENTRY *entry;
+            HASH_FIND_STR(dir->entries, key, entry);
+            if (entry != NULL) {
+                // keep the first match, like the directory scan used to
+                Memory_FreePointer(&key);
+                continue;
+            }
+            entry = Memory_Alloc(sizeof(M_INDEX_ENTRY));
+            entry->key = key;
+            entry->name = Memory_DupStr(cur_file->d_name);
+            HASH_ADD_KEYPTR(
+                hh, dir->entries, entry->key, strlen(entry->key), entry);
+        }
+        closedir(path_dir);
+    }
+
+    HASH_ADD_KEYPTR(hh, m_Index, dir->path, strlen(dir->path), dir);
+    LOG_DEBUG(
+        "Indexed %s (%d directory scans for %d path lookups)", path,
+        m_IndexStats.scans, m_IndexStats.lookups);
+    return dir;
+}
+
+static const char *M_IndexLookup(M_INDEX_DIR *const dir, const char *const name)
+{
+    char *key = String_ToUpper(name);
+    M_INDEX_ENTRY *entry;
+    HASH_FIND_STR(dir->entries, key, entry);
+    Memory_FreePointer(&key);
+    return entry != NULL ? entry->name : NULL;
+}
+
+void File_InvalidateIndex(void)
+{
+    M_LockIndex();
+    M_INDEX_DIR *dir, *tmp_dir;
+    HASH_ITER(hh, m_Index, dir, tmp_dir)
+    {
+        M_INDEX_ENTRY *entry, *tmp_entry;
+        HASH_ITER(hh, dir->entries, entry, tmp_entry)
+        {
+            HASH_DEL(dir->entries, entry);
+            Memory_Free(entry->key);
+            Memory_Free(entry->name);
+            Memory_Free(entry);
+        }
+        HASH_DEL(m_Index, dir);
+        Memory_Free(dir->path);
+        Memory_Free(dir);
+    }
+    M_UnlockIndex();
+}
+
 static char *M_CasePath(char const *path)
 {
     ASSERT(path != NULL);
@@ -52,6 +170,9 @@ static char *M_CasePath(char const *path)
         return path_copy;
     }
 
+    M_LockIndex();
+    m_IndexStats.lookups++;
+
     char *path_piece = path_copy;
     char *current_path = Memory_Alloc(strlen(path) + 2);
 
@@ -73,26 +194,16 @@ static char *M_CasePath(char const *path)
             *delim = '\0';
         }
 
-        DIR *path_dir = opendir(current_path);
-        if (!path_dir) {
+        M_INDEX_DIR *const dir = M_IndexDirectory(current_path);
+        if (!dir->exists) {
+            M_UnlockIndex();
             Memory_FreePointer(&path_copy);
             Memory_FreePointer(&current_path);
             return NULL;
         }
 
-        struct dirent *cur_file = readdir(path_dir);
-        while (cur_file) {
-            if (String_Equivalent(path_piece, cur_file->d_name)) {
-                M_PathAppendPart(current_path, cur_file->d_name);
-                break;
-            }
-            cur_file = readdir(path_dir);
-        }
-        closedir(path_dir);
-
-        if (!cur_file) {
-            M_PathAppendPart(current_path, path_piece);
-        }
+        const char *const name = M_IndexLookup(dir, path_piece);
+        M_PathAppendPart(current_path, name != NULL ? name : path_piece);
 
         if (delim) {
             *delim = old_delim;
@@ -101,6 +212,7 @@ static char *M_CasePath(char const *path)
             break;
         }
     }
+    M_UnlockIndex();
 
     Memory_FreePointer(&path_copy);
 
@@ -243,6 +355,9 @@ MYFILE *File_Open(const char *path, FILE_OPEN_MODE mode)
         break;
     }
     Memory_FreePointer(&full_path);
+    if (mode != FILE_OPEN_READ) {
+        File_InvalidateIndex();
+    }
     if (!file->fp) {
         Memory_FreePointer(&file->path);
         Memory_FreePointer(&file);
@@ -433,4 +548,5 @@ void File_CreateDirectory(const char *path)
     mkdir(full_path, 0775);
 #endif
     Memory_FreePointer(&full_path);
+    File_InvalidateIndex();
 }
@@ -0,0 +1,144 @@
+#include "frame_arena.h"
+
+#include "debug.h"
+#include "memory.h"
+#include "utils.h"
+
+#define ALIGNMENT 16
+#define MIN_BLOCK_SIZE (64 * 1024)
+
+typedef struct M_BLOCK {
+    struct M_BLOCK *next;
+    size_t size;
+    size_t used;
+    _Alignas(ALIGNMENT) char data[];
+} M_BLOCK;
+
+typedef struct {
+    M_BLOCK *first;
+    M_BLOCK *current;
+    size_t frame_bytes;
+    MEMORY_COUNTERS heap_counters;
+    FRAME_ARENA_STATS stats;
+} M_ARENA;
+
+static _Thread_local M_ARENA m_Arena = {};
+
+static M_BLOCK *M_CreateBlock(size_t size);
+static void M_FreeBlocks(M_BLOCK *block);
+
+static M_BLOCK *M_CreateBlock(const size_t size)
+{
+    // Memory_Realloc does not clear the memory like Memory_Alloc does, which
+    // would be wasted on a block that is overwritten every frame.
+    M_BLOCK *const block = Memory_Realloc(NULL, sizeof(M_BLOCK) + size);
+    block->next = NULL;
+    block->size = size;
+    block->used = 0;
+    return block;
+}
+
+static void M_FreeBlocks(M_BLOCK *block)
+{
+    while (block != NULL) {
+        M_BLOCK *const next = block->next;
+        Memory_Free(block);
+        block = next;
+    }
+}
+
+void *FrameArena_Alloc(const size_t size)
+{
+    const size_t aligned_size = (size + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+    M_ARENA *const arena = &m_Arena;
+    if (arena->first == NULL) {
+        arena->first = M_CreateBlock(MAX(MIN_BLOCK_SIZE, aligned_size));
+        arena->current = arena->first;
+    }
+
+    M_BLOCK *block = arena->current;
+    while (block->used + aligned_size > block->size) {
+        if (block->next == NULL || block->next->size < aligned_size) {
+            // Blocks that were too small are dropped; the next reset sizes
+            // the arena to fit the whole frame anyway.
+            M_FreeBlocks(block->next);
+            block->next = M_CreateBlock(MAX(block->size * 2, aligned_size));
+        }
+        block = block->next;
+        block->used = 0;
+    }
+
+    arena->current = block;
+    void *const result = block->data + block->used;
+    block->used += aligned_size;
+    arena->frame_bytes += aligned_size;
+    return result;
+}
+
+FRAME_ARENA_MARK FrameArena_GetMark(void)
+{
+    const M_ARENA *const arena = &m_Arena;
+    if (arena->current == NULL) {
+        return (FRAME_ARENA_MARK) {};
+    }
+    return (FRAME_ARENA_MARK) {
+        .block = arena->current,
+        .used = arena->current->used,
+    };
+}
+
+void FrameArena_Release(const FRAME_ARENA_MARK mark)
+{
+    M_ARENA *const arena = &m_Arena;
+    if (arena->first == NULL) {
+        return;
+    }
+    if (mark.block == NULL) {
+        arena->current = arena->first;
+        arena->current->used = 0;
+        return;
+    }
+    arena->current = mark.block;
+    arena->current->used = mark.used;
+}
+
+void FrameArena_Reset(void)
+{
+    M_ARENA *const arena = &m_Arena;
+    if (arena->first != NULL && arena->first->next != NULL) {
+        // The frame did not fit in a single block; replace the chain with
+        // one block large enough for all of it, so that the following frames
+        // do not need to touch the heap.
+        size_t total = 0;
+        for (M_BLOCK *block = arena->first; block != NULL;
+             block = block->next) {
+            total += block->size;
+        }
+        M_FreeBlocks(arena->first);
+        arena->first = M_CreateBlock(total);
+    }
+    if (arena->first != NULL) {
+        arena->first->used = 0;
+    }
+    arena->current = arena->first;
+
+    const MEMORY_COUNTERS counters = Memory_GetCounters();
+    arena->stats.arena_bytes = arena->frame_bytes;
+    arena->stats.heap_allocs = counters.allocs - arena->heap_counters.allocs;
+    arena->stats.heap_frees = counters.frees - arena->heap_counters.frees;
+    arena->heap_counters = counters;
+    arena->frame_bytes = 0;
+}
+
+void FrameArena_Shutdown(void)
+{
+    M_ARENA *const arena = &m_Arena;
+    M_FreeBlocks(arena->first);
+    arena->first = NULL;
+    arena->current = NULL;
+}
+
+const FRAME_ARENA_STATS *FrameArena_GetStats(void)
+{
+    return &m_Arena.stats;
+}
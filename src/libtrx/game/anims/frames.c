@@ -3,6 +3,7 @@
 #include "game/anims.h"
 #include "game/gamebuf.h"
 #include "game/objects/common.h"
+#include "hash_map.h"
 #include "log.h"
 #include "utils.h"
 
@@ -10,7 +11,7 @@ static ANIM_FRAME *m_Frames = NULL;
 
 static int32_t M_GetAnimFrameCount(int32_t anim_idx, int32_t frame_data_length);
 static OBJECT *M_GetAnimObject(int32_t anim_idx);
-static ANIM_FRAME *M_FindFrameBase(uint32_t frame_ofs);
+static HASH_MAP *M_CreateFrameBaseMap(void);
 static int32_t M_ParseFrame(
     ANIM_FRAME *frame, const int16_t *data_ptr, int16_t mesh_count,
     uint8_t frame_size);
@@ -48,17 +49,18 @@ static OBJECT *M_GetAnimObject(const int32_t anim_idx)
     return NULL;
 }
 
-static ANIM_FRAME *M_FindFrameBase(const uint32_t frame_ofs)
+static HASH_MAP *M_CreateFrameBaseMap(void)
 {
+    // Maps frame offsets to the frames of the first animation using them.
+    HASH_MAP *const map = HashMap_Create(HMK_INT, sizeof(ANIM_FRAME *));
     const int32_t anim_count = Anim_GetTotalCount();
     for (int32_t i = 0; i < anim_count; i++) {
         const ANIM *const anim = Anim_GetAnim(i);
-        if (anim->frame_ofs == frame_ofs) {
-            return anim->frame_ptr;
+        if (HashMap_FindInt(map, anim->frame_ofs) == NULL) {
+            HashMap_InsertInt(map, anim->frame_ofs, &anim->frame_ptr);
         }
     }
-
-    return NULL;
+    return map;
 }
 
 static int32_t M_ParseFrame(
@@ -172,13 +174,17 @@ void Anim_LoadFrames(const int16_t *data, const int32_t data_length)
 
     // Some OG data contains objects that point to the previous object's frames,
     // so ensure everything that's loaded is configured as such.
+    HASH_MAP *const frame_bases = M_CreateFrameBaseMap();
     for (int32_t i = 0; i < O_NUMBER_OF; i++) {
         OBJECT *const object = Object_GetObject(i);
         if (object->loaded && object->mesh_count >= 0 && object->anim_idx == -1
             && object->frame_base == NULL) {
-            object->frame_base = M_FindFrameBase(object->frame_ofs);
+            ANIM_FRAME *const *const frame_base =
+                HashMap_FindInt(frame_bases, object->frame_ofs);
+            object->frame_base = frame_base != NULL ? *frame_base : NULL;
         }
     }
+    HashMap_Free(frame_bases);
 
     Benchmark_End(benchmark, NULL);
 }
@@ -0,0 +1,125 @@
+#include "game/console/cmd/audio_stats.h"
+
+#include "engine/audio.h"
+#include "game/clock.h"
+#include "game/game_string.h"
+#include "game/ui/widgets/audio_stats.h"
+#include "log.h"
+#include "strings.h"
+
+#define BENCHMARK_SOUNDS 8
+#define BENCHMARK_ITERATIONS 1000
+
+static COMMAND_RESULT M_ShowStats(void);
+static COMMAND_RESULT M_ToggleOverlay(void);
+static COMMAND_RESULT M_ToggleAdaptive(void);
+static COMMAND_RESULT M_Benchmark(void);
+static COMMAND_RESULT M_Entrypoint(const COMMAND_CONTEXT *ctx);
+
+static COMMAND_RESULT M_ShowStats(void)
+{
+    const AUDIO_STATS stats = Audio_GetStats();
+    Console_Log(
+        GS(OSD_AUDIO_STATS), stats.buffer_samples, stats.buffer_period,
+        stats.avg_callback_time, stats.max_callback_time,
+        stats.avg_stream_time, stats.avg_load, stats.max_load,
+        stats.underruns, stats.active_samples, stats.active_streams);
+
+    // The load histogram is too long for the console.
+    LOG_INFO(
+        "Callback load: %d under 10%%, %d under 25%%, %d under 50%%, "
+        "%d under 75%%, %d under 100%%, %d over (%d callbacks)",
+        stats.load_histogram[0], stats.load_histogram[1],
+        stats.load_histogram[2], stats.load_histogram[3],
+        stats.load_histogram[4], stats.load_histogram[5], stats.callbacks);
+    return CR_SUCCESS;
+}
+
+static COMMAND_RESULT M_ToggleOverlay(void)
+{
+    if (Console_GetOverlay() != NULL) {
+        Console_SetOverlay(NULL);
+    } else {
+        Console_SetOverlay(UI_AudioStats_Create());
+    }
+    return CR_SUCCESS;
+}
+
+static COMMAND_RESULT M_ToggleAdaptive(void)
+{
+    const bool enable = !Audio_IsAdaptiveBuffer();
+    Audio_SetAdaptiveBuffer(enable);
+    Console_Log(
+        enable ? GS(OSD_AUDIO_ADAPTIVE_ON) : GS(OSD_AUDIO_ADAPTIVE_OFF));
+    return CR_SUCCESS;
+}
+
+static COMMAND_RESULT M_Benchmark(void)
+{
+    // Measures how long the game waits to send sound updates to the mixer.
+    // The sounds play too quietly to be heard.
+    int32_t sound_ids[BENCHMARK_SOUNDS];
+    int32_t sound_count = 0;
+    for (int32_t i = 0; i < BENCHMARK_SOUNDS; i++) {
+        const int32_t sound_id = Audio_Sample_Play(0, -10000, 1.0f, 0, true);
+        if (sound_id == AUDIO_NO_SOUND) {
+            break;
+        }
+        sound_ids[sound_count++] = sound_id;
+    }
+    if (sound_count == 0) {
+        return CR_UNAVAILABLE;
+    }
+
+    int32_t command_count = 0;
+    const double start = Clock_GetRealTime();
+    for (int32_t i = 0; i < BENCHMARK_ITERATIONS; i++) {
+        const int32_t sound_id = sound_ids[i % sound_count];
+        Audio_Sample_SetVolume(sound_id, -10000 + i % 100);
+        Audio_Sample_SetPan(sound_id, i % 200 - 100);
+        Audio_Sample_SetPitch(sound_id, 1.0f + (i % 10) * 0.01f);
+        Audio_Sample_SetFilter(sound_id, (i % 10) * 0.1f, false);
+        command_count += 4;
+    }
+    const double time = (Clock_GetRealTime() - start) * 1000.0;
+
+    for (int32_t i = 0; i < sound_count; i++) {
+        Audio_Sample_Close(sound_ids[i]);
+    }
+
+    Console_Log(GS(OSD_AUDIO_BENCHMARK), command_count, time);
+
+    const double load = Audio_Sample_MeasureVoiceLoad();
+    Console_Log(
+        GS(OSD_AUDIO_VOICE_LOAD), load * 100.0, AUDIO_VOICE_BUDGET * 100.0);
+    if (load > AUDIO_VOICE_BUDGET) {
+        LOG_WARNING(
+            "Mixing one sound takes %.3f%% of real time, over the budget of "
+            "%.1f%%",
+            load * 100.0, AUDIO_VOICE_BUDGET * 100.0);
+    }
+    return CR_SUCCESS;
+}
+
+static COMMAND_RESULT M_Entrypoint(const COMMAND_CONTEXT *const ctx)
+{
+    if (Audio_GetStats().buffer_samples == 0) {
+        return CR_UNAVAILABLE;
+    }
+
+    if (String_Equivalent(ctx->args, "")) {
+        return M_ShowStats();
+    } else if (String_Equivalent(ctx->args, "overlay")) {
+        return M_ToggleOverlay();
+    } else if (String_Equivalent(ctx->args, "adaptive")) {
+        return M_ToggleAdaptive();
+    } else if (String_Equivalent(ctx->args, "bench")) {
+        return M_Benchmark();
+    }
+    return CR_BAD_INVOCATION;
+}
+
+CONSOLE_COMMAND g_Console_Cmd_AudioStats = {
+    .prefix = "audio-?stats",
+    .proc = M_Entrypoint,
+};
@@ -0,0 +1,66 @@
+#include "game/console/cmd/mem_stats.h"
+
+#include "enum_map.h"
+#include "frame_arena.h"
+#include "game/game_string.h"
+#include "game/gamebuf.h"
+#include "log.h"
+#include "strings.h"
+
+#define TOP_BUFFER_COUNT 3
+
+static COMMAND_RESULT M_Entrypoint(const COMMAND_CONTEXT *ctx);
+
+static COMMAND_RESULT M_Entrypoint(const COMMAND_CONTEXT *const ctx)
+{
+    if (!String_Equivalent(ctx->args, "")) {
+        return CR_BAD_INVOCATION;
+    }
+
+    Console_Log(
+        GS(OSD_MEMORY_STATS), (int32_t)(GameBuf_GetUsedSize() / 1024),
+        (int32_t)(GameBuf_GetPeakSize() / 1024),
+        (int32_t)(GameBuf_GetReservedSize() / 1024));
+
+    const FRAME_ARENA_STATS *const arena_stats = FrameArena_GetStats();
+    Console_Log(
+        GS(OSD_MEMORY_STATS_FRAME), (int32_t)(arena_stats->arena_bytes / 1024),
+        arena_stats->heap_allocs, arena_stats->heap_frees);
+
+    // The full breakdown goes to the log; the console only lists the
+    // largest buffers.
+    bool shown[GBUF_NUM_MALLOC_TYPES] = {};
+    for (int32_t i = 0; i < TOP_BUFFER_COUNT; i++) {
+        int32_t best = -1;
+        for (int32_t j = 0; j < GBUF_NUM_MALLOC_TYPES; j++) {
+            if (!shown[j] && GameBuf_GetStats(j)->bytes > 0
+                && (best == -1
+                    || GameBuf_GetStats(j)->bytes
+                        > GameBuf_GetStats(best)->bytes)) {
+                best = j;
+            }
+        }
+        if (best == -1) {
+            break;
+        }
+        shown[best] = true;
+        Console_Log(
+            GS(OSD_MEMORY_STATS_BUFFER),
+            ENUM_MAP_TO_STRING(GAME_BUFFER, best),
+            (int32_t)(GameBuf_GetStats(best)->bytes / 1024));
+    }
+
+    for (int32_t i = 0; i < GBUF_NUM_MALLOC_TYPES; i++) {
+        const GAMEBUF_STATS *const stats = GameBuf_GetStats(i);
+        LOG_INFO(
+            "%s: %zu bytes in %d allocations (peak %zu bytes)",
+            ENUM_MAP_TO_STRING(GAME_BUFFER, i), stats->bytes,
+            stats->alloc_count, stats->peak_bytes);
+    }
+    return CR_SUCCESS;
+}
+
+CONSOLE_COMMAND g_Console_Cmd_MemStats = {
+    .prefix = "mem-?stats",
+    .proc = M_Entrypoint,
+};
@@ -0,0 +1,63 @@
+#include "game/console/cmd/record.h"
+
+#include "engine/recorder.h"
+#include "game/game_string.h"
+#include "memory.h"
+#include "screenshot.h"
+#include "strings.h"
+
+static COMMAND_RESULT M_Start(void);
+static COMMAND_RESULT M_Stop(void);
+static COMMAND_RESULT M_Status(void);
+static COMMAND_RESULT M_Entrypoint(const COMMAND_CONTEXT *ctx);
+
+static COMMAND_RESULT M_Start(void)
+{
+    char *path = Screenshot_GetRecordingPath();
+    const bool result = Recorder_Start(path);
+    if (result) {
+        Console_Log(GS(OSD_RECORDING_START), path);
+    } else {
+        Console_Log(GS(OSD_RECORDING_FAILED));
+    }
+    Memory_FreePointer(&path);
+    return result ? CR_SUCCESS : CR_FAILURE;
+}
+
+static COMMAND_RESULT M_Stop(void)
+{
+    Recorder_Stop();
+    const RECORDER_STATS stats = Recorder_GetStats();
+    Console_Log(
+        GS(OSD_RECORDING_STOP), stats.frames_encoded, stats.frames_dropped);
+    return CR_SUCCESS;
+}
+
+static COMMAND_RESULT M_Status(void)
+{
+    if (!Recorder_IsActive()) {
+        Console_Log(GS(OSD_RECORDING_INACTIVE));
+        return CR_SUCCESS;
+    }
+    const RECORDER_STATS stats = Recorder_GetStats();
+    Console_Log(
+        GS(OSD_RECORDING_STATUS), stats.frames_encoded, stats.frames_dropped,
+        stats.queue_depth);
+    return CR_SUCCESS;
+}
+
+static COMMAND_RESULT M_Entrypoint(const COMMAND_CONTEXT *const ctx)
+{
+    if (String_Equivalent(ctx->args, "status")) {
+        return M_Status();
+    }
+    if (!String_Equivalent(ctx->args, "")) {
+        return CR_BAD_INVOCATION;
+    }
+    return Recorder_IsActive() ? M_Stop() : M_Start();
+}
+
+CONSOLE_COMMAND g_Console_Cmd_Record = {
+    .prefix = "record",
+    .proc = M_Entrypoint,
+};
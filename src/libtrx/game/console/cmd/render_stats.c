@@ -0,0 +1,116 @@
+#include "game/console/cmd/render_stats.h"
+
+#include "game/clock.h"
+#include "game/game_string.h"
+#include "game/math.h"
+#include "game/output.h"
+#include "log.h"
+#include "memory.h"
+#include "strings.h"
+
+#include <string.h>
+
+#define BENCHMARK_VERTICES 1024
+#define BENCHMARK_ITERATIONS 1000
+
+static uint32_t M_NextValue(uint32_t *seed);
+static COMMAND_RESULT M_ShowStats(void);
+static COMMAND_RESULT M_Benchmark(void);
+static COMMAND_RESULT M_Entrypoint(const COMMAND_CONTEXT *ctx);
+
+static uint32_t M_NextValue(uint32_t *const seed)
+{
+    // A private generator, so that the benchmark leaves the game's random
+    // sequences alone.
+    *seed = *seed * 1103515245 + 12345;
+    return *seed >> 8;
+}
+
+static COMMAND_RESULT M_ShowStats(void)
+{
+    const GFX_3D_RENDERER_STATS *const stats = Output_GetRendererStats();
+    if (stats == NULL) {
+        return CR_UNAVAILABLE;
+    }
+
+    Console_Log(
+        GS(OSD_RENDER_STATS), stats->draw_calls, stats->vertices,
+        stats->requested_state_changes, stats->applied_state_changes,
+        stats->sorted_prims);
+    return CR_SUCCESS;
+}
+
+static COMMAND_RESULT M_Benchmark(void)
+{
+    // Runs the batched vertex transform against the plain C one on the same
+    // random matrices and vertices. Any difference between the two is a bug.
+    XYZ_16 *const vertices =
+        Memory_Alloc(sizeof(XYZ_16) * BENCHMARK_VERTICES);
+    XYZ_32 *const batched = Memory_Alloc(sizeof(XYZ_32) * BENCHMARK_VERTICES);
+    XYZ_32 *const scalar = Memory_Alloc(sizeof(XYZ_32) * BENCHMARK_VERTICES);
+
+    uint32_t seed = 1;
+    int32_t matrix[12];
+    int32_t mismatches = 0;
+    double batched_time = 0.0;
+    double scalar_time = 0.0;
+    for (int32_t i = 0; i < BENCHMARK_ITERATIONS; i++) {
+        for (int32_t j = 0; j < 12; j++) {
+            matrix[j] = (int32_t)(M_NextValue(&seed) << 8);
+        }
+        for (int32_t j = 0; j < BENCHMARK_VERTICES; j++) {
+            vertices[j].x = (int16_t)M_NextValue(&seed);
+            vertices[j].y = (int16_t)M_NextValue(&seed);
+            vertices[j].z = (int16_t)M_NextValue(&seed);
+        }
+        // Odd counts also cover the leftover vertices of the batches.
+        const int32_t count = BENCHMARK_VERTICES - i % 4;
+
+        double start = Clock_GetRealTime();
+        Math_TransformVertices(
+            matrix, vertices, sizeof(XYZ_16), count, batched);
+        batched_time += Clock_GetRealTime() - start;
+
+        start = Clock_GetRealTime();
+        Math_TransformVerticesScalar(
+            matrix, vertices, sizeof(XYZ_16), count, scalar);
+        scalar_time += Clock_GetRealTime() - start;
+
+        if (memcmp(batched, scalar, sizeof(XYZ_32) * count) != 0) {
+            mismatches++;
+        }
+    }
+
+    Memory_Free(vertices);
+    Memory_Free(batched);
+    Memory_Free(scalar);
+
+    Console_Log(
+        GS(OSD_TRANSFORM_BENCHMARK), batched_time * 1000.0,
+        scalar_time * 1000.0, mismatches);
+    if (!Math_IsTransformVectorized()) {
+        LOG_INFO("The vertex transform is not vectorised in this build");
+    }
+    if (mismatches > 0) {
+        LOG_ERROR(
+            "The batched vertex transform differs from the scalar one in %d "
+            "of %d runs",
+            mismatches, BENCHMARK_ITERATIONS);
+    }
+    return CR_SUCCESS;
+}
+
+static COMMAND_RESULT M_Entrypoint(const COMMAND_CONTEXT *const ctx)
+{
+    if (String_Equivalent(ctx->args, "")) {
+        return M_ShowStats();
+    } else if (String_Equivalent(ctx->args, "bench")) {
+        return M_Benchmark();
+    }
+    return CR_BAD_INVOCATION;
+}
+
+CONSOLE_COMMAND g_Console_Cmd_RenderStats = {
+    .prefix = "render-?stats",
+    .proc = M_Entrypoint,
+};
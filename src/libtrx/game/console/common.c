@@ -15,6 +15,7 @@
 
 static bool m_IsOpened = false;
 static UI_WIDGET *m_Console;
+static UI_WIDGET *m_Overlay = NULL;
 
 void Console_Init(void)
 {
@@ -24,6 +25,7 @@ void Console_Init(void)
 
 void Console_Shutdown(void)
 {
+    Console_SetOverlay(NULL);
     if (m_Console != NULL) {
         m_Console->free(m_Console);
         m_Console = NULL;
@@ -69,6 +71,19 @@ int32_t Console_GetMaxLogCount(void)
     return UI_Console_GetMaxLogCount(m_Console);
 }
 
+void Console_SetOverlay(UI_WIDGET *const overlay)
+{
+    if (m_Overlay != NULL) {
+        m_Overlay->free(m_Overlay);
+    }
+    m_Overlay = overlay;
+}
+
+UI_WIDGET *Console_GetOverlay(void)
+{
+    return m_Overlay;
+}
+
 void Console_Log(const char *fmt, ...)
 {
     ASSERT(fmt != NULL);
@@ -158,4 +173,11 @@ void Console_Draw(void)
     }
 
     m_Console->draw(m_Console);
+
+    if (m_Overlay != NULL) {
+        if (m_Overlay->control != NULL) {
+            m_Overlay->control(m_Overlay);
+        }
+        m_Overlay->draw(m_Overlay);
+    }
 }
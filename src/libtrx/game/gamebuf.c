@@ -1,52 +1,173 @@
 #include "game/gamebuf.h"
 
 #include "enum_map.h"
-#include "game/shell.h"
 #include "log.h"
 #include "memory.h"
+#include "utils.h"
 
-static size_t m_Cap = 0;
+#include <stdint.h>
+
+#define GAMEBUF_ALIGNMENT 16
+#define GAMEBUF_WIDE_ALIGNMENT 64
+
+typedef struct M_CHUNK {
+    struct M_CHUNK *next;
+    size_t size;
+    size_t used;
+    char *data;
+} M_CHUNK;
+
+static size_t m_ChunkSize = 0;
+static M_CHUNK *m_FirstChunk = NULL;
+static M_CHUNK *m_CurrentChunk = NULL;
 static size_t m_MemUsed = 0;
-static size_t m_MemFree = 0;
-static char *m_MemBase = NULL;
-static char *m_MemPtr = NULL;
+static size_t m_MemPeak = 0;
+static GAMEBUF_STATS m_Stats[GBUF_NUM_MALLOC_TYPES] = {};
+
+static size_t M_GetAlignment(GAME_BUFFER buffer);
+static M_CHUNK *M_CreateChunk(size_t size);
+static void M_FreeChunks(M_CHUNK *chunk);
+static size_t M_GetPadding(const M_CHUNK *chunk, size_t alignment);
+
+static size_t M_GetAlignment(const GAME_BUFFER buffer)
+{
+    // Large buffers that are streamed through in bulk start on a cache line.
+    switch (buffer) {
+    case GBUF_TEXTURE_PAGES:
+    case GBUF_MESHES:
+    case GBUF_ANIM_FRAMES:
+    case GBUF_ROOM_MESH:
+    case GBUF_SAMPLES:
+    case GBUF_VERTEX_BUFFER:
+        return GAMEBUF_WIDE_ALIGNMENT;
+    default:
+        return GAMEBUF_ALIGNMENT;
+    }
+}
+
+static M_CHUNK *M_CreateChunk(const size_t size)
+{
+    M_CHUNK *const chunk = Memory_Alloc(sizeof(M_CHUNK));
+    chunk->next = NULL;
+    chunk->size = size;
+    chunk->used = 0;
+    chunk->data = Memory_Alloc(size);
+    return chunk;
+}
+
+static void M_FreeChunks(M_CHUNK *chunk)
+{
+    while (chunk != NULL) {
+        M_CHUNK *const next = chunk->next;
+        Memory_FreePointer(&chunk->data);
+        Memory_FreePointer(&chunk);
+        chunk = next;
+    }
+}
+
+static size_t M_GetPadding(const M_CHUNK *const chunk, const size_t alignment)
+{
+    const uintptr_t ptr = (uintptr_t)(chunk->data + chunk->used);
+    return (alignment - (ptr & (alignment - 1))) & (alignment - 1);
+}
 
 void GameBuf_Init(const size_t cap)
 {
-    m_Cap = cap;
-    m_MemBase = Memory_Alloc(cap);
+    m_ChunkSize = cap;
+    m_FirstChunk = M_CreateChunk(cap);
+    m_MemPeak = 0;
     GameBuf_Reset();
 }
 
 void GameBuf_Reset(void)
 {
-    m_MemPtr = m_MemBase;
-    m_MemFree = m_Cap;
+    if (m_FirstChunk != NULL && m_FirstChunk->next != NULL) {
+        // The previous level needed more than one chunk; merge them so that
+        // loading a level of a similar size does not need to grow again.
+        size_t total = 0;
+        for (const M_CHUNK *chunk = m_FirstChunk; chunk != NULL;
+             chunk = chunk->next) {
+            total += chunk->size;
+        }
+        M_FreeChunks(m_FirstChunk);
+        m_FirstChunk = M_CreateChunk(total);
+    }
+    if (m_FirstChunk != NULL) {
+        m_FirstChunk->used = 0;
+    }
+    m_CurrentChunk = m_FirstChunk;
     m_MemUsed = 0;
+
+    for (int32_t i = 0; i < GBUF_NUM_MALLOC_TYPES; i++) {
+        m_Stats[i].bytes = 0;
+        m_Stats[i].alloc_count = 0;
+    }
 }
 
 void GameBuf_Shutdown(void)
 {
-    Memory_FreePointer(&m_MemBase);
-    m_Cap = 0;
-    m_MemFree = 0;
+    M_FreeChunks(m_FirstChunk);
+    m_FirstChunk = NULL;
+    m_CurrentChunk = NULL;
+    m_ChunkSize = 0;
     m_MemUsed = 0;
 }
 
 void *GameBuf_Alloc(const size_t alloc_size, const GAME_BUFFER buffer)
 {
-    const size_t aligned_size = (alloc_size + 3) & ~3;
+    const size_t alignment = M_GetAlignment(buffer);
+    const size_t aligned_size =
+        (alloc_size + GAMEBUF_ALIGNMENT - 1) & ~(GAMEBUF_ALIGNMENT - 1);
 
-    const char *const buffer_name = ENUM_MAP_TO_STRING(GAME_BUFFER, buffer);
-    if (aligned_size > m_MemFree) {
-        Shell_ExitSystemFmt(
-            "Ran out of memory while trying to allocate %d bytes for %s",
-            aligned_size, buffer_name);
+    M_CHUNK *chunk = m_CurrentChunk;
+    while (chunk->used + M_GetPadding(chunk, alignment) + aligned_size
+           > chunk->size) {
+        if (chunk->next == NULL) {
+            const size_t size = MAX(m_ChunkSize / 4, aligned_size + alignment);
+            chunk->next = M_CreateChunk(size);
+            LOG_INFO(
+                "Growing game memory by %zu bytes for %s", size,
+                ENUM_MAP_TO_STRING(GAME_BUFFER, buffer));
+        }
+        chunk = chunk->next;
+        chunk->used = 0;
     }
 
-    void *const result = m_MemPtr;
-    m_MemFree -= aligned_size;
+    chunk->used += M_GetPadding(chunk, alignment);
+    void *const result = chunk->data + chunk->used;
+    chunk->used += aligned_size;
+    m_CurrentChunk = chunk;
+
     m_MemUsed += aligned_size;
-    m_MemPtr += aligned_size;
+    m_MemPeak = MAX(m_MemPeak, m_MemUsed);
+    GAMEBUF_STATS *const stats = &m_Stats[buffer];
+    stats->bytes += aligned_size;
+    stats->peak_bytes = MAX(stats->peak_bytes, stats->bytes);
+    stats->alloc_count++;
     return result;
 }
+
+const GAMEBUF_STATS *GameBuf_GetStats(const GAME_BUFFER buffer)
+{
+    return &m_Stats[buffer];
+}
+
+size_t GameBuf_GetUsedSize(void)
+{
+    return m_MemUsed;
+}
+
+size_t GameBuf_GetPeakSize(void)
+{
+    return m_MemPeak;
+}
+
+size_t GameBuf_GetReservedSize(void)
+{
+    size_t total = 0;
+    for (const M_CHUNK *chunk = m_FirstChunk; chunk != NULL;
+         chunk = chunk->next) {
+        total += chunk->size;
+    }
+    return total;
+}
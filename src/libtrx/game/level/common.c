@@ -6,6 +6,7 @@
 #include "game/inject.h"
 #include "game/objects/common.h"
 #include "game/rooms.h"
+#include "hash_map.h"
 #include "log.h"
 #include "utils.h"
 #include "vector.h"
@@ -180,17 +181,22 @@ void Level_ReadObjectMeshes(
     // by several pointers as a dummy mesh.
     VECTOR *const unique_indices =
         Vector_CreateAtCapacity(sizeof(int32_t), num_indices);
+    HASH_MAP *const unique_lookup = HashMap_Create(HMK_INT, sizeof(int32_t));
     int32_t pointer_map[num_indices];
     for (int32_t i = 0; i < num_indices; i++) {
         const int32_t pointer = indices[i];
-        const int32_t index = Vector_IndexOf(unique_indices, (void *)&pointer);
-        if (index == -1) {
+        const int32_t *const index =
+            HashMap_FindInt(unique_lookup, (uint32_t)pointer);
+        if (index == NULL) {
             pointer_map[i] = unique_indices->count;
+            HashMap_InsertInt(
+                unique_lookup, (uint32_t)pointer, &unique_indices->count);
             Vector_Add(unique_indices, (void *)&pointer);
         } else {
-            pointer_map[i] = index;
+            pointer_map[i] = *index;
         }
     }
+    HashMap_Free(unique_lookup);
 
     OBJECT_MESH *const meshes =
         GameBuf_Alloc(sizeof(OBJECT_MESH) * unique_indices->count, GBUF_MESHES);
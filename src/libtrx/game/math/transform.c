@@ -0,0 +1,144 @@
+#include "game/math.h"
+
+#include <string.h>
+
+#if defined(__SSE2__)
+    #include <emmintrin.h>
+
+typedef struct {
+    __m128i xy_lo;
+    __m128i z1_lo;
+    __m128i xy_hi;
+    __m128i z1_hi;
+} M_ROW;
+#endif
+
+#define M_VERTEX(vertices, stride, i)                                          \
+    ((const XYZ_16 *)((const char *)(vertices) + (size_t)(i) * (stride)))
+
+static void M_TransformScalar(
+    const int32_t *matrix, const XYZ_16 *vertices, size_t stride,
+    int32_t count, XYZ_32 *out);
+#if defined(__SSE2__)
+static M_ROW M_SplitRow(const int32_t *row);
+static __m128 M_TransformRow(const M_ROW *row, __m128i xy, __m128i z1);
+#endif
+
+static void M_TransformScalar(
+    const int32_t *const matrix, const XYZ_16 *const vertices,
+    const size_t stride, const int32_t count, XYZ_32 *const out)
+{
+    // Unsigned arithmetic wraps on overflow the same way the SIMD lanes do.
+    const uint32_t *const m = (const uint32_t *)matrix;
+    for (int32_t i = 0; i < count; i++) {
+        const XYZ_16 *const vertex = M_VERTEX(vertices, stride, i);
+        const uint32_t x = (uint32_t)(int32_t)vertex->x;
+        const uint32_t y = (uint32_t)(int32_t)vertex->y;
+        const uint32_t z = (uint32_t)(int32_t)vertex->z;
+        out[i].x = (int32_t)(m[0] * x + m[1] * y + m[2] * z + m[3]);
+        out[i].y = (int32_t)(m[4] * x + m[5] * y + m[6] * z + m[7]);
+        out[i].z = (int32_t)(m[8] * x + m[9] * y + m[10] * z + m[11]);
+    }
+}
+
+#if defined(__SSE2__)
+// Splits each matrix value m into two 16-bit halves h and l, such that
+// m = h * 65536 + l with l signed. Vertex components are 16-bit too, so both
+// halves multiply with them in _mm_madd_epi16, which also sums the products
+// in pairs. The translation is paired with a constant 1 next to the z.
+static M_ROW M_SplitRow(const int32_t *const row)
+{
+    uint32_t lo[4];
+    uint32_t hi[4];
+    for (int32_t i = 0; i < 4; i++) {
+        const int16_t l = (int16_t)(uint16_t)row[i];
+        lo[i] = (uint16_t)l;
+        hi[i] = (uint16_t)(((uint32_t)row[i] - l) >> 16);
+    }
+    return (M_ROW) {
+        .xy_lo = _mm_set1_epi32(lo[0] | (lo[1] << 16)),
+        .z1_lo = _mm_set1_epi32(lo[2] | (lo[3] << 16)),
+        .xy_hi = _mm_set1_epi32(hi[0] | (hi[1] << 16)),
+        .z1_hi = _mm_set1_epi32(hi[2] | (hi[3] << 16)),
+    };
+}
+
+static __m128 M_TransformRow(
+    const M_ROW *const row, const __m128i xy, const __m128i z1)
+{
+    const __m128i lo = _mm_add_epi32(
+        _mm_madd_epi16(xy, row->xy_lo), _mm_madd_epi16(z1, row->z1_lo));
+    const __m128i hi = _mm_add_epi32(
+        _mm_madd_epi16(xy, row->xy_hi), _mm_madd_epi16(z1, row->z1_hi));
+    return _mm_castsi128_ps(_mm_add_epi32(lo, _mm_slli_epi32(hi, 16)));
+}
+#endif
+
+void Math_TransformVertices(
+    const int32_t *const matrix, const XYZ_16 *const vertices,
+    const size_t stride, const int32_t count, XYZ_32 *const out)
+{
+#if defined(__SSE2__)
+    const M_ROW row_x = M_SplitRow(&matrix[0]);
+    const M_ROW row_y = M_SplitRow(&matrix[4]);
+    const M_ROW row_z = M_SplitRow(&matrix[8]);
+
+    // Four vertices at a time; the remainder goes through the scalar path.
+    int32_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128i xy_v = _mm_setzero_si128();
+        __m128i z1_v = _mm_setzero_si128();
+        for (int32_t j = 3; j >= 0; j--) {
+            const XYZ_16 *const vertex = M_VERTEX(vertices, stride, i + j);
+            int32_t xy;
+            memcpy(&xy, &vertex->x, sizeof(int32_t));
+            const uint32_t z1 = (uint16_t)vertex->z | (1u << 16);
+            xy_v = _mm_or_si128(
+                _mm_slli_si128(xy_v, 4), _mm_cvtsi32_si128(xy));
+            z1_v = _mm_or_si128(
+                _mm_slli_si128(z1_v, 4), _mm_cvtsi32_si128(z1));
+        }
+
+        const __m128 x = M_TransformRow(&row_x, xy_v, z1_v);
+        const __m128 y = M_TransformRow(&row_y, xy_v, z1_v);
+        const __m128 z = M_TransformRow(&row_z, xy_v, z1_v);
+
+        // Interleave the x, y and z rows into four packed XYZ_32 entries.
+        const __m128 xy_lo_v = _mm_unpacklo_ps(x, y);
+        const __m128 xy_hi_v = _mm_unpackhi_ps(x, y);
+        const __m128 zx_lo_v = _mm_unpacklo_ps(z, x);
+        const __m128 zx_hi_v = _mm_unpackhi_ps(z, x);
+        const __m128 yz_lo_v = _mm_unpacklo_ps(y, z);
+        const __m128 yz_hi_v = _mm_unpackhi_ps(y, z);
+        float *const dst = (float *)&out[i];
+        _mm_storeu_ps(
+            dst, _mm_shuffle_ps(xy_lo_v, zx_lo_v, _MM_SHUFFLE(3, 0, 1, 0)));
+        _mm_storeu_ps(
+            dst + 4,
+            _mm_shuffle_ps(yz_lo_v, xy_hi_v, _MM_SHUFFLE(1, 0, 3, 2)));
+        _mm_storeu_ps(
+            dst + 8,
+            _mm_shuffle_ps(zx_hi_v, yz_hi_v, _MM_SHUFFLE(3, 2, 3, 0)));
+    }
+    M_TransformScalar(
+        matrix, M_VERTEX(vertices, stride, i), stride, count - i, &out[i]);
+#else
+    M_TransformScalar(matrix, vertices, stride, count, out);
+#endif
+}
+
+void Math_TransformVerticesScalar(
+    const int32_t *const matrix, const XYZ_16 *const vertices,
+    const size_t stride, const int32_t count, XYZ_32 *const out)
+{
+    M_TransformScalar(matrix, vertices, stride, count, out);
+}
+
+bool Math_IsTransformVectorized(void)
+{
+#if defined(__SSE2__)
+    return true;
+#else
+    return false;
+#endif
+}
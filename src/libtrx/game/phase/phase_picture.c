@@ -10,6 +10,7 @@
 #include "memory.h"
 
 typedef enum {
+    STATE_LOAD,
     STATE_FADE_IN,
     STATE_DISPLAY,
     STATE_FADE_OUT,
@@ -22,6 +23,7 @@ typedef struct {
     PHASE_PICTURE_ARGS args;
 } M_PRIV;
 
+static void M_FadeIn(M_PRIV *p);
 static void M_FadeOut(M_PRIV *p);
 
 static PHASE_CONTROL M_Start(PHASE *phase);
@@ -29,6 +31,14 @@ static void M_End(PHASE *phase);
 static PHASE_CONTROL M_Control(PHASE *phase, int32_t num_frames);
 static void M_Draw(PHASE *phase);
 
+static void M_FadeIn(M_PRIV *const p)
+{
+    Output_LoadBackgroundFromFile(p->args.file_name);
+    p->state = STATE_FADE_IN;
+    Fader_Init(&p->fader, FADER_BLACK, FADER_TRANSPARENT, p->args.fade_in_time);
+    ClockTimer_Sync(&p->timer);
+}
+
 static void M_FadeOut(M_PRIV *const p)
 {
     p->state = STATE_FADE_OUT;
@@ -38,9 +48,15 @@ static void M_FadeOut(M_PRIV *const p)
 static PHASE_CONTROL M_Start(PHASE *const phase)
 {
     M_PRIV *const p = phase->priv;
-    Output_LoadBackgroundFromFile(p->args.file_name);
-    Fader_Init(&p->fader, FADER_BLACK, FADER_TRANSPARENT, p->args.fade_in_time);
-    ClockTimer_Sync(&p->timer);
+    // Keep the screen black until the picture is decoded rather than
+    // stalling the frame, unless the gameflow already had it prefetched. If
+    // the cache is too full to take the request, load it right away.
+    if (!Output_PrefetchBackground(p->args.file_name)
+        || Output_IsBackgroundReady(p->args.file_name)) {
+        M_FadeIn(p);
+    } else {
+        p->state = STATE_LOAD;
+    }
     return (PHASE_CONTROL) {};
 }
 
@@ -57,6 +73,21 @@ static PHASE_CONTROL M_Control(PHASE *const phase, const int32_t num_frames)
     Shell_ProcessInput();
 
     switch (p->state) {
+    case STATE_LOAD:
+        if (g_InputDB.menu_confirm || g_InputDB.menu_back
+            || Game_IsExiting()) {
+            return (PHASE_CONTROL) {
+                .action = PHASE_ACTION_END,
+                .gf_cmd = { .action = GF_NOOP },
+            };
+        } else if (
+            // Requeue the picture in case it was evicted in the meantime.
+            !Output_PrefetchBackground(p->args.file_name)
+            || Output_IsBackgroundReady(p->args.file_name)) {
+            M_FadeIn(p);
+        }
+        break;
+
     case STATE_FADE_IN:
         if (g_InputDB.menu_confirm || g_InputDB.menu_back || Game_IsExiting()) {
             M_FadeOut(p);
@@ -94,9 +125,11 @@ static PHASE_CONTROL M_Control(PHASE *const phase, const int32_t num_frames)
 static void M_Draw(PHASE *const phase)
 {
     M_PRIV *const p = phase->priv;
-    Output_DrawBackground();
-    Output_DrawPolyList();
-    Fader_Draw(&p->fader);
+    if (p->state != STATE_LOAD) {
+        Output_DrawBackground();
+        Output_DrawPolyList();
+        Fader_Draw(&p->fader);
+    }
     Console_Draw();
     Text_Draw();
     Output_DrawPolyList();
@@ -107,7 +140,7 @@ PHASE *Phase_Picture_Create(const PHASE_PICTURE_ARGS args)
     PHASE *const phase = Memory_Alloc(sizeof(PHASE));
     M_PRIV *const p = Memory_Alloc(sizeof(M_PRIV));
     p->args = args;
-    p->state = STATE_FADE_IN;
+    p->state = STATE_LOAD;
     phase->priv = p;
     phase->start = M_Start;
     phase->end = M_End;
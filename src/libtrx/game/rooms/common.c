@@ -185,3 +185,37 @@ int32_t Room_GetAdjoiningRooms(
 
     return count;
 }
+
+void Room_GetNearbyRooms(
+    COLLISION_QUERY *const query, const int32_t x, const int32_t y,
+    const int32_t z, const int32_t r, const int32_t h, const int16_t room_num)
+{
+    query->room_count = 0;
+    query->room_nums[query->room_count++] = room_num;
+
+    Room_GetNewRoom(query, x + r, y, z + r, room_num);
+    Room_GetNewRoom(query, x - r, y, z + r, room_num);
+    Room_GetNewRoom(query, x + r, y, z - r, room_num);
+    Room_GetNewRoom(query, x - r, y, z - r, room_num);
+    Room_GetNewRoom(query, x + r, y - h, z + r, room_num);
+    Room_GetNewRoom(query, x - r, y - h, z + r, room_num);
+    Room_GetNewRoom(query, x + r, y - h, z - r, room_num);
+    Room_GetNewRoom(query, x - r, y - h, z - r, room_num);
+}
+
+void Room_GetNewRoom(
+    COLLISION_QUERY *const query, const int32_t x, const int32_t y,
+    const int32_t z, int16_t room_num)
+{
+    Room_GetSector(x, y, z, &room_num);
+
+    for (int32_t i = 0; i < query->room_count; i++) {
+        if (query->room_nums[i] == room_num) {
+            return;
+        }
+    }
+
+    if (query->room_count < COLLISION_QUERY_MAX_ROOMS) {
+        query->room_nums[query->room_count++] = room_num;
+    }
+}
@@ -35,6 +35,7 @@ static char *m_GlyphLookupKey = NULL;
 static M_HASH_ENTRY *m_GlyphMap = NULL;
 
 static size_t M_GetGlyphSize(const char *ptr);
+static void M_FreeBuffers(TEXTSTRING *text);
 
 static size_t M_GetGlyphSize(const char *const ptr)
 {
@@ -59,6 +60,14 @@ static size_t M_GetGlyphSize(const char *const ptr)
     return 1;
 }
 
+static void M_FreeBuffers(TEXTSTRING *const text)
+{
+    Memory_FreePointer(&text->content);
+    Memory_FreePointer(&text->glyphs);
+    text->content_capacity = 0;
+    text->glyph_capacity = 0;
+}
+
 void Text_Init(void)
 {
     for (int32_t i = 0; i < TEXT_MAX_STRINGS; i++) {
@@ -85,8 +94,7 @@ void Text_Shutdown(void)
 {
     for (int32_t i = 0; i < TEXT_MAX_STRINGS; i++) {
         TEXTSTRING *const text = &m_TextStrings[i];
-        Memory_FreePointer(&text->content);
-        Memory_FreePointer(&text->glyphs);
+        M_FreeBuffers(text);
     }
 
     M_HASH_ENTRY *current, *tmp;
@@ -139,7 +147,9 @@ TEXTSTRING *Text_Create(int16_t x, int16_t y, const char *const content)
 
     TEXTSTRING *text = &m_TextStrings[free_idx];
     text->content = NULL;
+    text->content_capacity = 0;
     text->glyphs = NULL;
+    text->glyph_capacity = 0;
     text->scale.h = TEXT_BASE_SCALE;
     text->scale.v = TEXT_BASE_SCALE;
     text->pos.x = x;
@@ -168,8 +178,7 @@ void Text_Remove(TEXTSTRING *const text)
     }
     if (text->flags.active) {
         text->flags.active = 0;
-        Memory_FreePointer(&text->content);
-        Memory_FreePointer(&text->glyphs);
+        M_FreeBuffers(text);
     }
 }
 
@@ -180,9 +189,14 @@ void Text_ChangeText(TEXTSTRING *const text, const char *const content)
     }
 
     ASSERT(content != NULL);
-    Memory_FreePointer(&text->content);
-    Memory_FreePointer(&text->glyphs);
+    if (text->flags.active && text->content != NULL
+        && strcmp(text->content, content) == 0) {
+        // HUD texts are refreshed every frame, usually with the same content
+        return;
+    }
+
     if (!text->flags.active) {
+        M_FreeBuffers(text);
         return;
     }
 
@@ -195,8 +209,19 @@ void Text_ChangeText(TEXTSTRING *const text, const char *const content)
         glyph_count++;
     }
 
-    text->content = Memory_DupStr(content);
-    text->glyphs = Memory_Alloc((glyph_count + 1) * sizeof(GLYPH_INFO *));
+    // Texts such as timers change every frame, but rarely grow, so the
+    // buffers are kept and only reallocated when the new content is longer.
+    const size_t content_size = strlen(content) + 1;
+    if (content_size > text->content_capacity) {
+        text->content = Memory_Realloc(text->content, content_size);
+        text->content_capacity = content_size;
+    }
+    memcpy(text->content, content, content_size);
+    if (glyph_count + 1 > text->glyph_capacity) {
+        text->glyphs = Memory_Realloc(
+            text->glyphs, (glyph_count + 1) * sizeof(GLYPH_INFO *));
+        text->glyph_capacity = glyph_count + 1;
+    }
 
     // Assign glyphs using hash table
     content_ptr = content;
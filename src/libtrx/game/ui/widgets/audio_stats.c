@@ -0,0 +1,108 @@
+#include "game/ui/widgets/audio_stats.h"
+
+#include "engine/audio.h"
+#include "game/clock.h"
+#include "game/game_string.h"
+#include "game/ui/common.h"
+#include "game/ui/widgets/label.h"
+#include "memory.h"
+
+#include <stdio.h>
+
+#define WINDOW_MARGIN 5
+// In seconds.
+#define REFRESH_RATE 0.5
+
+typedef struct {
+    UI_WIDGET_VTABLE vtable;
+    UI_WIDGET *label;
+    CLOCK_TIMER timer;
+} UI_AUDIO_STATS;
+
+static void M_Refresh(UI_AUDIO_STATS *self);
+
+static int32_t M_GetWidth(const UI_AUDIO_STATS *self);
+static int32_t M_GetHeight(const UI_AUDIO_STATS *self);
+static void M_SetPosition(UI_AUDIO_STATS *self, int32_t x, int32_t y);
+static void M_Control(UI_AUDIO_STATS *self);
+static void M_Draw(UI_AUDIO_STATS *self);
+static void M_Free(UI_AUDIO_STATS *self);
+
+static void M_Refresh(UI_AUDIO_STATS *const self)
+{
+    const AUDIO_STATS stats = Audio_GetStats();
+    char text[256];
+    snprintf(
+        text, sizeof(text), GS(OSD_AUDIO_STATS), stats.buffer_samples,
+        stats.buffer_period, stats.avg_callback_time, stats.max_callback_time,
+        stats.avg_stream_time, stats.avg_load, stats.max_load,
+        stats.underruns, stats.active_samples, stats.active_streams);
+    UI_Label_ChangeText(self->label, text);
+
+    // keep the label aligned to the right edge as its width changes
+    M_SetPosition(
+        self, UI_GetCanvasWidth() - M_GetWidth(self) - WINDOW_MARGIN,
+        WINDOW_MARGIN);
+}
+
+static int32_t M_GetWidth(const UI_AUDIO_STATS *const self)
+{
+    if (self->vtable.is_hidden) {
+        return 0;
+    }
+    return self->label->get_width(self->label);
+}
+
+static int32_t M_GetHeight(const UI_AUDIO_STATS *const self)
+{
+    if (self->vtable.is_hidden) {
+        return 0;
+    }
+    return self->label->get_height(self->label);
+}
+
+static void M_SetPosition(
+    UI_AUDIO_STATS *const self, const int32_t x, const int32_t y)
+{
+    self->label->set_position(self->label, x, y);
+}
+
+static void M_Control(UI_AUDIO_STATS *const self)
+{
+    if (ClockTimer_CheckElapsedAndTake(&self->timer, REFRESH_RATE)) {
+        M_Refresh(self);
+    }
+}
+
+static void M_Draw(UI_AUDIO_STATS *const self)
+{
+    if (self->vtable.is_hidden) {
+        return;
+    }
+    self->label->draw(self->label);
+}
+
+static void M_Free(UI_AUDIO_STATS *const self)
+{
+    self->label->free(self->label);
+    Memory_Free(self);
+}
+
+UI_WIDGET *UI_AudioStats_Create(void)
+{
+    UI_AUDIO_STATS *const self = Memory_Alloc(sizeof(UI_AUDIO_STATS));
+    self->vtable = (UI_WIDGET_VTABLE) {
+        .control = (UI_WIDGET_CONTROL)M_Control,
+        .draw = (UI_WIDGET_DRAW)M_Draw,
+        .get_width = (UI_WIDGET_GET_WIDTH)M_GetWidth,
+        .get_height = (UI_WIDGET_GET_HEIGHT)M_GetHeight,
+        .set_position = (UI_WIDGET_SET_POSITION)M_SetPosition,
+        .free = (UI_WIDGET_FREE)M_Free,
+    };
+    self->label =
+        UI_Label_Create("", UI_LABEL_AUTO_SIZE, UI_LABEL_AUTO_SIZE);
+    self->timer = (CLOCK_TIMER) { .type = CLOCK_TIMER_REAL };
+    ClockTimer_Sync(&self->timer);
+    M_Refresh(self);
+    return (UI_WIDGET *)self;
+}
@@ -19,6 +19,12 @@ typedef enum {
     M_UNIFORM_TINT_ENABLED,
     M_UNIFORM_TINT_COLOR,
     M_UNIFORM_EFFECT,
+    M_UNIFORM_TEXTURE_Y,
+    M_UNIFORM_TEXTURE_U,
+    M_UNIFORM_TEXTURE_V,
+    M_UNIFORM_YUV_ENABLED,
+    M_UNIFORM_YUV_RANGE,
+    M_UNIFORM_YUV_COEFFS,
     M_UNIFORM_NUMBER_OF,
 } M_UNIFORM;
 
@@ -35,6 +41,7 @@ struct GFX_2D_RENDERER {
     GFX_GL_TEXTURE surface_texture;
     GFX_GL_TEXTURE palette_texture;
     GFX_GL_TEXTURE alpha_texture;
+    GFX_GL_TEXTURE yuv_textures[3];
     GFX_GL_PROGRAM program;
 
     M_VERTEX *vertices;
@@ -42,6 +49,12 @@ struct GFX_2D_RENDERER {
 
     GFX_2D_SURFACE_DESC desc;
     GFX_2D_SURFACE_DESC alpha_desc;
+    struct {
+        int32_t width;
+        int32_t height;
+        bool is_bt709;
+        bool is_full_range;
+    } yuv_desc;
     struct {
         int32_t x;
         int32_t y;
@@ -51,6 +64,7 @@ struct GFX_2D_RENDERER {
     GFX_2D_EFFECT effect;
     bool use_palette;
     bool use_alpha;
+    bool use_yuv;
 
     // shader variable locations
     GLint loc[M_UNIFORM_NUMBER_OF];
@@ -65,6 +79,12 @@ static const M_VERTEX m_Vertices[] = {
     { .x = 1.0, .y = 1.0, .u = 1.0, .v = 1.0 },
 };
 
+static void M_UploadVertices(GFX_2D_RENDERER *r);
+static void M_UploadPlane(
+    GFX_GL_TEXTURE *texture, int32_t width, int32_t height,
+    const uint8_t *data, int32_t pitch, bool reallocate);
+static void M_SetYUVEnabled(GFX_2D_RENDERER *r, bool enabled);
+
 static void M_UploadVertices(GFX_2D_RENDERER *const r)
 {
     const int32_t mapping[] = { 0, 1, 3, 3, 1, 2 };
@@ -98,6 +118,46 @@ static void M_UploadVertices(GFX_2D_RENDERER *const r)
         r->vertices, GL_STATIC_DRAW);
 }
 
+static void M_UploadPlane(
+    GFX_GL_TEXTURE *const texture, const int32_t width, const int32_t height,
+    const uint8_t *const data, const int32_t pitch, const bool reallocate)
+{
+    GFX_GL_Texture_Bind(texture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    GFX_GL_CheckError();
+    // upload straight from the decoder's padded planes
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, pitch);
+    GFX_GL_CheckError();
+    if (reallocate) {
+        glTexImage2D(
+            GL_TEXTURE_2D, 0, GL_R8, width, height, 0, GL_RED,
+            GL_UNSIGNED_BYTE, data);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    } else {
+        glTexSubImage2D(
+            GL_TEXTURE_2D, 0, 0, 0, width, height, GL_RED, GL_UNSIGNED_BYTE,
+            data);
+    }
+    GFX_GL_CheckError();
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+    GFX_GL_CheckError();
+}
+
+static void M_SetYUVEnabled(GFX_2D_RENDERER *const r, const bool enabled)
+{
+    if (r->use_yuv == enabled) {
+        return;
+    }
+    GFX_GL_Program_Bind(&r->program);
+    GFX_GL_Program_Uniform1i(
+        &r->program, r->loc[M_UNIFORM_YUV_ENABLED], enabled);
+    GFX_GL_CheckError();
+    r->use_yuv = enabled;
+}
+
 GFX_2D_RENDERER *GFX_2D_Renderer_Create(void)
 {
     LOG_INFO("");
@@ -108,6 +168,7 @@ GFX_2D_RENDERER *GFX_2D_Renderer_Create(void)
     r->tint_color = (GFX_COLOR) { .r = 255, .g = 255, .b = 255 };
     r->use_palette = false;
     r->use_alpha = false;
+    r->use_yuv = false;
     r->repeat.x = 1;
     r->repeat.y = 1;
 
@@ -131,6 +192,9 @@ GFX_2D_RENDERER *GFX_2D_Renderer_Create(void)
     GFX_GL_Texture_Init(&r->surface_texture, GL_TEXTURE_2D);
     GFX_GL_Texture_Init(&r->palette_texture, GL_TEXTURE_1D);
     GFX_GL_Texture_Init(&r->alpha_texture, GL_TEXTURE_2D);
+    for (int32_t i = 0; i < 3; i++) {
+        GFX_GL_Texture_Init(&r->yuv_textures[i], GL_TEXTURE_2D);
+    }
 
     GFX_GL_Program_Init(&r->program);
     GFX_GL_Program_AttachShader(
@@ -152,6 +216,12 @@ GFX_2D_RENDERER *GFX_2D_Renderer_Create(void)
         { M_UNIFORM_TINT_ENABLED, "tintEnabled" },
         { M_UNIFORM_TINT_COLOR, "tintColor" },
         { M_UNIFORM_EFFECT, "effect" },
+        { M_UNIFORM_TEXTURE_Y, "texY" },
+        { M_UNIFORM_TEXTURE_U, "texU" },
+        { M_UNIFORM_TEXTURE_V, "texV" },
+        { M_UNIFORM_YUV_ENABLED, "yuvEnabled" },
+        { M_UNIFORM_YUV_RANGE, "yuvRange" },
+        { M_UNIFORM_YUV_COEFFS, "yuvCoeffs" },
         { -1, NULL },
     };
     for (int32_t i = 0; uniforms[i].name != NULL; i++) {
@@ -164,6 +234,11 @@ GFX_2D_RENDERER *GFX_2D_Renderer_Create(void)
     GFX_GL_Program_Uniform1i(&r->program, r->loc[M_UNIFORM_TEXTURE_MAIN], 0);
     GFX_GL_Program_Uniform1i(&r->program, r->loc[M_UNIFORM_TEXTURE_PALETTE], 1);
     GFX_GL_Program_Uniform1i(&r->program, r->loc[M_UNIFORM_TEXTURE_ALPHA], 2);
+    GFX_GL_Program_Uniform1i(&r->program, r->loc[M_UNIFORM_TEXTURE_Y], 3);
+    GFX_GL_Program_Uniform1i(&r->program, r->loc[M_UNIFORM_TEXTURE_U], 4);
+    GFX_GL_Program_Uniform1i(&r->program, r->loc[M_UNIFORM_TEXTURE_V], 5);
+    GFX_GL_Program_Uniform1i(
+        &r->program, r->loc[M_UNIFORM_YUV_ENABLED], r->use_yuv);
     GFX_GL_Program_Uniform1i(
         &r->program, r->loc[M_UNIFORM_PALETTE_ENABLED], r->use_palette);
     GFX_GL_Program_Uniform1i(
@@ -187,6 +262,9 @@ void GFX_2D_Renderer_Destroy(GFX_2D_RENDERER *const r)
     GFX_GL_Texture_Close(&r->surface_texture);
     GFX_GL_Texture_Close(&r->palette_texture);
     GFX_GL_Texture_Close(&r->alpha_texture);
+    for (int32_t i = 0; i < 3; i++) {
+        GFX_GL_Texture_Close(&r->yuv_textures[i]);
+    }
     GFX_GL_Program_Close(&r->program);
     Memory_FreePointer(&r->vertices);
     Memory_Free(r);
@@ -268,6 +346,7 @@ void GFX_2D_Renderer_Upload(
         reupload_vert = true;
     }
 
+    M_SetYUVEnabled(r, false);
     glActiveTexture(GL_TEXTURE0);
     GFX_GL_Texture_Bind(&r->surface_texture);
 
@@ -300,6 +379,68 @@ void GFX_2D_Renderer_Upload(
     }
 }
 
+void GFX_2D_Renderer_UploadYUV(
+    GFX_2D_RENDERER *const r, GFX_2D_SURFACE_DESC *const desc,
+    const GFX_2D_YUV_DATA *const data)
+{
+    ASSERT(r != NULL);
+    ASSERT(GFX_Context_GetConfig()->backend == GFX_GL_33C);
+
+    const bool reupload_vert =
+        memcmp(r->desc.uv, desc->uv, sizeof(desc->uv)) != 0;
+    const bool reallocate = r->yuv_desc.width != desc->width
+        || r->yuv_desc.height != desc->height;
+
+    if (reallocate || r->yuv_desc.is_bt709 != data->is_bt709
+        || r->yuv_desc.is_full_range != data->is_full_range) {
+        // Limited range video keeps luma in 16-235 and chroma in 16-240.
+        const float y_offset = data->is_full_range ? 0.0f : 16.0f / 255.0f;
+        const float y_scale = data->is_full_range ? 1.0f : 255.0f / 219.0f;
+        const float c_scale = data->is_full_range ? 1.0f : 255.0f / 224.0f;
+        GFX_GL_Program_Bind(&r->program);
+        GFX_GL_Program_Uniform3f(
+            &r->program, r->loc[M_UNIFORM_YUV_RANGE], y_offset, y_scale,
+            c_scale);
+        if (data->is_bt709) {
+            GFX_GL_Program_Uniform4f(
+                &r->program, r->loc[M_UNIFORM_YUV_COEFFS], 1.5748f, 0.187324f,
+                0.468124f, 1.8556f);
+        } else {
+            GFX_GL_Program_Uniform4f(
+                &r->program, r->loc[M_UNIFORM_YUV_COEFFS], 1.402f, 0.344136f,
+                0.714136f, 1.772f);
+        }
+        GFX_GL_CheckError();
+    }
+    M_SetYUVEnabled(r, true);
+
+    const int32_t chroma_width = (desc->width + 1) / 2;
+    const int32_t chroma_height = (desc->height + 1) / 2;
+    glActiveTexture(GL_TEXTURE3);
+    M_UploadPlane(
+        &r->yuv_textures[0], desc->width, desc->height, data->planes[0],
+        data->pitches[0], reallocate);
+    glActiveTexture(GL_TEXTURE4);
+    M_UploadPlane(
+        &r->yuv_textures[1], chroma_width, chroma_height, data->planes[1],
+        data->pitches[1], reallocate);
+    glActiveTexture(GL_TEXTURE5);
+    M_UploadPlane(
+        &r->yuv_textures[2], chroma_width, chroma_height, data->planes[2],
+        data->pitches[2], reallocate);
+    glActiveTexture(GL_TEXTURE0);
+
+    r->yuv_desc.width = desc->width;
+    r->yuv_desc.height = desc->height;
+    r->yuv_desc.is_bt709 = data->is_bt709;
+    r->yuv_desc.is_full_range = data->is_full_range;
+    // the RGB texture is left as it was, so only the coordinates carry over
+    memcpy(r->desc.uv, desc->uv, sizeof(desc->uv));
+    if (reupload_vert) {
+        M_UploadVertices(r);
+    }
+}
+
 void GFX_2D_Renderer_SetPalette(
     GFX_2D_RENDERER *const r, const GFX_COLOR *const palette)
 {
@@ -400,6 +541,12 @@ void GFX_2D_Renderer_Render(GFX_2D_RENDERER *const r)
         glActiveTexture(GL_TEXTURE2);
         GFX_GL_Texture_Bind(&r->alpha_texture);
     }
+    if (r->use_yuv) {
+        for (int32_t i = 0; i < 3; i++) {
+            glActiveTexture(GL_TEXTURE3 + i);
+            GFX_GL_Texture_Bind(&r->yuv_textures[i]);
+        }
+    }
 
     GLboolean blend = glIsEnabled(GL_BLEND);
     if (blend) {
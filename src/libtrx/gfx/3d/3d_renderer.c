@@ -5,8 +5,36 @@
 #include "gfx/gl/utils.h"
 #include "log.h"
 #include "memory.h"
+#include "utils.h"
 
 #include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef enum {
+    M_SHAPE_STRIP,
+    M_SHAPE_FAN,
+    M_SHAPE_LIST,
+} M_SHAPE;
+
+// State that is cheap to sort by, as opposed to the depth and shader settings
+// which force the queued primitives out when they change.
+typedef struct {
+    GFX_BLEND_MODE blend_mode;
+    bool texturing_enabled;
+    GFX_3D_PRIM_TYPE prim_type;
+} M_STATE;
+
+typedef struct {
+    M_STATE state;
+    M_SHAPE shape;
+    int texture_num;
+    float depth;
+    int32_t order;
+    int32_t first_vertex;
+    int32_t vertex_count;
+} M_QUEUED_PRIM;
 
 struct GFX_3D_RENDERER {
     const GFX_CONFIG *config;
@@ -15,10 +43,44 @@ struct GFX_3D_RENDERER {
     GFX_GL_SAMPLER sampler;
     GFX_3D_VERTEX_STREAM vertex_stream;
 
-    GFX_GL_TEXTURE *textures[GFX_MAX_TEXTURES];
+    // all texture pages live in layers of a single array texture, so that
+    // switching pages does not require a separate draw call
+    GFX_GL_TEXTURE *texture_array;
+    int texture_width;
+    int texture_height;
+    int texture_layers;
+    int max_texture_layers;
+    bool used_layers[GFX_MAX_TEXTURES];
+    // Pages are uploaded on the next draw, so that the array is only as
+    // large as the pages that a level registers in one go.
+    uint8_t *pending_pages[GFX_MAX_TEXTURES];
+    bool has_pending_pages;
     GFX_GL_TEXTURE *env_map_texture;
     int selected_texture_num;
-    GFX_BLEND_MODE selected_blend_mode;
+
+    // state requested by the caller, and state currently set up in GL
+    M_STATE state;
+    M_STATE applied_state;
+    bool is_applied_state_valid;
+    bool is_depth_writes_enabled;
+    bool is_depth_test_enabled;
+    bool is_depth_buffer_enabled;
+
+    // primitives waiting to be submitted in state order
+    bool is_state_sorting_enabled;
+    struct {
+        M_QUEUED_PRIM *data;
+        int32_t count;
+        int32_t capacity;
+    } queue;
+    struct {
+        GFX_3D_VERTEX *data;
+        int32_t count;
+        int32_t capacity;
+    } queue_vertices;
+
+    GFX_3D_RENDERER_STATS frame_stats;
+    GFX_3D_RENDERER_STATS stats;
 
     // shader variable locations
     GLint loc_mat_projection;
@@ -28,13 +90,100 @@ struct GFX_3D_RENDERER {
     GLint loc_alpha_point_discard;
     GLint loc_alpha_threshold;
     GLint loc_brightness_multiplier;
+    GLint loc_tex_pages;
+    GLint loc_tex_env_map;
 };
 
+static void M_ResizeTextureArray(GFX_3D_RENDERER *renderer, int layers);
+static void M_UploadPendingPages(GFX_3D_RENDERER *renderer);
+static void M_RenderPending(GFX_3D_RENDERER *renderer);
+static void M_ApplyState(GFX_3D_RENDERER *renderer, const M_STATE *state);
+static void M_Push(
+    GFX_3D_RENDERER *renderer, M_SHAPE shape, const GFX_3D_VERTEX *vertices,
+    int count);
+static bool M_IsQueueing(const GFX_3D_RENDERER *renderer);
+static bool M_IsOrderSensitive(const M_STATE *state);
+static void M_Enqueue(
+    GFX_3D_RENDERER *renderer, M_SHAPE shape, const GFX_3D_VERTEX *vertices,
+    int count);
+static int M_CompareQueuedPrims(const void *a, const void *b);
+static void M_SubmitQueue(GFX_3D_RENDERER *renderer);
 static void M_Flush(GFX_3D_RENDERER *renderer);
+static void M_Draw(
+    GFX_3D_RENDERER *renderer, M_SHAPE shape, const GFX_3D_VERTEX *vertices,
+    int count);
 static void M_SelectTextureImpl(GFX_3D_RENDERER *renderer, int texture_num);
 static void M_RestoreTexture(GFX_3D_RENDERER *const renderer);
 
-static void M_Flush(GFX_3D_RENDERER *const renderer)
+static void M_ResizeTextureArray(
+    GFX_3D_RENDERER *const renderer, const int layers)
+{
+    const int width = renderer->texture_width;
+    const int height = renderer->texture_height;
+    const size_t page_size = width * height * 4;
+
+    // Pages registered after the array was built; this is rare, so just
+    // read the uploaded pages back.
+    GFX_GL_TEXTURE *const old_array = renderer->texture_array;
+    uint8_t *old_data = NULL;
+    if (old_array != NULL) {
+        old_data = Memory_Alloc(page_size * renderer->texture_layers);
+        GFX_GL_Texture_Bind(old_array);
+        glGetTexImage(
+            GL_TEXTURE_2D_ARRAY, 0, GL_RGBA, GL_UNSIGNED_BYTE, old_data);
+        GFX_GL_CheckError();
+    }
+
+    renderer->texture_array = GFX_GL_Texture_Create(GL_TEXTURE_2D_ARRAY);
+    GFX_GL_Texture_LoadArray(
+        renderer->texture_array, width, height, layers, GL_RGBA, GL_RGBA);
+
+    if (old_array != NULL) {
+        for (int i = 0; i < renderer->texture_layers; i++) {
+            if (renderer->used_layers[i]
+                && renderer->pending_pages[i] == NULL) {
+                GFX_GL_Texture_LoadLayer(
+                    renderer->texture_array, i, &old_data[i * page_size],
+                    width, height, GL_RGBA);
+            }
+        }
+        GFX_GL_Texture_Free(old_array);
+        Memory_Free(old_data);
+    }
+
+    LOG_DEBUG("Texture array resized to %d layers", layers);
+    renderer->texture_layers = layers;
+}
+
+static void M_UploadPendingPages(GFX_3D_RENDERER *const renderer)
+{
+    if (!renderer->has_pending_pages) {
+        return;
+    }
+    renderer->has_pending_pages = false;
+
+    int layers = 0;
+    for (int i = 0; i < GFX_MAX_TEXTURES; i++) {
+        if (renderer->used_layers[i]) {
+            layers = i + 1;
+        }
+    }
+    if (renderer->texture_array == NULL || layers > renderer->texture_layers) {
+        M_ResizeTextureArray(renderer, layers);
+    }
+
+    for (int i = 0; i < GFX_MAX_TEXTURES; i++) {
+        if (renderer->pending_pages[i] != NULL) {
+            GFX_GL_Texture_LoadLayer(
+                renderer->texture_array, i, renderer->pending_pages[i],
+                renderer->texture_width, renderer->texture_height, GL_RGBA);
+            Memory_FreePointer(&renderer->pending_pages[i]);
+        }
+    }
+    GFX_GL_Texture_Bind(renderer->texture_array);
+}
+
+static void M_RenderPending(GFX_3D_RENDERER *const renderer)
 {
     glLineWidth(renderer->config->line_width);
     glPolygonMode(
@@ -42,7 +191,216 @@ static void M_Flush(GFX_3D_RENDERER *const renderer)
         renderer->config->enable_wireframe ? GL_LINE : GL_FILL);
     GFX_GL_CheckError();
 
+    const size_t pending_count =
+        renderer->vertex_stream.pending_vertices.count;
+    if (pending_count == 0) {
+        return;
+    }
+
+    M_UploadPendingPages(renderer);
+
     GFX_3D_VertexStream_RenderPending(&renderer->vertex_stream);
+    renderer->frame_stats.draw_calls++;
+    renderer->frame_stats.vertices += pending_count;
+}
+
+static void M_ApplyState(
+    GFX_3D_RENDERER *const renderer, const M_STATE *const state)
+{
+    M_STATE *const applied = &renderer->applied_state;
+    const bool force = !renderer->is_applied_state_valid;
+    if (!force && applied->blend_mode == state->blend_mode
+        && applied->texturing_enabled == state->texturing_enabled
+        && applied->prim_type == state->prim_type) {
+        return;
+    }
+
+    M_RenderPending(renderer);
+    renderer->frame_stats.applied_state_changes++;
+
+    if (force || applied->blend_mode != state->blend_mode) {
+        switch (state->blend_mode) {
+        case GFX_BLEND_MODE_OFF:
+            glBlendFunc(GL_ONE, GL_ZERO);
+            break;
+        case GFX_BLEND_MODE_NORMAL:
+            glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+            break;
+        case GFX_BLEND_MODE_MULTIPLY:
+            glBlendFunc(GL_DST_COLOR, GL_SRC_COLOR);
+            break;
+        }
+        GFX_GL_CheckError();
+    }
+
+    if (force || applied->texturing_enabled != state->texturing_enabled) {
+        GFX_GL_Program_Bind(&renderer->program);
+        GFX_GL_Program_Uniform1i(
+            &renderer->program, renderer->loc_texturing_enabled,
+            state->texturing_enabled);
+    }
+
+    if (force || applied->prim_type != state->prim_type) {
+        GFX_3D_VertexStream_SetPrimType(
+            &renderer->vertex_stream, state->prim_type);
+    }
+
+    *applied = *state;
+    renderer->is_applied_state_valid = true;
+}
+
+static void M_Push(
+    GFX_3D_RENDERER *const renderer, const M_SHAPE shape,
+    const GFX_3D_VERTEX *const vertices, const int count)
+{
+    switch (shape) {
+    case M_SHAPE_STRIP:
+        GFX_3D_VertexStream_PushPrimStrip(
+            &renderer->vertex_stream, vertices, count);
+        break;
+    case M_SHAPE_FAN:
+        GFX_3D_VertexStream_PushPrimFan(
+            &renderer->vertex_stream, vertices, count);
+        break;
+    case M_SHAPE_LIST:
+        GFX_3D_VertexStream_PushPrimList(
+            &renderer->vertex_stream, vertices, count);
+        break;
+    }
+}
+
+static bool M_IsQueueing(const GFX_3D_RENDERER *const renderer)
+{
+    // without depth testing and writing the submission order is what decides
+    // visibility, so it must be kept as is
+    return renderer->is_state_sorting_enabled
+        && renderer->is_depth_writes_enabled && renderer->is_depth_test_enabled
+        && renderer->is_depth_buffer_enabled;
+}
+
+static bool M_IsOrderSensitive(const M_STATE *const state)
+{
+    // Untextured faces and lines are what the games draw as decals on top of
+    // other geometry, often at the same depth, where the depth test lets the
+    // later primitive win. They are drawn in place instead of being queued.
+    return state->blend_mode == GFX_BLEND_MODE_OFF
+        && (!state->texturing_enabled
+            || state->prim_type != GFX_3D_PRIM_TRI);
+}
+
+static void M_Enqueue(
+    GFX_3D_RENDERER *const renderer, const M_SHAPE shape,
+    const GFX_3D_VERTEX *const vertices, const int count)
+{
+    if (count <= 0) {
+        return;
+    }
+
+    if (renderer->queue.count + 1 > renderer->queue.capacity) {
+        renderer->queue.capacity = MAX(renderer->queue.capacity * 2, 256);
+        renderer->queue.data = Memory_Realloc(
+            renderer->queue.data,
+            renderer->queue.capacity * sizeof(M_QUEUED_PRIM));
+    }
+
+    const int32_t required = renderer->queue_vertices.count + count;
+    if (required > renderer->queue_vertices.capacity) {
+        renderer->queue_vertices.capacity =
+            MAX(renderer->queue_vertices.capacity * 2, MAX(required, 1024));
+        renderer->queue_vertices.data = Memory_Realloc(
+            renderer->queue_vertices.data,
+            renderer->queue_vertices.capacity * sizeof(GFX_3D_VERTEX));
+    }
+
+    float depth = 0.0f;
+    GFX_3D_VERTEX *const target =
+        &renderer->queue_vertices.data[renderer->queue_vertices.count];
+    for (int i = 0; i < count; i++) {
+        target[i] = vertices[i];
+        depth += vertices[i].z;
+    }
+
+    M_QUEUED_PRIM *const prim = &renderer->queue.data[renderer->queue.count];
+    prim->state = renderer->state;
+    prim->shape = shape;
+    prim->texture_num = renderer->selected_texture_num;
+    prim->depth = depth / count;
+    prim->order = renderer->queue.count;
+    prim->first_vertex = renderer->queue_vertices.count;
+    prim->vertex_count = count;
+
+    renderer->queue.count++;
+    renderer->queue_vertices.count += count;
+}
+
+static int M_CompareQueuedPrims(const void *const a, const void *const b)
+{
+    const M_QUEUED_PRIM *const prim_a = a;
+    const M_QUEUED_PRIM *const prim_b = b;
+
+    // opaque geometry goes first in submission order, so that coplanar
+    // faces keep the same winner; translucent geometry goes last, back to
+    // front
+    const bool opaque_a = prim_a->state.blend_mode == GFX_BLEND_MODE_OFF;
+    const bool opaque_b = prim_b->state.blend_mode == GFX_BLEND_MODE_OFF;
+    if (opaque_a != opaque_b) {
+        return opaque_a ? -1 : 1;
+    }
+
+    if (!opaque_a && prim_a->depth != prim_b->depth) {
+        return prim_a->depth > prim_b->depth ? -1 : 1;
+    }
+
+    return prim_a->order - prim_b->order;
+}
+
+static void M_SubmitQueue(GFX_3D_RENDERER *const renderer)
+{
+    if (renderer->queue.count == 0) {
+        return;
+    }
+
+    qsort(
+        renderer->queue.data, renderer->queue.count, sizeof(M_QUEUED_PRIM),
+        M_CompareQueuedPrims);
+
+    for (int32_t i = 0; i < renderer->queue.count; i++) {
+        const M_QUEUED_PRIM *const prim = &renderer->queue.data[i];
+        M_ApplyState(renderer, &prim->state);
+        M_SelectTextureImpl(renderer, prim->texture_num);
+        M_Push(
+            renderer, prim->shape,
+            &renderer->queue_vertices.data[prim->first_vertex],
+            prim->vertex_count);
+    }
+
+    renderer->frame_stats.sorted_prims += renderer->queue.count;
+    renderer->queue.count = 0;
+    renderer->queue_vertices.count = 0;
+}
+
+static void M_Flush(GFX_3D_RENDERER *const renderer)
+{
+    M_SubmitQueue(renderer);
+    M_RenderPending(renderer);
+}
+
+static void M_Draw(
+    GFX_3D_RENDERER *const renderer, const M_SHAPE shape,
+    const GFX_3D_VERTEX *const vertices, const int count)
+{
+    if (M_IsQueueing(renderer)) {
+        if (!M_IsOrderSensitive(&renderer->state)) {
+            M_Enqueue(renderer, shape, vertices, count);
+            return;
+        }
+        // everything submitted so far has to be drawn underneath
+        M_SubmitQueue(renderer);
+    }
+
+    M_ApplyState(renderer, &renderer->state);
+    M_SelectTextureImpl(renderer, renderer->selected_texture_num);
+    M_Push(renderer, shape, vertices, count);
 }
 
 static void M_SelectTextureImpl(
@@ -50,27 +408,39 @@ static void M_SelectTextureImpl(
 {
     ASSERT(renderer != NULL);
 
-    GFX_GL_TEXTURE *texture = NULL;
+    // layer -1 tells the shader to sample the environment map instead
+    float layer = 0.0f;
     if (texture_num == GFX_ENV_MAP_TEXTURE) {
-        texture = renderer->env_map_texture;
+        layer = -1.0f;
     } else if (texture_num != GFX_NO_TEXTURE) {
         ASSERT(texture_num >= 0);
         ASSERT(texture_num < GFX_MAX_TEXTURES);
-        texture = renderer->textures[texture_num];
-    }
-
-    if (texture == NULL) {
-        glBindTexture(GL_TEXTURE_2D, 0);
-        GFX_GL_CheckError();
-        return;
+        layer = texture_num;
     }
 
-    GFX_GL_Texture_Bind(texture);
+    GFX_3D_VertexStream_SetTextureLayer(&renderer->vertex_stream, layer);
 }
 
 static void M_RestoreTexture(GFX_3D_RENDERER *const renderer)
 {
     ASSERT(renderer != NULL);
+
+    glActiveTexture(GL_TEXTURE1);
+    if (renderer->env_map_texture != NULL) {
+        GFX_GL_Texture_Bind(renderer->env_map_texture);
+    } else {
+        glBindTexture(GL_TEXTURE_2D, 0);
+    }
+    glActiveTexture(GL_TEXTURE0);
+    GFX_GL_CheckError();
+
+    if (renderer->texture_array != NULL) {
+        GFX_GL_Texture_Bind(renderer->texture_array);
+    } else {
+        glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+        GFX_GL_CheckError();
+    }
+
     M_SelectTextureImpl(renderer, renderer->selected_texture_num);
 }
 
@@ -81,12 +451,27 @@ GFX_3D_RENDERER *GFX_3D_Renderer_Create(void)
     renderer->config = GFX_Context_GetConfig();
 
     renderer->selected_texture_num = GFX_NO_TEXTURE;
+    renderer->state = (M_STATE) {
+        .blend_mode = GFX_BLEND_MODE_OFF,
+        .texturing_enabled = false,
+        .prim_type = GFX_3D_PRIM_TRI,
+    };
+    renderer->is_depth_writes_enabled = true;
+    renderer->is_depth_test_enabled = true;
+    renderer->is_depth_buffer_enabled = true;
     for (int i = 0; i < GFX_MAX_TEXTURES; i++) {
-        renderer->textures[i] = NULL;
+        renderer->used_layers[i] = false;
     }
 
+    // EXT_texture_array only guarantees 64 layers
+    GLint max_layers = 0;
+    glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &max_layers);
+    GFX_GL_CheckError();
+    renderer->max_texture_layers = MIN(MAX(max_layers, 1), GFX_MAX_TEXTURES);
+
     GFX_GL_Sampler_Init(&renderer->sampler);
     GFX_GL_Sampler_Bind(&renderer->sampler, 0);
+    GFX_GL_Sampler_Bind(&renderer->sampler, 1);
     GFX_GL_Sampler_Parameterf(
         &renderer->sampler, GL_TEXTURE_MAX_ANISOTROPY_EXT, 1);
     GFX_GL_Sampler_Parameteri(
@@ -117,6 +502,10 @@ GFX_3D_RENDERER *GFX_3D_Renderer_Create(void)
         GFX_GL_Program_UniformLocation(&renderer->program, "alphaThreshold");
     renderer->loc_brightness_multiplier = GFX_GL_Program_UniformLocation(
         &renderer->program, "brightnessMultiplier");
+    renderer->loc_tex_pages =
+        GFX_GL_Program_UniformLocation(&renderer->program, "texPages");
+    renderer->loc_tex_env_map =
+        GFX_GL_Program_UniformLocation(&renderer->program, "texEnvMap");
 
     GFX_GL_Program_FragmentData(&renderer->program, "fragColor");
     GFX_GL_Program_Bind(&renderer->program);
@@ -136,6 +525,9 @@ GFX_3D_RENDERER *GFX_3D_Renderer_Create(void)
         &renderer->program, renderer->loc_alpha_threshold, -1.0);
     GFX_GL_Program_Uniform1f(
         &renderer->program, renderer->loc_brightness_multiplier, 1.0);
+    GFX_GL_Program_Uniform1i(&renderer->program, renderer->loc_tex_pages, 0);
+    GFX_GL_Program_Uniform1i(
+        &renderer->program, renderer->loc_tex_env_map, 1);
 
     GFX_3D_VertexStream_Init(&renderer->vertex_stream);
     return renderer;
@@ -147,6 +539,13 @@ void GFX_3D_Renderer_Destroy(GFX_3D_RENDERER *const renderer)
     ASSERT(renderer != NULL);
 
     GFX_3D_VertexStream_Close(&renderer->vertex_stream);
+    Memory_FreePointer(&renderer->queue.data);
+    Memory_FreePointer(&renderer->queue_vertices.data);
+    for (int i = 0; i < GFX_MAX_TEXTURES; i++) {
+        Memory_FreePointer(&renderer->pending_pages[i]);
+    }
+    GFX_GL_Texture_Free(renderer->texture_array);
+    GFX_GL_Texture_Free(renderer->env_map_texture);
     GFX_GL_Program_Close(&renderer->program);
     GFX_GL_Sampler_Close(&renderer->sampler);
     Memory_Free(renderer);
@@ -157,10 +556,18 @@ void GFX_3D_Renderer_RenderBegin(GFX_3D_RENDERER *const renderer)
     ASSERT(renderer != NULL);
 
     renderer->vertex_stream.rendered_count = 0;
+    renderer->frame_stats = (GFX_3D_RENDERER_STATS) {};
+    renderer->is_applied_state_valid = false;
+    renderer->is_state_sorting_enabled = false;
+    renderer->is_depth_writes_enabled = true;
+    renderer->is_depth_test_enabled = true;
+    renderer->is_depth_buffer_enabled = true;
+    GFX_3D_VertexStream_BeginFrame(&renderer->vertex_stream);
 
     GFX_GL_Program_Bind(&renderer->program);
     GFX_3D_VertexStream_Bind(&renderer->vertex_stream);
     GFX_GL_Sampler_Bind(&renderer->sampler, 0);
+    GFX_GL_Sampler_Bind(&renderer->sampler, 1);
 
     M_RestoreTexture(renderer);
 
@@ -191,6 +598,34 @@ void GFX_3D_Renderer_RenderEnd(GFX_3D_RENDERER *const renderer)
 {
     ASSERT(renderer != NULL);
     M_Flush(renderer);
+    GFX_3D_VertexStream_EndFrame(&renderer->vertex_stream);
+    renderer->stats = renderer->frame_stats;
+}
+
+void GFX_3D_Renderer_SetStateSortingEnabled(
+    GFX_3D_RENDERER *const renderer, const bool is_enabled)
+{
+    ASSERT(renderer != NULL);
+    if (renderer->is_state_sorting_enabled == is_enabled) {
+        return;
+    }
+    M_Flush(renderer);
+    renderer->is_state_sorting_enabled = is_enabled;
+}
+
+const GFX_3D_RENDERER_STATS *GFX_3D_Renderer_GetStats(
+    const GFX_3D_RENDERER *const renderer)
+{
+    ASSERT(renderer != NULL);
+    return &renderer->stats;
+}
+
+void GFX_3D_Renderer_ReserveVertices(
+    GFX_3D_RENDERER *const renderer, const size_t count)
+{
+    ASSERT(renderer != NULL);
+    M_Flush(renderer);
+    GFX_3D_VertexStream_Reserve(&renderer->vertex_stream, count);
 }
 
 void GFX_3D_Renderer_ClearDepth(GFX_3D_RENDERER *const renderer)
@@ -229,14 +664,16 @@ bool GFX_3D_Renderer_UnregisterEnvironmentMap(
         return false;
     }
 
+    M_Flush(renderer);
+
     // unbind texture if currently bound
     if (renderer->selected_texture_num == texture_num) {
-        M_SelectTextureImpl(renderer, GFX_NO_TEXTURE);
         renderer->selected_texture_num = GFX_NO_TEXTURE;
     }
 
     GFX_GL_Texture_Free(texture);
     renderer->env_map_texture = NULL;
+    M_RestoreTexture(renderer);
     return true;
 }
 
@@ -247,7 +684,10 @@ void GFX_3D_Renderer_FillEnvironmentMap(GFX_3D_RENDERER *const renderer)
     GFX_GL_TEXTURE *const env_map = renderer->env_map_texture;
     if (env_map != NULL) {
         M_Flush(renderer);
+        glActiveTexture(GL_TEXTURE1);
         GFX_GL_Texture_LoadFromBackBuffer(env_map);
+        glActiveTexture(GL_TEXTURE0);
+        GFX_GL_CheckError();
         M_RestoreTexture(renderer);
     }
 }
@@ -258,20 +698,41 @@ int GFX_3D_Renderer_RegisterTexturePage(
 {
     ASSERT(renderer != NULL);
     ASSERT(data != NULL);
-    GFX_GL_TEXTURE *const texture = GFX_GL_Texture_Create(GL_TEXTURE_2D);
-    GFX_GL_Texture_Load(texture, data, width, height, GL_RGBA, GL_RGBA);
 
-    int texture_num = GFX_NO_TEXTURE;
+    bool has_pages = false;
     for (int i = 0; i < GFX_MAX_TEXTURES; i++) {
-        if (!renderer->textures[i]) {
-            renderer->textures[i] = texture;
+        has_pages |= renderer->used_layers[i];
+    }
+    if (!has_pages) {
+        renderer->texture_width = width;
+        renderer->texture_height = height;
+    } else if (
+        width != renderer->texture_width
+        || height != renderer->texture_height) {
+        LOG_ERROR(
+            "Texture page size mismatch: expected %dx%d, got %dx%d",
+            renderer->texture_width, renderer->texture_height, width, height);
+        return GFX_NO_TEXTURE;
+    }
+
+    int texture_num = GFX_NO_TEXTURE;
+    for (int i = 0; i < renderer->max_texture_layers; i++) {
+        if (!renderer->used_layers[i]) {
             texture_num = i;
             break;
         }
     }
+    if (texture_num == GFX_NO_TEXTURE) {
+        LOG_ERROR(
+            "Out of texture array layers (%d)", renderer->max_texture_layers);
+        return GFX_NO_TEXTURE;
+    }
 
-    M_RestoreTexture(renderer);
-
+    const size_t size = width * height * 4;
+    renderer->used_layers[texture_num] = true;
+    renderer->pending_pages[texture_num] = Memory_Alloc(size);
+    memcpy(renderer->pending_pages[texture_num], data, size);
+    renderer->has_pending_pages = true;
     return texture_num;
 }
 
@@ -282,20 +743,36 @@ bool GFX_3D_Renderer_UnregisterTexturePage(
     ASSERT(texture_num >= 0);
     ASSERT(texture_num < GFX_MAX_TEXTURES);
 
-    GFX_GL_TEXTURE *const texture = renderer->textures[texture_num];
-    if (!texture) {
+    if (!renderer->used_layers[texture_num]) {
         LOG_ERROR("Invalid texture handle");
         return false;
     }
 
+    // queued primitives may still refer to this page
+    M_Flush(renderer);
+
     // unbind texture if currently bound
     if (texture_num == renderer->selected_texture_num) {
         M_SelectTextureImpl(renderer, GFX_NO_TEXTURE);
         renderer->selected_texture_num = GFX_NO_TEXTURE;
     }
 
-    GFX_GL_Texture_Free(texture);
-    renderer->textures[texture_num] = NULL;
+    renderer->used_layers[texture_num] = false;
+    Memory_FreePointer(&renderer->pending_pages[texture_num]);
+
+    // release the array once the last page is gone, so that the next level
+    // is free to use a different page size
+    for (int i = 0; i < GFX_MAX_TEXTURES; i++) {
+        if (renderer->used_layers[i]) {
+            return true;
+        }
+    }
+
+    GFX_GL_Texture_Free(renderer->texture_array);
+    renderer->texture_array = NULL;
+    renderer->texture_layers = 0;
+    renderer->has_pending_pages = false;
+    M_RestoreTexture(renderer);
     return true;
 }
 
@@ -305,8 +782,7 @@ void GFX_3D_Renderer_RenderPrimStrip(
 {
     ASSERT(renderer != NULL);
     ASSERT(vertices != NULL);
-    GFX_3D_VertexStream_PushPrimStrip(
-        &renderer->vertex_stream, vertices, count);
+    M_Draw(renderer, M_SHAPE_STRIP, vertices, count);
 }
 
 void GFX_3D_Renderer_RenderPrimFan(
@@ -315,7 +791,7 @@ void GFX_3D_Renderer_RenderPrimFan(
 {
     ASSERT(renderer != NULL);
     ASSERT(vertices != NULL);
-    GFX_3D_VertexStream_PushPrimFan(&renderer->vertex_stream, vertices, count);
+    M_Draw(renderer, M_SHAPE_FAN, vertices, count);
 }
 
 void GFX_3D_Renderer_RenderPrimList(
@@ -324,24 +800,29 @@ void GFX_3D_Renderer_RenderPrimList(
 {
     ASSERT(renderer != NULL);
     ASSERT(vertices != NULL);
-    GFX_3D_VertexStream_PushPrimList(&renderer->vertex_stream, vertices, count);
+    M_Draw(renderer, M_SHAPE_LIST, vertices, count);
 }
 
 void GFX_3D_Renderer_SelectTexture(
     GFX_3D_RENDERER *const renderer, int texture_num)
 {
     ASSERT(renderer != NULL);
-    M_Flush(renderer);
+    if (renderer->selected_texture_num == texture_num) {
+        return;
+    }
     renderer->selected_texture_num = texture_num;
-    M_SelectTextureImpl(renderer, texture_num);
+    renderer->frame_stats.texture_changes++;
 }
 
 void GFX_3D_Renderer_SetPrimType(
     GFX_3D_RENDERER *const renderer, GFX_3D_PRIM_TYPE value)
 {
     ASSERT(renderer != NULL);
-    M_Flush(renderer);
-    GFX_3D_VertexStream_SetPrimType(&renderer->vertex_stream, value);
+    if (renderer->state.prim_type == value) {
+        return;
+    }
+    renderer->state.prim_type = value;
+    renderer->frame_stats.requested_state_changes++;
 }
 
 void GFX_3D_Renderer_SetTextureFilter(
@@ -365,15 +846,22 @@ void GFX_3D_Renderer_SetDepthWritesEnabled(
     GFX_3D_RENDERER *const renderer, const bool is_enabled)
 {
     ASSERT(renderer != NULL);
+    if (renderer->is_depth_writes_enabled == is_enabled) {
+        return;
+    }
     M_Flush(renderer);
     glDepthMask(is_enabled ? GL_TRUE : GL_FALSE);
     GFX_GL_CheckError();
+    renderer->is_depth_writes_enabled = is_enabled;
 }
 
 void GFX_3D_Renderer_SetDepthTestEnabled(
     GFX_3D_RENDERER *const renderer, const bool is_enabled)
 {
     ASSERT(renderer != NULL);
+    if (renderer->is_depth_test_enabled == is_enabled) {
+        return;
+    }
     M_Flush(renderer);
     if (is_enabled) {
         glEnable(GL_DEPTH_TEST);
@@ -381,42 +869,31 @@ void GFX_3D_Renderer_SetDepthTestEnabled(
         glDisable(GL_DEPTH_TEST);
     }
     GFX_GL_CheckError();
+    renderer->is_depth_test_enabled = is_enabled;
 }
 
 void GFX_3D_Renderer_SetDepthBufferEnabled(
     GFX_3D_RENDERER *const renderer, const bool is_enabled)
 {
     ASSERT(renderer != NULL);
+    if (renderer->is_depth_buffer_enabled == is_enabled) {
+        return;
+    }
     M_Flush(renderer);
     glDepthFunc(is_enabled ? GL_LEQUAL : GL_ALWAYS);
     GFX_GL_CheckError();
+    renderer->is_depth_buffer_enabled = is_enabled;
 }
 
 void GFX_3D_Renderer_SetBlendingMode(
     GFX_3D_RENDERER *const renderer, const GFX_BLEND_MODE blend_mode)
 {
     ASSERT(renderer != NULL);
-    if (renderer->selected_blend_mode == blend_mode) {
+    if (renderer->state.blend_mode == blend_mode) {
         return;
     }
-    M_Flush(renderer);
-
-    GFX_GL_Program_Bind(&renderer->program);
-    switch (blend_mode) {
-    case GFX_BLEND_MODE_OFF:
-        glBlendFunc(GL_ONE, GL_ZERO);
-        GFX_GL_CheckError();
-        break;
-    case GFX_BLEND_MODE_NORMAL:
-        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-        GFX_GL_CheckError();
-        break;
-    case GFX_BLEND_MODE_MULTIPLY:
-        glBlendFunc(GL_DST_COLOR, GL_SRC_COLOR);
-        GFX_GL_CheckError();
-        break;
-    }
-    renderer->selected_blend_mode = blend_mode;
+    renderer->state.blend_mode = blend_mode;
+    renderer->frame_stats.requested_state_changes++;
 }
 
 void GFX_3D_Renderer_SetAlphaPointDiscard(
@@ -453,10 +930,11 @@ void GFX_3D_Renderer_SetTexturingEnabled(
     GFX_3D_RENDERER *const renderer, const bool is_enabled)
 {
     ASSERT(renderer != NULL);
-    M_Flush(renderer);
-    GFX_GL_Program_Bind(&renderer->program);
-    GFX_GL_Program_Uniform1i(
-        &renderer->program, renderer->loc_texturing_enabled, is_enabled);
+    if (renderer->state.texturing_enabled == is_enabled) {
+        return;
+    }
+    renderer->state.texturing_enabled = is_enabled;
+    renderer->frame_stats.requested_state_changes++;
 }
 
 void GFX_3D_Renderer_SetAnisotropyFilter(
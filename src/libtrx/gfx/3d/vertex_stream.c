@@ -1,63 +1,319 @@
 #include "gfx/3d/vertex_stream.h"
 
+#include "gfx/context.h"
 #include "gfx/gl/gl_core_3_3.h"
 #include "gfx/gl/utils.h"
 #include "log.h"
 #include "memory.h"
+#include "utils.h"
+
+#define DEFAULT_SEGMENT_CAPACITY 10000
+#define FENCE_TIMEOUT 1000000000 // 1 second in nanoseconds
 
 static const GLenum GL_PRIM_MODES[] = {
     GL_LINES, // GFX_3D_PRIM_LINE
     GL_TRIANGLES, // GFX_3D_PRIM_TRI
 };
 
-static void M_PushVertex(
-    GFX_3D_VERTEX_STREAM *vertex_stream, const GFX_3D_VERTEX *vertex);
+static void M_SetAttributes(GFX_3D_VERTEX_STREAM *vertex_stream, size_t first);
+static void M_DeleteFences(GFX_3D_VERTEX_STREAM *vertex_stream);
+static void M_WaitForSegment(GFX_3D_VERTEX_STREAM *vertex_stream, int segment);
+static void M_Resize(GFX_3D_VERTEX_STREAM *vertex_stream, size_t capacity);
+static bool M_Map(GFX_3D_VERTEX_STREAM *vertex_stream);
+static void M_Unmap(GFX_3D_VERTEX_STREAM *vertex_stream);
+static bool M_ReserveClient(GFX_3D_VERTEX_STREAM *vertex_stream, size_t count);
+static bool M_Reserve(
+    GFX_3D_VERTEX_STREAM *vertex_stream, size_t vertex_count,
+    size_t index_count);
+static uint16_t M_PushVertices(
+    GFX_3D_VERTEX_STREAM *vertex_stream, const GFX_3D_VERTEX *vertices,
+    int count);
+static bool M_PushList(
+    GFX_3D_VERTEX_STREAM *vertex_stream, const GFX_3D_VERTEX *vertices,
+    int count);
+static void M_PushTriangle(
+    GFX_3D_VERTEX_STREAM *vertex_stream, uint16_t a, uint16_t b, uint16_t c);
 
-static void M_PushVertex(
-    GFX_3D_VERTEX_STREAM *const vertex_stream,
-    const GFX_3D_VERTEX *const vertex)
+static void M_SetAttributes(
+    GFX_3D_VERTEX_STREAM *const vertex_stream, const size_t first)
+{
+    const GLsizei stride = sizeof(GFX_3D_STREAM_VERTEX);
+    const GLsizei base = first * stride;
+    GFX_GL_Buffer_Bind(&vertex_stream->buffer);
+    GFX_GL_VertexArray_Attribute(
+        &vertex_stream->vtc_format, 0, 3, GL_FLOAT, GL_FALSE, stride, base);
+    GFX_GL_VertexArray_Attribute(
+        &vertex_stream->vtc_format, 1, 3, GL_FLOAT, GL_FALSE, stride,
+        base + 12);
+    GFX_GL_VertexArray_Attribute(
+        &vertex_stream->vtc_format, 2, 4, GL_FLOAT, GL_FALSE, stride,
+        base + 24);
+    GFX_GL_VertexArray_Attribute(
+        &vertex_stream->vtc_format, 3, 1, GL_FLOAT, GL_FALSE, stride,
+        base + 40);
+}
+
+static void M_DeleteFences(GFX_3D_VERTEX_STREAM *const vertex_stream)
 {
-    if (vertex_stream->pending_vertices.count + 1
-        >= vertex_stream->pending_vertices.capacity) {
-        vertex_stream->pending_vertices.capacity += 1000;
+    for (int i = 0; i < GFX_3D_STREAM_SEGMENTS; i++) {
+        if (vertex_stream->fences[i] != NULL) {
+            glDeleteSync(vertex_stream->fences[i]);
+            GFX_GL_CheckError();
+            vertex_stream->fences[i] = NULL;
+        }
+    }
+}
+
+static void M_WaitForSegment(
+    GFX_3D_VERTEX_STREAM *const vertex_stream, const int segment)
+{
+    GLsync fence = vertex_stream->fences[segment];
+    if (fence == NULL) {
+        return;
+    }
+
+    GLenum result;
+    do {
+        result = glClientWaitSync(
+            fence, GL_SYNC_FLUSH_COMMANDS_BIT, FENCE_TIMEOUT);
+        GFX_GL_CheckError();
+    } while (result == GL_TIMEOUT_EXPIRED);
+
+    glDeleteSync(fence);
+    GFX_GL_CheckError();
+    vertex_stream->fences[segment] = NULL;
+}
+
+static void M_Resize(
+    GFX_3D_VERTEX_STREAM *const vertex_stream, const size_t capacity)
+{
+    LOG_INFO(
+        "Vertex buffer resize: %d -> %d", vertex_stream->segment_capacity,
+        capacity);
+
+    // orphaning the storage hands the old regions over to the driver, so the
+    // fences guarding them are no longer needed
+    M_Unmap(vertex_stream);
+    M_DeleteFences(vertex_stream);
+
+    GFX_GL_Buffer_Bind(&vertex_stream->buffer);
+    GFX_GL_Buffer_Data(
+        &vertex_stream->buffer,
+        capacity * GFX_3D_STREAM_SEGMENTS * sizeof(GFX_3D_STREAM_VERTEX), NULL,
+        GL_STREAM_DRAW);
+
+    vertex_stream->segment_capacity = capacity;
+    vertex_stream->segment = 0;
+    vertex_stream->segment_offset = 0;
+}
+
+static bool M_Map(GFX_3D_VERTEX_STREAM *const vertex_stream)
+{
+    const size_t available =
+        vertex_stream->segment_capacity - vertex_stream->segment_offset;
+    const size_t offset =
+        vertex_stream->segment * vertex_stream->segment_capacity
+        + vertex_stream->segment_offset;
+
+    // the fence wait at the start of the frame guarantees that the GPU is
+    // done with this region, so there is no need for the driver to sync
+    const GLbitfield access = GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT
+        | GL_MAP_FLUSH_EXPLICIT_BIT | GL_MAP_UNSYNCHRONIZED_BIT;
+
+    GFX_GL_Buffer_Bind(&vertex_stream->buffer);
+    vertex_stream->pending_vertices.data = GFX_GL_Buffer_MapRange(
+        &vertex_stream->buffer, offset * sizeof(GFX_3D_STREAM_VERTEX),
+        available * sizeof(GFX_3D_STREAM_VERTEX), access);
+    if (vertex_stream->pending_vertices.data == NULL) {
+        LOG_ERROR("Failed to map the vertex buffer");
+        vertex_stream->pending_vertices.capacity = 0;
+        return false;
+    }
+
+    vertex_stream->pending_vertices.capacity = available;
+    return true;
+}
+
+static void M_Unmap(GFX_3D_VERTEX_STREAM *const vertex_stream)
+{
+    if (!vertex_stream->use_ring
+        || vertex_stream->pending_vertices.data == NULL) {
+        return;
+    }
+
+    GFX_GL_Buffer_Bind(&vertex_stream->buffer);
+    if (vertex_stream->pending_vertices.count > 0) {
+        GFX_GL_Buffer_FlushMappedRange(
+            &vertex_stream->buffer, 0,
+            vertex_stream->pending_vertices.count
+                * sizeof(GFX_3D_STREAM_VERTEX));
+    }
+    GFX_GL_Buffer_Unmap(&vertex_stream->buffer);
+
+    vertex_stream->pending_vertices.data = NULL;
+    vertex_stream->pending_vertices.capacity = 0;
+}
+
+static bool M_ReserveClient(
+    GFX_3D_VERTEX_STREAM *const vertex_stream, const size_t count)
+{
+    const size_t required = vertex_stream->pending_vertices.count + count;
+    if (required > vertex_stream->pending_vertices.capacity) {
+        vertex_stream->pending_vertices.capacity = MAX(
+            MAX(vertex_stream->pending_vertices.capacity * 2, required),
+            (size_t)DEFAULT_SEGMENT_CAPACITY);
         vertex_stream->pending_vertices.data = Memory_Realloc(
             vertex_stream->pending_vertices.data,
-            vertex_stream->pending_vertices.capacity * sizeof(GFX_3D_VERTEX));
+            vertex_stream->pending_vertices.capacity
+                * sizeof(GFX_3D_STREAM_VERTEX));
+    }
+    return true;
+}
+
+static bool M_Reserve(
+    GFX_3D_VERTEX_STREAM *const vertex_stream, const size_t count,
+    const size_t index_count)
+{
+    if (count == 0) {
+        return true;
+    }
+
+    if (vertex_stream->pending_vertices.count + count
+        > GFX_3D_STREAM_MAX_BATCH_VERTICES) {
+        GFX_3D_VertexStream_RenderPending(vertex_stream);
+    }
+
+    const size_t required_indices =
+        vertex_stream->pending_indices.count + index_count;
+    if (required_indices > vertex_stream->pending_indices.capacity) {
+        vertex_stream->pending_indices.capacity =
+            MAX(vertex_stream->pending_indices.capacity * 2, required_indices);
+        vertex_stream->pending_indices.data = Memory_Realloc(
+            vertex_stream->pending_indices.data,
+            vertex_stream->pending_indices.capacity * sizeof(uint16_t));
+    }
+
+    if (!vertex_stream->use_ring) {
+        return M_ReserveClient(vertex_stream, count);
+    }
+
+    if (vertex_stream->pending_vertices.data != NULL
+        && vertex_stream->pending_vertices.count + count
+            <= vertex_stream->pending_vertices.capacity) {
+        return true;
+    }
+
+    if (vertex_stream->segment_offset + vertex_stream->pending_vertices.count
+            + count
+        > vertex_stream->segment_capacity) {
+        // draw what we have and grow the buffer if this frame outgrew it
+        GFX_3D_VertexStream_RenderPending(vertex_stream);
+        if (vertex_stream->segment_offset + count
+            > vertex_stream->segment_capacity) {
+            M_Resize(
+                vertex_stream,
+                MAX(MAX(vertex_stream->segment_capacity * 2, count),
+                    (size_t)DEFAULT_SEGMENT_CAPACITY));
+        }
+    }
+
+    if (vertex_stream->pending_vertices.data == NULL) {
+        return M_Map(vertex_stream);
+    }
+    return true;
+}
+
+static uint16_t M_PushVertices(
+    GFX_3D_VERTEX_STREAM *const vertex_stream,
+    const GFX_3D_VERTEX *const vertices, const int count)
+{
+    const uint16_t base = vertex_stream->pending_vertices.count;
+    GFX_3D_STREAM_VERTEX *const target =
+        &vertex_stream->pending_vertices.data[base];
+    for (int i = 0; i < count; i++) {
+        target[i].vertex = vertices[i];
+        target[i].layer = vertex_stream->layer;
     }
+    vertex_stream->pending_vertices.count += count;
+    return base;
+}
 
-    vertex_stream->pending_vertices
-        .data[vertex_stream->pending_vertices.count++] = *vertex;
+static bool M_PushList(
+    GFX_3D_VERTEX_STREAM *const vertex_stream,
+    const GFX_3D_VERTEX *const vertices, const int count)
+{
+    if (count <= 0) {
+        return true;
+    }
+    if (!M_Reserve(vertex_stream, count, count)) {
+        return false;
+    }
+    const uint16_t base = M_PushVertices(vertex_stream, vertices, count);
+    for (int i = 0; i < count; i++) {
+        vertex_stream->pending_indices
+            .data[vertex_stream->pending_indices.count++] = base + i;
+    }
+    return true;
+}
+
+static void M_PushTriangle(
+    GFX_3D_VERTEX_STREAM *const vertex_stream, const uint16_t a,
+    const uint16_t b, const uint16_t c)
+{
+    uint16_t *const target =
+        &vertex_stream->pending_indices
+             .data[vertex_stream->pending_indices.count];
+    target[0] = a;
+    target[1] = b;
+    target[2] = c;
+    vertex_stream->pending_indices.count += 3;
 }
 
 void GFX_3D_VertexStream_Init(GFX_3D_VERTEX_STREAM *const vertex_stream)
 {
+    const GFX_CONFIG *const config = GFX_Context_GetConfig();
     vertex_stream->prim_type = GFX_3D_PRIM_TRI;
-    vertex_stream->buffer_size = 0;
+    vertex_stream->layer = 0.0f;
+    vertex_stream->use_ring =
+        config->has_sync && config->has_map_buffer_range;
+    vertex_stream->use_base_vertex = config->has_base_vertex;
+    vertex_stream->index_buffer_capacity = 0;
+    vertex_stream->segment_capacity = 0;
+    vertex_stream->segment = 0;
+    vertex_stream->segment_offset = 0;
+    for (int i = 0; i < GFX_3D_STREAM_SEGMENTS; i++) {
+        vertex_stream->fences[i] = NULL;
+    }
     vertex_stream->pending_vertices.data = NULL;
     vertex_stream->pending_vertices.count = 0;
     vertex_stream->pending_vertices.capacity = 0;
+    vertex_stream->pending_indices.data = NULL;
+    vertex_stream->pending_indices.count = 0;
+    vertex_stream->pending_indices.capacity = 0;
     vertex_stream->rendered_count = 0;
 
     GFX_GL_Buffer_Init(&vertex_stream->buffer, GL_ARRAY_BUFFER);
-    GFX_GL_Buffer_Bind(&vertex_stream->buffer);
+    GFX_GL_Buffer_Init(&vertex_stream->index_buffer, GL_ELEMENT_ARRAY_BUFFER);
 
     GFX_GL_VertexArray_Init(&vertex_stream->vtc_format);
     GFX_GL_VertexArray_Bind(&vertex_stream->vtc_format);
-    GFX_GL_VertexArray_Attribute(
-        &vertex_stream->vtc_format, 0, 3, GL_FLOAT, GL_FALSE, 40, 0);
-    GFX_GL_VertexArray_Attribute(
-        &vertex_stream->vtc_format, 1, 3, GL_FLOAT, GL_FALSE, 40, 12);
-    GFX_GL_VertexArray_Attribute(
-        &vertex_stream->vtc_format, 2, 4, GL_FLOAT, GL_FALSE, 40, 24);
+    M_SetAttributes(vertex_stream, 0);
+    GFX_GL_Buffer_Bind(&vertex_stream->index_buffer);
 
     GFX_GL_CheckError();
 }
 
 void GFX_3D_VertexStream_Close(GFX_3D_VERTEX_STREAM *const vertex_stream)
 {
+    M_Unmap(vertex_stream);
+    M_DeleteFences(vertex_stream);
+    if (!vertex_stream->use_ring) {
+        Memory_FreePointer(&vertex_stream->pending_vertices.data);
+    }
+    Memory_FreePointer(&vertex_stream->pending_indices.data);
     GFX_GL_VertexArray_Close(&vertex_stream->vtc_format);
+    GFX_GL_Buffer_Close(&vertex_stream->index_buffer);
     GFX_GL_Buffer_Close(&vertex_stream->buffer);
-    Memory_FreePointer(&vertex_stream->pending_vertices.data);
 }
 
 void GFX_3D_VertexStream_Bind(GFX_3D_VERTEX_STREAM *const vertex_stream)
@@ -65,32 +321,83 @@ void GFX_3D_VertexStream_Bind(GFX_3D_VERTEX_STREAM *const vertex_stream)
     GFX_GL_Buffer_Bind(&vertex_stream->buffer);
 }
 
+void GFX_3D_VertexStream_Reserve(
+    GFX_3D_VERTEX_STREAM *const vertex_stream, const size_t count)
+{
+    if (!vertex_stream->use_ring) {
+        M_ReserveClient(vertex_stream, count);
+        return;
+    }
+    if (count <= vertex_stream->segment_capacity) {
+        return;
+    }
+    GFX_3D_VertexStream_RenderPending(vertex_stream);
+    M_Resize(vertex_stream, count);
+}
+
+void GFX_3D_VertexStream_BeginFrame(GFX_3D_VERTEX_STREAM *const vertex_stream)
+{
+    GFX_3D_VertexStream_RenderPending(vertex_stream);
+    if (!vertex_stream->use_ring) {
+        return;
+    }
+    M_Unmap(vertex_stream);
+
+    vertex_stream->segment =
+        (vertex_stream->segment + 1) % GFX_3D_STREAM_SEGMENTS;
+    vertex_stream->segment_offset = 0;
+    M_WaitForSegment(vertex_stream, vertex_stream->segment);
+}
+
+void GFX_3D_VertexStream_EndFrame(GFX_3D_VERTEX_STREAM *const vertex_stream)
+{
+    GFX_3D_VertexStream_RenderPending(vertex_stream);
+    if (!vertex_stream->use_ring) {
+        return;
+    }
+    M_Unmap(vertex_stream);
+
+    if (vertex_stream->fences[vertex_stream->segment] != NULL) {
+        glDeleteSync(vertex_stream->fences[vertex_stream->segment]);
+    }
+    vertex_stream->fences[vertex_stream->segment] =
+        glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    GFX_GL_CheckError();
+}
+
 void GFX_3D_VertexStream_SetPrimType(
     GFX_3D_VERTEX_STREAM *const vertex_stream, const GFX_3D_PRIM_TYPE prim_type)
 {
     vertex_stream->prim_type = prim_type;
 }
 
+void GFX_3D_VertexStream_SetTextureLayer(
+    GFX_3D_VERTEX_STREAM *const vertex_stream, const float layer)
+{
+    vertex_stream->layer = layer;
+}
+
 bool GFX_3D_VertexStream_PushPrimStrip(
     GFX_3D_VERTEX_STREAM *const vertex_stream,
     const GFX_3D_VERTEX *const vertices, const int count)
 {
+    // lines and other degenerate shapes go through as they are
+    if (count < 3) {
+        return M_PushList(vertex_stream, vertices, count);
+    }
+
     if (vertex_stream->prim_type != GFX_3D_PRIM_TRI) {
         LOG_ERROR("Unsupported prim type: %d", vertex_stream->prim_type);
         return false;
     }
+    if (!M_Reserve(vertex_stream, count, (count - 2) * 3)) {
+        return false;
+    }
 
-    if (count <= 2) {
-        for (int i = 0; i < count; i++) {
-            M_PushVertex(vertex_stream, &vertices[i]);
-        }
-    } else {
-        // convert strip to raw triangles
-        for (int i = 2; i < count; i++) {
-            M_PushVertex(vertex_stream, &vertices[i - 2]);
-            M_PushVertex(vertex_stream, &vertices[i - 1]);
-            M_PushVertex(vertex_stream, &vertices[i]);
-        }
+    // push each vertex once and convert the strip to indexed triangles
+    const uint16_t base = M_PushVertices(vertex_stream, vertices, count);
+    for (int i = 2; i < count; i++) {
+        M_PushTriangle(vertex_stream, base + i - 2, base + i - 1, base + i);
     }
 
     return true;
@@ -100,22 +407,23 @@ bool GFX_3D_VertexStream_PushPrimFan(
     GFX_3D_VERTEX_STREAM *const vertex_stream,
     const GFX_3D_VERTEX *const vertices, const int count)
 {
+    // lines and other degenerate shapes go through as they are
+    if (count < 3) {
+        return M_PushList(vertex_stream, vertices, count);
+    }
+
     if (vertex_stream->prim_type != GFX_3D_PRIM_TRI) {
         LOG_ERROR("Unsupported prim type: %d", vertex_stream->prim_type);
         return false;
     }
+    if (!M_Reserve(vertex_stream, count, (count - 2) * 3)) {
+        return false;
+    }
 
-    if (count <= 2) {
-        for (int i = 0; i < count; i++) {
-            M_PushVertex(vertex_stream, &vertices[i]);
-        }
-    } else {
-        // convert fan to raw triangles
-        for (int i = 2; i < count; i++) {
-            M_PushVertex(vertex_stream, &vertices[0]);
-            M_PushVertex(vertex_stream, &vertices[i - 1]);
-            M_PushVertex(vertex_stream, &vertices[i]);
-        }
+    // push each vertex once and convert the fan to indexed triangles
+    const uint16_t base = M_PushVertices(vertex_stream, vertices, count);
+    for (int i = 2; i < count; i++) {
+        M_PushTriangle(vertex_stream, base, base + i - 1, base + i);
     }
 
     return true;
@@ -125,10 +433,7 @@ bool GFX_3D_VertexStream_PushPrimList(
     GFX_3D_VERTEX_STREAM *const vertex_stream,
     const GFX_3D_VERTEX *const vertices, const int count)
 {
-    for (int i = 0; i < count; i++) {
-        M_PushVertex(vertex_stream, &vertices[i]);
-    }
-    return true;
+    return M_PushList(vertex_stream, vertices, count);
 }
 
 void GFX_3D_VertexStream_RenderPending(
@@ -138,30 +443,60 @@ void GFX_3D_VertexStream_RenderPending(
         return;
     }
 
-    GFX_GL_Buffer_Bind(&vertex_stream->buffer);
-    GFX_GL_VertexArray_Bind(&vertex_stream->vtc_format);
-
-    // resize GPU buffer if required
-    size_t buffer_size =
-        sizeof(GFX_3D_VERTEX) * vertex_stream->pending_vertices.count;
-    if (buffer_size > vertex_stream->buffer_size) {
-        LOG_INFO(
-            "Vertex buffer resize: %d -> %d", vertex_stream->buffer_size,
-            buffer_size);
+    size_t first = 0;
+    if (vertex_stream->use_ring) {
+        M_Unmap(vertex_stream);
+        first = vertex_stream->segment * vertex_stream->segment_capacity
+            + vertex_stream->segment_offset;
+    } else {
+        // orphan the previous storage so the driver can keep it alive for
+        // draws still in flight without stalling the upload
+        GFX_GL_Buffer_Bind(&vertex_stream->buffer);
         GFX_GL_Buffer_Data(
-            &vertex_stream->buffer, buffer_size, NULL, GL_STREAM_DRAW);
-        vertex_stream->buffer_size = buffer_size;
+            &vertex_stream->buffer,
+            vertex_stream->pending_vertices.count
+                * sizeof(GFX_3D_STREAM_VERTEX),
+            vertex_stream->pending_vertices.data, GL_STREAM_DRAW);
     }
 
+    GFX_GL_VertexArray_Bind(&vertex_stream->vtc_format);
+    GFX_GL_Buffer_Bind(&vertex_stream->index_buffer);
+    if (vertex_stream->pending_indices.count
+        > vertex_stream->index_buffer_capacity) {
+        vertex_stream->index_buffer_capacity = MAX(
+            vertex_stream->index_buffer_capacity * 2,
+            vertex_stream->pending_indices.count);
+    }
+    // the previous batch may still be reading the indices, so orphan the
+    // storage rather than overwrite it in place
+    GFX_GL_Buffer_Data(
+        &vertex_stream->index_buffer,
+        vertex_stream->index_buffer_capacity * sizeof(uint16_t), NULL,
+        GL_STREAM_DRAW);
     GFX_GL_Buffer_SubData(
-        &vertex_stream->buffer, 0, buffer_size,
-        vertex_stream->pending_vertices.data);
+        &vertex_stream->index_buffer, 0,
+        vertex_stream->pending_indices.count * sizeof(uint16_t),
+        vertex_stream->pending_indices.data);
 
-    glDrawArrays(
-        GL_PRIM_MODES[vertex_stream->prim_type], 0,
-        vertex_stream->pending_vertices.count);
+    if (vertex_stream->use_base_vertex) {
+        glDrawElementsBaseVertex(
+            GL_PRIM_MODES[vertex_stream->prim_type],
+            vertex_stream->pending_indices.count, GL_UNSIGNED_SHORT, NULL,
+            first);
+    } else {
+        // no base vertex support - point the attributes at the batch instead
+        M_SetAttributes(vertex_stream, first);
+        glDrawElements(
+            GL_PRIM_MODES[vertex_stream->prim_type],
+            vertex_stream->pending_indices.count, GL_UNSIGNED_SHORT, NULL);
+    }
     GFX_GL_CheckError();
 
+    if (vertex_stream->use_ring) {
+        vertex_stream->segment_offset +=
+            vertex_stream->pending_vertices.count;
+    }
     vertex_stream->rendered_count += vertex_stream->pending_vertices.count;
     vertex_stream->pending_vertices.count = 0;
+    vertex_stream->pending_indices.count = 0;
 }
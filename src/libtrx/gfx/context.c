@@ -37,6 +37,7 @@ static GFX_CONTEXT m_Context = {};
 
 static bool M_IsExtensionSupported(const char *name);
 static void M_CheckExtensionSupport(const char *name);
+static bool M_DetectFeature(const char *name);
 
 static bool M_IsExtensionSupported(const char *name)
 {
@@ -62,6 +63,16 @@ static void M_CheckExtensionSupport(const char *name)
         "%s supported: %s", name, M_IsExtensionSupported(name) ? "yes" : "no");
 }
 
+static bool M_DetectFeature(const char *const name)
+{
+    if (m_Context.config.backend == GFX_GL_33C) {
+        return true;
+    }
+    const bool result = M_IsExtensionSupported(name);
+    LOG_INFO("%s supported: %s", name, result ? "yes" : "no");
+    return result;
+}
+
 void GFX_Context_SwitchToWindowViewport(void)
 {
     glViewport(0, 0, m_Context.window_width, m_Context.window_height);
@@ -147,8 +158,17 @@ bool GFX_Context_Attach(void *window_handle, GFX_GL_BACKEND backend)
     if (m_Context.config.backend == GFX_GL_21) {
         M_CheckExtensionSupport("GL_ARB_explicit_attrib_location");
         M_CheckExtensionSupport("GL_EXT_gpu_shader4");
+        M_CheckExtensionSupport("GL_EXT_texture_array");
     }
 
+    // The loader never hands out NULL function pointers, so the optional
+    // paths are picked from what the context reports instead.
+    m_Context.config.has_sync = M_DetectFeature("GL_ARB_sync");
+    m_Context.config.has_map_buffer_range =
+        M_DetectFeature("GL_ARB_map_buffer_range");
+    m_Context.config.has_base_vertex =
+        M_DetectFeature("GL_ARB_draw_elements_base_vertex");
+
     glClearColor(0, 0, 0, 0);
     glClearDepth(1);
     GFX_GL_CheckError();
@@ -164,6 +184,7 @@ void GFX_Context_Detach(void)
         return;
     }
 
+    GFX_Screenshot_Shutdown();
     if (m_Context.renderer != NULL && m_Context.renderer->shutdown != NULL) {
         m_Context.renderer->shutdown(m_Context.renderer);
     }
@@ -57,6 +57,26 @@ void *GFX_GL_Buffer_Map(GFX_GL_BUFFER *buf, GLenum access)
     return ret;
 }
 
+void *GFX_GL_Buffer_MapRange(
+    GFX_GL_BUFFER *const buf, const GLintptr offset, const GLsizeiptr length,
+    const GLbitfield access)
+{
+    ASSERT(buf != NULL);
+    ASSERT(buf->initialized);
+    void *const ret = glMapBufferRange(buf->target, offset, length, access);
+    GFX_GL_CheckError();
+    return ret;
+}
+
+void GFX_GL_Buffer_FlushMappedRange(
+    GFX_GL_BUFFER *const buf, const GLintptr offset, const GLsizeiptr length)
+{
+    ASSERT(buf != NULL);
+    ASSERT(buf->initialized);
+    glFlushMappedBufferRange(buf->target, offset, length);
+    GFX_GL_CheckError();
+}
+
 void GFX_GL_Buffer_Unmap(GFX_GL_BUFFER *buf)
 {
     ASSERT(buf != NULL);
@@ -47,7 +47,8 @@ char *GFX_GL_Program_PreprocessShader(
     const char *version_ogl21 =
         "#version 120\n"
         "#extension GL_ARB_explicit_attrib_location: enable\n"
-        "#extension GL_EXT_gpu_shader4: enable\n";
+        "#extension GL_EXT_gpu_shader4: enable\n"
+        "#extension GL_EXT_texture_array: enable\n";
     const char *version_ogl33c = "#version 330 core\n";
     const char *define_vertex = "#define VERTEX\n";
     const char *define_ogl33c = "#define OGL33C\n";
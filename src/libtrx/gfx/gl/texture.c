@@ -5,6 +5,47 @@
 #include "memory.h"
 #include "utils.h"
 
+#include <stdint.h>
+
+static int M_GetMipLevels(int width, int height);
+static void M_Downsample(
+    const uint8_t *src, int src_width, int src_height, uint8_t *dst,
+    int dst_width, int dst_height);
+
+static int M_GetMipLevels(int width, int height)
+{
+    int levels = 1;
+    while (width > 1 || height > 1) {
+        width = MAX(1, width / 2);
+        height = MAX(1, height / 2);
+        levels++;
+    }
+    return levels;
+}
+
+// Box filters an RGBA image down to the next mip level.
+static void M_Downsample(
+    const uint8_t *const src, const int src_width, const int src_height,
+    uint8_t *const dst, const int dst_width, const int dst_height)
+{
+    for (int y = 0; y < dst_height; y++) {
+        const int y0 = MIN(y * 2, src_height - 1);
+        const int y1 = MIN(y * 2 + 1, src_height - 1);
+        for (int x = 0; x < dst_width; x++) {
+            const int x0 = MIN(x * 2, src_width - 1);
+            const int x1 = MIN(x * 2 + 1, src_width - 1);
+            const uint8_t *const p00 = &src[(y0 * src_width + x0) * 4];
+            const uint8_t *const p01 = &src[(y0 * src_width + x1) * 4];
+            const uint8_t *const p10 = &src[(y1 * src_width + x0) * 4];
+            const uint8_t *const p11 = &src[(y1 * src_width + x1) * 4];
+            uint8_t *const out = &dst[(y * dst_width + x) * 4];
+            for (int c = 0; c < 4; c++) {
+                out[c] = (p00[c] + p01[c] + p10[c] + p11[c] + 2) / 4;
+            }
+        }
+    }
+}
+
 GFX_GL_TEXTURE *GFX_GL_Texture_Create(GLenum target)
 {
     GFX_GL_TEXTURE *texture = Memory_Alloc(sizeof(GFX_GL_TEXTURE));
@@ -67,6 +108,76 @@ void GFX_GL_Texture_Load(
     GFX_GL_CheckError();
 }
 
+void GFX_GL_Texture_LoadArray(
+    GFX_GL_TEXTURE *const texture, const int width, const int height,
+    const int layers, const GLint internal_format, const GLint format)
+{
+    ASSERT(texture != NULL);
+    ASSERT(texture->initialized);
+    ASSERT(texture->target == GL_TEXTURE_2D_ARRAY);
+
+    GFX_GL_Texture_Bind(texture);
+
+    // Mipmaps are built per layer on upload, as glGenerateMipmap would
+    // rebuild every layer of the array.
+    const int levels = M_GetMipLevels(width, height);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, levels - 1);
+    for (int level = 0; level < levels; level++) {
+        glTexImage3D(
+            GL_TEXTURE_2D_ARRAY, level, internal_format,
+            MAX(1, width >> level), MAX(1, height >> level), layers, 0, format,
+            GL_UNSIGNED_BYTE, NULL);
+    }
+    GFX_GL_CheckError();
+}
+
+void GFX_GL_Texture_LoadLayer(
+    GFX_GL_TEXTURE *const texture, const int layer, const void *const data,
+    const int width, const int height, const GLint format)
+{
+    ASSERT(texture != NULL);
+    ASSERT(texture->initialized);
+    ASSERT(texture->target == GL_TEXTURE_2D_ARRAY);
+    ASSERT(format == GL_RGBA);
+
+    GFX_GL_Texture_Bind(texture);
+
+    glTexSubImage3D(
+        GL_TEXTURE_2D_ARRAY, 0, 0, 0, layer, width, height, 1, format,
+        GL_UNSIGNED_BYTE, data);
+    GFX_GL_CheckError();
+
+    const int levels = M_GetMipLevels(width, height);
+    if (levels == 1) {
+        return;
+    }
+
+    // Each level is at most a quarter of the previous one, so two buffers
+    // sized for the first level are enough.
+    const size_t size = MAX(1, width / 2) * MAX(1, height / 2) * 4;
+    uint8_t *buffers[2] = { Memory_Alloc(size), Memory_Alloc(size) };
+    const uint8_t *src = data;
+    int src_width = width;
+    int src_height = height;
+    for (int level = 1; level < levels; level++) {
+        const int dst_width = MAX(1, src_width / 2);
+        const int dst_height = MAX(1, src_height / 2);
+        uint8_t *const dst = buffers[level % 2];
+        M_Downsample(src, src_width, src_height, dst, dst_width, dst_height);
+        glTexSubImage3D(
+            GL_TEXTURE_2D_ARRAY, level, 0, 0, layer, dst_width, dst_height, 1,
+            format, GL_UNSIGNED_BYTE, dst);
+        src = dst;
+        src_width = dst_width;
+        src_height = dst_height;
+    }
+    GFX_GL_CheckError();
+    Memory_Free(buffers[0]);
+    Memory_Free(buffers[1]);
+}
+
 void GFX_GL_Texture_LoadFromBackBuffer(GFX_GL_TEXTURE *const texture)
 {
     ASSERT(texture != NULL);
@@ -43,10 +43,12 @@ static void M_Unbind(const GFX_RENDERER *renderer);
 
 static void M_SwapBuffers(GFX_RENDERER *renderer)
 {
+    GFX_Screenshot_Update();
     if (GFX_Context_GetScheduledScreenshotPath()) {
         GFX_Screenshot_CaptureToFile(GFX_Context_GetScheduledScreenshotPath());
         GFX_Context_ClearScheduledScreenshotPath();
     }
+    GFX_Screenshot_CaptureToRecorder();
 
     GFX_Context_SwitchToWindowViewportAR();
     M_Render(renderer);
@@ -14,10 +14,12 @@ static void M_SwapBuffers(GFX_RENDERER *renderer)
     ASSERT(renderer != NULL);
 
     GFX_Context_SwitchToWindowViewportAR();
+    GFX_Screenshot_Update();
     if (GFX_Context_GetScheduledScreenshotPath()) {
         GFX_Screenshot_CaptureToFile(GFX_Context_GetScheduledScreenshotPath());
         GFX_Context_ClearScheduledScreenshotPath();
     }
+    GFX_Screenshot_CaptureToRecorder();
 
     SDL_GL_SwapWindow(GFX_Context_GetWindowHandle());
 
@@ -2,33 +2,339 @@
 
 #include "debug.h"
 #include "engine/image.h"
+#include "engine/recorder.h"
+#include "gfx/context.h"
+#include "gfx/gl/buffer.h"
 #include "gfx/gl/utils.h"
+#include "log.h"
 #include "memory.h"
 
+#include <SDL2/SDL.h>
 #include <string.h>
 
-bool GFX_Screenshot_CaptureToFile(const char *path)
-{
-    bool ret = false;
+// Readbacks are mapped at the latest this many frames after being issued,
+// even if the GPU has not signalled them yet.
+#define MAX_READBACK_AGE 2
+#define MAX_PENDING_READBACKS 4
 
+typedef struct {
+    bool active;
+    GFX_GL_BUFFER pbo;
+    size_t pbo_size;
+    GLsync fence;
+    int32_t age;
     GLint width;
     GLint height;
-    GFX_Screenshot_CaptureToBuffer(
-        NULL, &width, &height, 3, GL_RGB, GL_UNSIGNED_BYTE, true);
+    // NULL for frames that go to the video recorder
+    char *path;
+    int32_t timestamp;
+} M_READBACK;
+
+typedef struct M_JOB {
+    struct M_JOB *next;
+    IMAGE *image;
+    char *path;
+} M_JOB;
+
+static M_READBACK m_Readbacks[MAX_PENDING_READBACKS] = {};
+
+static struct {
+    SDL_Thread *thread;
+    SDL_mutex *mutex;
+    SDL_cond *cond;
+    M_JOB *head;
+    M_JOB *tail;
+    bool quit;
+} m_Encoder = {};
+
+static void M_FlipImage(IMAGE *image);
+static int M_EncoderThread(void *arg);
+static void M_QueueEncode(IMAGE *image, char *path);
+static void M_Deliver(IMAGE *image, char *path, int32_t timestamp);
+static void M_ReadNow(char *path, int32_t timestamp);
+static void M_FinishReadback(M_READBACK *readback);
+static M_READBACK *M_StartReadback(void);
+
+static void M_FlipImage(IMAGE *const image)
+{
+    const size_t pitch = image->width * sizeof(IMAGE_PIXEL);
+    uint8_t *const data = (uint8_t *)image->data;
+    uint8_t *scanline = Memory_Alloc(pitch);
+    for (int y1 = 0, middle = image->height / 2; y1 < middle; y1++) {
+        const int y2 = image->height - 1 - y1;
+        memcpy(scanline, &data[y1 * pitch], pitch);
+        memcpy(&data[y1 * pitch], &data[y2 * pitch], pitch);
+        memcpy(&data[y2 * pitch], scanline, pitch);
+    }
+    Memory_FreePointer(&scanline);
+}
+
+static int M_EncoderThread(void *const arg)
+{
+    SDL_LockMutex(m_Encoder.mutex);
+    while (true) {
+        while (m_Encoder.head == NULL && !m_Encoder.quit) {
+            SDL_CondWait(m_Encoder.cond, m_Encoder.mutex);
+        }
+        M_JOB *job = m_Encoder.head;
+        if (job == NULL) {
+            break;
+        }
+        m_Encoder.head = job->next;
+        if (m_Encoder.head == NULL) {
+            m_Encoder.tail = NULL;
+        }
+        SDL_UnlockMutex(m_Encoder.mutex);
+
+        M_FlipImage(job->image);
+        if (!Image_SaveToFile(job->image, job->path)) {
+            LOG_ERROR("Failed to save screenshot: %s", job->path);
+        }
+        Image_Free(job->image);
+        Memory_FreePointer(&job->path);
+        Memory_FreePointer(&job);
+
+        SDL_LockMutex(m_Encoder.mutex);
+    }
+    SDL_UnlockMutex(m_Encoder.mutex);
+    return 0;
+}
+
+static void M_QueueEncode(IMAGE *const image, char *const path)
+{
+    if (m_Encoder.thread == NULL) {
+        m_Encoder.mutex = SDL_CreateMutex();
+        m_Encoder.cond = SDL_CreateCond();
+        m_Encoder.quit = false;
+        m_Encoder.thread =
+            SDL_CreateThread(M_EncoderThread, "screenshot_encoder", NULL);
+        if (m_Encoder.thread == NULL) {
+            LOG_ERROR("SDL_CreateThread(): %s", SDL_GetError());
+        }
+    }
+
+    if (m_Encoder.thread == NULL) {
+        // fall back to encoding on the calling thread
+        M_FlipImage(image);
+        Image_SaveToFile(image, path);
+        Image_Free(image);
+        Memory_Free(path);
+        return;
+    }
+
+    M_JOB *const job = Memory_Alloc(sizeof(M_JOB));
+    job->image = image;
+    job->path = path;
+
+    SDL_LockMutex(m_Encoder.mutex);
+    if (m_Encoder.tail != NULL) {
+        m_Encoder.tail->next = job;
+    } else {
+        m_Encoder.head = job;
+    }
+    m_Encoder.tail = job;
+    SDL_CondSignal(m_Encoder.cond);
+    SDL_UnlockMutex(m_Encoder.mutex);
+}
+
+static void M_Deliver(
+    IMAGE *const image, char *const path, const int32_t timestamp)
+{
+    if (path == NULL) {
+        Recorder_PushFrame(image, timestamp);
+    } else {
+        M_QueueEncode(image, path);
+    }
+}
+
+static void M_ReadNow(char *const path, const int32_t timestamp)
+{
+    // Without sync objects there is no way to tell when a pack buffer is
+    // ready, so read straight into client memory and stall instead.
+    GLint viewport[4];
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    GFX_GL_CheckError();
 
-    IMAGE *image = Image_Create(width, height);
+    IMAGE *const image = Image_Create(viewport[2], viewport[3]);
     ASSERT(image != NULL);
 
-    GFX_Screenshot_CaptureToBuffer(
-        (uint8_t *)image->data, &width, &height, 3, GL_RGB, GL_UNSIGNED_BYTE,
-        true);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    GFX_GL_CheckError();
+    glReadBuffer(GL_BACK);
+    GFX_GL_CheckError();
+    glReadPixels(
+        viewport[0], viewport[1], viewport[2], viewport[3], GL_RGB,
+        GL_UNSIGNED_BYTE, image->data);
+    GFX_GL_CheckError();
 
-    ret = Image_SaveToFile(image, path);
+    M_Deliver(image, path, timestamp);
+}
+
+static void M_FinishReadback(M_READBACK *const readback)
+{
+    glClientWaitSync(
+        readback->fence, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+    GFX_GL_CheckError();
+    glDeleteSync(readback->fence);
+    GFX_GL_CheckError();
+    readback->fence = NULL;
+
+    IMAGE *const image = Image_Create(readback->width, readback->height);
+    ASSERT(image != NULL);
 
-    if (image) {
+    GFX_GL_Buffer_Bind(&readback->pbo);
+    const void *const pixels = GFX_GL_Buffer_Map(&readback->pbo, GL_READ_ONLY);
+    if (pixels != NULL) {
+        memcpy(
+            image->data, pixels,
+            readback->width * readback->height * sizeof(IMAGE_PIXEL));
+        GFX_GL_Buffer_Unmap(&readback->pbo);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    GFX_GL_CheckError();
+
+    if (pixels == NULL) {
+        LOG_ERROR("Failed to map the screenshot buffer");
         Image_Free(image);
+        Memory_Free(readback->path);
+    } else {
+        M_Deliver(image, readback->path, readback->timestamp);
+    }
+    readback->path = NULL;
+    readback->active = false;
+}
+
+static M_READBACK *M_StartReadback(void)
+{
+    M_READBACK *readback = NULL;
+    for (int32_t i = 0; i < MAX_PENDING_READBACKS; i++) {
+        if (!m_Readbacks[i].active) {
+            readback = &m_Readbacks[i];
+            break;
+        }
+    }
+    if (readback == NULL) {
+        // every slot is busy; make room by finishing the oldest readback
+        readback = &m_Readbacks[0];
+        for (int32_t i = 1; i < MAX_PENDING_READBACKS; i++) {
+            if (m_Readbacks[i].age > readback->age) {
+                readback = &m_Readbacks[i];
+            }
+        }
+        M_FinishReadback(readback);
+    }
+
+    GLint viewport[4];
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    GFX_GL_CheckError();
+    readback->width = viewport[2];
+    readback->height = viewport[3];
+
+    if (!readback->pbo.initialized) {
+        GFX_GL_Buffer_Init(&readback->pbo, GL_PIXEL_PACK_BUFFER);
+        readback->pbo_size = 0;
+    }
+    GFX_GL_Buffer_Bind(&readback->pbo);
+    // the previous contents were already mapped and copied out, so the
+    // storage can be reused as long as the viewport keeps its size
+    const size_t pbo_size =
+        readback->width * readback->height * sizeof(IMAGE_PIXEL);
+    if (pbo_size != readback->pbo_size) {
+        GFX_GL_Buffer_Data(&readback->pbo, pbo_size, NULL, GL_STREAM_READ);
+        readback->pbo_size = pbo_size;
+    }
+
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    GFX_GL_CheckError();
+    glReadBuffer(GL_BACK);
+    GFX_GL_CheckError();
+    // With a pack buffer bound, this only queues the copy on the GPU.
+    glReadPixels(
+        viewport[0], viewport[1], readback->width, readback->height, GL_RGB,
+        GL_UNSIGNED_BYTE, NULL);
+    GFX_GL_CheckError();
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    GFX_GL_CheckError();
+
+    readback->fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    GFX_GL_CheckError();
+    readback->path = NULL;
+    readback->age = 0;
+    readback->active = true;
+    return readback;
+}
+
+bool GFX_Screenshot_CaptureToFile(const char *const path)
+{
+    if (!GFX_Context_GetConfig()->has_sync) {
+        M_ReadNow(Memory_DupStr(path), 0);
+        return true;
+    }
+    M_READBACK *const readback = M_StartReadback();
+    readback->path = Memory_DupStr(path);
+    return true;
+}
+
+bool GFX_Screenshot_CaptureToRecorder(void)
+{
+    if (!Recorder_IsActive()) {
+        return false;
+    }
+    if (!GFX_Context_GetConfig()->has_sync) {
+        M_ReadNow(NULL, Recorder_GetTimestamp());
+        return true;
+    }
+    M_READBACK *const readback = M_StartReadback();
+    readback->timestamp = Recorder_GetTimestamp();
+    return true;
+}
+
+void GFX_Screenshot_Update(void)
+{
+    for (int32_t i = 0; i < MAX_PENDING_READBACKS; i++) {
+        M_READBACK *const readback = &m_Readbacks[i];
+        if (!readback->active) {
+            continue;
+        }
+
+        readback->age++;
+        const GLenum status = glClientWaitSync(readback->fence, 0, 0);
+        GFX_GL_CheckError();
+        if (status == GL_ALREADY_SIGNALED || status == GL_CONDITION_SATISFIED
+            || readback->age >= MAX_READBACK_AGE) {
+            M_FinishReadback(readback);
+        }
+    }
+}
+
+void GFX_Screenshot_Shutdown(void)
+{
+    for (int32_t i = 0; i < MAX_PENDING_READBACKS; i++) {
+        M_READBACK *const readback = &m_Readbacks[i];
+        if (readback->active) {
+            M_FinishReadback(readback);
+        }
+        GFX_GL_Buffer_Close(&readback->pbo);
+        readback->pbo_size = 0;
+    }
+
+    if (m_Encoder.thread != NULL) {
+        // let the encoder finish what is queued, so no screenshot is lost
+        SDL_LockMutex(m_Encoder.mutex);
+        m_Encoder.quit = true;
+        SDL_CondSignal(m_Encoder.cond);
+        SDL_UnlockMutex(m_Encoder.mutex);
+        SDL_WaitThread(m_Encoder.thread, NULL);
+        m_Encoder.thread = NULL;
+    }
+    if (m_Encoder.cond != NULL) {
+        SDL_DestroyCond(m_Encoder.cond);
+        m_Encoder.cond = NULL;
+    }
+    if (m_Encoder.mutex != NULL) {
+        SDL_DestroyMutex(m_Encoder.mutex);
+        m_Encoder.mutex = NULL;
     }
-    return ret;
 }
 
 void GFX_Screenshot_CaptureToBuffer(
@@ -0,0 +1,328 @@
+#include "hash_map.h"
+
+#include "debug.h"
+#include "memory.h"
+#include "utils.h"
+
+#include <SDL2/SDL_atomic.h>
+#include <string.h>
+
+#define HASH_MAP_MIN_CAPACITY 16
+#define HASH_MAP_EMPTY 0
+
+typedef union {
+    uint64_t num;
+    const char *str;
+} M_KEY;
+
+struct HASH_MAP {
+    HASH_MAP_KEY_TYPE key_type;
+    bool owns_keys;
+    size_t value_size;
+    int32_t count;
+    int32_t capacity;
+    uint32_t *hashes;
+    M_KEY *keys;
+    char *values;
+};
+
+static HASH_MAP *m_InternPool = NULL;
+static SDL_SpinLock m_InternLock = 0;
+
+static uint32_t M_HashInt(uint64_t key);
+static uint32_t M_HashStr(const char *key);
+static bool M_KeysEqual(const HASH_MAP *map, M_KEY a, M_KEY b);
+static int32_t M_FindSlot(const HASH_MAP *map, M_KEY key, uint32_t hash);
+static void M_Grow(HASH_MAP *map);
+static void *M_Insert(
+    HASH_MAP *map, M_KEY key, uint32_t hash, const void *value);
+static bool M_Remove(HASH_MAP *map, M_KEY key, uint32_t hash);
+static void *M_GetValue(const HASH_MAP *map, int32_t slot);
+static HASH_MAP *M_Create(
+    HASH_MAP_KEY_TYPE key_type, size_t value_size, bool owns_keys);
+
+static uint32_t M_HashInt(uint64_t key)
+{
+    // splitmix64 finalizer
+    key ^= key >> 30;
+    key *= 0xBF58476D1CE4E5B9ULL;
+    key ^= key >> 27;
+    key *= 0x94D049BB133111EBULL;
+    key ^= key >> 31;
+    const uint32_t hash = (uint32_t)key;
+    return hash == HASH_MAP_EMPTY ? 1 : hash;
+}
+
+static uint32_t M_HashStr(const char *key)
+{
+    // FNV-1a
+    uint32_t hash = 2166136261u;
+    while (*key != '\0') {
+        hash ^= (uint8_t)*key++;
+        hash *= 16777619u;
+    }
+    return hash == HASH_MAP_EMPTY ? 1 : hash;
+}
+
+static bool M_KeysEqual(const HASH_MAP *const map, const M_KEY a, const M_KEY b)
+{
+    if (map->key_type == HMK_INT) {
+        return a.num == b.num;
+    }
+    return a.str == b.str || strcmp(a.str, b.str) == 0;
+}
+
+static int32_t M_FindSlot(
+    const HASH_MAP *const map, const M_KEY key, const uint32_t hash)
+{
+    if (map->capacity == 0) {
+        return -1;
+    }
+
+    const int32_t mask = map->capacity - 1;
+    for (int32_t slot = hash & mask;; slot = (slot + 1) & mask) {
+        if (map->hashes[slot] == HASH_MAP_EMPTY) {
+            return -1;
+        }
+        if (map->hashes[slot] == hash
+            && M_KeysEqual(map, map->keys[slot], key)) {
+            return slot;
+        }
+    }
+}
+
+static void M_Grow(HASH_MAP *const map)
+{
+    const int32_t old_capacity = map->capacity;
+    uint32_t *const old_hashes = map->hashes;
+    M_KEY *const old_keys = map->keys;
+    char *const old_values = map->values;
+
+    map->capacity =
+        old_capacity == 0 ? HASH_MAP_MIN_CAPACITY : old_capacity * 2;
+    map->hashes = Memory_Alloc(sizeof(uint32_t) * map->capacity);
+    map->keys = Memory_Alloc(sizeof(M_KEY) * map->capacity);
+    map->values = Memory_Alloc(MAX(1, map->value_size * map->capacity));
+
+    const int32_t mask = map->capacity - 1;
+    for (int32_t i = 0; i < old_capacity; i++) {
+        if (old_hashes[i] == HASH_MAP_EMPTY) {
+            continue;
+        }
+        int32_t slot = old_hashes[i] & mask;
+        while (map->hashes[slot] != HASH_MAP_EMPTY) {
+            slot = (slot + 1) & mask;
+        }
+        map->hashes[slot] = old_hashes[i];
+        map->keys[slot] = old_keys[i];
+        memcpy(
+            M_GetValue(map, slot), old_values + i * map->value_size,
+            map->value_size);
+    }
+
+    Memory_Free(old_hashes);
+    Memory_Free(old_keys);
+    Memory_Free(old_values);
+}
+
+static void *M_Insert(
+    HASH_MAP *const map, M_KEY key, const uint32_t hash,
+    const void *const value)
+{
+    int32_t slot = M_FindSlot(map, key, hash);
+    if (slot == -1) {
+        // keep the load factor below 3/4
+        if ((map->count + 1) * 4 > map->capacity * 3) {
+            M_Grow(map);
+        }
+
+        const int32_t mask = map->capacity - 1;
+        slot = hash & mask;
+        while (map->hashes[slot] != HASH_MAP_EMPTY) {
+            slot = (slot + 1) & mask;
+        }
+
+        if (map->key_type == HMK_STRING) {
+            key.str = map->owns_keys ? Memory_DupStr(key.str)
+                                     : HashMap_Intern(key.str);
+        }
+        map->hashes[slot] = hash;
+        map->keys[slot] = key;
+        map->count++;
+    }
+
+    void *const result = M_GetValue(map, slot);
+    if (value != NULL) {
+        memcpy(result, value, map->value_size);
+    } else {
+        memset(result, 0, map->value_size);
+    }
+    return result;
+}
+
+static bool M_Remove(HASH_MAP *const map, const M_KEY key, const uint32_t hash)
+{
+    int32_t slot = M_FindSlot(map, key, hash);
+    if (slot == -1) {
+        return false;
+    }
+
+    if (map->owns_keys) {
+        Memory_Free((char *)map->keys[slot].str);
+    }
+
+    // Shift the following entries back rather than leaving a tombstone, so
+    // that lookups never need to skip over deleted slots.
+    const int32_t mask = map->capacity - 1;
+    int32_t next = (slot + 1) & mask;
+    while (map->hashes[next] != HASH_MAP_EMPTY) {
+        const int32_t home = map->hashes[next] & mask;
+        if (((next - home) & mask) >= ((next - slot) & mask)) {
+            map->hashes[slot] = map->hashes[next];
+            map->keys[slot] = map->keys[next];
+            memcpy(
+                M_GetValue(map, slot), M_GetValue(map, next),
+                map->value_size);
+            slot = next;
+        }
+        next = (next + 1) & mask;
+    }
+    map->hashes[slot] = HASH_MAP_EMPTY;
+    map->count--;
+    return true;
+}
+
+static void *M_GetValue(const HASH_MAP *const map, const int32_t slot)
+{
+    return map->values + slot * map->value_size;
+}
+
+static HASH_MAP *M_Create(
+    const HASH_MAP_KEY_TYPE key_type, const size_t value_size,
+    const bool owns_keys)
+{
+    HASH_MAP *const map = Memory_Alloc(sizeof(HASH_MAP));
+    map->key_type = key_type;
+    map->owns_keys = owns_keys;
+    map->value_size = value_size;
+    return map;
+}
+
+HASH_MAP *HashMap_Create(
+    const HASH_MAP_KEY_TYPE key_type, const size_t value_size)
+{
+    return M_Create(key_type, value_size, false);
+}
+
+void HashMap_Free(HASH_MAP *const map)
+{
+    if (map == NULL) {
+        return;
+    }
+    HashMap_Clear(map);
+    Memory_Free(map->hashes);
+    Memory_Free(map->keys);
+    Memory_Free(map->values);
+    Memory_Free(map);
+}
+
+void HashMap_Clear(HASH_MAP *const map)
+{
+    if (map->owns_keys) {
+        for (int32_t i = 0; i < map->capacity; i++) {
+            if (map->hashes[i] != HASH_MAP_EMPTY) {
+                Memory_Free((char *)map->keys[i].str);
+            }
+        }
+    }
+    if (map->capacity > 0) {
+        memset(map->hashes, 0, sizeof(uint32_t) * map->capacity);
+    }
+    map->count = 0;
+}
+
+int32_t HashMap_GetCount(const HASH_MAP *const map)
+{
+    return map->count;
+}
+
+void *HashMap_FindInt(const HASH_MAP *const map, const uint64_t key)
+{
+    ASSERT(map->key_type == HMK_INT);
+    const int32_t slot =
+        M_FindSlot(map, (M_KEY) { .num = key }, M_HashInt(key));
+    return slot == -1 ? NULL : M_GetValue(map, slot);
+}
+
+void *HashMap_InsertInt(
+    HASH_MAP *const map, const uint64_t key, const void *const value)
+{
+    ASSERT(map->key_type == HMK_INT);
+    return M_Insert(map, (M_KEY) { .num = key }, M_HashInt(key), value);
+}
+
+bool HashMap_RemoveInt(HASH_MAP *const map, const uint64_t key)
+{
+    ASSERT(map->key_type == HMK_INT);
+    return M_Remove(map, (M_KEY) { .num = key }, M_HashInt(key));
+}
+
+void *HashMap_FindStr(const HASH_MAP *const map, const char *const key)
+{
+    ASSERT(map->key_type == HMK_STRING);
+    const int32_t slot =
+        M_FindSlot(map, (M_KEY) { .str = key }, M_HashStr(key));
+    return slot == -1 ? NULL : M_GetValue(map, slot);
+}
+
+void *HashMap_InsertStr(
+    HASH_MAP *const map, const char *const key, const void *const value)
+{
+    ASSERT(map->key_type == HMK_STRING);
+    return M_Insert(map, (M_KEY) { .str = key }, M_HashStr(key), value);
+}
+
+bool HashMap_RemoveStr(HASH_MAP *const map, const char *const key)
+{
+    ASSERT(map->key_type == HMK_STRING);
+    return M_Remove(map, (M_KEY) { .str = key }, M_HashStr(key));
+}
+
+void *HashMap_Iterate(const HASH_MAP *const map, int32_t *const iter)
+{
+    while (*iter < map->capacity) {
+        const int32_t slot = (*iter)++;
+        if (map->hashes[slot] != HASH_MAP_EMPTY) {
+            return M_GetValue(map, slot);
+        }
+    }
+    return NULL;
+}
+
+const char *HashMap_Intern(const char *const string)
+{
+    ASSERT(string != NULL);
+    SDL_AtomicLock(&m_InternLock);
+    if (m_InternPool == NULL) {
+        m_InternPool = M_Create(HMK_STRING, 0, true);
+    }
+
+    const M_KEY key = { .str = string };
+    const uint32_t hash = M_HashStr(string);
+    int32_t slot = M_FindSlot(m_InternPool, key, hash);
+    if (slot == -1) {
+        M_Insert(m_InternPool, key, hash, NULL);
+        slot = M_FindSlot(m_InternPool, key, hash);
+    }
+    const char *const result = m_InternPool->keys[slot].str;
+    SDL_AtomicUnlock(&m_InternLock);
+    return result;
+}
+
+void HashMap_FreeInterned(void)
+{
+    SDL_AtomicLock(&m_InternLock);
+    HashMap_Free(m_InternPool);
+    m_InternPool = NULL;
+    SDL_AtomicUnlock(&m_InternLock);
+}
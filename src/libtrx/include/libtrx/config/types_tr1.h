@@ -123,6 +123,8 @@ typedef struct {
         bool enable_ps_uzi_sfx;
         bool enable_pitched_sounds;
         bool load_music_triggers;
+        bool enable_sample_disk_cache;
+        bool enable_sound_filters;
         UNDERWATER_MUSIC_MODE underwater_music_mode;
         MUSIC_LOAD_CONDITION music_load_condition;
     } audio;
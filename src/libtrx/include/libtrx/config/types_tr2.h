@@ -60,6 +60,8 @@ typedef struct {
         int32_t music_volume;
         bool enable_lara_mic;
         UNDERWATER_MUSIC_MODE underwater_music_mode;
+        bool enable_sample_disk_cache;
+        bool enable_sound_filters;
     } audio;
 
     struct {
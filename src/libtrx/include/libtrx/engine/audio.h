@@ -10,13 +10,54 @@
 #define AUDIO_MAX_ACTIVE_SAMPLES 50
 #define AUDIO_MAX_ACTIVE_STREAMS 10
 #define AUDIO_NO_SOUND (-1)
+#define AUDIO_LOAD_BUCKETS 6
+// Share of real time that mixing one playing sound may take, filters
+// included, so that all the sounds together take at most half of it.
+#define AUDIO_VOICE_BUDGET (0.5 / AUDIO_MAX_ACTIVE_SAMPLES)
+
+// Timings of the mixer callback; times are in milliseconds, and the load is
+// the callback time as a fraction of the buffer period.
+typedef struct {
+    int32_t buffer_samples;
+    double buffer_period;
+    int32_t callbacks;
+    // Callbacks that took longer than the buffer period, or started late.
+    int32_t underruns;
+    double last_callback_time;
+    double avg_callback_time;
+    double max_callback_time;
+    // Spent decoding and mixing the music and other streams.
+    double avg_stream_time;
+    double avg_load;
+    double max_load;
+    int32_t active_samples;
+    int32_t active_streams;
+    // Callback count by load: under 10%, 25%, 50%, 75%, 100%, and above.
+    int32_t load_histogram[AUDIO_LOAD_BUCKETS];
+} AUDIO_STATS;
 
 bool Audio_Init(void);
 bool Audio_Shutdown(void);
 
+// Call once per frame. In the adaptive mode, this grows the device buffer
+// when the mixer cannot keep up and shrinks it back after a quiet period.
+void Audio_Update(void);
+void Audio_SetAdaptiveBuffer(bool enable);
+bool Audio_IsAdaptiveBuffer(void);
+// Safe to call at any time; never blocks the mixer.
+AUDIO_STATS Audio_GetStats(void);
+
 bool Audio_Stream_Pause(int32_t sound_id);
 bool Audio_Stream_Unpause(int32_t sound_id);
+// Opens the file and decodes its start on a background thread, so that a
+// later call to Audio_Stream_CreateFromFileRange with the same arguments
+// starts playing right away. A few recently played streams are kept ready
+// the same way. Negative timestamps mean the start or end of the file.
+void Audio_Stream_Prefetch(const char *path, double start_at, double stop_at);
 int32_t Audio_Stream_CreateFromFile(const char *path);
+// Plays the given part of the file; the stream loops back to start_at.
+int32_t Audio_Stream_CreateFromFileRange(
+    const char *path, double start_at, double stop_at);
 bool Audio_Stream_Close(int32_t sound_id);
 bool Audio_Stream_IsLooped(int32_t sound_id);
 bool Audio_Stream_SetVolume(int32_t sound_id, float volume);
@@ -35,6 +76,10 @@ bool Audio_Sample_LoadSingle(
     int32_t sample_num, const char *content, size_t size);
 bool Audio_Sample_Unload(int32_t sample_id);
 bool Audio_Sample_UnloadAll(void);
+// Converted samples are kept in memory across level loads. With the disk
+// cache enabled they are also stored on disk, so that later runs can skip
+// the conversion too.
+void Audio_Sample_SetDiskCache(bool enable);
 
 int32_t Audio_Sample_Play(
     int32_t sample_id, int32_t volume, float pitch, int32_t pan,
@@ -49,3 +94,11 @@ bool Audio_Sample_CloseAll(void);
 bool Audio_Sample_SetPan(int32_t sound_id, int32_t pan);
 bool Audio_Sample_SetVolume(int32_t sound_id, int32_t volume);
 bool Audio_Sample_SetPitch(int32_t sound_id, float pan);
+// Muffles the sound the further away it is, with the distance going from 0
+// (not at all) to 1 (the edge of the audible range), and muffles it a lot
+// more underwater. Sounds start out unfiltered.
+bool Audio_Sample_SetFilter(
+    int32_t sound_id, float distance, bool is_underwater);
+// Mixes a second of a filtered test sound and returns the share of real time
+// that took. Mixing one sound should stay within AUDIO_VOICE_BUDGET.
+double Audio_Sample_MeasureVoiceLoad(void);
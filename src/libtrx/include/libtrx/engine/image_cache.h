@@ -0,0 +1,42 @@
+#pragma once
+
+#include "image.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Keeps recently used pictures decoded and scaled in memory, and lets the
+// game request pictures ahead of time so that they are decoded on background
+// threads. Images are looked up by path, size and fit mode; a size of 0x0
+// keeps the image at its original size.
+
+typedef struct {
+    int32_t hits;
+    // Requested while a worker was still decoding the image.
+    int32_t late_hits;
+    int32_t misses;
+    int32_t prefetches;
+    int32_t decodes;
+    int32_t failures;
+    // In milliseconds.
+    double total_decode_time;
+    double max_decode_time;
+} IMAGE_CACHE_STATS;
+
+void ImageCache_Shutdown(void);
+
+// Queues the image for decoding on a worker thread, unless it is already
+// cached or queued. Returns false if the cache is full of prefetched images
+// that were not used yet, in which case the request is dropped.
+bool ImageCache_Prefetch(
+    const char *path, int32_t width, int32_t height, IMAGE_FIT_MODE fit_mode);
+// Whether ImageCache_Get can return without decoding or waiting.
+bool ImageCache_IsReady(
+    const char *path, int32_t width, int32_t height, IMAGE_FIT_MODE fit_mode);
+// Returns the cached image, waiting for a worker or decoding it right away if
+// needed, or NULL if the image cannot be loaded. The image is owned by the
+// cache and is valid until the next call to the cache.
+const IMAGE *ImageCache_Get(
+    const char *path, int32_t width, int32_t height, IMAGE_FIT_MODE fit_mode);
+
+IMAGE_CACHE_STATS ImageCache_GetStats(void);
@@ -0,0 +1,36 @@
+#pragma once
+
+#include "image.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Records presented frames and the audio mix to a video file. Frames and
+// audio are queued by the game and encoded on a background thread, so the
+// caller never waits for the encoder; frames that do not fit in the queue
+// are dropped.
+
+typedef struct {
+    int32_t frames_encoded;
+    int32_t frames_dropped;
+    int32_t queue_depth;
+    int32_t max_queue_depth;
+    int32_t audio_samples_dropped;
+} RECORDER_STATS;
+
+// The container is picked from the file extension (eg. mp4 or mkv).
+bool Recorder_Start(const char *path);
+// Encodes everything that is still queued and finalizes the file.
+void Recorder_Stop(void);
+bool Recorder_IsActive(void);
+
+// Milliseconds since the recording started; used to time captured frames.
+int32_t Recorder_GetTimestamp(void);
+// Takes ownership of the image, which is stored bottom-up as read back from
+// the frame buffer.
+void Recorder_PushFrame(IMAGE *image, int32_t timestamp);
+// Interleaved stereo samples in the audio working format.
+void Recorder_PushAudio(const float *samples, size_t count);
+
+RECORDER_STATS Recorder_GetStats(void);
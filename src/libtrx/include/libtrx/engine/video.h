@@ -10,14 +10,52 @@ typedef struct {
     void *priv;
 } VIDEO;
 
+typedef struct {
+    int32_t frames_shown;
+    // frames dropped by the decoder for being late
+    int32_t frames_dropped_early;
+    // frames dropped by the presenter for being late
+    int32_t frames_dropped_late;
+    // frames converted by the video thread ahead of time
+    int32_t frames_staged;
+    // frames that had to be converted when presented, eg. after a resize
+    int32_t frames_converted_late;
+    // time the video thread spent waiting for the presenter, in seconds
+    double queue_wait_time;
+} VIDEO_STATS;
+
 typedef void *(*VIDEO_SURFACE_ALLOCATOR_FUNC)(
     int32_t width, int32_t height, void *user_data);
 
+// A decoded frame at its native size, as planar YUV 4:2:0.
+typedef struct {
+    int32_t width;
+    int32_t height;
+    const uint8_t *planes[3];
+    int32_t pitches[3];
+    bool is_bt709;
+    bool is_full_range;
+    // Texture coordinates of the surface corners (clockwise from top left)
+    // that place the frame on the surface keeping its aspect ratio; they go
+    // outside of [0, 1] where the surface needs black bars.
+    struct {
+        float u;
+        float v;
+    } uv[4];
+} VIDEO_YUV_FRAME;
+
+typedef void (*VIDEO_YUV_UPLOAD_FUNC)(
+    const VIDEO_YUV_FRAME *frame, void *user_data);
+
 VIDEO *Video_Open(const char *path);
 void Video_SetVolume(VIDEO *video, double volume);
 void Video_SetSurfaceSize(VIDEO *video, int32_t width, int32_t height);
 void Video_SetSurfacePixelFormat(VIDEO *video, enum AVPixelFormat pixel_format);
 void Video_SetSurfaceStride(VIDEO *video, int32_t stride);
+// The surface allocator, deallocator, clear, lock and unlock functions are
+// also called from the video thread, which converts frames into surfaces of
+// their own ahead of time. Uploading and rendering stay on the caller's
+// thread.
 void Video_SetSurfaceAllocatorFunc(
     VIDEO *video, VIDEO_SURFACE_ALLOCATOR_FUNC func, void *user_data);
 void Video_SetSurfaceDeallocatorFunc(
@@ -41,7 +79,13 @@ void Video_SetRenderBeginFunc(
 void Video_SetRenderEndFunc(
     VIDEO *video, void (*func)(void *surface, void *user_data),
     void *user_data);
+// When set, YUV 4:2:0 frames skip the surface and are handed to func as they
+// are, leaving the conversion and scaling to the GPU. Other formats still go
+// through the surface. Pass NULL to turn it off.
+void Video_SetYUVUploadFunc(
+    VIDEO *video, VIDEO_YUV_UPLOAD_FUNC func, void *user_data);
 void Video_Start(VIDEO *video);
 void Video_Stop(VIDEO *video);
 void Video_PumpEvents(VIDEO *video);
 void Video_Close(VIDEO *video);
+VIDEO_STATS Video_GetStats(VIDEO *video);
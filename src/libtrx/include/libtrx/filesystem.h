@@ -34,6 +34,11 @@ const char *File_GetGameDirectory(void);
 // only be necessary when interacting with external libraries.
 char *File_GetFullPath(const char *path);
 
+// Forget the cached directory listings used for case-insensitive lookups.
+// Writes made through this module do this automatically; call it after
+// creating files by other means, such as through an external library.
+void File_InvalidateIndex(void);
+
 char *File_GetParentDirectory(const char *path);
 
 char *File_GuessExtension(const char *path, const char **extensions);
@@ -0,0 +1,39 @@
+#pragma once
+
+// A bump allocator for short-lived allocations. Memory handed out by the
+// arena stays valid until the end of the current frame, when the arena is
+// reset as a whole. Every thread uses its own arena, so no locking is needed;
+// the arena of the main thread is reset by FrameArena_Reset at the end of
+// every rendered frame.
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct {
+    void *block;
+    size_t used;
+} FRAME_ARENA_MARK;
+
+typedef struct {
+    // bytes taken from the arena during the previous frame
+    size_t arena_bytes;
+    // heap allocations and frees done during the previous frame
+    int32_t heap_allocs;
+    int32_t heap_frees;
+} FRAME_ARENA_STATS;
+
+// Allocate n bytes aligned to 16 bytes. Unlike Memory_Alloc, the memory is
+// not cleared.
+void *FrameArena_Alloc(size_t size);
+
+// Marks and releases allow giving temporaries back before the end of the
+// frame, for code that does not know how often it is going to be called.
+FRAME_ARENA_MARK FrameArena_GetMark(void);
+void FrameArena_Release(FRAME_ARENA_MARK mark);
+
+// Invalidates everything allocated from the calling thread's arena.
+void FrameArena_Reset(void);
+// Frees the calling thread's arena.
+void FrameArena_Shutdown(void);
+
+const FRAME_ARENA_STATS *FrameArena_GetStats(void);
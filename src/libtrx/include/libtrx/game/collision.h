@@ -2,6 +2,8 @@
 
 #include "math.h"
 
+#define COLLISION_QUERY_MAX_ROOMS 16
+
 #if TR_VERSION == 1
 typedef struct {
     int32_t mid_floor;
@@ -78,3 +80,10 @@ typedef struct {
     // clang-format on
 } COLL_INFO;
 #endif
+
+// Rooms gathered around a single collision test. Every caller owns its query,
+// so that the test does not depend on any global scratch state.
+typedef struct {
+    int32_t room_count;
+    int16_t room_nums[COLLISION_QUERY_MAX_ROOMS];
+} COLLISION_QUERY;
@@ -0,0 +1,5 @@
+#pragma once
+
+#include "../common.h"
+
+extern CONSOLE_COMMAND g_Console_Cmd_MemStats;
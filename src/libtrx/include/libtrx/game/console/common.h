@@ -1,6 +1,7 @@
 #pragma once
 
 #include "../types.h"
+#include "../ui/widgets/base.h"
 
 #include <stdbool.h>
 #include <stdint.h>
@@ -34,6 +35,11 @@ void Console_ScrollLogs(void);
 int32_t Console_GetVisibleLogCount(void);
 int32_t Console_GetMaxLogCount(void);
 
+// A widget drawn on top of the game along with the console, eg. for live
+// stats. The console takes ownership of it; pass NULL to remove it.
+void Console_SetOverlay(UI_WIDGET *overlay);
+UI_WIDGET *Console_GetOverlay(void);
+
 void Console_Log(const char *fmt, ...);
 COMMAND_RESULT Console_Eval(const char *cmdline);
 
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <stddef.h>
+#include <stdint.h>
 
 // Internal game memory manager. It allocates its internal buffer once per
 // level launch. All subsequent "allocation" requests operate with pointer
@@ -8,6 +9,11 @@
 // go, but it makes freeing memory really inconvenient which is why it is
 // intentionally not implemented. To use more dynamic memory management, use
 // Memory_Alloc / Memory_Free.
+//
+// When a level needs more than the initial capacity, more chunks are added
+// as needed; consecutive allocations are therefore not guaranteed to be
+// adjacent in memory. Allocations are aligned to 16 bytes, and large bulk
+// buffers (meshes, frames, samples...) to 64 bytes.
 
 typedef enum {
     // clang-format off
@@ -53,3 +59,16 @@ void GameBuf_Shutdown(void);
 void GameBuf_Reset(void);
 
 void *GameBuf_Alloc(size_t alloc_size, GAME_BUFFER buffer);
+
+typedef struct {
+    // bytes used by the current level
+    size_t bytes;
+    // the most bytes used by any level since the game was launched
+    size_t peak_bytes;
+    int32_t alloc_count;
+} GAMEBUF_STATS;
+
+const GAMEBUF_STATS *GameBuf_GetStats(GAME_BUFFER buffer);
+size_t GameBuf_GetUsedSize(void);
+size_t GameBuf_GetPeakSize(void);
+size_t GameBuf_GetReservedSize(void);
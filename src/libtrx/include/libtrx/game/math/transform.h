@@ -0,0 +1,25 @@
+#pragma once
+
+#include "./types.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Transforms vertices to view space in batches. The matrix is the 3x4 fixed
+// point matrix of the game, as 12 values in row order (_00, _01, _02, _03,
+// _10 and so on). The vertices are read stride bytes apart, so that they can
+// be part of larger structures. The results are exactly the same as
+// multiplying each vertex in 32-bit integers, overflow included, so this can
+// replace a scalar loop without changing the output.
+void Math_TransformVertices(
+    const int32_t *matrix, const XYZ_16 *vertices, size_t stride,
+    int32_t count, XYZ_32 *out);
+// The plain C version, which Math_TransformVertices falls back to where SIMD
+// is not available; exposed to check and benchmark the two against each
+// other.
+void Math_TransformVerticesScalar(
+    const int32_t *matrix, const XYZ_16 *vertices, size_t stride,
+    int32_t count, XYZ_32 *out);
+// Whether Math_TransformVertices uses SIMD in this build.
+bool Math_IsTransformVectorized(void);
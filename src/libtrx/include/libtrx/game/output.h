@@ -1,10 +1,18 @@
 #pragma once
 
+#include "../gfx/3d/3d_renderer.h"
+
 extern bool Output_MakeScreenshot(const char *path);
+// Returns NULL if the active renderer does not keep statistics.
+extern const GFX_3D_RENDERER_STATS *Output_GetRendererStats(void);
 extern void Output_BeginScene(void);
 extern void Output_EndScene(void);
 
 void Output_LoadBackgroundFromFile(const char *file_name);
+// Starts decoding the background ahead of time on a worker thread. Returns
+// false if the request was dropped because the image cache is full.
+bool Output_PrefetchBackground(const char *file_name);
+bool Output_IsBackgroundReady(const char *file_name);
 void Output_UnloadBackground(void);
 
 void Output_DrawBlackRectangle(int32_t opacity);
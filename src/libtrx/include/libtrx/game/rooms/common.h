@@ -1,5 +1,6 @@
 #pragma once
 
+#include "../collision.h"
 #include "types.h"
 
 extern int32_t Room_GetTotalCount(void);
@@ -7,10 +8,21 @@ extern ROOM *Room_Get(int32_t room_num);
 
 extern void Room_FlipMap(void);
 extern bool Room_GetFlipStatus(void);
+extern SECTOR *Room_GetSector(
+    int32_t x, int32_t y, int32_t z, int16_t *room_num);
 
 int32_t Room_GetAdjoiningRooms(
     int16_t init_room_num, int16_t out_room_nums[], int32_t max_room_num_count);
 
+// Collects the rooms touched by a box of radius r and height h standing at
+// the given position.
+void Room_GetNearbyRooms(
+    COLLISION_QUERY *query, int32_t x, int32_t y, int32_t z, int32_t r,
+    int32_t h, int16_t room_num);
+void Room_GetNewRoom(
+    COLLISION_QUERY *query, int32_t x, int32_t y, int32_t z,
+    int16_t room_num);
+
 void Room_ParseFloorData(const int16_t *floor_data);
 void Room_PopulateSectorData(
     SECTOR *sector, const int16_t *floor_data, uint16_t start_index,
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
 // TODO: rename this
@@ -96,8 +97,10 @@ typedef struct {
     } outline;
 
     char *content;
+    size_t content_capacity;
 
     const GLYPH_INFO **glyphs;
+    size_t glyph_capacity;
 } TEXTSTRING;
 
 extern int32_t Text_GetMaxLineLength(void);
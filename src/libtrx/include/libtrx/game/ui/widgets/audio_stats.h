@@ -0,0 +1,6 @@
+#pragma once
+
+#include "./base.h"
+
+// Shows the live audio mixer stats in the top right corner of the screen.
+UI_WIDGET *UI_AudioStats_Create(void);
@@ -19,6 +19,14 @@ typedef enum {
     GFX_2D_EFFECT_VIGNETTE = 1,
 } GFX_2D_EFFECT;
 
+// A planar YUV 4:2:0 image; the conversion to RGB happens in the shader.
+typedef struct {
+    const uint8_t *planes[3];
+    int32_t pitches[3];
+    bool is_bt709;
+    bool is_full_range;
+} GFX_2D_YUV_DATA;
+
 typedef struct GFX_2D_RENDERER GFX_2D_RENDERER;
 
 GFX_2D_RENDERER *GFX_2D_Renderer_Create(void);
@@ -30,6 +38,12 @@ void GFX_2D_Renderer_UploadAlphaSurface(
     GFX_2D_RENDERER *renderer, GFX_2D_SURFACE *surface);
 void GFX_2D_Renderer_Upload(
     GFX_2D_RENDERER *renderer, GFX_2D_SURFACE_DESC *desc, const uint8_t *data);
+// Only the size and the texture coordinates of desc are used. Anything
+// outside of the [0, 1] range of the coordinates is drawn black. Requires
+// the OpenGL 3.3 backend.
+void GFX_2D_Renderer_UploadYUV(
+    GFX_2D_RENDERER *renderer, GFX_2D_SURFACE_DESC *desc,
+    const GFX_2D_YUV_DATA *data);
 
 void GFX_2D_Renderer_SetPalette(
     GFX_2D_RENDERER *renderer, const GFX_COLOR *palette);
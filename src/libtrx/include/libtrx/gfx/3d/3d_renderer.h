@@ -13,6 +13,7 @@
 #define GFX_ENV_MAP_TEXTURE (-2)
 
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
 typedef enum {
@@ -21,6 +22,15 @@ typedef enum {
     GFX_BLEND_MODE_MULTIPLY,
 } GFX_BLEND_MODE;
 
+typedef struct {
+    int32_t draw_calls;
+    int32_t vertices;
+    int32_t texture_changes;
+    int32_t requested_state_changes;
+    int32_t applied_state_changes;
+    int32_t sorted_prims;
+} GFX_3D_RENDERER_STATS;
+
 typedef struct GFX_3D_RENDERER GFX_3D_RENDERER;
 
 GFX_3D_RENDERER *GFX_3D_Renderer_Create(void);
@@ -30,6 +40,19 @@ void GFX_3D_Renderer_RenderBegin(GFX_3D_RENDERER *renderer);
 void GFX_3D_Renderer_RenderEnd(GFX_3D_RENDERER *renderer);
 void GFX_3D_Renderer_ClearDepth(GFX_3D_RENDERER *renderer);
 
+// Sizes the per-frame vertex buffer upfront to avoid growing it mid-frame.
+void GFX_3D_Renderer_ReserveVertices(GFX_3D_RENDERER *renderer, size_t count);
+
+// While enabled, primitives drawn with depth testing and writing on are queued
+// and submitted at the next state barrier: opaque ones grouped by state, and
+// translucent ones back to front.
+void GFX_3D_Renderer_SetStateSortingEnabled(
+    GFX_3D_RENDERER *renderer, bool is_enabled);
+
+// Counters for the last completed frame.
+const GFX_3D_RENDERER_STATS *GFX_3D_Renderer_GetStats(
+    const GFX_3D_RENDERER *renderer);
+
 int GFX_3D_Renderer_RegisterTexturePage(
     GFX_3D_RENDERER *renderer, const void *data, int width, int height);
 bool GFX_3D_Renderer_UnregisterTexturePage(
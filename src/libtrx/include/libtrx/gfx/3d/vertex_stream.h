@@ -5,6 +5,15 @@
 
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
+
+// Number of frames the GPU buffer is split between, so that the CPU can fill
+// one region while the GPU is still reading from the previous ones.
+#define GFX_3D_STREAM_SEGMENTS 3
+
+// Triangles are submitted as 16-bit indices relative to the first vertex of
+// the batch, so a single batch cannot address more vertices than this.
+#define GFX_3D_STREAM_MAX_BATCH_VERTICES 0x10000
 
 typedef enum {
     GFX_3D_PRIM_LINE = 0,
@@ -17,16 +26,44 @@ typedef struct {
     float r, g, b, a;
 } GFX_3D_VERTEX;
 
+// GPU-side vertex layout: the caller-supplied vertex plus the texture array
+// layer that was selected when it was pushed.
+typedef struct {
+    GFX_3D_VERTEX vertex;
+    float layer;
+} GFX_3D_STREAM_VERTEX;
+
 typedef struct {
     GFX_3D_PRIM_TYPE prim_type;
-    size_t buffer_size;
+    float layer;
     GFX_GL_BUFFER buffer;
+    GFX_GL_BUFFER index_buffer;
     GFX_GL_VERTEX_ARRAY vtc_format;
+    bool use_base_vertex;
+
+    // size of the index buffer storage in indices; it only ever grows
+    size_t index_buffer_capacity;
+
+    // ring buffer state, all sizes are in vertices; only used when the
+    // context supports both sync objects and ranged buffer mapping
+    bool use_ring;
+    size_t segment_capacity;
+    int segment;
+    size_t segment_offset;
+    GLsync fences[GFX_3D_STREAM_SEGMENTS];
+
+    // vertices written since the last draw; data points straight into the
+    // mapped region of the GPU buffer, or to client memory without the ring
     struct {
-        GFX_3D_VERTEX *data;
+        GFX_3D_STREAM_VERTEX *data;
         size_t count;
         size_t capacity;
     } pending_vertices;
+    struct {
+        uint16_t *data;
+        size_t count;
+        size_t capacity;
+    } pending_indices;
     size_t rendered_count;
 } GFX_3D_VERTEX_STREAM;
 
@@ -34,9 +71,15 @@ void GFX_3D_VertexStream_Init(GFX_3D_VERTEX_STREAM *vertex_stream);
 void GFX_3D_VertexStream_Close(GFX_3D_VERTEX_STREAM *vertex_stream);
 
 void GFX_3D_VertexStream_Bind(GFX_3D_VERTEX_STREAM *vertex_stream);
+void GFX_3D_VertexStream_Reserve(
+    GFX_3D_VERTEX_STREAM *vertex_stream, size_t count);
+void GFX_3D_VertexStream_BeginFrame(GFX_3D_VERTEX_STREAM *vertex_stream);
+void GFX_3D_VertexStream_EndFrame(GFX_3D_VERTEX_STREAM *vertex_stream);
 
 void GFX_3D_VertexStream_SetPrimType(
     GFX_3D_VERTEX_STREAM *vertex_stream, GFX_3D_PRIM_TYPE prim_type);
+void GFX_3D_VertexStream_SetTextureLayer(
+    GFX_3D_VERTEX_STREAM *vertex_stream, float layer);
 
 bool GFX_3D_VertexStream_PushPrimStrip(
     GFX_3D_VERTEX_STREAM *vertex_stream, const GFX_3D_VERTEX *vertices,
@@ -11,4 +11,10 @@ typedef struct {
     GFX_TEXTURE_FILTER display_filter;
     bool enable_wireframe;
     int32_t line_width;
+
+    // Optional OpenGL features, detected once when the context is attached.
+    // They are core in 3.3, but a 2.1 context only has them as extensions.
+    bool has_sync;
+    bool has_map_buffer_range;
+    bool has_base_vertex;
 } GFX_CONFIG;
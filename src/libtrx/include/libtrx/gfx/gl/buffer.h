@@ -19,5 +19,10 @@ void GFX_GL_Buffer_Data(
 void GFX_GL_Buffer_SubData(
     GFX_GL_BUFFER *buf, GLsizei offset, GLsizei size, const void *data);
 void *GFX_GL_Buffer_Map(GFX_GL_BUFFER *buf, GLenum access);
+void *GFX_GL_Buffer_MapRange(
+    GFX_GL_BUFFER *buf, GLintptr offset, GLsizeiptr length,
+    GLbitfield access);
+void GFX_GL_Buffer_FlushMappedRange(
+    GFX_GL_BUFFER *buf, GLintptr offset, GLsizeiptr length);
 void GFX_GL_Buffer_Unmap(GFX_GL_BUFFER *buf);
 GLint GFX_GL_Buffer_Parameter(GFX_GL_BUFFER *buf, GLenum pname);
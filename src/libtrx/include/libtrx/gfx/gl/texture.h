@@ -19,4 +19,12 @@ void GFX_GL_Texture_Bind(GFX_GL_TEXTURE *texture);
 void GFX_GL_Texture_Load(
     GFX_GL_TEXTURE *texture, const void *data, int width, int height,
     GLint internal_format, GLint format);
+// Allocates every mip level of an array texture without any data.
+void GFX_GL_Texture_LoadArray(
+    GFX_GL_TEXTURE *texture, int width, int height, int layers,
+    GLint internal_format, GLint format);
+// Uploads one RGBA layer and builds its mip levels.
+void GFX_GL_Texture_LoadLayer(
+    GFX_GL_TEXTURE *texture, int layer, const void *data, int width,
+    int height, GLint format);
 void GFX_GL_Texture_LoadFromBackBuffer(GFX_GL_TEXTURE *texture);
@@ -5,7 +5,20 @@
 #include <stdbool.h>
 #include <stdint.h>
 
+// Queues a copy of the current back buffer and returns immediately. The
+// pixels are picked up by GFX_Screenshot_Update a frame or two later and
+// written to the file by a background thread. Contexts without sync objects
+// read the pixels right away instead.
 bool GFX_Screenshot_CaptureToFile(const char *path);
+// Same as above, but hands the frame to the video recorder. Does nothing
+// unless a recording is in progress.
+bool GFX_Screenshot_CaptureToRecorder(void);
+// Collects finished readbacks; call once per frame.
+void GFX_Screenshot_Update(void);
+// Finishes all pending screenshots and hands pending frames to the recorder;
+// call before the GL context goes away. The recording itself is stopped by
+// the game with Recorder_Stop.
+void GFX_Screenshot_Shutdown(void);
 
 void GFX_Screenshot_CaptureToBuffer(
     uint8_t *out_buffer, GLint *out_width, GLint *out_height, GLint depth,
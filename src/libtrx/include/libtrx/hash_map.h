@@ -0,0 +1,45 @@
+#pragma once
+
+// A hash map with open addressing and linear probing. Keys, hashes and values
+// are stored in flat arrays, so lookups do not chase pointers the way uthash
+// does. Values are copied into the map; pointers to them stay valid until the
+// next insertion or removal.
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+typedef enum {
+    HMK_INT,
+    // String keys are interned on insertion, so the caller does not need to
+    // keep them alive.
+    HMK_STRING,
+} HASH_MAP_KEY_TYPE;
+
+typedef struct HASH_MAP HASH_MAP;
+
+HASH_MAP *HashMap_Create(HASH_MAP_KEY_TYPE key_type, size_t value_size);
+void HashMap_Free(HASH_MAP *map);
+void HashMap_Clear(HASH_MAP *map);
+int32_t HashMap_GetCount(const HASH_MAP *map);
+
+// The find functions return NULL if the key is missing. The insert functions
+// overwrite the value of an existing key, and return the stored value.
+void *HashMap_FindInt(const HASH_MAP *map, uint64_t key);
+void *HashMap_InsertInt(HASH_MAP *map, uint64_t key, const void *value);
+bool HashMap_RemoveInt(HASH_MAP *map, uint64_t key);
+
+void *HashMap_FindStr(const HASH_MAP *map, const char *key);
+void *HashMap_InsertStr(HASH_MAP *map, const char *key, const void *value);
+bool HashMap_RemoveStr(HASH_MAP *map, const char *key);
+
+// Walks the stored values in no particular order. Start with iter set to 0;
+// returns NULL once all values were visited.
+void *HashMap_Iterate(const HASH_MAP *map, int32_t *iter);
+
+// Returns a copy of the string that lives until HashMap_FreeInterned. Equal
+// strings are always interned to the same address. The pool itself can be
+// used from any thread, but the maps are not, so each map must stay on the
+// thread that owns it.
+const char *HashMap_Intern(const char *string);
+void HashMap_FreeInterned(void);
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <stdint.h>
+
+// A small pool of worker threads for data-parallel loops. The calling thread
+// takes part in the work, so with no workers everything runs inline.
+
+typedef void (*JOB_FUNC)(void *user_data, int32_t idx);
+
+void Jobs_Init(int32_t worker_count);
+void Jobs_Shutdown(void);
+int32_t Jobs_GetWorkerCount(void);
+
+// Calls func once for every index in [0, count) and returns when all calls
+// are done. Calls for different indices may run concurrently and in any
+// order, so they must not touch shared state.
+void Jobs_ParallelFor(int32_t count, JOB_FUNC func, void *user_data);
@@ -4,6 +4,12 @@
 // memory.
 
 #include <stddef.h>
+#include <stdint.h>
+
+typedef struct {
+    int32_t allocs;
+    int32_t frees;
+} MEMORY_COUNTERS;
 
 // Allocate n bytes. In case the memory allocation fails, shows an error to the
 // user and exits the application. The allocated memory is filled with zeros.
@@ -40,3 +46,7 @@ char *Memory_Dup(const char *buffer, size_t size);
 // the user and exits the application. The string must be NULL-terminated.
 // Giving a NULL to this function is a fatal error.
 char *Memory_DupStr(const char *string);
+
+// Returns the number of heap allocations and frees done so far by the calling
+// thread. Reallocations that move the memory count as both.
+MEMORY_COUNTERS Memory_GetCounters(void);
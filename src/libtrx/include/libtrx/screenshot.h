@@ -8,3 +8,5 @@ typedef enum {
 } SCREENSHOT_FORMAT;
 
 bool Screenshot_Make(SCREENSHOT_FORMAT format);
+// Returns a new path for a video recording, stored next to the screenshots.
+char *Screenshot_GetRecordingPath(void);
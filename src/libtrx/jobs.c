@@ -0,0 +1,199 @@
+#include "jobs.h"
+
+#include "debug.h"
+#include "frame_arena.h"
+#include "log.h"
+#include "utils.h"
+
+#include <SDL2/SDL.h>
+#include <stdbool.h>
+
+#define MAX_WORKERS 15
+
+// Every thread owns a contiguous range of indices. It consumes the range from
+// the front; once empty, it steals the back half of another thread's range.
+typedef struct {
+    SDL_mutex *mutex;
+    int32_t begin;
+    int32_t end;
+} M_QUEUE;
+
+static int32_t m_WorkerCount = 0;
+static SDL_Thread *m_Workers[MAX_WORKERS] = {};
+static M_QUEUE m_Queues[MAX_WORKERS + 1] = {};
+static SDL_sem *m_StartSem = NULL;
+static SDL_sem *m_DoneSem = NULL;
+static bool m_Quit = false;
+static bool m_IsRunning = false;
+
+static struct {
+    JOB_FUNC func;
+    void *user_data;
+} m_Batch = {};
+
+static bool M_Pop(int32_t slot, int32_t *out_idx);
+static bool M_Steal(int32_t slot);
+static void M_Work(int32_t slot);
+static int M_WorkerThread(void *arg);
+
+static bool M_Pop(const int32_t slot, int32_t *const out_idx)
+{
+    M_QUEUE *const queue = &m_Queues[slot];
+    SDL_LockMutex(queue->mutex);
+    const bool result = queue->begin < queue->end;
+    if (result) {
+        *out_idx = queue->begin++;
+    }
+    SDL_UnlockMutex(queue->mutex);
+    return result;
+}
+
+static bool M_Steal(const int32_t slot)
+{
+    const int32_t queue_count = m_WorkerCount + 1;
+    for (int32_t i = 1; i < queue_count; i++) {
+        M_QUEUE *const victim = &m_Queues[(slot + i) % queue_count];
+        SDL_LockMutex(victim->mutex);
+        const int32_t left = victim->end - victim->begin;
+        if (left <= 0) {
+            SDL_UnlockMutex(victim->mutex);
+            continue;
+        }
+
+        const int32_t end = victim->end;
+        victim->end -= MAX(1, left / 2);
+        const int32_t begin = victim->end;
+        SDL_UnlockMutex(victim->mutex);
+
+        M_QUEUE *const queue = &m_Queues[slot];
+        SDL_LockMutex(queue->mutex);
+        queue->begin = begin;
+        queue->end = end;
+        SDL_UnlockMutex(queue->mutex);
+        return true;
+    }
+    return false;
+}
+
+static void M_Work(const int32_t slot)
+{
+    while (true) {
+        int32_t idx;
+        if (M_Pop(slot, &idx)) {
+            m_Batch.func(m_Batch.user_data, idx);
+        } else if (!M_Steal(slot)) {
+            break;
+        }
+    }
+}
+
+static int M_WorkerThread(void *const arg)
+{
+    const int32_t slot = (intptr_t)arg;
+    while (true) {
+        SDL_SemWait(m_StartSem);
+        if (m_Quit) {
+            break;
+        }
+        M_Work(slot);
+        FrameArena_Reset();
+        SDL_SemPost(m_DoneSem);
+    }
+    FrameArena_Shutdown();
+    return 0;
+}
+
+void Jobs_Init(const int32_t worker_count)
+{
+    ASSERT(m_WorkerCount == 0);
+    m_Quit = false;
+
+    const int32_t queue_count = MIN(worker_count, MAX_WORKERS) + 1;
+    for (int32_t i = 0; i < queue_count; i++) {
+        m_Queues[i].mutex = SDL_CreateMutex();
+        m_Queues[i].begin = 0;
+        m_Queues[i].end = 0;
+    }
+    m_StartSem = SDL_CreateSemaphore(0);
+    m_DoneSem = SDL_CreateSemaphore(0);
+
+    for (int32_t i = 0; i < queue_count - 1; i++) {
+        SDL_Thread *const thread = SDL_CreateThread(
+            M_WorkerThread, "job_worker", (void *)(intptr_t)(i + 1));
+        if (thread == NULL) {
+            LOG_ERROR("SDL_CreateThread(): %s", SDL_GetError());
+            break;
+        }
+        m_Workers[m_WorkerCount++] = thread;
+    }
+    LOG_INFO("Started %d job workers", m_WorkerCount);
+}
+
+void Jobs_Shutdown(void)
+{
+    m_Quit = true;
+    for (int32_t i = 0; i < m_WorkerCount; i++) {
+        SDL_SemPost(m_StartSem);
+    }
+    for (int32_t i = 0; i < m_WorkerCount; i++) {
+        SDL_WaitThread(m_Workers[i], NULL);
+        m_Workers[i] = NULL;
+    }
+    for (int32_t i = 0; i < MAX_WORKERS + 1; i++) {
+        if (m_Queues[i].mutex != NULL) {
+            SDL_DestroyMutex(m_Queues[i].mutex);
+            m_Queues[i].mutex = NULL;
+        }
+    }
+    if (m_StartSem != NULL) {
+        SDL_DestroySemaphore(m_StartSem);
+        m_StartSem = NULL;
+    }
+    if (m_DoneSem != NULL) {
+        SDL_DestroySemaphore(m_DoneSem);
+        m_DoneSem = NULL;
+    }
+    m_WorkerCount = 0;
+}
+
+int32_t Jobs_GetWorkerCount(void)
+{
+    return m_WorkerCount;
+}
+
+void Jobs_ParallelFor(
+    const int32_t count, const JOB_FUNC func, void *const user_data)
+{
+    if (count <= 0) {
+        return;
+    }
+
+    // nested loops would wait on workers that are busy running the outer one
+    ASSERT(!m_IsRunning);
+
+    if (m_WorkerCount == 0 || count == 1) {
+        for (int32_t i = 0; i < count; i++) {
+            func(user_data, i);
+        }
+        return;
+    }
+
+    m_IsRunning = true;
+    m_Batch.func = func;
+    m_Batch.user_data = user_data;
+
+    const int32_t queue_count = m_WorkerCount + 1;
+    for (int32_t i = 0; i < queue_count; i++) {
+        m_Queues[i].begin = count * i / queue_count;
+        m_Queues[i].end = count * (i + 1) / queue_count;
+    }
+
+    for (int32_t i = 0; i < m_WorkerCount; i++) {
+        SDL_SemPost(m_StartSem);
+    }
+    M_Work(0);
+    for (int32_t i = 0; i < m_WorkerCount; i++) {
+        SDL_SemWait(m_DoneSem);
+    }
+    m_IsRunning = false;
+}
@@ -5,11 +5,14 @@
 #include <stdlib.h>
 #include <string.h>
 
+static _Thread_local MEMORY_COUNTERS m_Counters = {};
+
 void *Memory_Alloc(const size_t size)
 {
     void *result = malloc(size);
     ASSERT(result != NULL);
     memset(result, 0, size);
+    m_Counters.allocs++;
     return result;
 }
 
@@ -17,6 +20,12 @@ void *Memory_Realloc(void *const memory, const size_t size)
 {
     void *result = realloc(memory, size);
     ASSERT(result != NULL);
+    if (result != memory) {
+        m_Counters.allocs++;
+        if (memory != NULL) {
+            m_Counters.frees++;
+        }
+    }
     return result;
 }
 
@@ -24,6 +33,7 @@ void Memory_Free(void *const memory)
 {
     if (memory != NULL) {
         free(memory);
+        m_Counters.frees++;
     }
 }
 
@@ -51,3 +61,8 @@ char *Memory_DupStr(const char *const string)
     strcpy(memory, string);
     return memory;
 }
+
+MEMORY_COUNTERS Memory_GetCounters(void)
+{
+    return m_Counters;
+}
@@ -16,7 +16,8 @@ static char *M_GetScreenshotTitle(void);
 static char *M_CleanScreenshotTitle(const char *source);
 static char *M_GetScreenshotBaseName(void);
 static const char *M_GetScreenshotFileExt(SCREENSHOT_FORMAT format);
-static char *M_GetScreenshotPath(SCREENSHOT_FORMAT format);
+static bool M_ReservePath(const char *path);
+static char *M_GetScreenshotPath(const char *ext);
 
 static char *M_CleanScreenshotTitle(const char *const source)
 {
@@ -107,19 +108,34 @@ static const char *M_GetScreenshotFileExt(const SCREENSHOT_FORMAT format)
     }
 }
 
-static char *M_GetScreenshotPath(const SCREENSHOT_FORMAT format)
+static bool M_ReservePath(const char *const path)
+{
+    if (File_Exists(path)) {
+        return false;
+    }
+
+    // The image or video is written later by another thread, so create an
+    // empty file right away; otherwise a second capture within the same
+    // second would pick the same name.
+    MYFILE *const fp = File_Open(path, FILE_OPEN_WRITE);
+    if (fp != NULL) {
+        File_Close(fp);
+    }
+    return true;
+}
+
+static char *M_GetScreenshotPath(const char *const ext)
 {
     char *base_name = M_GetScreenshotBaseName();
-    const char *const ext = M_GetScreenshotFileExt(format);
 
     char *full_path = Memory_Alloc(
         strlen(SCREENSHOTS_DIR) + strlen(base_name) + strlen(ext) + 6);
     sprintf(full_path, "%s/%s.%s", SCREENSHOTS_DIR, base_name, ext);
-    if (File_Exists(full_path)) {
+    if (!M_ReservePath(full_path)) {
         for (int i = 2; i < 100; i++) {
             sprintf(
                 full_path, "%s/%s_%d.%s", SCREENSHOTS_DIR, base_name, i, ext);
-            if (!File_Exists(full_path)) {
+            if (M_ReservePath(full_path)) {
                 break;
             }
         }
@@ -133,9 +149,15 @@ bool Screenshot_Make(const SCREENSHOT_FORMAT format)
 {
     File_CreateDirectory(SCREENSHOTS_DIR);
 
-    char *full_path = M_GetScreenshotPath(format);
+    char *full_path = M_GetScreenshotPath(M_GetScreenshotFileExt(format));
     const bool result = Output_MakeScreenshot(full_path);
     Memory_FreePointer(&full_path);
 
     return result;
 }
+
+char *Screenshot_GetRecordingPath(void)
+{
+    File_CreateDirectory(SCREENSHOTS_DIR);
+    return M_GetScreenshotPath("mp4");
+}
@@ -1,6 +1,7 @@
 #include "vector.h"
 
 #include "debug.h"
+#include "frame_arena.h"
 #include "memory.h"
 
 #include <stdbool.h>
@@ -118,13 +119,14 @@ void Vector_Swap(
         return;
     }
     char *const items = P(vector).items;
-    void *tmp = Memory_Alloc(vector->item_size);
+    const FRAME_ARENA_MARK mark = FrameArena_GetMark();
+    void *const tmp = FrameArena_Alloc(vector->item_size);
     memcpy(tmp, items + index1 * vector->item_size, vector->item_size);
     memcpy(
         items + index1 * vector->item_size, items + index2 * vector->item_size,
         vector->item_size);
     memcpy(items + index2 * vector->item_size, tmp, vector->item_size);
-    Memory_FreePointer(&tmp);
+    FrameArena_Release(mark);
 }
 
 bool Vector_Remove(VECTOR *const vector, const void *item)
@@ -155,7 +157,8 @@ void Vector_Reverse(VECTOR *const vector)
 {
     int32_t i = 0;
     int32_t j = vector->count - 1;
-    void *tmp = Memory_Alloc(vector->item_size);
+    const FRAME_ARENA_MARK mark = FrameArena_GetMark();
+    void *const tmp = FrameArena_Alloc(vector->item_size);
     char *const items = P(vector).items;
     for (; i < j; i++, j--) {
         memcpy(tmp, items + i * vector->item_size, vector->item_size);
@@ -164,7 +167,7 @@ void Vector_Reverse(VECTOR *const vector)
             vector->item_size);
         memcpy(items + j * vector->item_size, tmp, vector->item_size);
     }
-    Memory_FreePointer(&tmp);
+    FrameArena_Release(mark);
 }
 
 void Vector_Clear(VECTOR *const vector)
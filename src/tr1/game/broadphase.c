@@ -0,0 +1,360 @@
+#include "game/broadphase.h"
+
+#include "game/collide.h"
+#include "game/items.h"
+#include "global/const.h"
+#include "global/vars.h"
+
+#include <libtrx/memory.h>
+#include <libtrx/utils.h>
+
+#include <stdbool.h>
+#include <stdlib.h>
+
+#define CELL_SHIFT (WALL_SHIFT + 1)
+#define BUCKET_COUNT 1024
+#define NO_LINK (-1)
+
+typedef struct {
+    bool linked;
+    int32_t cell_x;
+    int32_t cell_z;
+    int32_t bucket;
+    int16_t prev;
+    int16_t next;
+    uint32_t stamp;
+    // position of the item in its room item list
+    int32_t order;
+} M_ITEM_NODE;
+
+typedef struct {
+    BROADPHASE_STATIC ref;
+    BOUNDS_32 bounds;
+    uint32_t stamp;
+} M_STATIC_ENTRY;
+
+typedef struct {
+    int32_t entry_idx;
+    int32_t next;
+} M_STATIC_LINK;
+
+static M_ITEM_NODE m_ItemNodes[MAX_ITEMS] = {};
+static int16_t m_ItemBuckets[BUCKET_COUNT];
+static bool m_ItemsDirty = true;
+// Items are put at the head of their room item list, so each new link gets
+// a smaller order than every item already listed.
+static int32_t m_NextOrder = 0;
+
+static struct {
+    M_STATIC_ENTRY *entries;
+    int32_t entry_count;
+    M_STATIC_LINK *links;
+    int32_t link_count;
+    int32_t link_capacity;
+    int32_t buckets[BUCKET_COUNT];
+    bool dirty;
+} m_Statics = { .dirty = true };
+
+static uint32_t m_QueryStamp = 0;
+
+static int32_t M_GetBucket(int32_t cell_x, int32_t cell_z);
+static void M_LinkItem(int16_t item_num);
+static void M_UnlinkItem(int16_t item_num);
+static void M_RebuildItems(void);
+static void M_RefreshItem(int16_t item_num);
+static void M_RefreshItems(void);
+static int32_t M_CompareItems(const void *a, const void *b);
+static void M_AddStaticLink(int32_t bucket, int32_t entry_idx);
+static void M_RebuildStatics(void);
+
+static int32_t M_GetBucket(const int32_t cell_x, const int32_t cell_z)
+{
+    const uint32_t hash =
+        ((uint32_t)cell_x * 73856093u) ^ ((uint32_t)cell_z * 19349663u);
+    return hash & (BUCKET_COUNT - 1);
+}
+
+static void M_LinkItem(const int16_t item_num)
+{
+    const ITEM *const item = &g_Items[item_num];
+    M_ITEM_NODE *const node = &m_ItemNodes[item_num];
+    node->linked = true;
+    node->cell_x = item->pos.x >> CELL_SHIFT;
+    node->cell_z = item->pos.z >> CELL_SHIFT;
+    node->bucket = M_GetBucket(node->cell_x, node->cell_z);
+    node->prev = NO_ITEM;
+    node->next = m_ItemBuckets[node->bucket];
+    if (node->next != NO_ITEM) {
+        m_ItemNodes[node->next].prev = item_num;
+    }
+    m_ItemBuckets[node->bucket] = item_num;
+}
+
+static void M_UnlinkItem(const int16_t item_num)
+{
+    M_ITEM_NODE *const node = &m_ItemNodes[item_num];
+    if (!node->linked) {
+        return;
+    }
+    if (node->prev != NO_ITEM) {
+        m_ItemNodes[node->prev].next = node->next;
+    } else {
+        m_ItemBuckets[node->bucket] = node->next;
+    }
+    if (node->next != NO_ITEM) {
+        m_ItemNodes[node->next].prev = node->prev;
+    }
+    node->linked = false;
+}
+
+static void M_RebuildItems(void)
+{
+    for (int32_t i = 0; i < BUCKET_COUNT; i++) {
+        m_ItemBuckets[i] = NO_ITEM;
+    }
+    for (int32_t i = 0; i < MAX_ITEMS; i++) {
+        m_ItemNodes[i].linked = false;
+    }
+
+    for (int32_t i = 0; i < g_RoomCount; i++) {
+        int32_t order = 0;
+        int16_t item_num = g_RoomInfo[i].item_num;
+        while (item_num != NO_ITEM) {
+            M_LinkItem(item_num);
+            m_ItemNodes[item_num].order = order++;
+            item_num = g_Items[item_num].next_item;
+        }
+    }
+    m_NextOrder = 0;
+    m_ItemsDirty = false;
+}
+
+static void M_RefreshItem(const int16_t item_num)
+{
+    const ITEM *const item = &g_Items[item_num];
+    const M_ITEM_NODE *const node = &m_ItemNodes[item_num];
+    if (node->linked
+        && (node->cell_x != item->pos.x >> CELL_SHIFT
+            || node->cell_z != item->pos.z >> CELL_SHIFT)) {
+        M_UnlinkItem(item_num);
+        M_LinkItem(item_num);
+    }
+}
+
+static void M_RefreshItems(void)
+{
+    if (m_ItemsDirty) {
+        M_RebuildItems();
+    }
+
+    // Items move in their own control routines, so only the active ones can
+    // have left their cell since the last query. Code that moves any other
+    // item calls Broadphase_MoveItem.
+    int16_t item_num = g_NextItemActive;
+    while (item_num != NO_ITEM) {
+        M_RefreshItem(item_num);
+        item_num = g_Items[item_num].next_active;
+    }
+}
+
+static int32_t M_CompareItems(const void *const a, const void *const b)
+{
+    const int16_t item_num_a = *(const int16_t *)a;
+    const int16_t item_num_b = *(const int16_t *)b;
+    const int32_t order_a = m_ItemNodes[item_num_a].order;
+    const int32_t order_b = m_ItemNodes[item_num_b].order;
+    if (order_a != order_b) {
+        return order_a - order_b;
+    }
+    return item_num_a - item_num_b;
+}
+
+static void M_AddStaticLink(const int32_t bucket, const int32_t entry_idx)
+{
+    if (m_Statics.link_count == m_Statics.link_capacity) {
+        m_Statics.link_capacity = MAX(64, m_Statics.link_capacity * 2);
+        m_Statics.links = Memory_Realloc(
+            m_Statics.links, sizeof(M_STATIC_LINK) * m_Statics.link_capacity);
+    }
+    M_STATIC_LINK *const link = &m_Statics.links[m_Statics.link_count];
+    link->entry_idx = entry_idx;
+    link->next = m_Statics.buckets[bucket];
+    m_Statics.buckets[bucket] = m_Statics.link_count++;
+}
+
+static void M_RebuildStatics(void)
+{
+    for (int32_t i = 0; i < BUCKET_COUNT; i++) {
+        m_Statics.buckets[i] = NO_LINK;
+    }
+    m_Statics.link_count = 0;
+
+    int32_t total = 0;
+    for (int32_t i = 0; i < g_RoomCount; i++) {
+        total += g_RoomInfo[i].num_static_meshes;
+    }
+    m_Statics.entries =
+        Memory_Realloc(m_Statics.entries, sizeof(M_STATIC_ENTRY) * total);
+    m_Statics.entry_count = 0;
+
+    for (int32_t i = 0; i < g_RoomCount; i++) {
+        const ROOM *const r = &g_RoomInfo[i];
+        for (int32_t j = 0; j < r->num_static_meshes; j++) {
+            const STATIC_MESH *const mesh = &r->static_meshes[j];
+            const STATIC_INFO *const sinfo = &g_StaticObjects[mesh->static_num];
+            if (sinfo->flags & SMF_NON_COLLIDABLE) {
+                continue;
+            }
+
+            const int32_t entry_idx = m_Statics.entry_count++;
+            M_STATIC_ENTRY *const entry = &m_Statics.entries[entry_idx];
+            entry->ref.room_num = i;
+            entry->ref.mesh_idx = j;
+            entry->bounds = Collide_GetStaticMeshBounds(mesh);
+            entry->stamp = 0;
+
+            const int32_t min_cell_x = entry->bounds.min.x >> CELL_SHIFT;
+            const int32_t max_cell_x = entry->bounds.max.x >> CELL_SHIFT;
+            const int32_t min_cell_z = entry->bounds.min.z >> CELL_SHIFT;
+            const int32_t max_cell_z = entry->bounds.max.z >> CELL_SHIFT;
+            for (int32_t cx = min_cell_x; cx <= max_cell_x; cx++) {
+                for (int32_t cz = min_cell_z; cz <= max_cell_z; cz++) {
+                    M_AddStaticLink(M_GetBucket(cx, cz), entry_idx);
+                }
+            }
+        }
+    }
+    m_Statics.dirty = false;
+}
+
+void Broadphase_Reset(void)
+{
+    Memory_FreePointer(&m_Statics.entries);
+    Memory_FreePointer(&m_Statics.links);
+    m_Statics.entry_count = 0;
+    m_Statics.link_count = 0;
+    m_Statics.link_capacity = 0;
+    m_Statics.dirty = true;
+    m_ItemsDirty = true;
+}
+
+void Broadphase_Invalidate(void)
+{
+    m_ItemsDirty = true;
+}
+
+void Broadphase_InvalidateStatics(void)
+{
+    m_Statics.dirty = true;
+}
+
+void Broadphase_UpdateItem(const int16_t item_num)
+{
+    if (m_ItemsDirty) {
+        return;
+    }
+    M_UnlinkItem(item_num);
+    M_LinkItem(item_num);
+    m_ItemNodes[item_num].order = --m_NextOrder;
+}
+
+void Broadphase_MoveItem(const int16_t item_num)
+{
+    if (m_ItemsDirty) {
+        return;
+    }
+    M_RefreshItem(item_num);
+}
+
+void Broadphase_RemoveItem(const int16_t item_num)
+{
+    if (m_ItemsDirty) {
+        return;
+    }
+    M_UnlinkItem(item_num);
+}
+
+int32_t Broadphase_QueryItems(
+    const BOUNDS_32 *const bounds, int16_t *const item_nums,
+    const int32_t max_count)
+{
+    M_RefreshItems();
+    m_QueryStamp++;
+
+    const int32_t min_cell_x = bounds->min.x >> CELL_SHIFT;
+    const int32_t max_cell_x = bounds->max.x >> CELL_SHIFT;
+    const int32_t min_cell_z = bounds->min.z >> CELL_SHIFT;
+    const int32_t max_cell_z = bounds->max.z >> CELL_SHIFT;
+
+    int32_t count = 0;
+    for (int32_t cx = min_cell_x; cx <= max_cell_x; cx++) {
+        for (int32_t cz = min_cell_z; cz <= max_cell_z; cz++) {
+            int16_t item_num = m_ItemBuckets[M_GetBucket(cx, cz)];
+            while (item_num != NO_ITEM) {
+                M_ITEM_NODE *const node = &m_ItemNodes[item_num];
+                const ITEM *const item = &g_Items[item_num];
+                if (node->stamp != m_QueryStamp
+                    && item->pos.x >= bounds->min.x
+                    && item->pos.x <= bounds->max.x
+                    && item->pos.y >= bounds->min.y
+                    && item->pos.y <= bounds->max.y
+                    && item->pos.z >= bounds->min.z
+                    && item->pos.z <= bounds->max.z) {
+                    node->stamp = m_QueryStamp;
+                    if (count < max_count) {
+                        item_nums[count] = item_num;
+                    }
+                    count++;
+                }
+                item_num = node->next;
+            }
+        }
+    }
+
+    if (count <= max_count) {
+        qsort(item_nums, count, sizeof(int16_t), M_CompareItems);
+    }
+    return count;
+}
+
+int32_t Broadphase_QueryStatics(
+    const BOUNDS_32 *const bounds, BROADPHASE_STATIC *const statics,
+    const int32_t max_count)
+{
+    if (m_Statics.dirty) {
+        M_RebuildStatics();
+    }
+    m_QueryStamp++;
+
+    const int32_t min_cell_x = bounds->min.x >> CELL_SHIFT;
+    const int32_t max_cell_x = bounds->max.x >> CELL_SHIFT;
+    const int32_t min_cell_z = bounds->min.z >> CELL_SHIFT;
+    const int32_t max_cell_z = bounds->max.z >> CELL_SHIFT;
+
+    int32_t count = 0;
+    for (int32_t cx = min_cell_x; cx <= max_cell_x; cx++) {
+        for (int32_t cz = min_cell_z; cz <= max_cell_z; cz++) {
+            int32_t link_idx = m_Statics.buckets[M_GetBucket(cx, cz)];
+            while (link_idx != NO_LINK) {
+                const M_STATIC_LINK *const link = &m_Statics.links[link_idx];
+                M_STATIC_ENTRY *const entry =
+                    &m_Statics.entries[link->entry_idx];
+                if (entry->stamp != m_QueryStamp
+                    && entry->bounds.min.x <= bounds->max.x
+                    && entry->bounds.max.x >= bounds->min.x
+                    && entry->bounds.min.y <= bounds->max.y
+                    && entry->bounds.max.y >= bounds->min.y
+                    && entry->bounds.min.z <= bounds->max.z
+                    && entry->bounds.max.z >= bounds->min.z) {
+                    entry->stamp = m_QueryStamp;
+                    if (count < max_count) {
+                        statics[count] = entry->ref;
+                    }
+                    count++;
+                }
+                link_idx = link->next;
+            }
+        }
+    }
+    return count;
+}
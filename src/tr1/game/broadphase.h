@@ -0,0 +1,41 @@
+#pragma once
+
+#include "global/types.h"
+
+#include <stdint.h>
+
+// Uniform grid over item positions and static mesh bounds, used to narrow
+// down the candidates of item and static collision tests. Room membership is
+// not checked here; callers still filter the results by the rooms they are
+// interested in.
+
+typedef struct {
+    int16_t room_num;
+    int16_t mesh_idx;
+} BROADPHASE_STATIC;
+
+// Drops the whole grid; call whenever a new level is loaded.
+void Broadphase_Reset(void);
+// Rebuilds the item cells on the next query, for when many items were moved
+// at once (eg. after loading a savegame).
+void Broadphase_Invalidate(void);
+// Rebuilds the static cells on the next query, for when the room static
+// meshes change (eg. after flipping the map).
+void Broadphase_InvalidateStatics(void);
+
+// Keeps the grid in sync with the room item lists. Call UpdateItem right
+// after putting the item at the head of a room item list.
+void Broadphase_UpdateItem(int16_t item_num);
+void Broadphase_RemoveItem(int16_t item_num);
+// Active items are picked up by the next query on their own; call this after
+// moving an item that is not active.
+void Broadphase_MoveItem(int16_t item_num);
+
+// Both queries return the total number of candidates, which may exceed
+// max_count; only the first max_count candidates are written. When all of
+// them fit, item candidates from the same room come in the order of that
+// room's item list.
+int32_t Broadphase_QueryItems(
+    const BOUNDS_32 *bounds, int16_t *item_nums, int32_t max_count);
+int32_t Broadphase_QueryStatics(
+    const BOUNDS_32 *bounds, BROADPHASE_STATIC *statics, int32_t max_count);
@@ -1,5 +1,6 @@
 #include "game/carrier.h"
 
+#include "game/broadphase.h"
 #include "game/gameflow.h"
 #include "game/inventory.h"
 #include "game/items.h"
@@ -312,6 +313,7 @@ void Carrier_TestItemDrops(const int16_t item_num)
             pickup->pos = carrier->pos;
             pickup->rot = carrier->rot;
             pickup->status = IS_INACTIVE;
+            Broadphase_MoveItem(item->spawn_num);
         }
 
         item->status = DS_FALLING;
@@ -325,6 +327,7 @@ void Carrier_TestItemDrops(const int16_t item_num)
             if (pickup->room_num != item->room_num) {
                 Item_NewRoom(item->spawn_num, item->room_num);
             }
+            Broadphase_MoveItem(item->spawn_num);
         }
 
     } while ((item = item->next_item));
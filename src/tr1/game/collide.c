@@ -1,5 +1,6 @@
 #include "game/collide.h"
 
+#include "game/broadphase.h"
 #include "game/items.h"
 #include "game/output.h"
 #include "game/room.h"
@@ -10,8 +11,278 @@
 
 #include <libtrx/config.h>
 #include <libtrx/game/math.h>
+#include <libtrx/memory.h>
 #include <libtrx/utils.h>
 
+#include <stdlib.h>
+#include <string.h>
+
+// Item-relative bone matrices of the last pose computed for an item. The pose
+// only depends on the item rotation, its current frame and its extra bone
+// rotations, so it stays valid until one of those changes; the item position
+// is added by the readers.
+typedef struct {
+    GAME_OBJECT_ID object_id;
+    int32_t mesh_count;
+    const ANIM_FRAME *frame;
+    XYZ_16 rot;
+    bool has_extra_rotation;
+    int32_t extra_rotation_count;
+    int16_t *extra_rotation;
+    MATRIX *matrices;
+} M_POSE;
+
+static struct {
+    BROADPHASE_STATIC *data;
+    int32_t capacity;
+} m_StaticCandidates = {};
+
+static M_POSE *m_Poses[MAX_ITEMS] = {};
+static M_POSE m_TempPose = {};
+static COLLIDE_POSE_STATS m_PoseStats = {};
+static COLLIDE_POSE_STATS m_PoseStatsCurrent = {};
+
+static int32_t M_CompareStaticCandidates(const void *a, const void *b);
+static int32_t M_GetStaticCandidates(const BOUNDS_32 *bounds);
+static void M_FreePose(M_POSE *pose);
+static int32_t M_CountExtraRotations(const OBJECT *object);
+static bool M_IsPoseValid(const M_POSE *pose, const ITEM *item);
+static void M_ComputePose(M_POSE *pose, const ITEM *item);
+static const M_POSE *M_GetPose(const ITEM *item);
+static XYZ_32 M_GetPosePoint(
+    const M_POSE *pose, int32_t mesh_idx, int32_t x, int32_t y, int32_t z);
+static int32_t M_GetViewSpheres(const ITEM *item, SPHERE *ptr);
+
+static int32_t M_CompareStaticCandidates(
+    const void *const a, const void *const b)
+{
+    const BROADPHASE_STATIC *const static_a = a;
+    const BROADPHASE_STATIC *const static_b = b;
+    if (static_a->room_num != static_b->room_num) {
+        return static_a->room_num - static_b->room_num;
+    }
+    return static_a->mesh_idx - static_b->mesh_idx;
+}
+
+static int32_t M_GetStaticCandidates(const BOUNDS_32 *const bounds)
+{
+    int32_t count = Broadphase_QueryStatics(
+        bounds, m_StaticCandidates.data, m_StaticCandidates.capacity);
+    if (count > m_StaticCandidates.capacity) {
+        m_StaticCandidates.capacity = count;
+        m_StaticCandidates.data = Memory_Realloc(
+            m_StaticCandidates.data, sizeof(BROADPHASE_STATIC) * count);
+        count = Broadphase_QueryStatics(
+            bounds, m_StaticCandidates.data, m_StaticCandidates.capacity);
+    }
+
+    // keep the original room and mesh order so that the first static hit
+    // stays the same
+    qsort(
+        m_StaticCandidates.data, count, sizeof(BROADPHASE_STATIC),
+        M_CompareStaticCandidates);
+    return count;
+}
+
+static void M_FreePose(M_POSE *const pose)
+{
+    Memory_FreePointer(&pose->extra_rotation);
+    Memory_FreePointer(&pose->matrices);
+    pose->mesh_count = 0;
+    pose->frame = NULL;
+}
+
+static int32_t M_CountExtraRotations(const OBJECT *const object)
+{
+    int32_t count = 0;
+    for (int32_t i = 1; i < object->mesh_count; i++) {
+        const ANIM_BONE *const bone = Object_GetBone(object, i - 1);
+        count += bone->rot_x + bone->rot_y + bone->rot_z;
+    }
+    return count;
+}
+
+static bool M_IsPoseValid(const M_POSE *const pose, const ITEM *const item)
+{
+    if (pose->frame == NULL || pose->object_id != item->object_id
+        || pose->frame != Item_GetBestFrame(item)
+        || pose->rot.x != item->rot.x || pose->rot.y != item->rot.y
+        || pose->rot.z != item->rot.z
+        || pose->has_extra_rotation != (item->data != NULL)) {
+        return false;
+    }
+    return !pose->has_extra_rotation
+        || !memcmp(
+               pose->extra_rotation, item->data,
+               pose->extra_rotation_count * sizeof(int16_t));
+}
+
+static void M_ComputePose(M_POSE *const pose, const ITEM *const item)
+{
+    const OBJECT *const object = &g_Objects[item->object_id];
+    if (pose->object_id != item->object_id
+        || pose->mesh_count != object->mesh_count) {
+        M_FreePose(pose);
+        pose->object_id = item->object_id;
+        pose->mesh_count = object->mesh_count;
+        pose->extra_rotation_count = M_CountExtraRotations(object);
+        pose->extra_rotation =
+            Memory_Alloc(sizeof(int16_t) * pose->extra_rotation_count);
+        pose->matrices = Memory_Alloc(sizeof(MATRIX) * pose->mesh_count);
+    }
+
+    const ANIM_FRAME *const frame = Item_GetBestFrame(item);
+    pose->frame = frame;
+    pose->rot = item->rot;
+    pose->has_extra_rotation = item->data != NULL;
+    if (pose->has_extra_rotation) {
+        memcpy(
+            pose->extra_rotation, item->data,
+            pose->extra_rotation_count * sizeof(int16_t));
+    }
+
+    Matrix_PushUnit();
+    Matrix_RotYXZ(item->rot.y, item->rot.x, item->rot.z);
+    Matrix_TranslateRel(frame->offset.x, frame->offset.y, frame->offset.z);
+    Matrix_RotXYZ16(&frame->mesh_rots[0]);
+    pose->matrices[0] = *g_MatrixPtr;
+
+    const int16_t *extra_rotation = pose->extra_rotation;
+    for (int32_t i = 1; i < object->mesh_count; i++) {
+        const ANIM_BONE *const bone = Object_GetBone(object, i - 1);
+        if (bone->matrix_pop) {
+            Matrix_Pop();
+        }
+        if (bone->matrix_push) {
+            Matrix_Push();
+        }
+
+        Matrix_TranslateRel(bone->pos.x, bone->pos.y, bone->pos.z);
+        Matrix_RotXYZ16(&frame->mesh_rots[i]);
+
+        if (pose->has_extra_rotation) {
+            if (bone->rot_y) {
+                Matrix_RotY(*extra_rotation++);
+            }
+            if (bone->rot_x) {
+                Matrix_RotX(*extra_rotation++);
+            }
+            if (bone->rot_z) {
+                Matrix_RotZ(*extra_rotation++);
+            }
+        }
+
+        pose->matrices[i] = *g_MatrixPtr;
+    }
+
+    Matrix_Pop();
+}
+
+static const M_POSE *M_GetPose(const ITEM *const item)
+{
+    M_POSE *pose = &m_TempPose;
+    if (g_Items != NULL && item >= g_Items && item < g_Items + MAX_ITEMS) {
+        const int32_t item_num = item - g_Items;
+        if (m_Poses[item_num] == NULL) {
+            m_Poses[item_num] = Memory_Alloc(sizeof(M_POSE));
+        }
+        pose = m_Poses[item_num];
+        if (M_IsPoseValid(pose, item)) {
+            m_PoseStatsCurrent.reused++;
+            return pose;
+        }
+    }
+
+    m_PoseStatsCurrent.computed++;
+    M_ComputePose(pose, item);
+    return pose;
+}
+
+static XYZ_32 M_GetPosePoint(
+    const M_POSE *const pose, const int32_t mesh_idx, const int32_t x,
+    const int32_t y, const int32_t z)
+{
+    // go through the matrix stack so that the result matches a full walk of
+    // the hierarchy bit for bit
+    Matrix_Push();
+    *g_MatrixPtr = pose->matrices[mesh_idx];
+    Matrix_TranslateRel(x, y, z);
+    const XYZ_32 result = {
+        .x = g_MatrixPtr->_03 >> W2V_SHIFT,
+        .y = g_MatrixPtr->_13 >> W2V_SHIFT,
+        .z = g_MatrixPtr->_23 >> W2V_SHIFT,
+    };
+    Matrix_Pop();
+    return result;
+}
+
+static int32_t M_GetViewSpheres(const ITEM *const item, SPHERE *ptr)
+{
+    // View-space spheres are built on top of the world-to-view matrix, which
+    // rounds differently from an item-relative pose, so they cannot be taken
+    // from the cache.
+    Matrix_Push();
+    Matrix_TranslateAbs(item->pos.x, item->pos.y, item->pos.z);
+    Matrix_RotYXZ(item->rot.y, item->rot.x, item->rot.z);
+
+    const ANIM_FRAME *const frame = Item_GetBestFrame(item);
+    Matrix_TranslateRel(frame->offset.x, frame->offset.y, frame->offset.z);
+
+    Matrix_RotXYZ16(&frame->mesh_rots[0]);
+
+    const OBJECT *const object = &g_Objects[item->object_id];
+    const OBJECT_MESH *mesh = Object_GetMesh(object->mesh_idx);
+
+    Matrix_Push();
+    Matrix_TranslateRel(mesh->center.x, mesh->center.y, mesh->center.z);
+    ptr->x = g_MatrixPtr->_03 >> W2V_SHIFT;
+    ptr->y = g_MatrixPtr->_13 >> W2V_SHIFT;
+    ptr->z = g_MatrixPtr->_23 >> W2V_SHIFT;
+    ptr->r = mesh->radius;
+    ptr++;
+    Matrix_Pop();
+
+    const int16_t *extra_rotation = (int16_t *)item->data;
+    for (int32_t i = 1; i < object->mesh_count; i++) {
+        const ANIM_BONE *const bone = Object_GetBone(object, i - 1);
+        if (bone->matrix_pop) {
+            Matrix_Pop();
+        }
+        if (bone->matrix_push) {
+            Matrix_Push();
+        }
+
+        Matrix_TranslateRel(bone->pos.x, bone->pos.y, bone->pos.z);
+        Matrix_RotXYZ16(&frame->mesh_rots[i]);
+
+        if (extra_rotation != NULL) {
+            if (bone->rot_y) {
+                Matrix_RotY(*extra_rotation++);
+            }
+            if (bone->rot_x) {
+                Matrix_RotX(*extra_rotation++);
+            }
+            if (bone->rot_z) {
+                Matrix_RotZ(*extra_rotation++);
+            }
+        }
+
+        mesh = Object_GetMesh(object->mesh_idx + i);
+        Matrix_Push();
+        Matrix_TranslateRel(mesh->center.x, mesh->center.y, mesh->center.z);
+        ptr->x = g_MatrixPtr->_03 >> W2V_SHIFT;
+        ptr->y = g_MatrixPtr->_13 >> W2V_SHIFT;
+        ptr->z = g_MatrixPtr->_23 >> W2V_SHIFT;
+        ptr->r = mesh->radius;
+        Matrix_Pop();
+
+        ptr++;
+    }
+
+    Matrix_Pop();
+    return object->mesh_count;
+}
+
 void Collide_GetCollisionInfo(
     COLL_INFO *coll, int32_t xpos, int32_t ypos, int32_t zpos, int16_t room_num,
     int32_t obj_height)
@@ -338,54 +609,34 @@ bool Collide_CollideStaticObjects(
     shifter.y = 0;
     shifter.z = 0;
 
-    Room_GetNearByRooms(x, y, z, coll->radius + 50, height + 50, room_num);
+    COLLISION_QUERY query;
+    Room_GetNearbyRooms(
+        &query, x, y, z, coll->radius + 50, height + 50, room_num);
+
+    const BOUNDS_32 bounds = {
+        .min = { .x = inxmin, .y = inymin, .z = inzmin },
+        .max = { .x = inxmax, .y = inymax, .z = inzmax },
+    };
+    const int32_t candidate_count = M_GetStaticCandidates(&bounds);
 
-    for (int i = 0; i < g_RoomsToDrawCount; i++) {
-        int16_t room_num = g_RoomsToDraw[i];
+    for (int i = 0; i < query.room_count; i++) {
+        int16_t room_num = query.room_nums[i];
         ROOM *r = &g_RoomInfo[room_num];
 
-        for (int j = 0; j < r->num_static_meshes; j++) {
-            const STATIC_MESH *const mesh = &r->static_meshes[j];
-            const STATIC_INFO *const sinfo = &g_StaticObjects[mesh->static_num];
-            if (sinfo->flags & SMF_NON_COLLIDABLE) {
+        for (int j = 0; j < candidate_count; j++) {
+            if (m_StaticCandidates.data[j].room_num != room_num) {
                 continue;
             }
 
-            int32_t ymin = mesh->pos.y + sinfo->c.min.y;
-            int32_t ymax = mesh->pos.y + sinfo->c.max.y;
-            int32_t xmin;
-            int32_t xmax;
-            int32_t zmin;
-            int32_t zmax;
-            switch (mesh->rot.y) {
-            case PHD_90:
-                xmin = mesh->pos.x + sinfo->c.min.z;
-                xmax = mesh->pos.x + sinfo->c.max.z;
-                zmin = mesh->pos.z - sinfo->c.max.x;
-                zmax = mesh->pos.z - sinfo->c.min.x;
-                break;
-
-            case -PHD_180:
-                xmin = mesh->pos.x - sinfo->c.max.x;
-                xmax = mesh->pos.x - sinfo->c.min.x;
-                zmin = mesh->pos.z - sinfo->c.max.z;
-                zmax = mesh->pos.z - sinfo->c.min.z;
-                break;
-
-            case -PHD_90:
-                xmin = mesh->pos.x - sinfo->c.max.z;
-                xmax = mesh->pos.x - sinfo->c.min.z;
-                zmin = mesh->pos.z + sinfo->c.min.x;
-                zmax = mesh->pos.z + sinfo->c.max.x;
-                break;
-
-            default:
-                xmin = mesh->pos.x + sinfo->c.min.x;
-                xmax = mesh->pos.x + sinfo->c.max.x;
-                zmin = mesh->pos.z + sinfo->c.min.z;
-                zmax = mesh->pos.z + sinfo->c.max.z;
-                break;
-            }
+            const STATIC_MESH *const mesh =
+                &r->static_meshes[m_StaticCandidates.data[j].mesh_idx];
+            const BOUNDS_32 mesh_bounds = Collide_GetStaticMeshBounds(mesh);
+            const int32_t xmin = mesh_bounds.min.x;
+            const int32_t xmax = mesh_bounds.max.x;
+            const int32_t ymin = mesh_bounds.min.y;
+            const int32_t ymax = mesh_bounds.max.y;
+            const int32_t zmin = mesh_bounds.min.z;
+            const int32_t zmax = mesh_bounds.max.z;
 
             if (inxmax <= xmin || inxmin >= xmax || inymax <= ymin
                 || inymin >= ymax || inzmax <= zmin || inzmin >= zmax) {
@@ -485,86 +736,95 @@ bool Collide_CollideStaticObjects(
     return false;
 }
 
-int32_t Collide_GetSpheres(ITEM *item, SPHERE *ptr, int32_t world_space)
+void Collide_ResetPoseCache(void)
 {
-    if (!item) {
-        return 0;
+    for (int32_t i = 0; i < MAX_ITEMS; i++) {
+        if (m_Poses[i] != NULL) {
+            M_FreePose(m_Poses[i]);
+            Memory_FreePointer(&m_Poses[i]);
+        }
     }
+    M_FreePose(&m_TempPose);
+    m_PoseStats = (COLLIDE_POSE_STATS) {};
+    m_PoseStatsCurrent = (COLLIDE_POSE_STATS) {};
+}
 
-    int32_t x;
-    int32_t y;
-    int32_t z;
-    if (world_space) {
-        x = item->pos.x;
-        y = item->pos.y;
-        z = item->pos.z;
-        Matrix_PushUnit();
-    } else {
-        x = 0;
-        y = 0;
-        z = 0;
-        Matrix_Push();
-        Matrix_TranslateAbs(item->pos.x, item->pos.y, item->pos.z);
-    }
+void Collide_BeginPoseFrame(void)
+{
+    m_PoseStats = m_PoseStatsCurrent;
+    m_PoseStatsCurrent = (COLLIDE_POSE_STATS) {};
+}
 
-    Matrix_RotYXZ(item->rot.y, item->rot.x, item->rot.z);
+const COLLIDE_POSE_STATS *Collide_GetPoseStats(void)
+{
+    return &m_PoseStats;
+}
 
-    const ANIM_FRAME *const frame = Item_GetBestFrame(item);
-    Matrix_TranslateRel(frame->offset.x, frame->offset.y, frame->offset.z);
+BOUNDS_32 Collide_GetStaticMeshBounds(const STATIC_MESH *const mesh)
+{
+    const STATIC_INFO *const sinfo = &g_StaticObjects[mesh->static_num];
+    BOUNDS_32 bounds = {
+        .min.y = mesh->pos.y + sinfo->c.min.y,
+        .max.y = mesh->pos.y + sinfo->c.max.y,
+    };
+
+    switch (mesh->rot.y) {
+    case PHD_90:
+        bounds.min.x = mesh->pos.x + sinfo->c.min.z;
+        bounds.max.x = mesh->pos.x + sinfo->c.max.z;
+        bounds.min.z = mesh->pos.z - sinfo->c.max.x;
+        bounds.max.z = mesh->pos.z - sinfo->c.min.x;
+        break;
 
-    Matrix_RotXYZ16(&frame->mesh_rots[0]);
+    case -PHD_180:
+        bounds.min.x = mesh->pos.x - sinfo->c.max.x;
+        bounds.max.x = mesh->pos.x - sinfo->c.min.x;
+        bounds.min.z = mesh->pos.z - sinfo->c.max.z;
+        bounds.max.z = mesh->pos.z - sinfo->c.min.z;
+        break;
 
-    OBJECT *object = &g_Objects[item->object_id];
-    const OBJECT_MESH *mesh = Object_GetMesh(object->mesh_idx);
+    case -PHD_90:
+        bounds.min.x = mesh->pos.x - sinfo->c.max.z;
+        bounds.max.x = mesh->pos.x - sinfo->c.min.z;
+        bounds.min.z = mesh->pos.z + sinfo->c.min.x;
+        bounds.max.z = mesh->pos.z + sinfo->c.max.x;
+        break;
 
-    Matrix_Push();
-    Matrix_TranslateRel(mesh->center.x, mesh->center.y, mesh->center.z);
-    ptr->x = x + (g_MatrixPtr->_03 >> W2V_SHIFT);
-    ptr->y = y + (g_MatrixPtr->_13 >> W2V_SHIFT);
-    ptr->z = z + (g_MatrixPtr->_23 >> W2V_SHIFT);
-    ptr->r = mesh->radius;
-    ptr++;
-    Matrix_Pop();
+    default:
+        bounds.min.x = mesh->pos.x + sinfo->c.min.x;
+        bounds.max.x = mesh->pos.x + sinfo->c.max.x;
+        bounds.min.z = mesh->pos.z + sinfo->c.min.z;
+        bounds.max.z = mesh->pos.z + sinfo->c.max.z;
+        break;
+    }
 
-    const int16_t *extra_rotation = (int16_t *)item->data;
-    for (int32_t i = 1; i < object->mesh_count; i++) {
-        const ANIM_BONE *const bone = Object_GetBone(object, i - 1);
-        if (bone->matrix_pop) {
-            Matrix_Pop();
-        }
-        if (bone->matrix_push) {
-            Matrix_Push();
-        }
+    return bounds;
+}
 
-        Matrix_TranslateRel(bone->pos.x, bone->pos.y, bone->pos.z);
-        Matrix_RotXYZ16(&frame->mesh_rots[i]);
+int32_t Collide_GetSpheres(ITEM *item, SPHERE *ptr, int32_t world_space)
+{
+    if (!item) {
+        return 0;
+    }
 
-        if (extra_rotation != NULL) {
-            if (bone->rot_y) {
-                Matrix_RotY(*extra_rotation++);
-            }
-            if (bone->rot_x) {
-                Matrix_RotX(*extra_rotation++);
-            }
-            if (bone->rot_z) {
-                Matrix_RotZ(*extra_rotation++);
-            }
-        }
+    if (!world_space) {
+        return M_GetViewSpheres(item, ptr);
+    }
 
-        mesh = Object_GetMesh(object->mesh_idx + i);
-        Matrix_Push();
-        Matrix_TranslateRel(mesh->center.x, mesh->center.y, mesh->center.z);
-        ptr->x = x + (g_MatrixPtr->_03 >> W2V_SHIFT);
-        ptr->y = y + (g_MatrixPtr->_13 >> W2V_SHIFT);
-        ptr->z = z + (g_MatrixPtr->_23 >> W2V_SHIFT);
+    const M_POSE *const pose = M_GetPose(item);
+    for (int32_t i = 0; i < pose->mesh_count; i++) {
+        const OBJECT_MESH *const mesh =
+            Object_GetMesh(g_Objects[item->object_id].mesh_idx + i);
+        const XYZ_32 center = M_GetPosePoint(
+            pose, i, mesh->center.x, mesh->center.y, mesh->center.z);
+        ptr->x = item->pos.x + center.x;
+        ptr->y = item->pos.y + center.y;
+        ptr->z = item->pos.z + center.z;
         ptr->r = mesh->radius;
-        Matrix_Pop();
-
         ptr++;
     }
 
-    Matrix_Pop();
-    return object->mesh_count;
+    return pose->mesh_count;
 }
 
 int32_t Collide_TestCollision(ITEM *item, ITEM *lara_item)
@@ -605,44 +865,10 @@ int32_t Collide_TestCollision(ITEM *item, ITEM *lara_item)
 
 void Collide_GetJointAbsPosition(ITEM *item, XYZ_32 *vec, int32_t joint)
 {
-    OBJECT *object = &g_Objects[item->object_id];
-
-    Matrix_PushUnit();
-    Matrix_RotYXZ(item->rot.y, item->rot.x, item->rot.z);
-
-    const ANIM_FRAME *const frame = Item_GetBestFrame(item);
-    Matrix_TranslateRel(frame->offset.x, frame->offset.y, frame->offset.z);
-
-    Matrix_RotXYZ16(&frame->mesh_rots[0]);
-
-    int16_t *extra_rotation = (int16_t *)item->data;
-    const int32_t abs_joint = MIN(object->mesh_count, joint);
-    for (int32_t i = 0; i < abs_joint; i++) {
-        const ANIM_BONE *const bone = Object_GetBone(object, i);
-        if (bone->matrix_pop) {
-            Matrix_Pop();
-        }
-        if (bone->matrix_push) {
-            Matrix_Push();
-        }
-
-        Matrix_TranslateRel(bone->pos.x, bone->pos.y, bone->pos.z);
-        Matrix_RotXYZ16(&frame->mesh_rots[i + 1]);
-
-        if (bone->rot_y) {
-            Matrix_RotY(*extra_rotation++);
-        }
-        if (bone->rot_x) {
-            Matrix_RotX(*extra_rotation++);
-        }
-        if (bone->rot_z) {
-            Matrix_RotZ(*extra_rotation++);
-        }
-    }
-
-    Matrix_TranslateRel(vec->x, vec->y, vec->z);
-    vec->x = (g_MatrixPtr->_03 >> W2V_SHIFT) + item->pos.x;
-    vec->y = (g_MatrixPtr->_13 >> W2V_SHIFT) + item->pos.y;
-    vec->z = (g_MatrixPtr->_23 >> W2V_SHIFT) + item->pos.z;
-    Matrix_Pop();
+    const M_POSE *const pose = M_GetPose(item);
+    const int32_t abs_joint = MAX(0, MIN(pose->mesh_count - 1, joint));
+    const XYZ_32 pos = M_GetPosePoint(pose, abs_joint, vec->x, vec->y, vec->z);
+    vec->x = pos.x + item->pos.x;
+    vec->y = pos.y + item->pos.y;
+    vec->z = pos.z + item->pos.z;
 }
@@ -5,6 +5,13 @@
 #include <stdbool.h>
 #include <stdint.h>
 
+typedef struct {
+    // poses served from the cache without walking the bone hierarchy
+    int32_t reused;
+    // poses that had to be recomputed
+    int32_t computed;
+} COLLIDE_POSE_STATS;
+
 void Collide_GetCollisionInfo(
     COLL_INFO *coll, int32_t xpos, int32_t ypos, int32_t zpos, int16_t room_num,
     int32_t objheight);
@@ -13,6 +20,16 @@ bool Collide_CollideStaticObjects(
     COLL_INFO *coll, int32_t x, int32_t y, int32_t z, int16_t room_num,
     int32_t height);
 
+// Returns the world space collision box of a room static mesh.
+BOUNDS_32 Collide_GetStaticMeshBounds(const STATIC_MESH *mesh);
+
+// Drops every cached item pose; call whenever the item array is reloaded.
+void Collide_ResetPoseCache(void);
+// Publishes the pose cache counters gathered during the previous frame.
+void Collide_BeginPoseFrame(void);
+// Counters of the previous frame, shown by /posestats.
+const COLLIDE_POSE_STATS *Collide_GetPoseStats(void);
+
 int32_t Collide_GetSpheres(ITEM *item, SPHERE *slist, int32_t world_space);
 
 int32_t Collide_TestCollision(ITEM *item, ITEM *lara_item);
@@ -0,0 +1,25 @@
+#include "game/console/cmd/los_stats.h"
+
+#include "game/game_string.h"
+#include "game/los.h"
+
+#include <libtrx/strings.h>
+
+static COMMAND_RESULT M_Entrypoint(const COMMAND_CONTEXT *ctx);
+
+static COMMAND_RESULT M_Entrypoint(const COMMAND_CONTEXT *const ctx)
+{
+    if (!String_Equivalent(ctx->args, "")) {
+        return CR_BAD_INVOCATION;
+    }
+
+    const LOS_CACHE_STATS *const stats = LOS_GetCacheStats();
+    Console_Log(
+        GS(OSD_LOS_STATS), stats->hits, stats->misses, stats->uncached);
+    return CR_SUCCESS;
+}
+
+CONSOLE_COMMAND g_Console_Cmd_LOSStats = {
+    .prefix = "los-?stats",
+    .proc = M_Entrypoint,
+};
@@ -0,0 +1,24 @@
+#include "game/console/cmd/pose_stats.h"
+
+#include "game/collide.h"
+#include "game/game_string.h"
+
+#include <libtrx/strings.h>
+
+static COMMAND_RESULT M_Entrypoint(const COMMAND_CONTEXT *ctx);
+
+static COMMAND_RESULT M_Entrypoint(const COMMAND_CONTEXT *const ctx)
+{
+    if (!String_Equivalent(ctx->args, "")) {
+        return CR_BAD_INVOCATION;
+    }
+
+    const COLLIDE_POSE_STATS *const stats = Collide_GetPoseStats();
+    Console_Log(GS(OSD_POSE_STATS), stats->reused, stats->computed);
+    return CR_SUCCESS;
+}
+
+CONSOLE_COMMAND g_Console_Cmd_PoseStats = {
+    .prefix = "pose-?stats",
+    .proc = M_Entrypoint,
+};
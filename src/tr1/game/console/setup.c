@@ -1,7 +1,10 @@
 #include "game/console/setup.h"
 
 #include "game/console/cmd/easy_config.h"
+#include "game/console/cmd/los_stats.h"
+#include "game/console/cmd/pose_stats.h"
 
+#include <libtrx/game/console/cmd/audio_stats.h>
 #include <libtrx/game/console/cmd/config.h>
 #include <libtrx/game/console/cmd/die.h>
 #include <libtrx/game/console/cmd/end_level.h>
@@ -13,9 +16,12 @@
 #include <libtrx/game/console/cmd/heal.h>
 #include <libtrx/game/console/cmd/kill.h>
 #include <libtrx/game/console/cmd/load_game.h>
+#include <libtrx/game/console/cmd/mem_stats.h>
 #include <libtrx/game/console/cmd/play_demo.h>
 #include <libtrx/game/console/cmd/play_level.h>
 #include <libtrx/game/console/cmd/pos.h>
+#include <libtrx/game/console/cmd/record.h>
+#include <libtrx/game/console/cmd/render_stats.h>
 #include <libtrx/game/console/cmd/save_game.h>
 #include <libtrx/game/console/cmd/set_health.h>
 #include <libtrx/game/console/cmd/sfx.h>
@@ -46,6 +52,12 @@ CONSOLE_COMMAND *g_ConsoleCommands[] = {
     &g_Console_Cmd_Config,
     &g_Console_Cmd_GiveItem,
     &g_Console_Cmd_SFX,
+    &g_Console_Cmd_RenderStats,
+    &g_Console_Cmd_MemStats,
+    &g_Console_Cmd_Record,
+    &g_Console_Cmd_AudioStats,
+    &g_Console_Cmd_LOSStats,
+    &g_Console_Cmd_PoseStats,
     // clang-format on
     NULL,
 };
@@ -34,6 +34,7 @@ static void M_RenderEnd(void *surface, void *user_data);
 static void *M_LockSurface(void *surface, void *user_data);
 static void M_UnlockSurface(void *surface, void *user_data);
 static void M_UploadSurface(void *surface, void *user_data);
+static void M_UploadYUV(const VIDEO_YUV_FRAME *frame, void *user_data);
 static bool M_Play(const char *file_path);
 
 static void *M_AllocateSurface(
@@ -88,6 +89,28 @@ static void M_UploadSurface(void *const surface, void *const user_data)
     GFX_2D_Renderer_Render(renderer_2d);
 }
 
+static void M_UploadYUV(
+    const VIDEO_YUV_FRAME *const frame, void *const user_data)
+{
+    GFX_2D_RENDERER *const renderer_2d = user_data;
+    GFX_2D_SURFACE_DESC desc = {
+        .width = frame->width,
+        .height = frame->height,
+    };
+    for (int32_t i = 0; i < 4; i++) {
+        desc.uv[i].u = frame->uv[i].u;
+        desc.uv[i].v = frame->uv[i].v;
+    }
+    const GFX_2D_YUV_DATA data = {
+        .planes = { frame->planes[0], frame->planes[1], frame->planes[2] },
+        .pitches = { frame->pitches[0], frame->pitches[1], frame->pitches[2] },
+        .is_bt709 = frame->is_bt709,
+        .is_full_range = frame->is_full_range,
+    };
+    GFX_2D_Renderer_UploadYUV(renderer_2d, &desc, &data);
+    GFX_2D_Renderer_Render(renderer_2d);
+}
+
 static bool M_Play(const char *const file_path)
 {
     VIDEO *video = Video_Open(file_path);
@@ -106,6 +129,9 @@ static bool M_Play(const char *const file_path)
     Video_SetSurfaceLockFunc(video, M_LockSurface, NULL);
     Video_SetSurfaceUnlockFunc(video, M_UnlockSurface, NULL);
     Video_SetSurfaceUploadFunc(video, M_UploadSurface, renderer_2d);
+    if (GFX_Context_GetConfig()->backend == GFX_GL_33C) {
+        Video_SetYUVUploadFunc(video, M_UploadYUV, renderer_2d);
+    }
 
     Video_Start(video);
     while (video->is_playing) {
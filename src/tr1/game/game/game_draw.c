@@ -21,6 +21,9 @@ void Game_Draw(bool draw_overlay)
     Interpolation_Commit();
     Camera_Apply();
 
+    // the world is depth tested, so it can be drawn in state order
+    Output_EnableStateSorting();
+
     if (g_Objects[O_LARA].loaded) {
         Room_DrawAllRooms(g_Camera.interp.room_num, g_Camera.target.room_num);
 
@@ -36,6 +39,7 @@ void Game_Draw(bool draw_overlay)
 
         Lara_Draw(g_LaraItem);
         Output_FlushTranslucentObjects();
+        Output_DisableStateSorting();
 
         if (draw_overlay) {
             Overlay_DrawGameInfo();
@@ -58,5 +62,6 @@ void Game_Draw(bool draw_overlay)
         Output_SetupAboveWater(false);
         Lara_Hair_Draw();
         Output_FlushTranslucentObjects();
+        Output_DisableStateSorting();
     }
 }
@@ -66,6 +66,8 @@ static bool M_LoadObjectNames(
 static void M_ScanLevelText(
     const GAME_FLOW_STRING_ENTRY *entry,
     void (*callback)(GAME_OBJECT_ID object_id, const char *text));
+static void M_PrefetchPictures(
+    const GAME_FLOW_SEQUENCE *seq, GAME_FLOW_LEVEL_TYPE level_type);
 
 static const STRING_TO_ENUM_TYPE m_GameFlowLevelTypeEnumMap[] = {
     { "title", GFL_TITLE },
@@ -593,6 +595,51 @@ static void M_ScanLevelText(
     }
 }
 
+static void M_PrefetchPictures(
+    const GAME_FLOW_SEQUENCE *seq, const GAME_FLOW_LEVEL_TYPE level_type)
+{
+    if (level_type == GFL_SAVED) {
+        return;
+    }
+
+    // The main menu follows the title sequence.
+    if (level_type == GFL_TITLE) {
+        Output_PrefetchBackground(g_GameFlow.main_menu_background_path);
+    }
+
+    // Pictures are decoded on worker threads while the sequence runs, so
+    // they are usually ready by the time they are shown. Stop once the cache
+    // is full, so that later pictures do not push out the earlier ones.
+    for (; seq->type != GFS_END; seq++) {
+        const GAME_FLOW_DISPLAY_PICTURE_DATA *const data = seq->data;
+        const char *path = NULL;
+        switch (seq->type) {
+        case GFS_LOADING_SCREEN:
+            if (g_Config.gameplay.enable_loading_screens) {
+                path = data->path;
+            }
+            break;
+
+        case GFS_DISPLAY_PICTURE:
+            path = data->path;
+            break;
+
+        case GFS_TOTAL_STATS:
+            if (g_Config.gameplay.enable_total_stats) {
+                path = data->path;
+            }
+            break;
+
+        default:
+            break;
+        }
+
+        if (path != NULL && !Output_PrefetchBackground(path)) {
+            break;
+        }
+    }
+}
+
 static bool M_LoadScriptLevels(JSON_OBJECT *obj)
 {
     JSON_ARRAY *jlvl_arr = JSON_ObjectGetArray(obj, "levels");
@@ -1002,6 +1049,7 @@ GameFlow_InterpretSequence(int32_t level_num, GAME_FLOW_LEVEL_TYPE level_type)
 
     GAME_FLOW_SEQUENCE *seq = g_GameFlow.levels[level_num].sequence;
     GAME_FLOW_COMMAND command = { .action = GF_EXIT_TO_TITLE };
+    M_PrefetchPictures(seq, level_type);
 
     while (seq->type != GFS_END) {
         LOG_INFO("seq %d %d", seq->type, seq->data);
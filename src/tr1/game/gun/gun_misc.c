@@ -216,48 +216,69 @@ void Gun_GetNewTarget(WEAPON_INFO *winfo)
     src.z = g_LaraItem->pos.z;
     src.room_num = g_LaraItem->room_num;
 
-    ITEM *item = NULL;
-    for (int16_t item_num = g_NextItemActive; item_num != NO_ITEM;
-         item_num = item->next_active) {
-        item = &g_Items[item_num];
-        if (item->hit_points <= 0) {
-            continue;
-        }
+    // Gather the candidates in small batches so that their line of sight
+    // checks can be resolved together.
+    ITEM *candidates[NUM_SLOTS];
+    LOS_QUERY queries[NUM_SLOTS];
+    int16_t item_num = g_NextItemActive;
+    while (true) {
+        int32_t candidate_count = 0;
+        for (; item_num != NO_ITEM && candidate_count < NUM_SLOTS;
+             item_num = g_Items[item_num].next_active) {
+            ITEM *const item = &g_Items[item_num];
+            if (item->hit_points <= 0) {
+                continue;
+            }
 
-        int32_t x = item->pos.x - src.x;
-        int32_t y = item->pos.y - src.y;
-        int32_t z = item->pos.z - src.z;
-        if (ABS(x) > maxdist || ABS(y) > maxdist || ABS(z) > maxdist) {
-            continue;
-        }
+            int32_t x = item->pos.x - src.x;
+            int32_t y = item->pos.y - src.y;
+            int32_t z = item->pos.z - src.z;
+            if (ABS(x) > maxdist || ABS(y) > maxdist || ABS(z) > maxdist) {
+                continue;
+            }
 
-        int32_t dist = x * x + y * y + z * z;
-        if (dist >= maxdist2) {
-            continue;
-        }
+            int32_t dist = x * x + y * y + z * z;
+            if (dist >= maxdist2) {
+                continue;
+            }
 
-        GAME_VECTOR target;
-        Gun_FindTargetPoint(item, &target);
-        if (!LOS_Check(&src, &target)) {
-            continue;
+            candidates[candidate_count] = item;
+            queries[candidate_count].start = src;
+            Gun_FindTargetPoint(item, &queries[candidate_count].target);
+            candidate_count++;
         }
 
-        PHD_ANGLE ang[2];
-        Math_GetVectorAngles(
-            target.x - src.x, target.y - src.y, target.z - src.z, ang);
-        ang[0] -= g_Lara.torso_rot.y + g_LaraItem->rot.y;
-        ang[1] -= g_Lara.torso_rot.x + g_LaraItem->rot.x;
-        if (ang[0] >= winfo->lock_angles[0] && ang[0] <= winfo->lock_angles[1]
-            && ang[1] >= winfo->lock_angles[2]
-            && ang[1] <= winfo->lock_angles[3]) {
-            int16_t yrot = ABS(ang[0]);
-            m_TargetList[num_targets] = item;
-            num_targets++;
-            if (yrot < best_yrot) {
-                best_yrot = yrot;
-                best_target = item;
+        LOS_CheckBatch(queries, candidate_count);
+
+        for (int32_t i = 0; i < candidate_count; i++) {
+            if (!queries[i].result) {
+                continue;
+            }
+
+            ITEM *const item = candidates[i];
+            const GAME_VECTOR *const target = &queries[i].result_target;
+            PHD_ANGLE ang[2];
+            Math_GetVectorAngles(
+                target->x - src.x, target->y - src.y, target->z - src.z, ang);
+            ang[0] -= g_Lara.torso_rot.y + g_LaraItem->rot.y;
+            ang[1] -= g_Lara.torso_rot.x + g_LaraItem->rot.x;
+            if (ang[0] >= winfo->lock_angles[0]
+                && ang[0] <= winfo->lock_angles[1]
+                && ang[1] >= winfo->lock_angles[2]
+                && ang[1] <= winfo->lock_angles[3]) {
+                int16_t yrot = ABS(ang[0]);
+                m_TargetList[num_targets] = item;
+                num_targets++;
+                if (yrot < best_yrot) {
+                    best_yrot = yrot;
+                    best_target = item;
+                }
             }
         }
+
+        if (item_num == NO_ITEM) {
+            break;
+        }
     }
     m_TargetList[num_targets] = NULL;
 
@@ -1,9 +1,12 @@
 #include "game/items.h"
 
+#include "game/broadphase.h"
 #include "game/carrier.h"
+#include "game/collide.h"
 #include "game/effects.h"
 #include "game/interpolation.h"
 #include "game/item_actions.h"
+#include "game/los.h"
 #include "game/random.h"
 #include "game/room.h"
 #include "game/shell.h"
@@ -54,6 +57,9 @@ int32_t Item_GetTotalCount(void)
 
 void Item_Control(void)
 {
+    Collide_BeginPoseFrame();
+    LOS_BeginFrame();
+
     int16_t item_num = g_NextItemActive;
     while (item_num != NO_ITEM) {
         ITEM *item = &g_Items[item_num];
@@ -145,6 +151,7 @@ void Item_Initialise(int16_t item_num)
     ROOM *const r = &g_RoomInfo[item->room_num];
     item->next_item = r->item_num;
     r->item_num = item_num;
+    Broadphase_UpdateItem(item_num);
     const int32_t z_sector = (item->pos.z - r->pos.z) >> WALL_SHIFT;
     const int32_t x_sector = (item->pos.x - r->pos.x) >> WALL_SHIFT;
     const SECTOR *const sector = &r->sectors[z_sector + x_sector * r->size.z];
@@ -168,6 +175,8 @@ void Item_RemoveActive(int16_t item_num)
     }
 
     item->active = 0;
+    // the broadphase stops checking the item for moves from now on
+    Broadphase_MoveItem(item_num);
 
     int16_t link_num = g_NextItemActive;
     if (link_num == item_num) {
@@ -188,6 +197,7 @@ void Item_RemoveDrawn(int16_t item_num)
 {
     ITEM *const item = &g_Items[item_num];
     ROOM *const r = &g_RoomInfo[item->room_num];
+    Broadphase_RemoveItem(item_num);
 
     int16_t link_num = r->item_num;
     if (link_num == item_num) {
@@ -245,6 +255,7 @@ void Item_NewRoom(int16_t item_num, int16_t room_num)
     item->room_num = room_num;
     item->next_item = r->item_num;
     r->item_num = item_num;
+    Broadphase_UpdateItem(item_num);
 }
 
 void Item_UpdateRoom(ITEM *item, int32_t height)
@@ -1,6 +1,7 @@
 #include "game/lara/control.h"
 
 #include "game/box.h"
+#include "game/broadphase.h"
 #include "game/collide.h"
 #include "game/gun.h"
 #include "game/input.h"
@@ -18,14 +19,20 @@
 
 #include <libtrx/config.h>
 #include <libtrx/game/math.h>
+#include <libtrx/memory.h>
 
 #include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
 
 static int32_t m_OpenDoorsCheatCooldown = 0;
+static struct {
+    int16_t *data;
+    int32_t capacity;
+} m_BaddieCandidates = {};
 
 static void M_WaterCurrent(COLL_INFO *coll);
+static int32_t M_GetBaddieCandidates(const BOUNDS_32 *bounds);
 static void M_BaddieCollision(ITEM *lara_item, COLL_INFO *coll);
 static SECTOR *M_GetCurrentSector(const ITEM *lara_item);
 
@@ -109,6 +116,20 @@ static void M_WaterCurrent(COLL_INFO *coll)
     coll->old.z = item->pos.z;
 }
 
+static int32_t M_GetBaddieCandidates(const BOUNDS_32 *const bounds)
+{
+    int32_t count = Broadphase_QueryItems(
+        bounds, m_BaddieCandidates.data, m_BaddieCandidates.capacity);
+    if (count > m_BaddieCandidates.capacity) {
+        m_BaddieCandidates.capacity = count;
+        m_BaddieCandidates.data = Memory_Realloc(
+            m_BaddieCandidates.data, sizeof(int16_t) * count);
+        count = Broadphase_QueryItems(
+            bounds, m_BaddieCandidates.data, m_BaddieCandidates.capacity);
+    }
+    return count;
+}
+
 static void M_BaddieCollision(ITEM *lara_item, COLL_INFO *coll)
 {
     lara_item->hit_status = 0;
@@ -121,10 +142,30 @@ static void M_BaddieCollision(ITEM *lara_item, COLL_INFO *coll)
     const int32_t roomies_count =
         Room_GetAdjoiningRooms(lara_item->room_num, roomies, 12);
 
+    const BOUNDS_32 bounds = {
+        .min = {
+            .x = lara_item->pos.x - TARGET_DIST,
+            .y = lara_item->pos.y - TARGET_DIST,
+            .z = lara_item->pos.z - TARGET_DIST,
+        },
+        .max = {
+            .x = lara_item->pos.x + TARGET_DIST,
+            .y = lara_item->pos.y + TARGET_DIST,
+            .z = lara_item->pos.z + TARGET_DIST,
+        },
+    };
+    int32_t candidate_count = M_GetBaddieCandidates(&bounds);
+
     for (int32_t i = 0; i < roomies_count; i++) {
-        int16_t item_num = g_RoomInfo[roomies[i]].item_num;
-        while (item_num != NO_ITEM) {
+        // collision callbacks can move and remove items, so the candidates
+        // are fetched again before the next room once any of them ran
+        bool is_stale = false;
+        for (int32_t j = 0; j < candidate_count; j++) {
+            const int16_t item_num = m_BaddieCandidates.data[j];
             ITEM *item = &g_Items[item_num];
+            if (item->room_num != roomies[i]) {
+                continue;
+            }
             if (item->collidable && item->status != IS_INVISIBLE) {
                 OBJECT *object = &g_Objects[item->object_id];
                 if (object->collision) {
@@ -135,10 +176,13 @@ static void M_BaddieCollision(ITEM *lara_item, COLL_INFO *coll)
                         && y < TARGET_DIST && z > -TARGET_DIST
                         && z < TARGET_DIST) {
                         object->collision(item_num, lara_item, coll);
+                        is_stale = true;
                     }
                 }
             }
-            item_num = item->next_item;
+        }
+        if (is_stale) {
+            candidate_count = M_GetBaddieCandidates(&bounds);
         }
     }
 
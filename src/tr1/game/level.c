@@ -1,13 +1,16 @@
 #include "game/level.h"
 
+#include "game/broadphase.h"
 #include "game/camera.h"
 #include "game/carrier.h"
+#include "game/collide.h"
 #include "game/effects.h"
 #include "game/gameflow.h"
 #include "game/inject.h"
 #include "game/inventory_ring/vars.h"
 #include "game/items.h"
 #include "game/lara/common.h"
+#include "game/los.h"
 #include "game/lot.h"
 #include "game/music.h"
 #include "game/objects/creatures/mutant.h"
@@ -613,6 +616,9 @@ static void M_LoadItems(VFILE *file)
         g_Items = GameBuf_Alloc(sizeof(ITEM) * MAX_ITEMS, GBUF_ITEMS);
         g_LevelItemCount = m_LevelInfo.item_count;
         Item_InitialiseArray(MAX_ITEMS);
+        Collide_ResetPoseCache();
+        LOS_InvalidateCache();
+        Broadphase_Reset();
 
         for (int i = 0; i < m_LevelInfo.item_count; i++) {
             ITEM *item = &g_Items[i];
@@ -1009,6 +1015,13 @@ bool Level_Initialise(int32_t level_num)
     Camera_Reset();
     Pierre_Reset();
 
+    // open the level music while the level loads
+    const bool disable_music = level_num == g_GameFlow.title_level_num
+        && !g_Config.audio.enable_music_in_menu;
+    if (g_GameFlow.levels[level_num].music && !disable_music) {
+        Music_Prefetch(g_GameFlow.levels[level_num].music);
+    }
+
     Lara_InitialiseLoad(NO_ITEM);
     Level_Load(level_num);
     GameFlow_LoadStrings(level_num);
@@ -1027,8 +1040,6 @@ bool Level_Initialise(int32_t level_num)
     Music_SetVolume(g_Config.audio.music_volume);
     Sound_ResetEffects();
 
-    const bool disable_music = level_num == g_GameFlow.title_level_num
-        && !g_Config.audio.enable_music_in_menu;
     if (g_GameFlow.levels[level_num].music && !disable_music) {
         Music_PlayLooped(g_GameFlow.levels[level_num].music);
     }
@@ -2,15 +2,67 @@
 
 #include "game/room.h"
 #include "global/const.h"
+#include "global/vars.h"
 
 #include <libtrx/utils.h>
 
 #include <stdint.h>
-
+#include <string.h>
+
+#define LOS_CACHE_SIZE 256
+
+typedef struct {
+    uint32_t epoch;
+    // the camera traces with chunky floors, which changes the heights
+    bool is_chunky;
+    GAME_VECTOR start;
+    GAME_VECTOR target;
+    GAME_VECTOR result_target;
+    int32_t result_height_type;
+    bool result;
+} M_CACHE_ENTRY;
+
+static M_CACHE_ENTRY m_Cache[LOS_CACHE_SIZE] = {};
+static uint32_t m_Epoch = 1;
+static bool m_IsTraceDynamic = false;
+static LOS_CACHE_STATS m_Stats = {};
+static LOS_CACHE_STATS m_StatsCurrent = {};
+
+static int16_t M_GetHeight(
+    const SECTOR *sector, int32_t x, int32_t y, int32_t z);
+static int16_t M_GetCeiling(
+    const SECTOR *sector, int32_t x, int32_t y, int32_t z);
 static int32_t M_CheckX(const GAME_VECTOR *start, GAME_VECTOR *target);
 static int32_t M_CheckZ(const GAME_VECTOR *start, GAME_VECTOR *target);
 static bool M_ClipTarget(
     const GAME_VECTOR *start, GAME_VECTOR *target, const SECTOR *sector);
+static bool M_Trace(const GAME_VECTOR *start, GAME_VECTOR *target);
+static M_CACHE_ENTRY *M_GetCacheEntry(
+    const GAME_VECTOR *start, const GAME_VECTOR *target);
+static bool M_IsSameVector(const GAME_VECTOR *a, const GAME_VECTOR *b);
+
+static int16_t M_GetHeight(
+    const SECTOR *const sector, const int32_t x, const int32_t y,
+    const int32_t z)
+{
+    // Trapdoors, bridges and similar items change the floor height of the
+    // sectors that trigger them while they move, so any ray that passes
+    // over a triggered sector cannot be cached.
+    if (Room_GetPitSector(sector, x, z)->trigger != NULL) {
+        m_IsTraceDynamic = true;
+    }
+    return Room_GetHeight(sector, x, y, z);
+}
+
+static int16_t M_GetCeiling(
+    const SECTOR *const sector, const int32_t x, const int32_t y,
+    const int32_t z)
+{
+    if (Room_GetPitSector(sector, x, z)->trigger != NULL) {
+        m_IsTraceDynamic = true;
+    }
+    return Room_GetCeiling(sector, x, y, z);
+}
 
 static int32_t M_CheckX(
     const GAME_VECTOR *const start, GAME_VECTOR *const target)
@@ -35,8 +87,8 @@ static int32_t M_CheckX(
 
         while (x > target->x) {
             sector = Room_GetSector(x, y, z, &room_num);
-            if (y > Room_GetHeight(sector, x, y, z)
-                || y < Room_GetCeiling(sector, x, y, z)) {
+            if (y > M_GetHeight(sector, x, y, z)
+                || y < M_GetCeiling(sector, x, y, z)) {
                 target->x = x;
                 target->y = y;
                 target->z = z;
@@ -47,8 +99,8 @@ static int32_t M_CheckX(
             last_room = room_num;
 
             sector = Room_GetSector(x - 1, y, z, &room_num);
-            if (y > Room_GetHeight(sector, x - 1, y, z)
-                || y < Room_GetCeiling(sector, x - 1, y, z)) {
+            if (y > M_GetHeight(sector, x - 1, y, z)
+                || y < M_GetCeiling(sector, x - 1, y, z)) {
                 target->x = x;
                 target->y = y;
                 target->z = z;
@@ -67,8 +119,8 @@ static int32_t M_CheckX(
 
         while (x < target->x) {
             sector = Room_GetSector(x, y, z, &room_num);
-            if (y > Room_GetHeight(sector, x, y, z)
-                || y < Room_GetCeiling(sector, x, y, z)) {
+            if (y > M_GetHeight(sector, x, y, z)
+                || y < M_GetCeiling(sector, x, y, z)) {
                 target->x = x;
                 target->y = y;
                 target->z = z;
@@ -79,8 +131,8 @@ static int32_t M_CheckX(
             last_room = room_num;
 
             sector = Room_GetSector(x + 1, y, z, &room_num);
-            if (y > Room_GetHeight(sector, x + 1, y, z)
-                || y < Room_GetCeiling(sector, x + 1, y, z)) {
+            if (y > M_GetHeight(sector, x + 1, y, z)
+                || y < M_GetCeiling(sector, x + 1, y, z)) {
                 target->x = x;
                 target->y = y;
                 target->z = z;
@@ -121,8 +173,8 @@ static int32_t M_CheckZ(
 
         while (z > target->z) {
             sector = Room_GetSector(x, y, z, &room_num);
-            if (y > Room_GetHeight(sector, x, y, z)
-                || y < Room_GetCeiling(sector, x, y, z)) {
+            if (y > M_GetHeight(sector, x, y, z)
+                || y < M_GetCeiling(sector, x, y, z)) {
                 target->x = x;
                 target->y = y;
                 target->z = z;
@@ -133,8 +185,8 @@ static int32_t M_CheckZ(
             last_room = room_num;
 
             sector = Room_GetSector(x, y, z - 1, &room_num);
-            if (y > Room_GetHeight(sector, x, y, z - 1)
-                || y < Room_GetCeiling(sector, x, y, z - 1)) {
+            if (y > M_GetHeight(sector, x, y, z - 1)
+                || y < M_GetCeiling(sector, x, y, z - 1)) {
                 target->x = x;
                 target->y = y;
                 target->z = z;
@@ -153,8 +205,8 @@ static int32_t M_CheckZ(
 
         while (z < target->z) {
             sector = Room_GetSector(x, y, z, &room_num);
-            if (y > Room_GetHeight(sector, x, y, z)
-                || y < Room_GetCeiling(sector, x, y, z)) {
+            if (y > M_GetHeight(sector, x, y, z)
+                || y < M_GetCeiling(sector, x, y, z)) {
                 target->x = x;
                 target->y = y;
                 target->z = z;
@@ -165,8 +217,8 @@ static int32_t M_CheckZ(
             last_room = room_num;
 
             sector = Room_GetSector(x, y, z + 1, &room_num);
-            if (y > Room_GetHeight(sector, x, y, z + 1)
-                || y < Room_GetCeiling(sector, x, y, z + 1)) {
+            if (y > M_GetHeight(sector, x, y, z + 1)
+                || y < M_GetCeiling(sector, x, y, z + 1)) {
                 target->x = x;
                 target->y = y;
                 target->z = z;
@@ -193,7 +245,7 @@ static bool M_ClipTarget(
     int32_t dz = target->z - start->z;
 
     const int32_t height =
-        Room_GetHeight(sector, target->x, target->y, target->z);
+        M_GetHeight(sector, target->x, target->y, target->z);
     if (target->y > height && start->y < height) {
         target->y = height;
         target->x = start->x + dx * (height - start->y) / dy;
@@ -202,7 +254,7 @@ static bool M_ClipTarget(
     }
 
     const int32_t ceiling =
-        Room_GetCeiling(sector, target->x, target->y, target->z);
+        M_GetCeiling(sector, target->x, target->y, target->z);
     if (target->y < ceiling && start->y > ceiling) {
         target->y = ceiling;
         target->x = start->x + dx * (ceiling - start->y) / dy;
@@ -213,7 +265,8 @@ static bool M_ClipTarget(
     return true;
 }
 
-bool LOS_Check(const GAME_VECTOR *const start, GAME_VECTOR *const target)
+static bool M_Trace(
+    const GAME_VECTOR *const start, GAME_VECTOR *const target)
 {
     int32_t los1;
     int32_t los2;
@@ -235,3 +288,100 @@ bool LOS_Check(const GAME_VECTOR *const start, GAME_VECTOR *const target)
 
     return M_ClipTarget(start, target, sector) && los1 == 1 && los2 == 1;
 }
+
+static bool M_IsSameVector(
+    const GAME_VECTOR *const a, const GAME_VECTOR *const b)
+{
+    return a->x == b->x && a->y == b->y && a->z == b->z
+        && a->room_num == b->room_num;
+}
+
+static M_CACHE_ENTRY *M_GetCacheEntry(
+    const GAME_VECTOR *const start, const GAME_VECTOR *const target)
+{
+    // Nearby rays share a slot, but an entry is only reused for the exact
+    // same endpoints so that the results never differ from a fresh trace.
+    const uint32_t hash = ((uint32_t)(start->x >> 6) * 73856093u)
+        ^ ((uint32_t)(start->z >> 6) * 19349663u)
+        ^ ((uint32_t)(target->x >> 6) * 83492791u)
+        ^ ((uint32_t)(target->z >> 6) * 2971215073u)
+        ^ ((uint32_t)(start->y ^ target->y) >> 6);
+    return &m_Cache[hash & (LOS_CACHE_SIZE - 1)];
+}
+
+bool LOS_Check(const GAME_VECTOR *const start, GAME_VECTOR *const target)
+{
+    M_CACHE_ENTRY *const entry = M_GetCacheEntry(start, target);
+    if (entry->epoch == m_Epoch && entry->is_chunky == g_ChunkyFlag
+        && M_IsSameVector(&entry->start, start)
+        && M_IsSameVector(&entry->target, target)) {
+        m_StatsCurrent.hits++;
+        *target = entry->result_target;
+        g_HeightType = entry->result_height_type;
+        return entry->result;
+    }
+
+    const GAME_VECTOR original_target = *target;
+    m_IsTraceDynamic = false;
+    const bool result = M_Trace(start, target);
+    if (m_IsTraceDynamic) {
+        m_StatsCurrent.uncached++;
+        return result;
+    }
+
+    m_StatsCurrent.misses++;
+    entry->epoch = m_Epoch;
+    entry->is_chunky = g_ChunkyFlag;
+    entry->start = *start;
+    entry->target = original_target;
+    entry->result_target = *target;
+    entry->result_height_type = g_HeightType;
+    entry->result = result;
+    return result;
+}
+
+void LOS_CheckBatch(LOS_QUERY *const queries, const int32_t count)
+{
+    for (int32_t i = 0; i < count; i++) {
+        LOS_QUERY *const query = &queries[i];
+
+        // Rays that repeat an earlier one in the batch (eg. several targets
+        // sharing a point) are resolved from that one rather than traced.
+        int32_t j = 0;
+        for (; j < i; j++) {
+            if (M_IsSameVector(&queries[j].start, &query->start)
+                && M_IsSameVector(&queries[j].target, &query->target)) {
+                break;
+            }
+        }
+        if (j < i) {
+            m_StatsCurrent.hits++;
+            query->result_target = queries[j].result_target;
+            query->result = queries[j].result;
+            continue;
+        }
+
+        query->result_target = query->target;
+        query->result = LOS_Check(&query->start, &query->result_target);
+    }
+}
+
+void LOS_InvalidateCache(void)
+{
+    m_Epoch++;
+    if (m_Epoch == 0) {
+        memset(m_Cache, 0, sizeof(m_Cache));
+        m_Epoch = 1;
+    }
+}
+
+void LOS_BeginFrame(void)
+{
+    m_Stats = m_StatsCurrent;
+    m_StatsCurrent = (LOS_CACHE_STATS) {};
+}
+
+const LOS_CACHE_STATS *LOS_GetCacheStats(void)
+{
+    return &m_Stats;
+}
@@ -3,5 +3,31 @@
 #include "global/types.h"
 
 #include <stdbool.h>
+#include <stdint.h>
+
+typedef struct {
+    GAME_VECTOR start;
+    GAME_VECTOR target;
+    // the target clipped to the first obstacle, as LOS_Check would leave it
+    GAME_VECTOR result_target;
+    bool result;
+} LOS_QUERY;
+
+typedef struct {
+    int32_t hits;
+    int32_t misses;
+    // rays over moving geometry, which are never cached
+    int32_t uncached;
+} LOS_CACHE_STATS;
 
 bool LOS_Check(const GAME_VECTOR *start, GAME_VECTOR *target);
+void LOS_CheckBatch(LOS_QUERY *queries, int32_t count);
+
+// Results are cached until the level geometry may have changed: call this
+// whenever sectors are altered (doors, moving blocks, flipmaps, loading).
+void LOS_InvalidateCache(void);
+// Publishes the counters of the previous frame. The cache itself is kept, as
+// Lara, creatures and the camera keep tracing the same rays while they stand
+// still.
+void LOS_BeginFrame(void);
+const LOS_CACHE_STATS *LOS_GetCacheStats(void);
@@ -151,6 +151,17 @@ bool Music_PlayLooped(MUSIC_TRACK_ID track)
     return true;
 }
 
+void Music_Prefetch(const MUSIC_TRACK_ID track)
+{
+    if (M_IsBrokenTrack(track)) {
+        return;
+    }
+
+    char *file_path = M_GetTrackFileName(track);
+    Audio_Stream_Prefetch(file_path, -1.0, -1.0);
+    Memory_FreePointer(&file_path);
+}
+
 void Music_Stop(void)
 {
     m_TrackCurrent = MX_INACTIVE;
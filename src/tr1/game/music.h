@@ -20,6 +20,10 @@ bool Music_Play(MUSIC_TRACK_ID track);
 // playback for the chosen track.
 bool Music_PlayLooped(MUSIC_TRACK_ID track);
 
+// Opens the track in the background, so that playing it later starts
+// without a delay.
+void Music_Prefetch(MUSIC_TRACK_ID track);
+
 // Stops any music, whether looped or active speech.
 void Music_Stop(void);
 
@@ -3,6 +3,7 @@
 #include "game/collide.h"
 #include "game/items.h"
 #include "game/lara/common.h"
+#include "game/los.h"
 #include "game/objects/common.h"
 #include "game/room.h"
 #include "global/const.h"
@@ -11,6 +12,8 @@
 #include <libtrx/game/gamebuf.h>
 #include <libtrx/utils.h>
 
+#include <string.h>
+
 typedef struct {
     DOORPOS_DATA d1;
     DOORPOS_DATA d1flip;
@@ -94,6 +97,7 @@ static void M_Shut(DOORPOS_DATA *const d)
         return;
     }
 
+    const SECTOR old_sector = *sector;
     sector->box = NO_BOX;
     sector->floor.height = NO_HEIGHT;
     sector->ceiling.height = NO_HEIGHT;
@@ -102,6 +106,9 @@ static void M_Shut(DOORPOS_DATA *const d)
     sector->portal_room.sky = NO_ROOM;
     sector->portal_room.pit = NO_ROOM;
     sector->portal_room.wall = NO_ROOM;
+    if (memcmp(&old_sector, sector, sizeof(SECTOR)) != 0) {
+        LOS_InvalidateCache();
+    }
 
     const int16_t box_num = d->block;
     if (box_num != NO_BOX) {
@@ -117,7 +124,10 @@ static void M_Open(DOORPOS_DATA *const d)
         return;
     }
 
-    *sector = d->old_sector;
+    if (memcmp(&d->old_sector, sector, sizeof(SECTOR)) != 0) {
+        *sector = d->old_sector;
+        LOS_InvalidateCache();
+    }
 
     const int16_t box_num = d->block;
     if (box_num != NO_BOX) {
@@ -1,5 +1,6 @@
 #include "game/objects/traps/rolling_ball.h"
 
+#include "game/broadphase.h"
 #include "game/collide.h"
 #include "game/items.h"
 #include "game/lara/common.h"
@@ -98,6 +99,7 @@ void RollingBall_Control(int16_t item_num)
             item->next_item = r->item_num;
             r->item_num = item_num;
             item->room_num = data->room_num;
+            Broadphase_UpdateItem(item_num);
         }
         item->current_anim_state = TRAP_SET;
         item->goal_anim_state = TRAP_SET;
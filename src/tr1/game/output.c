@@ -16,7 +16,9 @@
 #include <libtrx/config.h>
 #include <libtrx/debug.h>
 #include <libtrx/engine/image.h>
+#include <libtrx/engine/image_cache.h>
 #include <libtrx/filesystem.h>
+#include <libtrx/frame_arena.h>
 #include <libtrx/game/console/common.h>
 #include <libtrx/game/gamebuf.h>
 #include <libtrx/game/math.h>
@@ -66,6 +68,7 @@ static int32_t m_ShadeTable[WIBBLE_SIZE] = {};
 static int32_t m_RandTable[WIBBLE_SIZE] = {};
 
 static PHD_VBUF *m_VBuf = NULL;
+static XYZ_32 *m_ViewPos = NULL;
 static PHD_UV *m_EnvMapUV = NULL;
 static int32_t m_DrawDistFade = 0;
 static int32_t m_DrawDistMax = 0;
@@ -87,6 +90,7 @@ static void M_DrawTexturedFace4s(const FACE4 *faces, int32_t count);
 static void M_DrawObjectFace3EnvMap(const FACE3 *faces, int32_t count);
 static void M_DrawObjectFace4EnvMap(const FACE4 *faces, int32_t count);
 static void M_DrawRoomSprites(const ROOM_MESH *mesh);
+static inline int16_t M_CalcScreenClip(double xs, double ys);
 static bool M_CalcObjectVertices(const XYZ_16 *vertices, int16_t count);
 static void M_CalcVerticeLight(const OBJECT_MESH *mesh);
 static bool M_CalcVerticeEnvMap(const OBJECT_MESH *mesh);
@@ -241,61 +245,56 @@ static void M_DrawRoomSprites(const ROOM_MESH *const mesh)
     }
 }
 
+// Gives the same flags as testing each edge in turn, as the left edge never
+// lies past the right one nor the top past the bottom. The vertex loops that
+// use this first transform the whole mesh with Math_TransformVertices, which
+// runs four vertices at a time, and then project and clip one PHD_VBUF at a
+// time, as that part branches on the near plane.
+static inline int16_t M_CalcScreenClip(const double xs, const double ys)
+{
+    // clang-format off
+    return (xs < g_PhdLeft)
+        | (xs > g_PhdRight) << 1
+        | (ys < g_PhdTop) << 2
+        | (ys > g_PhdBottom) << 3;
+    // clang-format on
+}
+
 static bool M_CalcObjectVertices(
     const XYZ_16 *const vertices, const int16_t count)
 {
+    const MATRIX *const mptr = g_MatrixPtr;
+    const int32_t near_z = Output_GetNearZ();
+    const int32_t center_x = Viewport_GetCenterX();
+    const int32_t center_y = Viewport_GetCenterY();
+
+    Math_TransformVertices(
+        &mptr->_00, vertices, sizeof(XYZ_16), count, m_ViewPos);
+
     uint16_t total_clip = 0xFFFF;
-    for (int i = 0; i < count; i++) {
-        const XYZ_16 *const vertex = &vertices[i];
-        // clang-format off
-        double xv =
-            g_MatrixPtr->_00 * vertex->x +
-            g_MatrixPtr->_01 * vertex->y +
-            g_MatrixPtr->_02 * vertex->z +
-            g_MatrixPtr->_03;
-        double yv =
-            g_MatrixPtr->_10 * vertex->x +
-            g_MatrixPtr->_11 * vertex->y +
-            g_MatrixPtr->_12 * vertex->z +
-            g_MatrixPtr->_13;
-        double zv =
-            g_MatrixPtr->_20 * vertex->x +
-            g_MatrixPtr->_21 * vertex->y +
-            g_MatrixPtr->_22 * vertex->z +
-            g_MatrixPtr->_23;
-        // clang-format on
+    for (int32_t i = 0; i < count; i++) {
+        PHD_VBUF *const vbuf = &m_VBuf[i];
+        const double xv = m_ViewPos[i].x;
+        const double yv = m_ViewPos[i].y;
+        const double zv = m_ViewPos[i].z;
 
-        m_VBuf[i].xv = xv;
-        m_VBuf[i].yv = yv;
-        m_VBuf[i].zv = zv;
+        vbuf->xv = xv;
+        vbuf->yv = yv;
+        vbuf->zv = zv;
 
         uint16_t clip_flags;
-        if (zv < Output_GetNearZ()) {
+        if (zv < near_z) {
             clip_flags = 0x8000;
         } else {
-            clip_flags = 0;
-
-            double persp = g_PhdPersp / zv;
-            double xs = Viewport_GetCenterX() + xv * persp;
-            double ys = Viewport_GetCenterY() + yv * persp;
-
-            if (xs < g_PhdLeft) {
-                clip_flags |= 1;
-            } else if (xs > g_PhdRight) {
-                clip_flags |= 2;
-            }
-
-            if (ys < g_PhdTop) {
-                clip_flags |= 4;
-            } else if (ys > g_PhdBottom) {
-                clip_flags |= 8;
-            }
-
-            m_VBuf[i].xs = xs;
-            m_VBuf[i].ys = ys;
+            const double persp = g_PhdPersp / zv;
+            const double xs = center_x + xv * persp;
+            const double ys = center_y + yv * persp;
+            clip_flags = M_CalcScreenClip(xs, ys);
+            vbuf->xs = xs;
+            vbuf->ys = ys;
         }
 
-        m_VBuf[i].clip = clip_flags;
+        vbuf->clip = clip_flags;
         total_clip &= clip_flags;
     }
 
@@ -407,43 +406,35 @@ static void M_CalcSkyboxLight(const OBJECT_MESH *const mesh)
 
 static void M_CalcRoomVertices(const ROOM_MESH *const mesh)
 {
+    const MATRIX *const mptr = g_MatrixPtr;
+    const int32_t near_z = Output_GetNearZ();
+    const int32_t center_x = Viewport_GetCenterX();
+    const int32_t center_y = Viewport_GetCenterY();
+    const int32_t draw_dist_max = Output_GetDrawDistMax();
+
+    Math_TransformVertices(
+        &mptr->_00, &mesh->vertices[0].pos, sizeof(ROOM_VERTEX),
+        mesh->num_vertices, m_ViewPos);
+
     for (int32_t i = 0; i < mesh->num_vertices; i++) {
         PHD_VBUF *const vbuf = &m_VBuf[i];
         const ROOM_VERTEX *const vertex = &mesh->vertices[i];
-
-        // clang-format off
-        const double xv = (
-            g_MatrixPtr->_00 * vertex->pos.x +
-            g_MatrixPtr->_01 * vertex->pos.y +
-            g_MatrixPtr->_02 * vertex->pos.z +
-            g_MatrixPtr->_03
-        );
-        const double yv = (
-            g_MatrixPtr->_10 * vertex->pos.x +
-            g_MatrixPtr->_11 * vertex->pos.y +
-            g_MatrixPtr->_12 * vertex->pos.z +
-            g_MatrixPtr->_13
-        );
-        const int32_t zv_int = (
-            g_MatrixPtr->_20 * vertex->pos.x +
-            g_MatrixPtr->_21 * vertex->pos.y +
-            g_MatrixPtr->_22 * vertex->pos.z +
-            g_MatrixPtr->_23
-        );
+        const double xv = m_ViewPos[i].x;
+        const double yv = m_ViewPos[i].y;
+        const int32_t zv_int = m_ViewPos[i].z;
         const double zv = zv_int;
-        // clang-format on
 
         vbuf->xv = xv;
         vbuf->yv = yv;
         vbuf->zv = zv;
         vbuf->g = vertex->shade & MAX_LIGHTING;
 
-        if (zv < Output_GetNearZ()) {
+        if (zv_int < near_z) {
             vbuf->clip = (int16_t)0x8000;
         } else {
             int16_t clip_flags = 0;
             const int32_t depth = zv_int >> W2V_SHIFT;
-            if (depth > Output_GetDrawDistMax()) {
+            if (depth > draw_dist_max) {
                 vbuf->g = MAX_LIGHTING;
                 if (!m_IsSkyboxEnabled) {
                     clip_flags |= 16;
@@ -455,21 +446,10 @@ static void M_CalcRoomVertices(const ROOM_MESH *const mesh)
                 }
             }
 
-            const double persp = g_PhdPersp / (double)zv;
-            const double xs = Viewport_GetCenterX() + xv * persp;
-            const double ys = Viewport_GetCenterY() + yv * persp;
-
-            if (xs < g_PhdLeft) {
-                clip_flags |= 1;
-            } else if (xs > g_PhdRight) {
-                clip_flags |= 2;
-            }
-
-            if (ys < g_PhdTop) {
-                clip_flags |= 4;
-            } else if (ys > g_PhdBottom) {
-                clip_flags |= 8;
-            }
+            const double persp = g_PhdPersp / zv;
+            const double xs = center_x + xv * persp;
+            const double ys = center_y + yv * persp;
+            clip_flags |= M_CalcScreenClip(xs, ys);
 
             if (m_IsWaterEffect) {
                 vbuf->g += m_ShadeTable[(
@@ -501,18 +481,8 @@ static void M_CalcRoomVerticesWibble(const ROOM_MESH *const mesh)
         xs += m_WibbleTable[(m_WibbleOffset + (int)ys) & (WIBBLE_SIZE - 1)];
         ys += m_WibbleTable[(m_WibbleOffset + (int)xs) & (WIBBLE_SIZE - 1)];
 
-        int16_t clip_flags = vbuf->clip & ~15;
-        if (xs < g_PhdLeft) {
-            clip_flags |= 1;
-        } else if (xs > g_PhdRight) {
-            clip_flags |= 2;
-        }
-
-        if (ys < g_PhdTop) {
-            clip_flags |= 4;
-        } else if (ys > g_PhdBottom) {
-            clip_flags |= 8;
-        }
+        const int16_t clip_flags =
+            (vbuf->clip & ~15) | M_CalcScreenClip(xs, ys);
 
         vbuf->xs = xs;
         vbuf->ys = ys;
@@ -561,7 +531,9 @@ void Output_Shutdown(void)
 void Output_ReserveVertexBuffer(const size_t size)
 {
     m_VBuf = GameBuf_Alloc(size * sizeof(PHD_VBUF), GBUF_VERTEX_BUFFER);
+    m_ViewPos = GameBuf_Alloc(size * sizeof(XYZ_32), GBUF_VERTEX_BUFFER);
     m_EnvMapUV = GameBuf_Alloc(size * sizeof(PHD_UV), GBUF_VERTEX_BUFFER);
+    S_Output_ReserveVertexBuffer(size);
 }
 
 void Output_SetWindowSize(int width, int height)
@@ -625,6 +597,7 @@ void Output_EndScene(void)
     S_Output_RenderEnd();
     S_Output_FlipScreen();
     Shell_ProcessEvents();
+    FrameArena_Reset();
     g_FPSCounter++;
 }
 
@@ -633,6 +606,16 @@ void Output_ClearDepthBuffer(void)
     S_Output_ClearDepthBuffer();
 }
 
+void Output_EnableStateSorting(void)
+{
+    S_Output_EnableStateSorting();
+}
+
+void Output_DisableStateSorting(void)
+{
+    S_Output_DisableStateSorting();
+}
+
 void Output_CalculateLight(int32_t x, int32_t y, int32_t z, int16_t room_num)
 {
     ROOM *r = &g_RoomInfo[room_num];
@@ -1106,15 +1089,34 @@ void Output_LoadBackgroundFromFile(const char *const file_name)
     m_BackdropImagePath = File_GuessExtension(file_name, m_ImageExtensions);
     Memory_FreePointer(&old_path);
 
-    IMAGE *img = Image_CreateFromFileInto(
+    const IMAGE *const img = ImageCache_Get(
         m_BackdropImagePath, Viewport_GetWidth(), Viewport_GetHeight(),
         IMAGE_FIT_SMART);
     if (img != NULL) {
         S_Output_DownloadBackdropSurface(img);
-        Image_Free(img);
     }
 }
 
+bool Output_PrefetchBackground(const char *const file_name)
+{
+    ASSERT(file_name != NULL);
+    char *path = File_GuessExtension(file_name, m_ImageExtensions);
+    const bool result = ImageCache_Prefetch(
+        path, Viewport_GetWidth(), Viewport_GetHeight(), IMAGE_FIT_SMART);
+    Memory_FreePointer(&path);
+    return result;
+}
+
+bool Output_IsBackgroundReady(const char *const file_name)
+{
+    ASSERT(file_name != NULL);
+    char *path = File_GuessExtension(file_name, m_ImageExtensions);
+    const bool result = ImageCache_IsReady(
+        path, Viewport_GetWidth(), Viewport_GetHeight(), IMAGE_FIT_SMART);
+    Memory_FreePointer(&path);
+    return result;
+}
+
 void Output_UnloadBackground(void)
 {
     S_Output_DownloadBackdropSurface(NULL);
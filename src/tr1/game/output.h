@@ -32,6 +32,8 @@ void Output_EndScene(void);
 
 void Output_DrawBlack(void);
 void Output_ClearDepthBuffer(void);
+void Output_EnableStateSorting(void);
+void Output_DisableStateSorting(void);
 
 void Output_CalculateLight(int32_t x, int32_t y, int32_t z, int16_t room_num);
 void Output_CalculateStaticLight(int16_t adder);
@@ -1,5 +1,6 @@
 #include "game/packer.h"
 
+#include "game/clock.h"
 #include "global/const.h"
 #include "global/types.h"
 #include "global/vars.h"
@@ -9,6 +10,7 @@
 #include <libtrx/utils.h>
 
 #include <stddef.h>
+#include <stdlib.h>
 #include <string.h>
 
 typedef enum {
@@ -40,14 +42,24 @@ typedef struct {
     TEX_INFO *tex_infos;
 } TEX_CONTAINER;
 
+// Free space on each page is tracked as a list of maximal free rectangles,
+// which may overlap each other (MaxRects).
 typedef struct {
     int32_t index;
     int32_t free_space;
-    RGBA_8888 data[PAGE_SIZE];
+    int32_t free_rect_count;
+    int32_t free_rect_capacity;
+    RECTANGLE *free_rects;
 } TEX_PAGE;
 
 static void M_AllocateNewPage(void);
-static void M_FillVirtualData(TEX_PAGE *page, RECTANGLE *bounds);
+static void M_AddFreeRect(TEX_PAGE *page, RECTANGLE rect);
+static void M_PruneFreeRects(TEX_PAGE *page);
+static void M_OccupyArea(TEX_PAGE *page, const RECTANGLE *area);
+static bool M_FindPosition(
+    const TEX_PAGE *page, int32_t w, int32_t h, int32_t *out_x,
+    int32_t *out_y);
+static int M_CompareContainers(const void *a, const void *b);
 static void M_Cleanup(void);
 
 static RECTANGLE_COMPARISON M_Compare(RECTANGLE *r1, RECTANGLE *r2);
@@ -64,7 +76,7 @@ static void M_MoveSprite(
     int index, RECTANGLE *old_bounds, uint16_t tpage, uint16_t new_x,
     uint16_t new_y);
 
-static bool M_PackContainerAt(
+static void M_PackContainerAt(
     TEX_CONTAINER *container, TEX_PAGE *page, int x_pos, int y_pos);
 static bool M_PackContainer(TEX_CONTAINER *container);
 
@@ -78,6 +90,7 @@ static TEX_CONTAINER *m_Queue = NULL;
 
 bool Packer_Pack(PACKER_DATA *data)
 {
+    const double start_time = Clock_GetRealTime();
     m_Data = data;
 
     m_StartPage = m_Data->level_page_count - 1;
@@ -94,6 +107,13 @@ bool Packer_Pack(PACKER_DATA *data)
         M_PrepareSprite(i);
     }
 
+    // Placing the largest textures first leaves the smaller ones to fill in
+    // the gaps.
+    if (m_Queue != NULL) {
+        qsort(
+            m_Queue, m_QueueSize, sizeof(TEX_CONTAINER), M_CompareContainers);
+    }
+
     bool result = true;
     for (int i = 0; i < m_QueueSize; i++) {
         TEX_CONTAINER *container = &m_Queue[i];
@@ -104,6 +124,19 @@ bool Packer_Pack(PACKER_DATA *data)
         }
     }
 
+    if (result) {
+        int32_t used_space = 0;
+        for (int i = 0; i < m_UsedPageCount; i++) {
+            used_space += PAGE_SIZE - m_VirtualPages[i].free_space;
+        }
+        LOG_INFO(
+            "Packed %d containers into %d page(s) in %.2f ms, utilisation "
+            "%.1f%%",
+            m_QueueSize, m_UsedPageCount,
+            (Clock_GetRealTime() - start_time) * 1000.0,
+            used_space * 100.0 / (m_UsedPageCount * PAGE_SIZE));
+    }
+
     M_Cleanup();
     return result;
 }
@@ -118,7 +151,7 @@ static void M_PrepareObject(int object_index)
     PHD_TEXTURE *object_texture = &g_PhdTextureInfo[object_index];
     if (object_texture->tpage == m_StartPage) {
         RECTANGLE *bounds = M_GetObjectBounds(object_texture);
-        M_FillVirtualData(m_VirtualPages, bounds);
+        M_OccupyArea(m_VirtualPages, bounds);
         Memory_FreePointer(&bounds);
 
     } else if (object_texture->tpage > m_StartPage) {
@@ -138,7 +171,7 @@ static void M_PrepareSprite(int sprite_index)
     PHD_SPRITE *sprite_texture = &g_PhdSpriteInfo[sprite_index];
     if (sprite_texture->tpage == m_StartPage) {
         RECTANGLE *bounds = M_GetSpriteBounds(sprite_texture);
-        M_FillVirtualData(m_VirtualPages, bounds);
+        M_OccupyArea(m_VirtualPages, bounds);
         Memory_FreePointer(&bounds);
     } else if (sprite_texture->tpage > m_StartPage) {
         TEX_INFO *info = Memory_Alloc(sizeof(TEX_INFO));
@@ -152,20 +185,130 @@ static void M_PrepareSprite(int sprite_index)
     }
 }
 
-static void M_FillVirtualData(TEX_PAGE *page, RECTANGLE *bounds)
+static void M_AddFreeRect(TEX_PAGE *const page, const RECTANGLE rect)
+{
+    if (page->free_rect_count == page->free_rect_capacity) {
+        page->free_rect_capacity = MAX(page->free_rect_capacity * 2, 16);
+        page->free_rects = Memory_Realloc(
+            page->free_rects, sizeof(RECTANGLE) * page->free_rect_capacity);
+    }
+    page->free_rects[page->free_rect_count++] = rect;
+}
+
+static void M_PruneFreeRects(TEX_PAGE *const page)
+{
+    // Drop free rectangles that lie entirely within another one.
+    for (int i = 0; i < page->free_rect_count; i++) {
+        for (int j = i + 1; j < page->free_rect_count; j++) {
+            const RECTANGLE_COMPARISON comparison =
+                M_Compare(&page->free_rects[i], &page->free_rects[j]);
+            if (comparison == RC_COVERS) {
+                page->free_rects[i] =
+                    page->free_rects[--page->free_rect_count];
+                i--;
+                break;
+            } else if (comparison != RC_UNRELATED) {
+                page->free_rects[j--] =
+                    page->free_rects[--page->free_rect_count];
+            }
+        }
+    }
+}
+
+static void M_OccupyArea(TEX_PAGE *const page, const RECTANGLE *const area)
+{
+    const int32_t area_x_end = area->x + area->w;
+    const int32_t area_y_end = area->y + area->h;
+
+    const int32_t count = page->free_rect_count;
+    int32_t kept = 0;
+    for (int i = 0; i < count; i++) {
+        const RECTANGLE rect = page->free_rects[i];
+        const int32_t rect_x_end = rect.x + rect.w;
+        const int32_t rect_y_end = rect.y + rect.h;
+        if (area->x >= rect_x_end || area_x_end <= rect.x
+            || area->y >= rect_y_end || area_y_end <= rect.y) {
+            page->free_rects[kept++] = rect;
+            continue;
+        }
+
+        // Split the intersected rectangle into the (up to four) maximal
+        // rectangles that surround the occupied area.
+        if (area->x > rect.x) {
+            M_AddFreeRect(
+                page,
+                (RECTANGLE) { rect.x, rect.y, area->x - rect.x, rect.h });
+        }
+        if (area_x_end < rect_x_end) {
+            M_AddFreeRect(
+                page,
+                (RECTANGLE) { area_x_end, rect.y, rect_x_end - area_x_end,
+                              rect.h });
+        }
+        if (area->y > rect.y) {
+            M_AddFreeRect(
+                page,
+                (RECTANGLE) { rect.x, rect.y, rect.w, area->y - rect.y });
+        }
+        if (area_y_end < rect_y_end) {
+            M_AddFreeRect(
+                page,
+                (RECTANGLE) { rect.x, area_y_end, rect.w,
+                              rect_y_end - area_y_end });
+        }
+    }
+
+    // Compact the untouched rectangles together with the new splits.
+    const int32_t added = page->free_rect_count - count;
+    memmove(
+        &page->free_rects[kept], &page->free_rects[count],
+        sizeof(RECTANGLE) * added);
+    page->free_rect_count = kept + added;
+
+    M_PruneFreeRects(page);
+    page->free_space -= area->w * area->h;
+}
+
+static bool M_FindPosition(
+    const TEX_PAGE *const page, const int32_t w, const int32_t h,
+    int32_t *const out_x, int32_t *const out_y)
 {
-    int y_end = bounds->y + bounds->h;
-    int x_end = bounds->x + bounds->w;
-    for (int y = bounds->y; y < y_end; y++) {
-        for (int x = bounds->x; x < x_end; x++) {
-            page->data[y * PAGE_WIDTH + x].r = 1;
-            page->data[y * PAGE_WIDTH + x].g = 1;
-            page->data[y * PAGE_WIDTH + x].b = 1;
-            page->data[y * PAGE_WIDTH + x].a = 255;
+    // Best short side fit: pick the free rectangle that leaves the smallest
+    // leftover along its shorter side, breaking ties by the longer side.
+    int32_t best_short = INT32_MAX;
+    int32_t best_long = INT32_MAX;
+    for (int i = 0; i < page->free_rect_count; i++) {
+        const RECTANGLE *const rect = &page->free_rects[i];
+        if (rect->w < w || rect->h < h) {
+            continue;
+        }
+
+        const int32_t leftover_w = rect->w - w;
+        const int32_t leftover_h = rect->h - h;
+        const int32_t short_side = MIN(leftover_w, leftover_h);
+        const int32_t long_side = MAX(leftover_w, leftover_h);
+        if (short_side < best_short
+            || (short_side == best_short && long_side < best_long)) {
+            best_short = short_side;
+            best_long = long_side;
+            *out_x = rect->x;
+            *out_y = rect->y;
         }
     }
 
-    page->free_space -= bounds->w * bounds->h;
+    return best_short != INT32_MAX;
+}
+
+static int M_CompareContainers(const void *const a, const void *const b)
+{
+    const RECTANGLE *const bounds_a = ((const TEX_CONTAINER *)a)->bounds;
+    const RECTANGLE *const bounds_b = ((const TEX_CONTAINER *)b)->bounds;
+    const int32_t area_a = bounds_a->w * bounds_a->h;
+    const int32_t area_b = bounds_b->w * bounds_b->h;
+    if (area_a != area_b) {
+        return area_b - area_a;
+    }
+    return MAX(bounds_b->w, bounds_b->h) - MAX(bounds_a->w, bounds_a->h);
 }
 
 static bool M_EnqueueTexInfo(TEX_INFO *info)
@@ -258,7 +401,6 @@ static bool M_PackContainer(TEX_CONTAINER *container)
         return false;
     }
 
-    int y, x, y_end, x_end;
     for (int i = 0; i < m_EndPage; i++) {
         if (i == m_UsedPageCount) {
             M_AllocateNewPage();
@@ -269,14 +411,12 @@ static bool M_PackContainer(TEX_CONTAINER *container)
             continue;
         }
 
-        y_end = PAGE_HEIGHT - container->bounds->h;
-        x_end = PAGE_WIDTH - container->bounds->w;
-        for (y = 0; y <= y_end; y++) {
-            for (x = 0; x <= x_end; x++) {
-                if (M_PackContainerAt(container, page, x, y)) {
-                    return true;
-                }
-            }
+        int32_t x;
+        int32_t y;
+        if (M_FindPosition(
+                page, container->bounds->w, container->bounds->h, &x, &y)) {
+            M_PackContainerAt(container, page, x, y);
+            return true;
         }
     }
 
@@ -291,7 +431,10 @@ static void M_AllocateNewPage(void)
     TEX_PAGE *page = &m_VirtualPages[m_UsedPageCount];
     page->index = m_StartPage + m_UsedPageCount;
     page->free_space = PAGE_SIZE;
-    memset(page->data, 0, PAGE_SIZE * sizeof(RGBA_8888));
+    page->free_rect_count = 0;
+    page->free_rect_capacity = 0;
+    page->free_rects = NULL;
+    M_AddFreeRect(page, (RECTANGLE) { 0, 0, PAGE_WIDTH, PAGE_HEIGHT });
 
     if (m_UsedPageCount > 0) {
         int new_count = m_Data->level_page_count + m_UsedPageCount;
@@ -305,54 +448,40 @@ static void M_AllocateNewPage(void)
     m_UsedPageCount++;
 }
 
-static bool M_PackContainerAt(
+static void M_PackContainerAt(
     TEX_CONTAINER *container, TEX_PAGE *page, int x_pos, int y_pos)
 {
-    int y_end = y_pos + container->bounds->h;
-    int x_end = x_pos + container->bounds->w;
-
-    for (int y = y_pos; y < y_end; y++) {
-        for (int x = x_pos; x < x_end; x++) {
-            if (page->data[y * PAGE_WIDTH + x].r
-                || page->data[y * PAGE_WIDTH + x].g
-                || page->data[y * PAGE_WIDTH + x].b
-                || page->data[y * PAGE_WIDTH + x].a) {
-                return false;
-            }
-        }
-    }
-
-    // There is adequate space at this position. Copy the pixel data from the
-    // source texture page into the one identified, and fill the placeholder
-    // data to avoid anything else taking this position.
+    // Copy the pixel data from the source texture page into the one
+    // identified, and mark the area as used to avoid anything else taking
+    // this position.
     int source_page_index =
         container->tex_infos->tpage - m_Data->level_page_count;
     RGBA_8888 *source_page =
         m_Data->source_pages + source_page_index * PAGE_SIZE;
     RGBA_8888 *level_page = m_Data->level_pages + page->index * PAGE_SIZE;
 
-    int old_pixel, new_pixel;
-    for (int y = 0; y < container->bounds->h; y++) {
-        for (int x = 0; x < container->bounds->w; x++) {
-            old_pixel = (container->bounds->y + y) * PAGE_WIDTH
-                + container->bounds->x + x;
-            new_pixel = (y_pos + y) * PAGE_WIDTH + x_pos + x;
-            page->data[new_pixel].r = 1;
-            page->data[new_pixel].g = 1;
-            page->data[new_pixel].b = 1;
-            page->data[new_pixel].a = 255;
-            level_page[new_pixel] = source_page[old_pixel];
-        }
+    const RECTANGLE *const bounds = container->bounds;
+    for (int y = 0; y < bounds->h; y++) {
+        memcpy(
+            &level_page[(y_pos + y) * PAGE_WIDTH + x_pos],
+            &source_page[(bounds->y + y) * PAGE_WIDTH + bounds->x],
+            bounds->w * sizeof(RGBA_8888));
     }
 
+    const RECTANGLE area = {
+        .x = x_pos,
+        .y = y_pos,
+        .w = bounds->w,
+        .h = bounds->h,
+    };
+    M_OccupyArea(page, &area);
+
     // Move each of the child tex_info coordinates accordingly.
     for (int i = 0; i < container->size; i++) {
         TEX_INFO *texture = &container->tex_infos[i];
         texture->move(
             texture->index, texture->bounds, page->index, x_pos, y_pos);
     }
-
-    return true;
 }
 
 static void M_MoveObject(
@@ -416,6 +545,9 @@ static void M_Cleanup(void)
         Memory_FreePointer(&container->tex_infos);
     }
 
+    for (int i = 0; i < m_UsedPageCount; i++) {
+        Memory_FreePointer(&m_VirtualPages[i].free_rects);
+    }
     Memory_FreePointer(&m_VirtualPages);
     Memory_FreePointer(&m_Queue);
 }
@@ -1,8 +1,10 @@
 #include "game/room.h"
 
+#include "game/broadphase.h"
 #include "game/camera.h"
 #include "game/items.h"
 #include "game/lara/misc.h"
+#include "game/los.h"
 #include "game/lot.h"
 #include "game/music.h"
 #include "game/objects/common.h"
@@ -192,39 +194,6 @@ int32_t Room_FindGridShift(int32_t src, int32_t dst)
     }
 }
 
-void Room_GetNearByRooms(
-    int32_t x, int32_t y, int32_t z, int32_t r, int32_t h, int16_t room_num)
-{
-    g_RoomsToDrawCount = 0;
-    if (g_RoomsToDrawCount + 1 < MAX_ROOMS_TO_DRAW) {
-        g_RoomsToDraw[g_RoomsToDrawCount++] = room_num;
-    }
-    Room_GetNewRoom(x + r, y, z + r, room_num);
-    Room_GetNewRoom(x - r, y, z + r, room_num);
-    Room_GetNewRoom(x + r, y, z - r, room_num);
-    Room_GetNewRoom(x - r, y, z - r, room_num);
-    Room_GetNewRoom(x + r, y - h, z + r, room_num);
-    Room_GetNewRoom(x - r, y - h, z + r, room_num);
-    Room_GetNewRoom(x + r, y - h, z - r, room_num);
-    Room_GetNewRoom(x - r, y - h, z - r, room_num);
-}
-
-void Room_GetNewRoom(int32_t x, int32_t y, int32_t z, int16_t room_num)
-{
-    Room_GetSector(x, y, z, &room_num);
-
-    for (int i = 0; i < g_RoomsToDrawCount; i++) {
-        int16_t drawn_room = g_RoomsToDraw[i];
-        if (drawn_room == room_num) {
-            return;
-        }
-    }
-
-    if (g_RoomsToDrawCount + 1 < MAX_ROOMS_TO_DRAW) {
-        g_RoomsToDraw[g_RoomsToDrawCount++] = room_num;
-    }
-}
-
 SECTOR *Room_GetPitSector(
     const SECTOR *sector, const int32_t x, const int32_t z)
 {
@@ -590,6 +559,8 @@ void Room_AlterFloorHeight(ITEM *item, int32_t height)
             sky_sector->ceiling.height + ROUND_TO_CLICK(height);
     }
 
+    LOS_InvalidateCache();
+
     if (g_Boxes[sector->box].overlap_index & BLOCKABLE) {
         if (height < 0) {
             g_Boxes[sector->box].overlap_index |= BLOCKED;
@@ -632,6 +603,8 @@ void Room_FlipMap(void)
     }
 
     g_FlipStatus = !g_FlipStatus;
+    Broadphase_InvalidateStatics();
+    LOS_InvalidateCache();
 }
 
 void Room_TestTriggers(const ITEM *const item)
@@ -1,9 +1,11 @@
 #include "game/savegame.h"
 
+#include "game/broadphase.h"
 #include "game/game_string.h"
 #include "game/gameflow.h"
 #include "game/inventory.h"
 #include "game/items.h"
+#include "game/los.h"
 #include "game/lot.h"
 #include "game/objects/creatures/pod.h"
 #include "game/objects/general/pickup.h"
@@ -442,6 +444,8 @@ bool Savegame_Load(const int32_t slot_num)
     if (ret) {
         M_LoadPostprocess();
     }
+    Broadphase_Invalidate();
+    LOS_InvalidateCache();
 
     g_GameInfo.save_initial_version = m_SavegameInfo[slot_num].initial_version;
 
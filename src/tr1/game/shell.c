@@ -23,10 +23,14 @@
 #include "specific/s_shell.h"
 
 #include <libtrx/config.h>
+#include <libtrx/engine/image_cache.h>
+#include <libtrx/engine/recorder.h>
 #include <libtrx/enum_map.h>
 #include <libtrx/filesystem.h>
+#include <libtrx/frame_arena.h>
 #include <libtrx/game/gamebuf.h>
 #include <libtrx/game/ui/common.h>
+#include <libtrx/hash_map.h>
 #include <libtrx/log.h>
 #include <libtrx/memory.h>
 
@@ -122,12 +126,15 @@ void Shell_Shutdown(void)
     Savegame_Shutdown();
     GameFlow_Shutdown();
 
+    ImageCache_Shutdown();
     Output_Shutdown();
+    Recorder_Stop();
     Input_Shutdown();
     Music_Shutdown();
     Sound_Shutdown();
     UI_Shutdown();
     Text_Shutdown();
+    FrameArena_Shutdown();
     Config_Shutdown();
     Log_Shutdown();
 }
@@ -264,6 +271,7 @@ void Shell_Main(void)
     Config_Write();
     EnumMap_Shutdown();
     GameString_Shutdown();
+    HashMap_FreeInterned();
 }
 
 void Shell_ProcessInput(void)
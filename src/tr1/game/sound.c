@@ -31,6 +31,7 @@ typedef struct {
     int sound_id;
     const XYZ_32 *pos;
     uint32_t loudness;
+    int32_t distance;
     int16_t volume;
     int16_t pan;
     SOUND_EFFECT_ID effect_num;
@@ -57,6 +58,8 @@ static int16_t m_AmbientLookup[MAX_AMBIENT_FX] = {};
 static int32_t m_AmbientLookupIdx = 0;
 static int m_DecibelLUT[DECIBEL_LUT_SIZE] = {};
 static bool m_SoundIsActive = false;
+// The sound filter option as last applied to the playing sounds.
+static bool m_FiltersEnabled = false;
 
 static int32_t M_ConvertVolumeToDecibel(int volume);
 static int32_t M_ConvertPanToDecibel(uint16_t pan);
@@ -65,6 +68,8 @@ static float M_CalcPitch(int pitch);
 static SOUND_SLOT *M_GetSlot(
     int32_t sfx_num, uint32_t loudness, const XYZ_32 *pos, int16_t mode);
 static void M_UpdateSlotParams(SOUND_SLOT *slot);
+static void M_UpdateSlotFilter(const SOUND_SLOT *slot);
+static void M_SyncFilterOption(void);
 static void M_ClearSlot(SOUND_SLOT *slot);
 static void M_ClearSlotHandles(SOUND_SLOT *slot);
 static void M_ResetAmbientLoudness(void);
@@ -144,8 +149,8 @@ static void M_UpdateSlotParams(SOUND_SLOT *slot)
     }
 
     uint32_t distance = SQUARE(x) + SQUARE(y) + SQUARE(z);
-    int32_t volume =
-        s->volume - Math_Sqrt(distance) * SOUND_RANGE_MULT_CONSTANT;
+    slot->distance = Math_Sqrt(distance);
+    int32_t volume = s->volume - slot->distance * SOUND_RANGE_MULT_CONSTANT;
     if (volume < 0) {
         slot->volume = 0;
         return;
@@ -166,6 +171,40 @@ static void M_UpdateSlotParams(SOUND_SLOT *slot)
     slot->pan = angle;
 }
 
+static void M_UpdateSlotFilter(const SOUND_SLOT *const slot)
+{
+    // New sounds start unfiltered, and M_SyncFilterOption resets the
+    // playing ones when the option is turned off.
+    if (!g_Config.audio.enable_sound_filters) {
+        return;
+    }
+
+    // Sounds without a position, such as the menu sounds, are left as is.
+    const bool is_underwater = slot->pos != NULL
+        && (g_RoomInfo[g_Camera.pos.room_num].flags & RF_UNDERWATER);
+    Audio_Sample_SetFilter(
+        slot->sound_id, slot->distance / (float)SOUND_RADIUS, is_underwater);
+}
+
+static void M_SyncFilterOption(void)
+{
+    if (m_FiltersEnabled == g_Config.audio.enable_sound_filters) {
+        return;
+    }
+    m_FiltersEnabled = g_Config.audio.enable_sound_filters;
+    if (m_FiltersEnabled) {
+        return;
+    }
+
+    for (int i = 0; i < MAX_PLAYING_FX; i++) {
+        const SOUND_SLOT *const slot = &m_SFXPlaying[i];
+        if ((slot->flags & SOUND_FLAG_USED)
+            && slot->sound_id != AUDIO_NO_SOUND) {
+            Audio_Sample_SetFilter(slot->sound_id, 0.0f, false);
+        }
+    }
+}
+
 static void M_ClearSlot(SOUND_SLOT *slot)
 {
     slot->sound_id = AUDIO_NO_SOUND;
@@ -173,6 +212,7 @@ static void M_ClearSlot(SOUND_SLOT *slot)
     slot->flags = SOUND_FLAG_UNUSED;
     slot->volume = 0;
     slot->pan = 0;
+    slot->distance = 0;
     slot->loudness = SOUND_NOT_AUDIBLE;
     slot->effect_num = SFX_INVALID;
 }
@@ -223,6 +263,8 @@ void Sound_UpdateEffects(void)
         return;
     }
 
+    M_SyncFilterOption();
+
     for (int i = 0; i < MAX_PLAYING_FX; i++) {
         SOUND_SLOT *slot = &m_SFXPlaying[i];
         if (!(slot->flags & SOUND_FLAG_USED)) {
@@ -238,6 +280,7 @@ void Sound_UpdateEffects(void)
                     slot->sound_id,
                     M_ConvertVolumeToDecibel(
                         (m_MasterVolume * slot->volume) >> 6));
+                M_UpdateSlotFilter(slot);
             } else {
                 if (slot->sound_id != AUDIO_NO_SOUND) {
                     Audio_Sample_Close(slot->sound_id);
@@ -254,6 +297,7 @@ void Sound_UpdateEffects(void)
                         slot->sound_id,
                         M_ConvertVolumeToDecibel(
                             (m_MasterVolume * slot->volume) >> 6));
+                    M_UpdateSlotFilter(slot);
                 } else {
                     if (slot->sound_id != AUDIO_NO_SOUND) {
                         Audio_Sample_Close(slot->sound_id);
@@ -368,6 +412,8 @@ bool Sound_Effect(
         fxslot->flags = SOUND_FLAG_USED;
         fxslot->effect_num = sfx_num;
         fxslot->pos = pos;
+        fxslot->distance = distance;
+        M_UpdateSlotFilter(fxslot);
         return true;
     }
 
@@ -383,6 +429,8 @@ bool Sound_Effect(
                 M_ConvertPanToDecibel(pan), false);
 
             M_ClearSlotHandles(fxslot);
+            fxslot->distance = distance;
+            M_UpdateSlotFilter(fxslot);
             return true;
         }
         fxslot->sound_id = Audio_Sample_Play(
@@ -395,6 +443,8 @@ bool Sound_Effect(
         fxslot->flags = SOUND_FLAG_USED;
         fxslot->effect_num = sfx_num;
         fxslot->pos = pos;
+        fxslot->distance = distance;
+        M_UpdateSlotFilter(fxslot);
         return true;
     }
 
@@ -408,6 +458,7 @@ bool Sound_Effect(
         if (fxslot->flags & SOUND_FLAG_AMBIENT) {
             if (volume > 0) {
                 fxslot->loudness = loudness;
+                fxslot->distance = distance;
                 fxslot->pan = pan;
                 fxslot->volume = volume;
             } else {
@@ -432,6 +483,8 @@ bool Sound_Effect(
             fxslot->volume = volume;
             fxslot->flags |= SOUND_FLAG_AMBIENT | SOUND_FLAG_USED;
             fxslot->pos = pos;
+            fxslot->distance = distance;
+            M_UpdateSlotFilter(fxslot);
             return true;
         }
 
@@ -522,6 +575,7 @@ void Sound_StopAmbientSounds(void)
 void Sound_LoadSamples(
     size_t num_samples, const char **sample_pointers, size_t *sizes)
 {
+    Audio_Sample_SetDiskCache(g_Config.audio.enable_sample_disk_cache);
     Audio_Sample_LoadMany(num_samples, sample_pointers, sizes);
 }
 
@@ -16,6 +16,7 @@
 #include <string.h>
 
 #define CLIP_VERTCOUNT_SCALE 4
+#define STREAM_VERTCOUNT_SCALE 16
 #define MAP_DEPTH(zv) (g_FltResZBuf - g_FltResZ * (1.0 / (double)(zv)))
 #define VBUF_VISIBLE(a, b, c)                                                  \
     (((a).ys - (b).ys) * ((c).xs - (b).xs)                                     \
@@ -107,6 +108,11 @@ static void M_ReleaseSurfaces(void)
     }
 }
 
+const GFX_3D_RENDERER_STATS *Output_GetRendererStats(void)
+{
+    return GFX_3D_Renderer_GetStats(m_Renderer3D);
+}
+
 void Output_FillEnvironmentMap(void)
 {
     GFX_3D_Renderer_FillEnvironmentMap(m_Renderer3D);
@@ -444,6 +450,16 @@ void S_Output_DisableDepthTest(void)
     GFX_3D_Renderer_SetDepthTestEnabled(m_Renderer3D, false);
 }
 
+void S_Output_EnableStateSorting(void)
+{
+    GFX_3D_Renderer_SetStateSortingEnabled(m_Renderer3D, true);
+}
+
+void S_Output_DisableStateSorting(void)
+{
+    GFX_3D_Renderer_SetStateSortingEnabled(m_Renderer3D, false);
+}
+
 void S_Output_RenderBegin(void)
 {
     GFX_Context_Clear();
@@ -470,6 +486,14 @@ void S_Output_ClearDepthBuffer(void)
     GFX_3D_Renderer_ClearDepth(m_Renderer3D);
 }
 
+void S_Output_ReserveVertexBuffer(const size_t size)
+{
+    // a frame is made of many meshes, each of which can be clipped into more
+    // vertices than it started with
+    GFX_3D_Renderer_ReserveVertices(
+        m_Renderer3D, size * CLIP_VERTCOUNT_SCALE * STREAM_VERTCOUNT_SCALE);
+}
+
 void S_Output_DrawBackdropSurface(void)
 {
     if (m_PictureSurface == NULL) {
@@ -5,6 +5,7 @@
 #include <libtrx/engine/image.h>
 
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
 bool S_Output_Init(void);
@@ -16,11 +17,14 @@ void S_Output_EnableDepthWrites(void);
 void S_Output_DisableDepthWrites(void);
 void S_Output_EnableDepthTest(void);
 void S_Output_DisableDepthTest(void);
+void S_Output_EnableStateSorting(void);
+void S_Output_DisableStateSorting(void);
 
 void S_Output_RenderBegin(void);
 void S_Output_RenderEnd(void);
 void S_Output_FlipScreen(void);
 void S_Output_ClearDepthBuffer(void);
+void S_Output_ReserveVertexBuffer(size_t size);
 
 void S_Output_SetWindowSize(int width, int height);
 void S_Output_ApplyRenderSettings(void);
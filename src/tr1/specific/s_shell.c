@@ -9,6 +9,7 @@
 #include "game/sound.h"
 
 #include <libtrx/config.h>
+#include <libtrx/engine/audio.h>
 #include <libtrx/filesystem.h>
 #include <libtrx/game/ui/common.h>
 #include <libtrx/gfx/common.h>
@@ -218,6 +219,8 @@ void Shell_ProcessEvents(void)
             break;
         }
     }
+
+    Audio_Update();
 }
 
 int main(int argc, char **argv)
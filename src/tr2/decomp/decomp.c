@@ -168,6 +168,13 @@ int32_t Level_Initialise(
     InitialiseGameFlags();
     g_Lara.item_num = NO_ITEM;
 
+    // open the level music while the level loads
+    if ((level_type == GFL_NORMAL || level_type == GFL_SAVED
+         || level_type == GFL_DEMO)
+        && g_GF_MusicTracks[0]) {
+        Music_Prefetch(g_GF_MusicTracks[0]);
+    }
+
     bool result;
     if (level_type == GFL_TITLE) {
         result = S_LoadLevelFile(g_GF_TitleFileNames[0], level_num, level_type);
@@ -282,6 +289,11 @@ GAME_FLOW_COMMAND DisplayCredits(void)
 
     for (int32_t i = 0; i < 8; i++) {
         char file_name[60];
+        // decode the next picture while this one is shown
+        if (i + 1 < 8) {
+            sprintf(file_name, "data/credit0%d.pcx", i + 2);
+            Output_PrefetchBackground(file_name);
+        }
         sprintf(file_name, "data/credit0%d.pcx", i + 1);
 
         PHASE *const phase = Phase_Picture_Create((PHASE_PICTURE_ARGS) {
@@ -1,10 +1,13 @@
 #include "game/box.h"
 
+#include "game/items.h"
 #include "game/random.h"
 #include "game/room.h"
 #include "global/const.h"
 #include "global/vars.h"
 
+#include <libtrx/jobs.h>
+#include <libtrx/memory.h>
 #include <libtrx/utils.h>
 
 #define BOX_OVERLAP_BITS 0x3FFF
@@ -23,8 +26,100 @@
 #define BOX_CLIP_ALL                                                           \
     (BOX_CLIP_LEFT | BOX_CLIP_RIGHT | BOX_CLIP_TOP | BOX_CLIP_BOTTOM) // = 15
 #define BOX_CLIP_SECONDARY 16
+#define BOX_MAX_PREDICTED_NODES 128
+
+typedef struct {
+    int16_t box_num;
+    BOX_NODE node;
+} M_NODE_WRITE;
+
+typedef struct {
+    int16_t box_num;
+    uint16_t overlap_index;
+} M_BOX_READ;
+
+// The outcome of running a creature's LOT search ahead of its control
+// routine. The search result is kept in a copy of every node it touched, and
+// is only applied if the LOT and every box it looked at are still the same
+// when the control routine gets to it, which keeps it identical to running
+// the search in place.
+typedef struct {
+    LOT_INFO *lot;
+    LOT_INFO before;
+    LOT_INFO after;
+    int32_t result;
+    int32_t flip_status;
+    bool is_valid;
+    int32_t write_count;
+    M_NODE_WRITE writes[BOX_MAX_PREDICTED_NODES];
+    BOX_NODE overflow;
+    int32_t read_count;
+    M_BOX_READ reads[BOX_MAX_PREDICTED_NODES];
+} M_PREDICTION;
+
+static struct {
+    M_PREDICTION *data;
+    int32_t count;
+    int32_t capacity;
+} m_Predictions = {};
+static BOX_PREDICTION_STATS m_PredictionStats = {};
+static BOX_PREDICTION_STATS m_PredictionStatsCurrent = {};
+
+static BOX_NODE *M_GetNode(
+    LOT_INFO *lot, M_PREDICTION *pred, int16_t box_num);
+static uint16_t M_GetBlockFlags(
+    const LOT_INFO *lot, M_PREDICTION *pred, int16_t box_num);
+static int32_t M_SearchLOT(
+    LOT_INFO *lot, int32_t expansion, M_PREDICTION *pred);
+static void M_Predict(void *user_data, int32_t idx);
+static bool M_IsPredictionUsable(
+    const M_PREDICTION *pred, const LOT_INFO *lot, int32_t expansion);
+static M_PREDICTION *M_FindPrediction(const LOT_INFO *lot);
+
+static BOX_NODE *M_GetNode(
+    LOT_INFO *const lot, M_PREDICTION *const pred, const int16_t box_num)
+{
+    if (pred == NULL) {
+        return &lot->node[box_num];
+    }
 
-int32_t Box_SearchLOT(LOT_INFO *const lot, const int32_t expansion)
+    for (int32_t i = 0; i < pred->write_count; i++) {
+        if (pred->writes[i].box_num == box_num) {
+            return &pred->writes[i].node;
+        }
+    }
+
+    if (pred->write_count == BOX_MAX_PREDICTED_NODES) {
+        // too many nodes touched; finish the pass on a dummy node and let
+        // the control routine run the search again
+        pred->is_valid = false;
+        return &pred->overflow;
+    }
+
+    M_NODE_WRITE *const write = &pred->writes[pred->write_count++];
+    write->box_num = box_num;
+    write->node = lot->node[box_num];
+    return &write->node;
+}
+
+static uint16_t M_GetBlockFlags(
+    const LOT_INFO *const lot, M_PREDICTION *const pred, const int16_t box_num)
+{
+    const uint16_t overlap_index = g_Boxes[box_num].overlap_index;
+    if (pred != NULL) {
+        if (pred->read_count == BOX_MAX_PREDICTED_NODES) {
+            pred->is_valid = false;
+        } else {
+            M_BOX_READ *const read = &pred->reads[pred->read_count++];
+            read->box_num = box_num;
+            read->overlap_index = overlap_index;
+        }
+    }
+    return overlap_index & lot->block_mask;
+}
+
+static int32_t M_SearchLOT(
+    LOT_INFO *const lot, const int32_t expansion, M_PREDICTION *const pred)
 {
     int16_t *zone;
     if (lot->fly) {
@@ -35,12 +130,16 @@ int32_t Box_SearchLOT(LOT_INFO *const lot, const int32_t expansion)
 
     const int16_t search_zone = zone[lot->head];
     for (int32_t i = 0; i < expansion; i++) {
+        if (pred != NULL && !pred->is_valid) {
+            return false;
+        }
+
         if (lot->head == NO_BOX) {
             lot->tail = NO_BOX;
             return false;
         }
 
-        BOX_NODE *node = &lot->node[lot->head];
+        BOX_NODE *node = M_GetNode(lot, pred, lot->head);
         const BOX_INFO *box = &g_Boxes[lot->head];
 
         bool done = false;
@@ -61,7 +160,7 @@ int32_t Box_SearchLOT(LOT_INFO *const lot, const int32_t expansion)
                 continue;
             }
 
-            BOX_NODE *const expand = &lot->node[box_num];
+            BOX_NODE *const expand = M_GetNode(lot, pred, box_num);
             if ((node->search_num & BOX_SEARCH_NUM)
                 < (expand->search_num & BOX_SEARCH_NUM)) {
                 continue;
@@ -80,7 +179,7 @@ int32_t Box_SearchLOT(LOT_INFO *const lot, const int32_t expansion)
                     continue;
                 }
 
-                if ((g_Boxes[box_num].overlap_index & lot->block_mask) != 0) {
+                if (M_GetBlockFlags(lot, pred, box_num) != 0) {
                     expand->search_num = node->search_num | BOX_BLOCKED_SEARCH;
                 } else {
                     expand->search_num = node->search_num;
@@ -89,7 +188,7 @@ int32_t Box_SearchLOT(LOT_INFO *const lot, const int32_t expansion)
             }
 
             if (expand->next_expansion == NO_BOX && box_num != lot->tail) {
-                lot->node[lot->tail].next_expansion = box_num;
+                M_GetNode(lot, pred, lot->tail)->next_expansion = box_num;
                 lot->tail = box_num;
             }
         }
@@ -101,6 +200,121 @@ int32_t Box_SearchLOT(LOT_INFO *const lot, const int32_t expansion)
     return true;
 }
 
+
+static void M_Predict(void *const user_data, const int32_t idx)
+{
+    M_PREDICTION *const pred = &m_Predictions.data[idx];
+    pred->is_valid = true;
+    pred->flip_status = g_FlipStatus;
+    pred->write_count = 0;
+    pred->read_count = 0;
+    pred->before = *pred->lot;
+    pred->after = *pred->lot;
+    pred->result = M_SearchLOT(&pred->after, BOX_MAX_EXPANSION, pred);
+}
+
+static bool M_IsPredictionUsable(
+    const M_PREDICTION *const pred, const LOT_INFO *const lot,
+    const int32_t expansion)
+{
+    if (!pred->is_valid || expansion != BOX_MAX_EXPANSION
+        || pred->flip_status != g_FlipStatus
+        || lot->head != pred->before.head || lot->tail != pred->before.tail
+        || lot->search_num != pred->before.search_num
+        || lot->block_mask != pred->before.block_mask
+        || lot->step != pred->before.step || lot->drop != pred->before.drop
+        || lot->fly != pred->before.fly
+        || lot->target_box != pred->before.target_box
+        || lot->required_box != pred->before.required_box) {
+        return false;
+    }
+
+    for (int32_t i = 0; i < pred->read_count; i++) {
+        const M_BOX_READ *const read = &pred->reads[i];
+        if (g_Boxes[read->box_num].overlap_index != read->overlap_index) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static M_PREDICTION *M_FindPrediction(const LOT_INFO *const lot)
+{
+    for (int32_t i = 0; i < m_Predictions.count; i++) {
+        if (m_Predictions.data[i].lot == lot) {
+            return &m_Predictions.data[i];
+        }
+    }
+    return NULL;
+}
+
+void Box_PredictLOTs(void)
+{
+    m_PredictionStats = m_PredictionStatsCurrent;
+    m_PredictionStatsCurrent = (BOX_PREDICTION_STATS) {};
+
+    m_Predictions.count = 0;
+    for (int16_t item_num = g_NextItemActive; item_num != NO_ITEM;
+         item_num = Item_Get(item_num)->next_active) {
+        const ITEM *const item = Item_Get(item_num);
+        const OBJECT *const object = Object_GetObject(item->object_id);
+        CREATURE *const creature = item->data;
+        if (!object->intelligent || creature == NULL
+            || (item->flags & IF_KILLED)) {
+            continue;
+        }
+
+        // only searches that keep their current target can be run ahead of
+        // time; a new target is picked from the random number generator
+        LOT_INFO *const lot = &creature->lot;
+        if (lot->required_box != NO_BOX
+            && lot->required_box != lot->target_box) {
+            continue;
+        }
+
+        if (m_Predictions.count == m_Predictions.capacity) {
+            m_Predictions.capacity = MAX(8, m_Predictions.capacity * 2);
+            m_Predictions.data = Memory_Realloc(
+                m_Predictions.data,
+                sizeof(M_PREDICTION) * m_Predictions.capacity);
+        }
+        m_Predictions.data[m_Predictions.count++].lot = lot;
+    }
+
+    m_PredictionStatsCurrent.predicted = m_Predictions.count;
+    Jobs_ParallelFor(m_Predictions.count, M_Predict, NULL);
+}
+
+void Box_ClearPredictions(void)
+{
+    m_Predictions.count = 0;
+}
+
+void Box_ResetPredictions(void)
+{
+    m_Predictions.count = 0;
+    m_PredictionStats = (BOX_PREDICTION_STATS) {};
+    m_PredictionStatsCurrent = (BOX_PREDICTION_STATS) {};
+}
+
+void Box_ForgetPrediction(const LOT_INFO *const lot)
+{
+    M_PREDICTION *const pred = M_FindPrediction(lot);
+    if (pred != NULL) {
+        pred->is_valid = false;
+    }
+}
+
+const BOX_PREDICTION_STATS *Box_GetPredictionStats(void)
+{
+    return &m_PredictionStats;
+}
+
+int32_t Box_SearchLOT(LOT_INFO *const lot, const int32_t expansion)
+{
+    return M_SearchLOT(lot, expansion, NULL);
+}
+
 int32_t Box_UpdateLOT(LOT_INFO *const lot, const int32_t expansion)
 {
     if (lot->required_box == NO_BOX || lot->required_box == lot->target_box) {
@@ -120,7 +334,22 @@ int32_t Box_UpdateLOT(LOT_INFO *const lot, const int32_t expansion)
     expand->search_num = lot->search_num;
     expand->exit_box = NO_BOX;
 
-end:
+end:;
+    M_PREDICTION *const pred = M_FindPrediction(lot);
+    if (pred != NULL) {
+        pred->lot = NULL;
+        if (M_IsPredictionUsable(pred, lot, expansion)) {
+            for (int32_t i = 0; i < pred->write_count; i++) {
+                const M_NODE_WRITE *const write = &pred->writes[i];
+                lot->node[write->box_num] = write->node;
+            }
+            lot->head = pred->after.head;
+            lot->tail = pred->after.tail;
+            m_PredictionStatsCurrent.used++;
+            return pred->result;
+        }
+        m_PredictionStatsCurrent.rejected++;
+    }
     return Box_SearchLOT(lot, expansion);
 }
 
@@ -7,6 +7,26 @@
 #define BOX_BLOCKABLE 0x8000
 #define BOX_ZONE(num) (((num) / STEP_L) - 1)
 
+typedef struct {
+    // LOT searches run ahead of time on the job pool
+    int32_t predicted;
+    // LOT searches taken from the prediction pass
+    int32_t used;
+    // predictions thrown away because the LOT or the boxes changed first
+    int32_t rejected;
+} BOX_PREDICTION_STATS;
+
+// Runs the LOT search of every active creature in parallel before the items
+// are updated. Box_UpdateLOT then picks up the results where they are still
+// valid, so the outcome is the same as searching in place.
+void Box_PredictLOTs(void);
+void Box_ClearPredictions(void);
+// Drops the predictions and the counters when a level starts.
+void Box_ResetPredictions(void);
+void Box_ForgetPrediction(const LOT_INFO *lot);
+// Counters of the previous frame.
+const BOX_PREDICTION_STATS *Box_GetPredictionStats(void);
+
 int32_t Box_SearchLOT(LOT_INFO *lot, int32_t expansion);
 int32_t Box_UpdateLOT(LOT_INFO *lot, int32_t expansion);
 void Box_TargetBox(LOT_INFO *lot, int16_t box_num);
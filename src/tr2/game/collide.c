@@ -303,10 +303,12 @@ int32_t Collide_CollideStaticObjects(
     const int32_t in_z_max = z + coll->radius;
     XYZ_32 shifter = { .x = 0, .z = 0 };
 
-    Room_GetNearbyRooms(x, y, z, coll->radius + 50, height + 50, room_num);
+    COLLISION_QUERY query;
+    Room_GetNearbyRooms(
+        &query, x, y, z, coll->radius + 50, height + 50, room_num);
 
-    for (int32_t i = 0; i < g_RoomsToDrawCount; i++) {
-        const ROOM *const room = &g_Rooms[g_RoomsToDraw[i]];
+    for (int32_t i = 0; i < query.room_count; i++) {
+        const ROOM *const room = &g_Rooms[query.room_nums[i]];
 
         for (int32_t j = 0; j < room->num_static_meshes; j++) {
             const STATIC_MESH *const mesh = &room->static_meshes[j];
@@ -0,0 +1,27 @@
+#include "game/console/cmd/lot_stats.h"
+
+#include "game/box.h"
+#include "game/game_string.h"
+
+#include <libtrx/jobs.h>
+#include <libtrx/strings.h>
+
+static COMMAND_RESULT M_Entrypoint(const COMMAND_CONTEXT *ctx);
+
+static COMMAND_RESULT M_Entrypoint(const COMMAND_CONTEXT *const ctx)
+{
+    if (!String_Equivalent(ctx->args, "")) {
+        return CR_BAD_INVOCATION;
+    }
+
+    const BOX_PREDICTION_STATS *const stats = Box_GetPredictionStats();
+    Console_Log(
+        GS(OSD_LOT_STATS), stats->predicted, Jobs_GetWorkerCount(),
+        stats->used, stats->rejected);
+    return CR_SUCCESS;
+}
+
+CONSOLE_COMMAND g_Console_Cmd_LOTStats = {
+    .prefix = "lot-?stats",
+    .proc = M_Entrypoint,
+};
@@ -1,5 +1,8 @@
 #include "game/console/setup.h"
 
+#include "game/console/cmd/lot_stats.h"
+
+#include <libtrx/game/console/cmd/audio_stats.h>
 #include <libtrx/game/console/cmd/config.h>
 #include <libtrx/game/console/cmd/die.h>
 #include <libtrx/game/console/cmd/end_level.h>
@@ -11,9 +14,12 @@
 #include <libtrx/game/console/cmd/heal.h>
 #include <libtrx/game/console/cmd/kill.h>
 #include <libtrx/game/console/cmd/load_game.h>
+#include <libtrx/game/console/cmd/mem_stats.h>
 #include <libtrx/game/console/cmd/play_demo.h>
 #include <libtrx/game/console/cmd/play_level.h>
 #include <libtrx/game/console/cmd/pos.h>
+#include <libtrx/game/console/cmd/record.h>
+#include <libtrx/game/console/cmd/render_stats.h>
 #include <libtrx/game/console/cmd/save_game.h>
 #include <libtrx/game/console/cmd/set_health.h>
 #include <libtrx/game/console/cmd/sfx.h>
@@ -43,6 +49,11 @@ CONSOLE_COMMAND *g_ConsoleCommands[] = {
     &g_Console_Cmd_SetHealth,
     &g_Console_Cmd_GiveItem,
     &g_Console_Cmd_SFX,
+    &g_Console_Cmd_RenderStats,
+    &g_Console_Cmd_MemStats,
+    &g_Console_Cmd_Record,
+    &g_Console_Cmd_AudioStats,
+    &g_Console_Cmd_LOTStats,
     // clang-format on
     NULL,
 };
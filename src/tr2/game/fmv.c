@@ -11,6 +11,7 @@
 #include <libtrx/debug.h>
 #include <libtrx/engine/video.h>
 #include <libtrx/filesystem.h>
+#include <libtrx/gfx/context.h>
 #include <libtrx/log.h>
 #include <libtrx/memory.h>
 
@@ -27,6 +28,7 @@ static void M_RenderEnd(void *surface, void *user_data);
 static void *M_LockSurface(void *surface, void *user_data);
 static void M_UnlockSurface(void *surface, void *user_data);
 static void M_UploadSurface(void *surface, void *user_data);
+static void M_UploadYUV(const VIDEO_YUV_FRAME *frame, void *user_data);
 
 static void M_Play(const char *file_name);
 
@@ -86,6 +88,28 @@ static void M_UploadSurface(void *const surface, void *const user_data)
     GFX_2D_Renderer_Render(renderer_2d);
 }
 
+static void M_UploadYUV(
+    const VIDEO_YUV_FRAME *const frame, void *const user_data)
+{
+    GFX_2D_RENDERER *const renderer_2d = user_data;
+    GFX_2D_SURFACE_DESC desc = {
+        .width = frame->width,
+        .height = frame->height,
+    };
+    for (int32_t i = 0; i < 4; i++) {
+        desc.uv[i].u = frame->uv[i].u;
+        desc.uv[i].v = frame->uv[i].v;
+    }
+    const GFX_2D_YUV_DATA data = {
+        .planes = { frame->planes[0], frame->planes[1], frame->planes[2] },
+        .pitches = { frame->pitches[0], frame->pitches[1], frame->pitches[2] },
+        .is_bt709 = frame->is_bt709,
+        .is_full_range = frame->is_full_range,
+    };
+    GFX_2D_Renderer_UploadYUV(renderer_2d, &desc, &data);
+    GFX_2D_Renderer_Render(renderer_2d);
+}
+
 static void M_Play(const char *const file_name)
 {
     VIDEO *const video = Video_Open(file_name);
@@ -128,9 +152,13 @@ static void M_Play(const char *const file_name)
             Shell_GetCurrentDisplayHeight());
         if (g_Config.rendering.render_mode == RM_SOFTWARE) {
             Video_SetSurfacePixelFormat(video, AV_PIX_FMT_RGB8);
+            Video_SetYUVUploadFunc(video, NULL, NULL);
             GFX_2D_Renderer_SetPalette(renderer_2d, palette);
         } else {
             Video_SetSurfacePixelFormat(video, AV_PIX_FMT_BGRA);
+            if (GFX_Context_GetConfig()->backend == GFX_GL_33C) {
+                Video_SetYUVUploadFunc(video, M_UploadYUV, renderer_2d);
+            }
             GFX_2D_Renderer_SetPalette(renderer_2d, NULL);
         }
 
@@ -1,5 +1,6 @@
 #include "game/items.h"
 
+#include "game/box.h"
 #include "game/effects.h"
 #include "game/gameflow/gameflow_new.h"
 #include "game/item_actions.h"
@@ -70,6 +71,8 @@ void Item_InitialiseArray(const int32_t num_items)
 
 void Item_Control(void)
 {
+    Box_PredictLOTs();
+
     int16_t item_num = g_NextItemActive;
     while (item_num != NO_ITEM) {
         const ITEM *const item = Item_Get(item_num);
@@ -80,6 +83,8 @@ void Item_Control(void)
         }
         item_num = next;
     }
+
+    Box_ClearPredictions();
 }
 
 int32_t Item_GetTotalCount(void)
@@ -15,6 +15,7 @@
 #include "global/vars.h"
 
 #include <libtrx/benchmark.h>
+#include <libtrx/config.h>
 #include <libtrx/debug.h>
 #include <libtrx/engine/audio.h>
 #include <libtrx/filesystem.h>
@@ -664,6 +665,7 @@ static void M_LoadSamples(VFILE *const file)
     BENCHMARK *const benchmark = Benchmark_Start();
     int32_t *sample_offsets = NULL;
 
+    Audio_Sample_SetDiskCache(g_Config.audio.enable_sample_disk_cache);
     Audio_Sample_CloseAll();
     Audio_Sample_UnloadAll();
 
@@ -22,6 +22,7 @@ void LOT_InitialiseArray(void)
     }
 
     m_SlotsUsed = 0;
+    Box_ResetPredictions();
 }
 
 void LOT_DisableBaddieAI(const int16_t item_num)
@@ -207,6 +208,7 @@ void LOT_CreateZone(ITEM *const item)
 
 void LOT_ClearLOT(LOT_INFO *const lot)
 {
+    Box_ForgetPrediction(lot);
     lot->search_num = 0;
     lot->head = NO_BOX;
     lot->tail = NO_BOX;
@@ -85,6 +85,9 @@ bool Music_Init(void);
 void Music_Shutdown(void);
 void Music_Play(MUSIC_TRACK_ID track_id, MUSIC_PLAY_MODE mode);
 void Music_Stop(void);
+// Opens the track in the background, so that playing it later starts
+// without a delay.
+void Music_Prefetch(MUSIC_TRACK_ID track_id);
 bool Music_PlaySynced(int16_t track_id);
 double Music_GetTimestamp(void);
 bool Music_SeekTimestamp(double timestamp);
@@ -26,7 +26,10 @@ typedef struct {
 static bool M_Parse(BACKEND_DATA *data);
 static bool M_Init(MUSIC_BACKEND *backend);
 static const char *M_Describe(const MUSIC_BACKEND *backend);
+static const CDAUDIO_TRACK *M_GetTrack(
+    const BACKEND_DATA *data, int32_t track_id);
 static int32_t M_Play(const MUSIC_BACKEND *backend, int32_t track_id);
+static void M_Prefetch(const MUSIC_BACKEND *backend, int32_t track_id);
 
 static bool M_Parse(BACKEND_DATA *const data)
 {
@@ -129,6 +132,18 @@ static const char *M_Describe(const MUSIC_BACKEND *const backend)
     return data->description;
 }
 
+static const CDAUDIO_TRACK *M_GetTrack(
+    const BACKEND_DATA *const data, const int32_t track_id)
+{
+    const int32_t track_idx = track_id - 1;
+    if (track_idx < 0 || track_idx >= MAX_CD_TRACKS
+        || !data->tracks[track_idx].active) {
+        LOG_ERROR("Invalid track: %d", track_id);
+        return NULL;
+    }
+    return &data->tracks[track_idx];
+}
+
 static int32_t M_Play(
     const MUSIC_BACKEND *const backend, const int32_t track_id)
 {
@@ -136,23 +151,27 @@ static int32_t M_Play(
     const BACKEND_DATA *const data = backend->data;
     ASSERT(data != NULL);
 
-    const int32_t track_idx = track_id - 1;
-    const CDAUDIO_TRACK *track = &data->tracks[track_idx];
-    if (track_idx < 0 || track_idx >= MAX_CD_TRACKS) {
-        LOG_ERROR("Invalid track: %d", track_id);
+    const CDAUDIO_TRACK *const track = M_GetTrack(data, track_id);
+    if (track == NULL) {
         return -1;
     }
 
-    if (!track->active) {
-        LOG_ERROR("Invalid track: %d", track_id);
-        return -1;
-    }
+    return Audio_Stream_CreateFromFileRange(
+        data->path, track->from / 1000.0, track->to / 1000.0);
+}
 
-    int32_t audio_stream_id = Audio_Stream_CreateFromFile(data->path);
-    Audio_Stream_SetStartTimestamp(audio_stream_id, track->from / 1000.0);
-    Audio_Stream_SetStopTimestamp(audio_stream_id, track->to / 1000.0);
-    Audio_Stream_SeekTimestamp(audio_stream_id, track->from / 1000.0);
-    return audio_stream_id;
+static void M_Prefetch(
+    const MUSIC_BACKEND *const backend, const int32_t track_id)
+{
+    ASSERT(backend != NULL);
+    const BACKEND_DATA *const data = backend->data;
+    ASSERT(data != NULL);
+
+    const CDAUDIO_TRACK *const track = M_GetTrack(data, track_id);
+    if (track != NULL) {
+        Audio_Stream_Prefetch(
+            data->path, track->from / 1000.0, track->to / 1000.0);
+    }
 }
 
 MUSIC_BACKEND *Music_Backend_CDAudio_Factory(const char *path)
@@ -173,6 +192,7 @@ MUSIC_BACKEND *Music_Backend_CDAudio_Factory(const char *path)
     backend->init = M_Init;
     backend->describe = M_Describe;
     backend->play = M_Play;
+    backend->prefetch = M_Prefetch;
     return backend;
 }
 
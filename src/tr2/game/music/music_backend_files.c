@@ -19,6 +19,7 @@ static char *M_GetTrackFileName(const char *base_dir, int32_t track);
 static const char *M_Describe(const MUSIC_BACKEND *backend);
 static bool M_Init(MUSIC_BACKEND *backend);
 static int32_t M_Play(const MUSIC_BACKEND *backend, int32_t track_id);
+static void M_Prefetch(const MUSIC_BACKEND *backend, int32_t track_id);
 
 static char *M_GetTrackFileName(const char *base_dir, int32_t track)
 {
@@ -65,6 +66,20 @@ static int32_t M_Play(
     return Audio_Stream_CreateFromFile(file_path);
 }
 
+static void M_Prefetch(
+    const MUSIC_BACKEND *const backend, const int32_t track_id)
+{
+    ASSERT(backend != NULL);
+    const BACKEND_DATA *const data = backend->data;
+    ASSERT(data != NULL);
+
+    char *file_path = M_GetTrackFileName(data->dir, track_id);
+    if (file_path != NULL) {
+        Audio_Stream_Prefetch(file_path, -1.0, -1.0);
+        Memory_FreePointer(&file_path);
+    }
+}
+
 MUSIC_BACKEND *Music_Backend_Files_Factory(const char *path)
 {
     ASSERT(path != NULL);
@@ -83,6 +98,7 @@ MUSIC_BACKEND *Music_Backend_Files_Factory(const char *path)
     backend->init = M_Init;
     backend->describe = M_Describe;
     backend->play = M_Play;
+    backend->prefetch = M_Prefetch;
     return backend;
 }
 
@@ -179,6 +179,14 @@ bool Music_PlaySynced(int16_t track_id)
     return true;
 }
 
+void Music_Prefetch(const MUSIC_TRACK_ID track_id)
+{
+    if (m_Backend == NULL || m_Backend->prefetch == NULL) {
+        return;
+    }
+    m_Backend->prefetch(m_Backend, Music_GetRealTrack(track_id));
+}
+
 double Music_GetTimestamp(void)
 {
     if (m_AudioStreamID < 0) {
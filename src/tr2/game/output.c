@@ -11,6 +11,8 @@
 #include "global/vars.h"
 
 #include <libtrx/config.h>
+#include <libtrx/engine/image_cache.h>
+#include <libtrx/frame_arena.h>
 #include <libtrx/game/math.h>
 #include <libtrx/log.h>
 #include <libtrx/utils.h>
@@ -22,8 +24,10 @@ static LIGHT m_DynamicLights[MAX_DYNAMIC_LIGHTS] = {};
 static float m_WibbleTable[32];
 static int16_t m_ShadesTable[32];
 static int32_t m_RandomTable[32];
+static XYZ_32 m_ViewPos[MAX_VBUF_VERTICES];
 
 static int32_t M_CalcFogShade(int32_t depth);
+static inline int16_t M_CalcScreenClip(double xs, double ys);
 
 static const int16_t *M_CalcRoomVerticesWibble(const int16_t *obj_ptr);
 
@@ -42,6 +46,21 @@ static int32_t M_CalcFogShade(const int32_t depth)
     return 0;
 }
 
+// Gives the same flags as testing each edge in turn, as the left edge never
+// lies past the right one nor the top past the bottom. The vertex loops that
+// use this first transform the whole mesh with Math_TransformVertices, which
+// runs four vertices at a time, and then project and clip one PHD_VBUF at a
+// time, as that part branches on the near plane.
+static inline int16_t M_CalcScreenClip(const double xs, const double ys)
+{
+    // clang-format off
+    return (xs < g_FltWinLeft)
+        | (xs > g_FltWinRight) << 1
+        | (ys < g_FltWinTop) << 2
+        | (ys > g_FltWinBottom) << 3;
+    // clang-format on
+}
+
 static void M_InsertBar(
     const int32_t l, const int32_t t, const int32_t w, const int32_t h,
     const int32_t percent, const COLOR_NAME bar_color_main,
@@ -99,18 +118,8 @@ static const int16_t *M_CalcRoomVerticesWibble(const int16_t *obj_ptr)
             [(((g_WibbleOffset + (int)xs) % WIBBLE_SIZE) + WIBBLE_SIZE)
              % WIBBLE_SIZE];
 
-        int16_t clip_flags = vbuf->clip & ~15;
-        if (xs < g_FltWinLeft) {
-            clip_flags |= 1;
-        } else if (xs > g_FltWinRight) {
-            clip_flags |= 2;
-        }
-
-        if (ys < g_FltWinTop) {
-            clip_flags |= 4;
-        } else if (ys > g_FltWinBottom) {
-            clip_flags |= 8;
-        }
+        const int16_t clip_flags =
+            (vbuf->clip & ~15) | M_CalcScreenClip(xs, ys);
         vbuf->xs = xs;
         vbuf->ys = ys;
         vbuf->clip = clip_flags;
@@ -201,67 +210,43 @@ const int16_t *Output_CalcObjectVertices(const int16_t *obj_ptr)
     const double base_z = g_Config.rendering.enable_zbuffer
         ? 0.0
         : (g_MidSort << (W2V_SHIFT + 8));
+    const MATRIX *const mptr = g_MatrixPtr;
+    const float near_z = g_FltNearZ;
+    const float far_z = g_FltFarZ;
+    const float persp_o = g_FltPersp;
+    const float rhw_o_persp = g_FltRhwOPersp;
+    const float center_x = g_FltWinCenterX;
+    const float center_y = g_FltWinCenterY;
     uint8_t total_clip = 0xFF;
 
     obj_ptr++; // skip poly counter
     const int32_t vtx_count = *obj_ptr++;
 
+    Math_TransformVertices(
+        &mptr->_00, (const XYZ_16 *)obj_ptr, sizeof(int16_t) * 3, vtx_count,
+        m_ViewPos);
+
     for (int32_t i = 0; i < vtx_count; i++) {
         PHD_VBUF *const vbuf = &g_PhdVBuf[i];
-
-        // clang-format off
-        const MATRIX *const mptr = g_MatrixPtr;
-        const double xv = (
-            mptr->_00 * obj_ptr[0] +
-            mptr->_01 * obj_ptr[1] +
-            mptr->_02 * obj_ptr[2] +
-            mptr->_03
-        );
-        const double yv = (
-            mptr->_10 * obj_ptr[0] +
-            mptr->_11 * obj_ptr[1] +
-            mptr->_12 * obj_ptr[2] +
-            mptr->_13
-        );
-        double zv = (
-            mptr->_20 * obj_ptr[0] +
-            mptr->_21 * obj_ptr[1] +
-            mptr->_22 * obj_ptr[2] +
-            mptr->_23
-        );
-        // clang-format on
+        const double xv = m_ViewPos[i].x;
+        const double yv = m_ViewPos[i].y;
+        const double zv = m_ViewPos[i].z;
 
         vbuf->xv = xv;
         vbuf->yv = yv;
 
         uint8_t clip_flags;
-        if (zv < g_FltNearZ) {
+        if (zv < near_z) {
             vbuf->zv = zv;
             clip_flags = 0x80;
         } else {
-            if (zv >= g_FltFarZ) {
-                vbuf->zv = g_FltFarZ;
-            } else {
-                vbuf->zv = zv + base_z;
-            }
-
-            const double persp = g_FltPersp / zv;
-            vbuf->xs = persp * xv + g_FltWinCenterX;
-            vbuf->ys = persp * yv + g_FltWinCenterY;
-            vbuf->rhw = persp * g_FltRhwOPersp;
+            vbuf->zv = zv >= far_z ? far_z : zv + base_z;
 
-            clip_flags = 0x00;
-            if (vbuf->xs < g_FltWinLeft) {
-                clip_flags |= 1;
-            } else if (vbuf->xs > g_FltWinRight) {
-                clip_flags |= 2;
-            }
-
-            if (vbuf->ys < g_FltWinTop) {
-                clip_flags |= 4;
-            } else if (vbuf->ys > g_FltWinBottom) {
-                clip_flags |= 8;
-            }
+            const double persp = persp_o / zv;
+            vbuf->xs = persp * xv + center_x;
+            vbuf->ys = persp * yv + center_y;
+            vbuf->rhw = persp * rhw_o_persp;
+            clip_flags = M_CalcScreenClip(vbuf->xs, vbuf->ys);
         }
 
         vbuf->clip = clip_flags;
@@ -347,33 +332,25 @@ const int16_t *Output_CalcRoomVertices(const int16_t *obj_ptr, int32_t far_clip)
     const double base_z = g_Config.rendering.enable_zbuffer
         ? 0.0
         : (g_MidSort << (W2V_SHIFT + 8));
+    const MATRIX *const mptr = g_MatrixPtr;
+    const float near_z = g_FltNearZ;
+    const float far_z = g_FltFarZ;
+    const float persp_o = g_FltPersp;
+    const float rhw_o_persp = g_FltRhwOPersp;
+    const float center_x = g_FltWinCenterX;
+    const float center_y = g_FltWinCenterY;
     const int32_t vtx_count = *obj_ptr++;
 
+    Math_TransformVertices(
+        &mptr->_00, (const XYZ_16 *)obj_ptr, sizeof(int16_t) * 6, vtx_count,
+        m_ViewPos);
+
     for (int32_t i = 0; i < vtx_count; i++) {
         PHD_VBUF *const vbuf = &g_PhdVBuf[i];
-
-        // clang-format off
-        const MATRIX *const mptr = g_MatrixPtr;
-        const double xv = (
-            mptr->_00 * obj_ptr[0] +
-            mptr->_01 * obj_ptr[1] +
-            mptr->_02 * obj_ptr[2] +
-            mptr->_03
-        );
-        const double yv = (
-            mptr->_10 * obj_ptr[0] +
-            mptr->_11 * obj_ptr[1] +
-            mptr->_12 * obj_ptr[2] +
-            mptr->_13
-        );
-        const int32_t zv_int = (
-            mptr->_20 * obj_ptr[0] +
-            mptr->_21 * obj_ptr[1] +
-            mptr->_22 * obj_ptr[2] +
-            mptr->_23
-        );
+        const double xv = m_ViewPos[i].x;
+        const double yv = m_ViewPos[i].y;
+        const int32_t zv_int = m_ViewPos[i].z;
         const double zv = zv_int;
-        // clang-format on
 
         vbuf->xv = xv;
         vbuf->yv = yv;
@@ -388,10 +365,10 @@ const int16_t *Output_CalcRoomVertices(const int16_t *obj_ptr, int32_t far_clip)
         }
 
         uint16_t clip_flags = 0;
-        if (zv < g_FltNearZ) {
+        if (zv < near_z) {
             clip_flags = 0xFF80;
         } else {
-            const double persp = g_FltPersp / zv;
+            const double persp = persp_o / zv;
             const int32_t depth = zv_int >> W2V_SHIFT;
             vbuf->zv += base_z;
 
@@ -399,28 +376,16 @@ const int16_t *Output_CalcRoomVertices(const int16_t *obj_ptr, int32_t far_clip)
                 if (depth > FOG_START) {
                     shade += depth - FOG_START;
                 }
-                vbuf->rhw = persp * g_FltRhwOPersp;
             } else {
                 // clip_flags = far_clip;
                 shade = 0x1FFF;
-                vbuf->zv = g_FltFarZ;
-                vbuf->rhw = persp * g_FltRhwOPersp;
-            }
-
-            double xs = xv * persp + g_FltWinCenterX;
-            double ys = yv * persp + g_FltWinCenterY;
-
-            if (xs < g_FltWinLeft) {
-                clip_flags |= 1;
-            } else if (xs > g_FltWinRight) {
-                clip_flags |= 2;
+                vbuf->zv = far_z;
             }
+            vbuf->rhw = persp * rhw_o_persp;
 
-            if (ys < g_FltWinTop) {
-                clip_flags |= 4;
-            } else if (ys > g_FltWinBottom) {
-                clip_flags |= 8;
-            }
+            const double xs = xv * persp + center_x;
+            const double ys = yv * persp + center_y;
+            clip_flags |= M_CalcScreenClip(xs, ys);
 
             vbuf->xs = xs;
             vbuf->ys = ys;
@@ -624,6 +589,11 @@ void Output_DrawScreenSprite(
     }
 }
 
+const GFX_3D_RENDERER_STATS *Output_GetRendererStats(void)
+{
+    return Render_GetStats();
+}
+
 bool Output_MakeScreenshot(const char *const path)
 {
     LOG_INFO("Taking screenshot");
@@ -642,13 +612,24 @@ void Output_EndScene(void)
 {
     Render_EndScene();
     Shell_ProcessEvents();
+    FrameArena_Reset();
 }
 
 void Output_LoadBackgroundFromFile(const char *const file_name)
 {
-    IMAGE *const image = Image_CreateFromFile(file_name);
+    const IMAGE *const image =
+        ImageCache_Get(file_name, 0, 0, IMAGE_FIT_STRETCH);
     Render_LoadBackgroundFromImage(image);
-    Image_Free(image);
+}
+
+bool Output_PrefetchBackground(const char *const file_name)
+{
+    return ImageCache_Prefetch(file_name, 0, 0, IMAGE_FIT_STRETCH);
+}
+
+bool Output_IsBackgroundReady(const char *const file_name)
+{
+    return ImageCache_IsReady(file_name, 0, 0, IMAGE_FIT_STRETCH);
 }
 
 void Output_LoadBackgroundFromObject(void)
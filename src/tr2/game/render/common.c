@@ -256,6 +256,15 @@ void Render_ClearZBuffer(void)
     }
 }
 
+const GFX_3D_RENDERER_STATS *Render_GetStats(void)
+{
+    RENDERER *const r = M_GetRenderer();
+    if (r->GetStats != NULL) {
+        return r->GetStats(r);
+    }
+    return NULL;
+}
+
 void Render_EnableZBuffer(const bool z_write_enable, const bool z_test_enable)
 {
     RENDERER *const r = M_GetRenderer();
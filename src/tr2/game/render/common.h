@@ -4,6 +4,7 @@
 
 #include <libtrx/engine/image.h>
 #include <libtrx/gfx/2d/2d_surface.h>
+#include <libtrx/gfx/3d/3d_renderer.h>
 
 #include <stdbool.h>
 #include <stdint.h>
@@ -47,6 +48,7 @@ void Render_DrawBlackRectangle(int32_t opacity);
 void Render_ClearZBuffer(void);
 void Render_EnableZBuffer(bool z_write_enable, bool z_test_enable);
 void Render_SetWet(bool is_wet);
+const GFX_3D_RENDERER_STATS *Render_GetStats(void);
 
 // TODO: there's too much repetition for these
 const int16_t *Render_InsertObjectG3(
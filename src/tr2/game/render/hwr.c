@@ -143,6 +143,7 @@ static void M_DrawPolyList(RENDERER *renderer);
 static void M_EnableZBuffer(
     RENDERER *renderer, bool z_write_enable, bool z_test_enable);
 static void M_ClearZBuffer(RENDERER *renderer);
+static const GFX_3D_RENDERER_STATS *M_GetStats(RENDERER *renderer);
 
 static void M_ShadeColor(
     GFX_3D_VERTEX *const target, uint32_t red, uint32_t green,
@@ -1449,6 +1450,7 @@ static void M_Init(RENDERER *const renderer)
     M_PRIV *const priv = Memory_Alloc(sizeof(M_PRIV));
     priv->renderer_2d = GFX_2D_Renderer_Create();
     priv->renderer_3d = GFX_3D_Renderer_Create();
+    GFX_3D_Renderer_ReserveVertices(priv->renderer_3d, MAX_VERTICES);
 
     for (int32_t i = 0; i < GFX_MAX_TEXTURES; i++) {
         priv->texture_map[i] = GFX_NO_TEXTURE;
@@ -1538,6 +1540,9 @@ static void M_BeginScene(RENDERER *const renderer)
     GFX_3D_Renderer_SetAlphaThreshold(priv->renderer_3d, -1.0);
     GFX_3D_Renderer_SetTextureFilter(
         priv->renderer_3d, g_Config.rendering.texture_filter);
+    // z-buffered geometry can be drawn in state order until the painter's
+    // list takes over
+    GFX_3D_Renderer_SetStateSortingEnabled(priv->renderer_3d, true);
 }
 
 static void M_EndScene(RENDERER *const renderer)
@@ -1575,6 +1580,7 @@ static void M_DrawPolyList(RENDERER *const renderer)
     M_PRIV *const priv = renderer->priv;
     ASSERT(renderer->initialized && renderer->open);
 
+    GFX_3D_Renderer_SetStateSortingEnabled(priv->renderer_3d, false);
     Render_SortPolyList();
     // NOTE: depth writes only work for fully transparent pixels
     M_EnableZBuffer(renderer, true, true);
@@ -1654,6 +1660,15 @@ static void M_ClearZBuffer(RENDERER *const renderer)
     GFX_3D_Renderer_ClearDepth(priv->renderer_3d);
 }
 
+static const GFX_3D_RENDERER_STATS *M_GetStats(RENDERER *const renderer)
+{
+    M_PRIV *const priv = renderer->priv;
+    if (!renderer->initialized) {
+        return NULL;
+    }
+    return GFX_3D_Renderer_GetStats(priv->renderer_3d);
+}
+
 void Renderer_HW_Prepare(RENDERER *const renderer)
 {
     renderer->Init = M_Init;
@@ -1667,5 +1682,6 @@ void Renderer_HW_Prepare(RENDERER *const renderer)
     renderer->DrawPolyList = M_DrawPolyList;
     renderer->EnableZBuffer = M_EnableZBuffer;
     renderer->ClearZBuffer = M_ClearZBuffer;
+    renderer->GetStats = M_GetStats;
     M_ResetFuncPtrs(renderer);
 }
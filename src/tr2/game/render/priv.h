@@ -25,6 +25,7 @@ typedef struct RENDERER {
     void (*EnableZBuffer)(struct RENDERER *, bool, bool);
     void (*DrawPolyList)(struct RENDERER *);
     void (*SetWet)(struct RENDERER *, bool);
+    const GFX_3D_RENDERER_STATS *(*GetStats)(struct RENDERER *);
 
     const int16_t *(*InsertGT4)(
         struct RENDERER *renderer, const int16_t *obj_ptr, int32_t num,
@@ -2363,6 +2363,7 @@ void Renderer_SW_Prepare(RENDERER *const renderer)
     renderer->ResetPolyList = NULL;
     renderer->EnableZBuffer = NULL;
     renderer->ClearZBuffer = NULL;
+    renderer->GetStats = NULL;
     renderer->SetWet = M_SetWet;
 
     renderer->InsertObjectG3 = M_InsertObjectG3;
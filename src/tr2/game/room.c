@@ -481,30 +481,6 @@ int32_t Room_FindGridShift(int32_t src, const int32_t dst)
     }
 }
 
-void Room_GetNearbyRooms(
-    const int32_t x, const int32_t y, const int32_t z, const int32_t r,
-    const int32_t h, const int16_t room_num)
-{
-    g_RoomsToDrawCount = 0;
-    Room_MarkToBeDrawn(room_num);
-
-    Room_GetNewRoom(r + x, y, r + z, room_num);
-    Room_GetNewRoom(x - r, y, r + z, room_num);
-    Room_GetNewRoom(r + x, y, z - r, room_num);
-    Room_GetNewRoom(x - r, y, z - r, room_num);
-    Room_GetNewRoom(r + x, y - h, r + z, room_num);
-    Room_GetNewRoom(x - r, y - h, r + z, room_num);
-    Room_GetNewRoom(r + x, y - h, z - r, room_num);
-    Room_GetNewRoom(x - r, y - h, z - r, room_num);
-}
-
-void Room_GetNewRoom(
-    const int32_t x, const int32_t y, const int32_t z, int16_t room_num)
-{
-    Room_GetSector(x, y, z, &room_num);
-    Room_MarkToBeDrawn(room_num);
-}
-
 int16_t Room_GetTiltType(
     const SECTOR *sector, const int32_t x, const int32_t y, const int32_t z)
 {
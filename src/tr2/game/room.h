@@ -11,9 +11,6 @@ extern int32_t g_FlipEffect;
 int16_t Room_GetIndexFromPos(int32_t x, int32_t y, int32_t z);
 int32_t Room_FindByPos(int32_t x, int32_t y, int32_t z);
 int32_t Room_FindGridShift(int32_t src, int32_t dst);
-void Room_GetNearbyRooms(
-    int32_t x, int32_t y, int32_t z, int32_t r, int32_t h, int16_t room_num);
-void Room_GetNewRoom(int32_t x, int32_t y, int32_t z, int16_t room_num);
 int16_t Room_GetTiltType(const SECTOR *sector, int32_t x, int32_t y, int32_t z);
 
 // TODO: poor abstraction
@@ -22,12 +22,19 @@
 #include "global/vars.h"
 
 #include <libtrx/config.h>
+#include <libtrx/engine/audio.h>
+#include <libtrx/engine/image_cache.h>
+#include <libtrx/engine/recorder.h>
 #include <libtrx/enum_map.h>
+#include <libtrx/frame_arena.h>
 #include <libtrx/game/gamebuf.h>
 #include <libtrx/game/shell.h>
 #include <libtrx/game/ui/common.h>
+#include <libtrx/hash_map.h>
+#include <libtrx/jobs.h>
 #include <libtrx/log.h>
 #include <libtrx/memory.h>
+#include <libtrx/utils.h>
 
 #include <SDL2/SDL.h>
 #include <stdarg.h>
@@ -320,6 +327,7 @@ static void M_HandleConfigChange(const EVENT *const event, void *const data)
 
 static void M_DisplayLegal(void)
 {
+    Output_PrefetchBackground("data/title.pcx");
     PHASE *const phase = Phase_Picture_Create((PHASE_PICTURE_ARGS) {
         .file_name = "data/legal.pcx",
         .display_time = 6.0,
@@ -375,6 +383,7 @@ void Shell_Main(void)
     S_FrontEndCheck();
 
     GameBuf_Init(GAMEBUF_MEM_CAP);
+    Jobs_Init(MAX(0, SDL_GetCPUCount() - 1));
     M_DisplayLegal();
 
     const bool is_frontend_fail = GF_DoFrontendSequence();
@@ -464,11 +473,17 @@ void Shell_Shutdown(void)
 {
     GameString_Shutdown();
     Console_Shutdown();
+    ImageCache_Shutdown();
     Render_Shutdown();
+    Recorder_Stop();
     Text_Shutdown();
     UI_Shutdown();
     GameBuf_Shutdown();
+    Jobs_Shutdown();
+    FrameArena_Shutdown();
     Config_Shutdown();
+    EnumMap_Shutdown();
+    HashMap_FreeInterned();
 }
 
 const char *Shell_GetConfigPath(void)
@@ -572,6 +587,8 @@ void Shell_ProcessEvents(void)
             break;
         }
     }
+
+    Audio_Update();
 }
 
 SDL_Window *Shell_GetWindow(void)
@@ -25,6 +25,8 @@ typedef struct {
     int32_t pan;
     int32_t sample_num;
     int32_t pitch;
+    int32_t distance;
+    bool is_positional;
     int32_t handle;
 } SOUND_SLOT;
 
@@ -54,12 +56,16 @@ typedef enum {
 static float m_MasterVolume = 0.0f;
 static int32_t m_DecibelLUT[DECIBEL_LUT_SIZE] = {};
 static SOUND_SLOT m_SoundSlots[SOUND_MAX_SLOTS] = {};
+// The sound filter option as last applied to the playing sounds.
+static bool m_FiltersEnabled = false;
 
 static int32_t M_ConvertVolumeToDecibel(int32_t volume);
 static int32_t M_ConvertPanToDecibel(uint16_t pan);
 static float M_ConvertPitch(float pitch);
 static int32_t M_Play(
     int32_t track_id, int32_t volume, float pitch, int32_t pan, bool is_looped);
+static void M_SetFilter(int32_t handle, int32_t distance, bool is_positional);
+static void M_SyncFilterOption(void);
 
 static void M_ClearSlot(SOUND_SLOT *const slot);
 static void M_ClearAllSlots(void);
@@ -100,6 +106,41 @@ static int32_t M_Play(
     return handle;
 }
 
+static void M_SetFilter(
+    const int32_t handle, const int32_t distance, const bool is_positional)
+{
+    // New sounds start unfiltered, and M_SyncFilterOption resets the
+    // playing ones when the option is turned off.
+    if (!g_Config.audio.enable_sound_filters) {
+        return;
+    }
+
+    // Sounds without a position, such as the menu sounds, are left as is.
+    const bool is_underwater = is_positional
+        && (g_Rooms[g_Camera.pos.room_num].flags & RF_UNDERWATER);
+    Audio_Sample_SetFilter(
+        handle, distance / (float)(SOUND_RADIUS - SOUND_MAXVOL_RADIUS),
+        is_underwater);
+}
+
+static void M_SyncFilterOption(void)
+{
+    if (m_FiltersEnabled == g_Config.audio.enable_sound_filters) {
+        return;
+    }
+    m_FiltersEnabled = g_Config.audio.enable_sound_filters;
+    if (m_FiltersEnabled) {
+        return;
+    }
+
+    for (int32_t i = 0; i < SOUND_MAX_SLOTS; i++) {
+        const SOUND_SLOT *const slot = &m_SoundSlots[i];
+        if (slot->sample_num >= 0) {
+            Audio_Sample_SetFilter(slot->handle, 0.0f, false);
+        }
+    }
+}
+
 static void M_ClearAllSlots(void)
 {
     for (int32_t i = 0; i < SOUND_MAX_SLOTS; i++) {
@@ -126,6 +167,7 @@ static void M_UpdateSlot(SOUND_SLOT *const slot)
     Audio_Sample_SetPitch(slot->handle, M_ConvertPitch(slot->pitch));
     Audio_Sample_SetVolume(
         slot->handle, M_ConvertVolumeToDecibel(slot->volume));
+    M_SetFilter(slot->handle, slot->distance, slot->is_positional);
 }
 
 void Sound_Init(void)
@@ -285,6 +327,8 @@ bool Sound_Effect(
                     slot->volume = volume;
                     slot->pan = pan;
                     slot->pitch = pitch;
+                    slot->distance = distance;
+                    slot->is_positional = pos != NULL;
                 }
                 return true;
             }
@@ -317,6 +361,7 @@ bool Sound_Effect(
         s->number = -1;
         return false;
     }
+    M_SetFilter(handle, distance, pos != NULL);
 
     int32_t free_slot = -1;
     for (int32_t i = 0; i < SOUND_MAX_SLOTS; i++) {
@@ -332,6 +377,8 @@ bool Sound_Effect(
         slot->volume = volume;
         slot->pan = pan;
         slot->pitch = pitch;
+        slot->distance = distance;
+        slot->is_positional = pos != NULL;
         slot->sample_num = sample_num;
         slot->handle = handle;
     }
@@ -368,6 +415,8 @@ void Sound_EndScene(void)
         return;
     }
 
+    M_SyncFilterOption();
+
     for (int32_t i = 0; i < SOUND_MAX_SLOTS; i++) {
         SOUND_SLOT *const slot = &m_SoundSlots[i];
         SAMPLE_INFO *const s = &g_SampleInfos[slot->sample_num];
@@ -47,6 +47,7 @@
 #define MAX_ROOMS_TO_DRAW 100
 #define MAX_FLIP_MAPS 10
 #define MAX_VERTICES 0x2000
+#define MAX_VBUF_VERTICES 1500
 #define MAX_BOUND_ROOMS 128
 #define MAX_STATIC_OBJECTS 50
 #define MAX_ITEMS 256
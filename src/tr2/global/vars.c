@@ -63,7 +63,7 @@ int32_t g_PhdWinWidth;
 int32_t g_PhdViewDistance;
 DEPTHQ_ENTRY g_DepthQTable[32];
 int32_t g_LsDivider;
-PHD_VBUF g_PhdVBuf[1500];
+PHD_VBUF g_PhdVBuf[MAX_VBUF_VERTICES];
 uint8_t *g_TexturePageBuffer8[MAX_TEXTURE_PAGES] = {};
 float g_FltWinRight;
 XYZ_32 g_LsVectorView;